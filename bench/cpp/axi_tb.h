@@ -0,0 +1,345 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	axi_tb.h
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	An AXI master model, for test benches of cores having an
+//		AXI4 read-only memory port (S_AXI_AR*, S_AXI_R*) together
+//	with an AXI-Lite configuration port (S_AXIL_*), such as axiqflexpress.
+//
+//	Memory reads are queued with axi_request().  The model then presents
+//	each AR request in turn, as fast as the core will accept them, while
+//	collecting every R beat returned.  Any number of requests may
+//	therefore be outstanding at once.  axi_wait() waits for a given
+//	number of beats to have been returned, which may then be checked with
+//	axi_beat().  The R channel may be throttled with rready_rate().
+//
+//	The configuration port accesses, axil_write() and axil_read(), are
+//	blocking.  cfg_write() and cfg_read() address the configuration
+//	register at offset zero, so that this class may be used as the BASE
+//	of QFLEX_TB.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2015-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#ifndef	AXI_TB_H
+#define	AXI_TB_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <deque>
+#include <verilated.h>
+#include <verilated_vcd_c.h>
+#include "testb.h"
+
+static const int	AXI_BOMBCOUNT = 2048;
+
+#define	AXI_FIXED	0
+#define	AXI_INCR	1
+#define	AXI_WRAP	2
+
+typedef	struct	{
+	unsigned	m_id, m_addr, m_len, m_size, m_burst;
+} AXI_AREQ;
+
+typedef	struct	{
+	unsigned	m_id, m_data;
+	bool		m_last;
+} AXI_RBEAT;
+
+// axi_beat_addr
+// {{{
+// Returns the address of the given beat of an AXI burst, following the
+// AXI4 rules for FIXED, INCR, and WRAP bursts
+static inline unsigned	axi_beat_addr(unsigned addr, unsigned len,
+		unsigned size, unsigned burst, unsigned beat) {
+	unsigned	aligned = addr & ~((1u<<size)-1);
+
+	if (beat == 0)
+		return addr;
+	if (burst == AXI_FIXED)
+		return addr;
+	if (burst == AXI_WRAP) {
+		unsigned	wrapsz = (len+1) << size;
+
+		return (addr & ~(wrapsz-1))
+			| ((aligned + (beat << size)) & (wrapsz-1));
+	}
+
+	return aligned + (beat << size);
+}
+// }}}
+
+template <class VA>	class	AXIFLASH_TB : public TESTB<VA> {
+	std::deque<AXI_AREQ>	m_arq;
+	int			m_rready_rate;
+public:
+	std::deque<AXI_RBEAT>	m_rbeats;
+	bool			m_bomb;
+
+	AXIFLASH_TB(void) {
+		// {{{
+		VA	*core = TESTB<VA>::m_core;
+
+		m_bomb = false;
+		m_rready_rate = 100;
+
+		core->S_AXI_ARVALID  = 0;
+		core->S_AXI_RREADY   = 1;
+		core->S_AXIL_AWVALID = 0;
+		core->S_AXIL_WVALID  = 0;
+		core->S_AXIL_BREADY  = 1;
+		core->S_AXIL_ARVALID = 0;
+		core->S_AXIL_RREADY  = 1;
+		// }}}
+	}
+
+	bool	bombed(void) const { return m_bomb; }
+
+	// rready_rate
+	// {{{
+	// Set the percentage of clocks on which the R channel will accept
+	// a beat.
+	void	rready_rate(int pct) {
+		m_rready_rate = pct;
+	}
+	// }}}
+
+	virtual	void	tick(void) {
+		// {{{
+		VA	*core = TESTB<VA>::m_core;
+		bool	ar_fire, r_fire;
+		AXI_RBEAT	beat;
+
+		// Determine which handshakes will take place on this edge
+		this->eval();
+		ar_fire = (core->S_AXI_ARVALID)&&(core->S_AXI_ARREADY);
+		r_fire  = (core->S_AXI_RVALID)&&(core->S_AXI_RREADY);
+		if (r_fire) {
+			beat.m_id   = core->S_AXI_RID;
+			beat.m_data = core->S_AXI_RDATA;
+			beat.m_last = core->S_AXI_RLAST;
+			if (core->S_AXI_RRESP != 0) {
+				printf("AXI-BOMB: RRESP = %d\n", core->S_AXI_RRESP);
+				m_bomb = true;
+			}
+		}
+
+		TESTB<VA>::tick();
+
+		if (r_fire)
+			m_rbeats.push_back(beat);
+		if (ar_fire)
+			m_arq.pop_front();
+
+		// Present the next AR request, if there is one
+		if (m_arq.empty())
+			core->S_AXI_ARVALID = 0;
+		else {
+			const AXI_AREQ &req = m_arq.front();
+
+			core->S_AXI_ARVALID = 1;
+			core->S_AXI_ARID    = req.m_id;
+			core->S_AXI_ARADDR  = req.m_addr;
+			core->S_AXI_ARLEN   = req.m_len;
+			core->S_AXI_ARSIZE  = req.m_size;
+			core->S_AXI_ARBURST = req.m_burst;
+		}
+
+		core->S_AXI_RREADY = ((rand() % 100) < m_rready_rate) ? 1:0;
+		// }}}
+	}
+
+	// axi_request
+	// {{{
+	// Queue an AXI4 read request.  len is the number of beats, minus one,
+	// as in ARLEN.
+	void	axi_request(unsigned id, unsigned addr, unsigned len,
+			unsigned burst = AXI_INCR, unsigned size = 2) {
+		AXI_AREQ	req;
+
+		req.m_id    = id;
+		req.m_addr  = addr;
+		req.m_len   = len;
+		req.m_size  = size;
+		req.m_burst = burst;
+		m_arq.push_back(req);
+
+		// Present it now, if nothing else is waiting
+		if (m_arq.size() == 1) {
+			VA	*core = TESTB<VA>::m_core;
+
+			core->S_AXI_ARVALID = 1;
+			core->S_AXI_ARID    = id;
+			core->S_AXI_ARADDR  = addr;
+			core->S_AXI_ARLEN   = len;
+			core->S_AXI_ARSIZE  = size;
+			core->S_AXI_ARBURST = burst;
+		}
+	}
+	// }}}
+
+	// axi_wait
+	// {{{
+	// Wait until at least nbeats R beats have been collected.  Returns
+	// false on a timeout.
+	bool	axi_wait(unsigned nbeats) {
+		unsigned long	errcount = 0;
+
+		while((m_rbeats.size() < nbeats)
+				&&(errcount++ < AXI_BOMBCOUNT * (nbeats+1)))
+			tick();
+
+		if (m_rbeats.size() < nbeats) {
+			printf("AXI-BOMB: Only %ld of %d beats returned\n",
+				(long)m_rbeats.size(), nbeats);
+			m_bomb = true;
+			return false;
+		} return true;
+	}
+	// }}}
+
+	// axi_beat
+	// {{{
+	// Remove the oldest R beat from the list, and return it
+	AXI_RBEAT	axi_beat(void) {
+		AXI_RBEAT	beat;
+
+		assert(!m_rbeats.empty());
+		beat = m_rbeats.front();
+		m_rbeats.pop_front();
+		return beat;
+	}
+	// }}}
+
+	// axi_read
+	// {{{
+	// A single beat read, waiting for the result
+	unsigned	axi_read(unsigned addr) {
+		AXI_RBEAT	beat;
+
+		axi_request(0, addr, 0);
+		if (!axi_wait(1))
+			return 0;
+		beat = axi_beat();
+		if (!beat.m_last) {
+			printf("AXI-BOMB: RLAST not set on a single beat read\n");
+			m_bomb = true;
+		}
+		return beat.m_data;
+	}
+	// }}}
+
+	void	axil_write(unsigned a, unsigned v) {
+		// {{{
+		VA	*core = TESTB<VA>::m_core;
+		int	errcount = 0;
+		bool	accepted;
+
+		core->S_AXIL_AWVALID = 1;
+		core->S_AXIL_AWADDR  = a;
+		core->S_AXIL_WVALID  = 1;
+		core->S_AXIL_WDATA   = v;
+		core->S_AXIL_BREADY  = 1;
+
+		do {
+			this->eval();
+			accepted = (core->S_AXIL_AWREADY)&&(core->S_AXIL_WREADY);
+			tick();
+		} while((!accepted)&&(errcount++ < AXI_BOMBCOUNT));
+
+		core->S_AXIL_AWVALID = 0;
+		core->S_AXIL_WVALID  = 0;
+
+		while((!core->S_AXIL_BVALID)&&(errcount++ < AXI_BOMBCOUNT))
+			tick();
+
+		if (errcount >= AXI_BOMBCOUNT) {
+			printf("AXIL-BOMB: NO WRITE RESPONSE AFTER %d CLOCKS\n",
+				errcount);
+			m_bomb = true;
+		} else if (core->S_AXIL_BRESP != 0) {
+			printf("AXIL-BOMB: BRESP = %d\n", core->S_AXIL_BRESP);
+			m_bomb = true;
+		}
+
+		// Accept the response
+		tick();
+		// }}}
+	}
+
+	unsigned axil_read(unsigned a) {
+		// {{{
+		VA		*core = TESTB<VA>::m_core;
+		int		errcount = 0;
+		bool		accepted;
+		unsigned	result;
+
+		core->S_AXIL_ARVALID = 1;
+		core->S_AXIL_ARADDR  = a;
+		core->S_AXIL_RREADY  = 1;
+
+		do {
+			this->eval();
+			accepted = core->S_AXIL_ARREADY;
+			tick();
+		} while((!accepted)&&(errcount++ < AXI_BOMBCOUNT));
+
+		core->S_AXIL_ARVALID = 0;
+
+		while((!core->S_AXIL_RVALID)&&(errcount++ < AXI_BOMBCOUNT))
+			tick();
+
+		result = core->S_AXIL_RDATA;
+		if (errcount >= AXI_BOMBCOUNT) {
+			printf("AXIL-BOMB: NO READ RESPONSE AFTER %d CLOCKS\n",
+				errcount);
+			m_bomb = true;
+		} else if (core->S_AXIL_RRESP != 0) {
+			printf("AXIL-BOMB: RRESP = %d\n", core->S_AXIL_RRESP);
+			m_bomb = true;
+		}
+
+		// Accept the response
+		tick();
+
+		return result;
+		// }}}
+	}
+
+	void	cfg_write(unsigned v) { axil_write(0, v); }
+	unsigned cfg_read(void) { return axil_read(0); }
+};
+
+#endif
@@ -0,0 +1,282 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	axiqflexpress_tb.cpp
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	To determine whether or not the axiqflexpress AXI4 flash
+//		controller works.  The AXI master model of axi_tb.h drives
+//	the core, while the FLASHSIM model plays the part of the flash.  The
+//	test
+//
+//	1. Reads single words, one at a time
+//	2. Reads INCR bursts of random lengths, from random addresses, with
+//	   several requests (and IDs) outstanding at once
+//	3. Reads WRAP bursts, starting mid-way through the wrap
+//	4. Repeats the bursts while throttling the R channel
+//	5. Compares the time taken by a single long burst against that taken
+//	   by the same words read one at a time
+//	6. Reads the flash's ID, then erases and programs it, all through the
+//	   AXI-Lite configuration port, and reads back the result
+//
+//	Every beat is checked for its ID, its RLAST, and its data.
+//
+//	Run the simulation program this with no arguments, and then check
+//	whether or not the last line contains "SUCCESS" or not.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2015-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#include <stdlib.h>
+#include "verilated.h"
+#include "Vaxiqflexpress.h"
+#include "byteswap.h"
+#include "axi_tb.h"
+#include "qflex_tb.h"
+
+#define	NSINGLE		64
+#define	NBURSTS		40
+#define	NOUTSTANDING	4
+#define	MAXBURST	64
+#define	LONGBURST	64
+
+typedef	QFLEX_TB<Vaxiqflexpress, AXIFLASH_TB<Vaxiqflexpress> >	AXIQFLEX_TB;
+
+// checkburst
+// {{{
+// Collect the beats of a burst previously requested, and check each of
+// them against the flash
+bool	checkburst(AXIQFLEX_TB *tb, unsigned id, unsigned addr, unsigned len,
+		unsigned burst) {
+	for(unsigned k=0; k<=len; k++) {
+		AXI_RBEAT	beat;
+		unsigned	a, exv;
+
+		if (!tb->axi_wait(1))
+			return false;
+		beat = tb->axi_beat();
+		a    = axi_beat_addr(addr, len, 2, burst, k);
+		exv  = (*tb)[a>>2];
+
+		if (beat.m_id != id) {
+			printf("BOMB: Beat %d of burst at %08x returned ID %d, expected %d\n",
+				k, addr, beat.m_id, id);
+			return false;
+		} if (beat.m_last != (k == len)) {
+			printf("BOMB: Beat %d of %d, burst at %08x, RLAST = %d\n",
+				k, len+1, addr, beat.m_last);
+			return false;
+		} if (beat.m_data != exv) {
+			printf("BOMB: READ[%08x] %08x, EXPECTED %08x (beat %d of burst at %08x)\n",
+				a, beat.m_data, exv, k, addr);
+			return false;
+		}
+	}
+
+	return !tb->bombed();
+}
+// }}}
+
+// runbursts
+// {{{
+// Issue NBURSTS random INCR and WRAP bursts, NOUTSTANDING at a time, and
+// check all that come back
+bool	runbursts(AXIQFLEX_TB *tb) {
+	unsigned	id[NOUTSTANDING], addr[NOUTSTANDING],
+			len[NOUTSTANDING], burst[NOUTSTANDING];
+
+	for(int b=0; b<NBURSTS; b+= NOUTSTANDING) {
+		for(int k=0; k<NOUTSTANDING; k++) {
+			id[k] = (b+k) & 3;
+			if (rand() & 1) {
+				// WRAP: 2, 4, 8, or 16 beats, starting from
+				// anywhere within the wrap
+				burst[k] = AXI_WRAP;
+				len[k]   = (2 << (rand() & 3)) - 1;
+				addr[k]  = (rand() % (2*SECTORSZW)) << 2;
+			} else {
+				burst[k] = AXI_INCR;
+				len[k]   = rand() % MAXBURST;
+				addr[k]  = (rand() % (2*SECTORSZW - MAXBURST))<<2;
+			}
+
+			tb->axi_request(id[k], addr[k], len[k], burst[k]);
+		}
+
+		for(int k=0; k<NOUTSTANDING; k++)
+			if (!checkburst(tb, id[k], addr[k], len[k], burst[k]))
+				return false;
+	}
+
+	return true;
+}
+// }}}
+
+int main(int  argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	AXIQFLEX_TB	*tb = new AXIQFLEX_TB;
+	unsigned	rdv, exv;
+	unsigned long	start, burstclocks, singleclocks;
+
+	tb->opentrace("axiqflexpress.vcd");
+
+	srand(0x1234);
+	for(int i=0; i<2*SECTORSZW; i++)
+		tb->set(i, rand());
+
+	// Wait for the controller's startup sequence to complete.  Until then,
+	// memory requests are stalled.
+	tb->axi_request(0, 0, 0);
+	while((tb->m_rbeats.empty())&&(tb->m_tickcount < STARTUP_CLOCKS))
+		tb->tick();
+	if (!tb->axi_wait(1))
+		goto test_failure;
+	(void)tb->axi_beat();
+	printf("Startup completed\n");
+
+	// 1. Single word reads
+	// {{{
+	for(int k=0; k<NSINGLE; k++) {
+		unsigned a = rand() % (2*SECTORSZW);
+
+		rdv = tb->axi_read(a<<2);
+		exv = (*tb)[a];
+		if (rdv != exv) {
+			printf("BOMB: READ[%08x] %08x, EXPECTED %08x\n",
+				a<<2, rdv, exv);
+			goto test_failure;
+		}
+	}
+	printf("Single word reads:  PASS\n");
+	// }}}
+
+	// 2-3. Bursts
+	// {{{
+	if (!runbursts(tb))
+		goto test_failure;
+	printf("Bursts:             PASS\n");
+	// }}}
+
+	// 4. Bursts, with back pressure on R
+	// {{{
+	tb->rready_rate(30);
+	if (!runbursts(tb))
+		goto test_failure;
+	tb->rready_rate(100);
+	printf("Throttled bursts:   PASS\n");
+	// }}}
+
+	// 5. Burst throughput
+	// {{{
+	start = tb->m_tickcount;
+	tb->axi_request(1, SECTORSZB, LONGBURST-1);
+	if (!checkburst(tb, 1, SECTORSZB, LONGBURST-1, AXI_INCR))
+		goto test_failure;
+	burstclocks = tb->m_tickcount - start;
+
+	start = tb->m_tickcount;
+	for(int k=0; k<LONGBURST; k++) {
+		rdv = tb->axi_read(SECTORSZB + 4*k);
+		if (rdv != (*tb)[SECTORSZW+k]) {
+			printf("BOMB: READ[%08x] %08x, EXPECTED %08x\n",
+				SECTORSZB+4*k, rdv, (*tb)[SECTORSZW+k]);
+			goto test_failure;
+		}
+	}
+	singleclocks = tb->m_tickcount - start;
+
+	printf("%d words: %ld clocks as one burst, %ld clocks one at a time\n",
+		LONGBURST, burstclocks, singleclocks);
+	if (burstclocks * 2 > singleclocks) {
+		printf("BOMB: The burst was not (much) faster\n");
+		goto test_failure;
+	}
+	// }}}
+
+	// 6. The configuration port
+	// {{{
+	tb->take_offline();
+	printf("Status Register = 0x%02x\n", rdv = tb->flstatus());
+	printf("ID     Register = 0x%08x\n", rdv = tb->flreadid());
+	{	extern const unsigned DEVID;
+		if (rdv != DEVID) {
+			printf("BOMB: ID read %08x, expected %08x\n",
+				rdv, DEVID);
+			goto test_failure;
+		}
+	}
+	tb->place_online();
+
+	tb->flerase(SECTORSZB);
+	tb->axi_request(2, SECTORSZB, 15);
+	for(int k=0; k<16; k++) {
+		AXI_RBEAT	beat;
+
+		if (!tb->axi_wait(1))
+			goto test_failure;
+		beat = tb->axi_beat();
+		if (beat.m_data != 0xffffffff) {
+			printf("BOMB: READ[%08x] %08x after erase\n",
+				SECTORSZB+4*k, beat.m_data);
+			goto test_failure;
+		}
+	}
+
+	{	char	buf[4];
+		buf[0] = 0x12;
+		buf[1] = 0x34;
+		buf[2] = 0x56;
+		buf[3] = 0x78;
+		tb->flprogram(SECTORSZB+4, 4, buf);
+	}
+
+	tb->axi_request(3, SECTORSZB, 3);
+	if (!checkburst(tb, 3, SECTORSZB, 3, AXI_INCR))
+		goto test_failure;
+	if ((*tb)[SECTORSZW+1] != 0x12345678) {
+		printf("BOMB: The flash was not programmed\n");
+		goto test_failure;
+	}
+	printf("Configuration port: PASS\n");
+	// }}}
+
+	if (tb->bombed())
+		goto test_failure;
+
+	printf("SUCCESS!!\n");
+	exit(EXIT_SUCCESS);
+test_failure:
+	printf("FAIL-HERE\n");
+	for(int i=0; i<8; i++)
+		tb->tick();
+	printf("TEST FAILED\n");
+	exit(EXIT_FAILURE);
+}
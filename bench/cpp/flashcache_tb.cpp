@@ -0,0 +1,393 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	flashcache_tb.cpp
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	To determine whether or not the flashcache read cache works,
+//		in both its direct mapped and two way set associative forms.
+//	Each is placed in front of a qflexpress controller, via the qflexcache
+//	harness, and then
+//
+//	1. Runs a set of loops, as a CPU would, checking every word read and
+//	   requiring that repeated passes hit in the cache.
+//	2. Alternates between two addresses sharing the same cache set.  The
+//	   two way cache should only miss on the first access to each, the
+//	   direct mapped cache on every access.
+//	3. Checks coherence: words held in the cache are then erased and
+//	   programmed through the configuration port, and must be read back
+//	   with their new values.
+//
+//	A third model, filling its lines critical word first from a flash set
+//	to wrap its bursts at the line length, is then run through the same
+//	tests.  A miss on the last word of a line must then be acknowledged
+//	sooner than it is by the direct mapped cache, which fills in order.
+//
+//	The cache's own statistics registers, read through the configuration
+//	port, are used to count hits and misses.
+//
+//	Run the simulation program this with no arguments, and then check
+//	whether or not the last line contains "SUCCESS" or not.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2015-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#include <stdlib.h>
+#include "verilated.h"
+#include "Vqflexcache.h"
+#include "Vqflexcache2.h"
+#include "Vqflexcachew.h"
+#include "byteswap.h"
+#include "qflex_tb.h"
+
+// These must match the parameters given to the qflexcache harness
+#define	LGLINE		3
+#define	LGLINES		6
+#define	WAYSZW		(1<<(LGLINE+LGLINES))
+// ... and to the LGWRAP given to the wrapped model, Vqflexcachew
+#define	LGWRAP		LGLINE
+
+// Addresses of the cache statistics, within the configuration space
+#define	R_HITS		0x18
+#define	R_MISSES	0x19
+#define	R_INVALS	0x1a
+#define	R_GEOMETRY	0x1b
+
+// The loop test: NLOOPS loops of LOOPLEN words each, every one run NPASSES
+// times
+#define	NLOOPS		4
+#define	LOOPLEN		40
+#define	NPASSES		8
+
+template <class VA>	class	CACHE_TB : public QFLEX_TB<VA> {
+public:
+	// stat_read
+	// {{{
+	unsigned stat_read(unsigned addr) {
+		VA		*core = TESTB<VA>::m_core;
+		int		errcount = 0;
+		unsigned	result;
+
+		core->i_wb_cyc  = 1;
+		core->i_wb_stb  = 0;
+		core->i_cfg_stb = 1;
+		core->i_wb_we   = 0;
+		core->i_wb_addr = addr;
+
+		while((errcount++ < BOMBCOUNT)&&(core->o_wb_stall))
+			this->tick();
+		this->tick();
+		core->i_cfg_stb = 0;
+
+		while((errcount++ < BOMBCOUNT)&&(!core->o_wb_ack))
+			this->tick();
+
+		result = core->o_wb_data;
+		core->i_wb_cyc = 0;
+		core->i_wb_addr = 0;
+
+		if (errcount >= BOMBCOUNT) {
+			printf("STAT-BOMB: NO RESPONSE AFTER %d CLOCKS\n", errcount);
+			this->m_bomb = true;
+		}
+
+		this->tick();
+		return result;
+	}
+	// }}}
+
+	// stat_clear
+	// {{{
+	void	stat_clear(void) {
+		VA	*core = TESTB<VA>::m_core;
+		int	errcount = 0;
+
+		core->i_wb_cyc  = 1;
+		core->i_wb_stb  = 0;
+		core->i_cfg_stb = 1;
+		core->i_wb_we   = 1;
+		core->i_wb_addr = R_HITS;
+		core->i_wb_data = 0;
+
+		while((errcount++ < BOMBCOUNT)&&(core->o_wb_stall))
+			this->tick();
+		this->tick();
+		core->i_cfg_stb = 0;
+
+		while((errcount++ < BOMBCOUNT)&&(!core->o_wb_ack))
+			this->tick();
+
+		core->i_wb_cyc  = 0;
+		core->i_wb_addr = 0;
+
+		if (errcount >= BOMBCOUNT) {
+			printf("STAT-BOMB: NO RESPONSE AFTER %d CLOCKS\n", errcount);
+			this->m_bomb = true;
+		}
+
+		this->tick();
+	}
+	// }}}
+
+	// check
+	// {{{
+	// Read a word through the cache, and compare it against the flash
+	bool	check(unsigned wordaddr, const char *msg) {
+		unsigned	rdv, exv;
+
+		rdv = this->wb_read(wordaddr<<2);
+		exv = (*this)[wordaddr];
+		if (rdv != exv) {
+			printf("BOMB(%s): READ[%08x] %08x, EXPECTED %08x\n",
+				msg, wordaddr<<2, rdv, exv);
+			return false;
+		}
+
+		return !this->bombed();
+	}
+	// }}}
+
+	// miss_latency
+	// {{{
+	// Read a word which isn't (yet) in the cache, and return the number
+	// of clocks it took, from request to acknowledgement
+	unsigned long	miss_latency(unsigned wordaddr) {
+		unsigned long	start = this->m_tickcount;
+
+		if (!check(wordaddr, "MISS"))
+			return 0;
+		return this->m_tickcount - start;
+	}
+	// }}}
+
+	void	report(const char *name) {
+		printf("%-10s: %6d hits, %6d misses, %6d invalidations\n",
+			name, stat_read(R_HITS), stat_read(R_MISSES),
+			stat_read(R_INVALS));
+	}
+};
+
+// runtests
+// {{{
+template <class VA>	bool	runtests(CACHE_TB<VA> *tb, bool twoway,
+		bool wrapfill, const char *name) {
+	unsigned	hits, misses, expected, rdv, base;
+
+	printf("\n%s\n", name);
+	tb->tick();
+	while(tb->m_core->o_wb_stall)
+		tb->tick();
+
+	// The geometry register should tell us what we built
+	rdv = tb->stat_read(R_GEOMETRY);
+	expected = (wrapfill ? 0x20000 : 0) | (twoway ? 0x10000 : 0)
+			| (LGLINES << 8) | LGLINE;
+	if (rdv != expected) {
+		printf("BOMB: Cache geometry reads %08x, expected %08x\n",
+			rdv, expected);
+		return false;
+	}
+
+	// 1. Loops
+	// {{{
+	// Each loop starts at a random place.  Loops are kept apart, within
+	// the first sector, so they don't evict each other.
+	tb->stat_clear();
+	for(int lp=0; lp<NLOOPS; lp++) {
+		base = lp * (WAYSZW / NLOOPS) + (rand() % 8);
+		for(int pass=0; pass<NPASSES; pass++) {
+			for(int k=0; k<LOOPLEN; k++) {
+				if (!tb->check(base+k, "LOOP"))
+					return false;
+			}
+		}
+	}
+
+	hits   = tb->stat_read(R_HITS);
+	misses = tb->stat_read(R_MISSES);
+	tb->report(name);
+
+	// Only the first pass of each loop should miss, and then only once
+	// per line touched
+	expected = NLOOPS * ((LOOPLEN + 7 + (1<<LGLINE)-1) >> LGLINE);
+	if (misses > expected) {
+		printf("BOMB: %d misses on the loop test, expected no more than %d\n",
+			misses, expected);
+		return false;
+	} if (hits + misses != NLOOPS * NPASSES * LOOPLEN) {
+		printf("BOMB: %d hits + %d misses != %d reads\n",
+			hits, misses, NLOOPS * NPASSES * LOOPLEN);
+		return false;
+	}
+	// }}}
+
+	// 2. Set conflicts
+	// {{{
+	tb->stat_clear();
+	for(int k=0; k<16; k++) {
+		if (!tb->check(SECTORSZW/2 + ((k&1) ? WAYSZW : 0), "CONFLICT"))
+			return false;
+	}
+
+	misses = tb->stat_read(R_MISSES);
+	expected = (twoway) ? 2 : 16;
+	if (misses != expected) {
+		printf("BOMB: %d misses on the conflict test, expected %d\n",
+			misses, expected);
+		return false;
+	}
+	// }}}
+
+	// 3. Coherence
+	// {{{
+	// Load the first few words of the second sector into the cache, and
+	// then change them underneath it.
+	for(int k=0; k<8; k++)
+		if (!tb->check(SECTORSZW+k, "PRE-ERASE"))
+			return false;
+
+	tb->stat_clear();
+	tb->take_offline();
+	printf("Status Register = 0x%02x\n", rdv = tb->flstatus());
+	printf("ID     Register = 0x%08x\n", rdv = tb->flreadid());
+	{	extern const unsigned DEVID;
+		if (rdv != DEVID) {
+			printf("BOMB: Pass-through ID read %08x, expected %08x\n",
+				rdv, DEVID);
+			return false;
+		}
+	}
+	tb->place_online();
+
+	tb->flerase(SECTORSZB);
+	for(int k=0; k<8; k++) {
+		rdv = tb->wb_read((SECTORSZW+k)<<2);
+		if (rdv != 0xffffffff) {
+			printf("BOMB: Stale data after erase, READ[%08x] = %08x\n",
+				(SECTORSZW+k)<<2, rdv);
+			return false;
+		}
+	}
+
+	{	char	buf[4];
+		buf[0] = 0x12;
+		buf[1] = 0x34;
+		buf[2] = 0x56;
+		buf[3] = 0x78;
+		tb->flprogram(SECTORSZB+4, 4, buf);
+	}
+
+	for(int k=0; k<8; k++) {
+		unsigned	exv = (k == 1) ? 0x12345678 : 0xffffffff;
+		rdv = tb->wb_read((SECTORSZW+k)<<2);
+		if (rdv != exv) {
+			printf("BOMB: Stale data after program, READ[%08x] = %08x, expected %08x\n",
+				(SECTORSZW+k)<<2, rdv, exv);
+			return false;
+		}
+	}
+
+	if (tb->stat_read(R_INVALS) == 0) {
+		printf("BOMB: The cache was never invalidated\n");
+		return false;
+	}
+	// }}}
+
+	return !tb->bombed();
+}
+// }}}
+
+int main(int  argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	CACHE_TB<Vqflexcache>	*dm = new CACHE_TB<Vqflexcache>;
+	CACHE_TB<Vqflexcache2>	*tw = new CACHE_TB<Vqflexcache2>;
+	CACHE_TB<Vqflexcachew>	*wr = new CACHE_TB<Vqflexcachew>;
+	unsigned long	dmlat, wrlat;
+
+	dm->opentrace("flashcache.vcd");
+
+	// Both flash simulations get the same contents
+	srand(0x1234);
+	for(int i=0; i<2*SECTORSZW; i++) {
+		unsigned v = rand();
+		dm->set(i, v);
+		tw->set(i, v);
+		wr->set(i, v);
+	}
+
+	srand(52);
+	if (!runtests(dm, false, false, "DIRECT-MAPPED"))
+		goto test_failure;
+	srand(52);
+	if (!runtests(tw, true,  false, "TWO-WAY"))
+		goto test_failure;
+
+	// The wrapped model needs the flash set to wrap at the line length
+	// before it can be used
+	wr->tick();
+	while(wr->m_core->o_wb_stall)
+		wr->tick();
+	wr->flsetwrap(LGWRAP);
+	srand(52);
+	if (!runtests(wr, false, true, "WRAP-FILL"))
+		goto test_failure;
+
+	// Critical word first should return a miss on the last word of a
+	// line sooner than a fill from the start of the line
+	{
+		unsigned	addr = SECTORSZW/4 + (1<<LGLINE)-1;
+
+		dmlat = dm->miss_latency(addr);
+		wrlat = wr->miss_latency(addr);
+		printf("Miss latency, last word of line: %ld clocks in order, %ld clocks critical word first\n",
+			dmlat, wrlat);
+		if ((dmlat == 0)||(wrlat == 0))
+			goto test_failure;
+		if (wrlat >= dmlat) {
+			printf("BOMB: Critical word first did not reduce the miss latency\n");
+			goto test_failure;
+		}
+
+		// The rest of the line must now be in the cache, and correct
+		for(int k=0; k<(1<<LGLINE); k++)
+			if (!wr->check((addr & (-1<<LGLINE)) + k, "WRAP-LINE"))
+				goto test_failure;
+	}
+
+	printf("SUCCESS!!\n");
+	exit(EXIT_SUCCESS);
+test_failure:
+	printf("FAIL-HERE\n");
+	for(int i=0; i<8; i++)
+		dm->tick();
+	printf("TEST FAILED\n");
+	exit(EXIT_FAILURE);
+}
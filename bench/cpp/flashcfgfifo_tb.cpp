@@ -0,0 +1,327 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	flashcfgfifo_tb.cpp
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	To determine whether or not the flashcfgfifo configuration
+//		port FIFO works, and how much sooner it frees the bus than
+//	writing each byte to the configuration port directly.  The test
+//
+//	1. Reads the flash's ID through the FIFO, collecting the four ID bytes
+//	   in the receive FIFO, and then checks that emptying the receive
+//	   FIFO works
+//	2. Programs a page through the FIFO, as one burst of bus writes, and
+//	   then the same data into the next page by writing the same words to
+//	   the configuration port directly.  Both pages must read back the same,
+//	   and the burst must take no more than a clock per word.
+//	3. Makes certain normal reads pass through the FIFO unchanged
+//
+//	Run the simulation program this with no arguments, and then check
+//	whether or not the last line contains "SUCCESS" or not.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2015-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#include <stdlib.h>
+#include "verilated.h"
+#include "Vqflexcfgfifo.h"
+#include "byteswap.h"
+#include "qflex_tb.h"
+
+// The FIFO's registers, within the configuration space
+#define	R_CFGQ		0x0e
+#define	R_CFGRX		0x0f
+#define	CFGQ_BUSY	0x80000000
+#define	CFGQ_RXEN	0x00010000
+#define	CFGRX_VALID	0x80000000
+
+// The most clocks we'll wait for the FIFO to drain
+#define	DRAIN_CLOCKS	(1<<16)
+
+class	CFGFIFO_TB : public QFLEX_TB<Vqflexcfgfifo> {
+public:
+	// fifo_write
+	// {{{
+	// Write n configuration words into the FIFO, as one pipelined burst
+	// within a single bus cycle, returning the number of clocks the bus
+	// was held for
+	unsigned long	fifo_write(unsigned n, const unsigned *buf) {
+		int		errcount = 0;
+		unsigned	nacks = 0;
+		unsigned long	start = m_tickcount;
+
+		m_core->i_wb_cyc  = 1;
+		m_core->i_wb_stb  = 0;
+		m_core->i_cfg_stb = 1;
+		m_core->i_wb_we   = 1;
+		m_core->i_wb_addr = R_CFGQ;
+
+		for(unsigned k=0; k<n; k++) {
+			m_core->i_wb_data = buf[k];
+			eval();
+			while((errcount++ < BOMBCOUNT)&&(m_core->o_wb_stall)) {
+				tick();
+				if (m_core->o_wb_ack)
+					nacks++;
+			}
+			tick();
+			if (m_core->o_wb_ack)
+				nacks++;
+		}
+		m_core->i_cfg_stb = 0;
+
+		while((errcount++ < BOMBCOUNT)&&(nacks < n)) {
+			tick();
+			if (m_core->o_wb_ack)
+				nacks++;
+		}
+
+		m_core->i_wb_cyc = 0;
+		m_core->i_wb_addr = 0;
+
+		if (errcount >= BOMBCOUNT) {
+			printf("FIFO-BOMB: NO RESPONSE AFTER %d CLOCKS\n", errcount);
+			m_bomb = true;
+		}
+
+		start = m_tickcount - start;
+		tick();
+		return start;
+	}
+	// }}}
+
+	// fifo_wait
+	// {{{
+	// Poll the FIFO until it has drained, returning the clocks it took
+	unsigned long	fifo_wait(void) {
+		unsigned long	start = m_tickcount;
+
+		while((m_tickcount - start < DRAIN_CLOCKS)
+				&&(reg_read(R_CFGQ) & CFGQ_BUSY))
+			;
+
+		if (m_tickcount - start >= DRAIN_CLOCKS) {
+			printf("FIFO-BOMB: The FIFO never drained\n");
+			m_bomb = true;
+		}
+
+		return m_tickcount - start;
+	}
+	// }}}
+
+	// fifo_pgm
+	// {{{
+	// Build the configuration words to program ln bytes into the page at
+	// addr, returning the number of words
+	unsigned fifo_pgm(unsigned *buf, unsigned addr, unsigned ln,
+			const char *data) {
+		unsigned	n = 0;
+
+		buf[n++] = F_END;
+		buf[n++] = cfgcmd(F_WREN);
+		buf[n++] = F_END;
+
+		buf[n++] = cfgcmd(F_PP);
+		buf[n++] = cfgcmd(CFG_USERMODE|((addr >> 16)&0x0ff));
+		buf[n++] = cfgcmd(CFG_USERMODE|((addr >>  8)&0x0ff));
+		buf[n++] = cfgcmd(CFG_USERMODE|((addr      )&0x0ff));
+
+		for(unsigned i=0; i<ln; i++)
+			buf[n++] = cfgcmd(CFG_USERMODE|(data[i] & 0x0ff));
+		buf[n++] = F_END;
+
+		return n;
+	}
+	// }}}
+};
+
+int main(int  argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	CFGFIFO_TB	*tb = new CFGFIFO_TB;
+	unsigned	rdv, exv, rdbuf[PGLENW], wbuf[PGLENB+16], n;
+	char		pgbuf[PGLENB];
+	unsigned long	pushcks, draincks, directcks, start;
+
+	tb->opentrace("flashcfgfifo.vcd");
+
+	srand(0x5678);
+	for(int i=0; i<2*SECTORSZW; i++)
+		tb->set(i, rand());
+
+	// Wait for the controller's startup sequence to complete
+	tb->tick();
+	while(tb->m_core->o_wb_stall)
+		tb->tick();
+
+	// 1. The flash's ID
+	// {{{
+	tb->take_offline();
+
+	n = 0;
+	wbuf[n++] = tb->cfgcmd(F_READID);
+	for(int k=0; k<4; k++)
+		wbuf[n++] = CFGQ_RXEN | tb->cfgrd();
+	wbuf[n++] = F_END;
+	tb->fifo_write(n, wbuf);
+	tb->fifo_wait();
+
+	if (((rdv = tb->reg_read(R_CFGQ)) & 0x0ffff) != 4) {
+		printf("BOMB: CFGQ = %08x, expected four bytes received\n", rdv);
+		goto test_failure;
+	}
+
+	exv = 0;
+	for(int k=0; k<4; k++) {
+		rdv = tb->reg_read(R_CFGRX);
+		if (!(rdv & CFGRX_VALID)) {
+			printf("BOMB: ID byte %d never received\n", k);
+			goto test_failure;
+		} exv = (exv << 8) | (rdv & 0x0ff);
+	}
+
+	{	extern const unsigned DEVID;
+		if (exv != DEVID) {
+			printf("BOMB: ID read %08x, expected %08x\n",
+				exv, DEVID);
+			goto test_failure;
+		}
+	}
+
+	if ((rdv = tb->reg_read(R_CFGRX)) & CFGRX_VALID) {
+		printf("BOMB: CFGRX = %08x, with the receive FIFO empty\n",
+			rdv);
+		goto test_failure;
+	}
+
+	// Collect a byte, and then throw it away
+	wbuf[0] = tb->cfgcmd(F_RDSR);
+	wbuf[1] = CFGQ_RXEN | tb->cfgrd();
+	wbuf[2] = F_END;
+	tb->fifo_write(3, wbuf);
+	tb->fifo_wait();
+	tb->reg_write(R_CFGRX, 0);
+	if ((rdv = tb->reg_read(R_CFGQ)) != 0) {
+		printf("BOMB: CFGQ = %08x after emptying the receive FIFO\n",
+			rdv);
+		goto test_failure;
+	}
+
+	tb->place_online();
+	printf("ID     Register = 0x%08x\n", exv);
+	printf("Reading through the FIFO:  PASS\n");
+	// }}}
+
+	// 2. Program a page, both through the FIFO and directly
+	// {{{
+	for(int k=0; k<PGLENB; k++)
+		pgbuf[k] = rand();
+
+	tb->flerase(SECTORSZB);
+
+	tb->take_offline();
+	n = tb->fifo_pgm(wbuf, SECTORSZB, PGLENB, pgbuf);
+	pushcks  = tb->fifo_write(n, wbuf);
+
+	// The FIFO should still be busy sending the page
+	if (!((rdv = tb->reg_read(R_CFGQ)) & CFGQ_BUSY)) {
+		printf("BOMB: CFGQ = %08x, already idle following the burst\n",
+			rdv);
+		goto test_failure;
+	}
+
+	draincks = tb->fifo_wait() + pushcks;
+	tb->flwait();
+	tb->place_online();
+
+	// The same words, written to the configuration port one at a time
+	tb->take_offline();
+	n = tb->fifo_pgm(wbuf, SECTORSZB+PGLENB, PGLENB, pgbuf);
+	start = tb->m_tickcount;
+	for(unsigned k=0; k<n; k++)
+		tb->cfg_write(wbuf[k]);
+	directcks = tb->m_tickcount - start;
+	tb->flwait();
+	tb->place_online();
+
+	tb->wb_read(SECTORSZB, PGLENW, rdbuf);
+	for(int k=0; k<PGLENW; k++) {
+		exv = (*tb)[SECTORSZW+PGLENW+k];
+		if ((rdbuf[k] != exv)||((*tb)[SECTORSZW+k] != exv)) {
+			printf("BOMB: READ[%08x] %08x, EXPECTED %08x\n",
+				SECTORSZB+4*k, rdbuf[k], exv);
+			goto test_failure;
+		}
+	}
+
+	printf("Page program, through the FIFO: bus held %6ld clocks, %8ld to drain\n",
+		pushcks, draincks);
+	printf("Page program, directly:         bus held %6ld clocks\n",
+		directcks);
+	if (pushcks > n + 8) {
+		printf("BOMB: The burst took more than a clock per word\n");
+		goto test_failure;
+	} if (pushcks * 4 > directcks) {
+		printf("BOMB: The FIFO didn't free the bus any sooner\n");
+		goto test_failure;
+	}
+
+	if (tb->bombed())
+		goto test_failure;
+	printf("Page program through the FIFO:  PASS\n");
+	// }}}
+
+	// 3. Pass-through reads
+	// {{{
+	tb->wb_read(0, PGLENW, rdbuf);
+	for(int k=0; k<PGLENW; k++) {
+		if (rdbuf[k] != (*tb)[k]) {
+			printf("BOMB: READ[%08x] %08x, EXPECTED %08x\n",
+				4*k, rdbuf[k], (*tb)[k]);
+			goto test_failure;
+		}
+	}
+
+	if (tb->bombed())
+		goto test_failure;
+	printf("Pass-through reads:        PASS\n");
+	// }}}
+
+	printf("SUCCESS!!\n");
+	exit(EXIT_SUCCESS);
+test_failure:
+	printf("FAIL-HERE\n");
+	for(int i=0; i<8; i++)
+		tb->tick();
+	printf("TEST FAILED\n");
+	exit(EXIT_FAILURE);
+}
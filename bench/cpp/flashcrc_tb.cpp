@@ -0,0 +1,403 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	flashcrc_tb.cpp
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	To determine whether or not the flashcrc verification and
+//		blank check engine works, and how much faster it is than
+//	reading the flash back across the bus.  The test
+//
+//	1. Checks the engine's CRC of a single word, and of several random
+//	   ranges of random data, against one calculated here
+//	2. Makes certain normal reads pass through the engine unchanged
+//	3. Times the CRC of a full sector, against the time taken to read the
+//	   same sector back across the bus
+//	4. Programs a page through the configuration port, and verifies it
+//	   using only the engine's CRC
+//	5. Blank checks the rest of the erased sector, and then again after
+//	   placing a word in it, to make certain the engine finds the word,
+//	   reports its address, and stops there
+//	6. Streams a range out of the AXI-Stream port into a sink model,
+//	   checking every word and TLAST, and measuring the sustained bytes
+//	   per clock.  The stream is then repeated with back pressure.
+//
+//	Run the simulation program this with no arguments, and then check
+//	whether or not the last line contains "SUCCESS" or not.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2015-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#include <stdlib.h>
+#include <vector>
+#include "verilated.h"
+#include "Vqflexcrc.h"
+#include "byteswap.h"
+#include "qflex_tb.h"
+
+// The engine's registers, within the configuration space
+#define	R_CRCADDR	0x1c
+#define	R_CRCLEN	0x1d
+#define	R_CRC		0x1e
+#define	R_BLANK		0x1f
+#define	CRC_BUSY	0x80000000
+#define	CRC_BLANKCHK	0x80000000
+#define	CRC_STREAM	0x40000000
+#define	BLANK		0x80000000
+
+#define	NRANGES		8
+#define	MAXRANGE	512
+#define	STREAMLEN	4096
+
+// The most clocks we'll wait for the engine to read a full sector
+#define	CRC_CLOCKS	(1<<20)
+
+class	CRC_TB : public QFLEX_TB<Vqflexcrc> {
+public:
+	unsigned long	m_nacks;
+	// The stream sink
+	std::vector<unsigned>	m_sink;
+	unsigned long	m_sinkfirst, m_sinklast, m_nlast;
+	int		m_tready_rate;
+
+	CRC_TB(void) {
+		m_nacks = 0;
+		m_tready_rate = 100;
+		m_core->M_AXIS_TREADY = 1;
+		sink_clear();
+	}
+
+	virtual	void	tick(void) {
+		bool		beat;
+		unsigned	data;
+
+		eval();
+		beat = (m_core->M_AXIS_TVALID)&&(m_core->M_AXIS_TREADY);
+		data = m_core->M_AXIS_TDATA;
+		if ((beat)&&(m_core->M_AXIS_TLAST)&&(m_nlast == 0))
+			m_nlast = m_sink.size() + 1;
+
+		QFLEX_TB<Vqflexcrc>::tick();
+
+		if (m_core->o_wb_ack)
+			m_nacks++;
+		if (beat) {
+			if (m_sink.empty())
+				m_sinkfirst = m_tickcount;
+			m_sinklast = m_tickcount;
+			m_sink.push_back(data);
+		}
+
+		m_core->M_AXIS_TREADY = ((rand() % 100) < m_tready_rate) ? 1:0;
+	}
+
+	// sink_clear
+	// {{{
+	// Empty the stream sink.  m_nlast, if nonzero, will count the beats
+	// received through the first one with TLAST set.
+	void	sink_clear(void) {
+		m_sink.clear();
+		m_sinkfirst = m_sinklast = 0;
+		m_nlast = 0;
+	}
+	// }}}
+
+	// flcrc
+	// {{{
+	// Have the engine calculate the CRC of ln words, starting at byte
+	// address a.  The engine's registers are polled until it is done.
+	unsigned flcrc(unsigned a, unsigned ln) {
+		unsigned long	start;
+
+		reg_write(R_CRCADDR, a);
+		reg_write(R_CRCLEN, ln);
+		start = m_tickcount;
+		while((m_tickcount - start < CRC_CLOCKS)
+				&&(reg_read(R_CRCLEN) & CRC_BUSY))
+			;
+
+		if (m_tickcount - start >= CRC_CLOCKS) {
+			printf("CRC-BOMB: The engine never finished\n");
+			m_bomb = true;
+		}
+
+		return reg_read(R_CRC);
+	}
+	// }}}
+
+	// swcrc
+	// {{{
+	// The CRC32 of ln words of the flash, starting at byte address a,
+	// calculated here from the flash simulator's memory
+	unsigned swcrc(unsigned a, unsigned ln) {
+		unsigned	crc = 0xffffffff;
+
+		for(unsigned k=0; k<ln; k++) {
+			unsigned	w = (*this)[(a>>2)+k];
+
+			for(int b=24; b>=0; b-=8) {
+				crc ^= (w >> b) & 0x0ff;
+				for(int i=0; i<8; i++)
+					crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0);
+			}
+		}
+
+		return ~crc;
+	}
+	// }}}
+
+	// checkcrc
+	// {{{
+	bool	checkcrc(unsigned a, unsigned ln) {
+		unsigned	rdv, exv;
+
+		rdv = flcrc(a, ln);
+		exv = swcrc(a, ln);
+		if (rdv != exv) {
+			printf("BOMB: CRC[%08x, %d words] = %08x, EXPECTED %08x\n",
+				a, ln, rdv, exv);
+			return false;
+		}
+
+		return !bombed();
+	}
+	// }}}
+};
+
+int main(int  argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	CRC_TB		*tb = new CRC_TB;
+	unsigned	rdv, exv, rdbuf[PGLENW], dirty;
+	unsigned long	start, crccks, crcnacks, readcks, readnacks;
+
+	tb->opentrace("flashcrc.vcd");
+
+	srand(0x1234);
+	for(int i=0; i<3*SECTORSZW; i++)
+		tb->set(i, rand());
+
+	// Wait for the controller's startup sequence to complete
+	tb->tick();
+	while(tb->m_core->o_wb_stall)
+		tb->tick();
+
+	// 1. Random ranges
+	// {{{
+	if (!tb->checkcrc(4*17, 1))
+		goto test_failure;
+
+	for(int k=0; k<NRANGES; k++) {
+		unsigned	a, ln;
+
+		ln = 1 + (rand() % MAXRANGE);
+		a  = (rand() % (2*SECTORSZW)) << 2;
+		if (!tb->checkcrc(a, ln))
+			goto test_failure;
+	}
+
+	if ((rdv = tb->reg_read(R_CRCLEN)) != 0) {
+		printf("BOMB: CRCLEN = %08x once done\n", rdv);
+		goto test_failure;
+	}
+
+	// Random data is hardly blank
+	if ((rdv = tb->reg_read(R_BLANK)) & BLANK) {
+		printf("BOMB: BLANK = %08x, random data reported as blank\n",
+			rdv);
+		goto test_failure;
+	}
+	printf("CRC of random ranges:  PASS\n");
+	// }}}
+
+	// 2. Pass-through reads
+	// {{{
+	tb->wb_read(SECTORSZB, PGLENW, rdbuf);
+	for(int k=0; k<PGLENW; k++) {
+		if (rdbuf[k] != (*tb)[SECTORSZW+k]) {
+			printf("BOMB: READ[%08x] %08x, EXPECTED %08x\n",
+				SECTORSZB+4*k, rdbuf[k], (*tb)[SECTORSZW+k]);
+			goto test_failure;
+		}
+	}
+
+	if (tb->bombed())
+		goto test_failure;
+	printf("Pass-through reads:    PASS\n");
+	// }}}
+
+	// 3. A full sector
+	// {{{
+	start = tb->m_tickcount;
+	crcnacks = tb->m_nacks;
+	if (!tb->checkcrc(2*SECTORSZB, SECTORSZW))
+		goto test_failure;
+	crcnacks = tb->m_nacks - crcnacks;
+	crccks   = tb->m_tickcount - start;
+
+	start = tb->m_tickcount;
+	readnacks = tb->m_nacks;
+	for(int k=0; k<SECTORSZW; k+= PGLENW)
+		tb->wb_read(2*SECTORSZB+4*k, PGLENW, rdbuf);
+	readnacks = tb->m_nacks - readnacks;
+	readcks   = tb->m_tickcount - start;
+
+	printf("Sector verify, by reading:  %6ld bus transactions, %8ld clocks\n",
+		readnacks, readcks);
+	printf("Sector verify, by CRC:      %6ld bus transactions, %8ld clocks\n",
+		crcnacks, crccks);
+	if (crccks > readcks) {
+		printf("BOMB: The CRC was slower than reading the sector\n");
+		goto test_failure;
+	}
+	// }}}
+
+	// 4. Verify a newly programmed page
+	// {{{
+	{
+		char	bbuf[PGLENB];
+		unsigned crc = 0xffffffff;
+
+		for(int k=0; k<PGLENB; k++) {
+			bbuf[k] = rand();
+			crc ^= bbuf[k] & 0x0ff;
+			for(int i=0; i<8; i++)
+				crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0);
+		} exv = ~crc;
+
+		tb->flerase(SECTORSZB);
+		tb->flprogram(SECTORSZB, PGLENB, bbuf);
+
+		rdv = tb->flcrc(SECTORSZB, PGLENW);
+		if (rdv != exv) {
+			printf("BOMB: CRC of the programmed page = %08x, EXPECTED %08x\n",
+				rdv, exv);
+			goto test_failure;
+		}
+	}
+	printf("Programmed page CRC:   PASS\n");
+	// }}}
+
+	// 5. Blank checks
+	// {{{
+	start = tb->m_tickcount;
+	(void)tb->flcrc(SECTORSZB+PGLENB, CRC_BLANKCHK | (SECTORSZW-PGLENW));
+	crccks = tb->m_tickcount - start;
+	if ((rdv = tb->reg_read(R_BLANK)) != BLANK) {
+		printf("BOMB: BLANK = %08x, the erased sector is not blank\n",
+			rdv);
+		goto test_failure;
+	}
+
+	dirty = SECTORSZB + SECTORSZB/2 + 4*37;
+	tb->set(dirty>>2, 0xffffff7f);
+
+	start = tb->m_tickcount;
+	(void)tb->flcrc(SECTORSZB+PGLENB, CRC_BLANKCHK | (SECTORSZW-PGLENW));
+	readcks = tb->m_tickcount - start;
+	if ((rdv = tb->reg_read(R_BLANK)) != dirty) {
+		printf("BOMB: BLANK = %08x, EXPECTED %08x\n", rdv, dirty);
+		goto test_failure;
+	}
+
+	printf("Blank check, full sector:     %8ld clocks\n", crccks);
+	printf("Blank check, stopping early:  %8ld clocks\n", readcks);
+	if (readcks * 3 > crccks * 2) {
+		printf("BOMB: The blank check didn't stop early\n");
+		goto test_failure;
+	}
+	printf("Blank check:           PASS\n");
+	// }}}
+
+	// 6. Streaming
+	// {{{
+	for(int pass=0; pass<2; pass++) {
+		unsigned	crc;
+		double		rate;
+
+		tb->m_tready_rate = (pass == 0) ? 100 : 40;
+		tb->sink_clear();
+		// The engine remains busy until its FIFO has drained
+		crc = tb->flcrc(2*SECTORSZB, CRC_STREAM | STREAMLEN);
+
+		if (tb->m_sink.size() != STREAMLEN) {
+			printf("BOMB: %ld words streamed, expected %d\n",
+				(long)tb->m_sink.size(), STREAMLEN);
+			goto test_failure;
+		} if (tb->m_nlast != STREAMLEN) {
+			printf("BOMB: TLAST on beat %ld, expected %d\n",
+				tb->m_nlast, STREAMLEN);
+			goto test_failure;
+		}
+
+		for(int k=0; k<STREAMLEN; k++) {
+			// The first byte from the flash is in TDATA[7:0]
+			rdv = (*tb)[2*SECTORSZW+k];
+			exv = ((rdv & 0x0ff) << 24) | ((rdv & 0x0ff00) << 8)
+				| ((rdv >> 8) & 0x0ff00) | ((rdv >> 24) & 0x0ff);
+			if (tb->m_sink[k] != exv) {
+				printf("BOMB: STREAM[%d] = %08x, EXPECTED %08x\n",
+					k, tb->m_sink[k], exv);
+				goto test_failure;
+			}
+		}
+
+		exv = tb->swcrc(2*SECTORSZB, STREAMLEN);
+		if (crc != exv) {
+			printf("BOMB: CRC of the stream = %08x, EXPECTED %08x\n",
+				crc, exv);
+			goto test_failure;
+		}
+
+		rate = 4.0 * STREAMLEN / (tb->m_sinklast - tb->m_sinkfirst + 1);
+		printf("Stream, TREADY %3d%%:  %d words, %.3f bytes per clock\n",
+			tb->m_tready_rate, STREAMLEN, rate);
+		if ((pass == 0)&&(rate < 0.3)) {
+			printf("BOMB: The stream isn't running at the flash rate\n");
+			goto test_failure;
+		}
+	}
+
+	tb->m_tready_rate = 100;
+	printf("Streaming:             PASS\n");
+	// }}}
+
+	if (tb->bombed())
+		goto test_failure;
+
+	printf("SUCCESS!!\n");
+	exit(EXIT_SUCCESS);
+test_failure:
+	printf("FAIL-HERE\n");
+	for(int i=0; i<8; i++)
+		tb->tick();
+	printf("TEST FAILED\n");
+	exit(EXIT_FAILURE);
+}
@@ -0,0 +1,385 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	flashperf_tb.cpp
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	To determine whether or not the performance counters
+//		(OPT_PERF) of the spixpress, dualflexpress, and qflexpress
+//	controllers count what they should.  Each controller is built with
+//	OPT_PERF set, and attached to its own FLASHSIM model.  PERF_TB
+//	keeps its own count of the same events from the bus.  For each
+//	controller, the test
+//
+//	1. Clears the counters, then reads single words from random
+//	   addresses, each needing a new address
+//	2. Reads a burst, continuing the first read of it
+//	3. Compares the counters against the bus count
+//	4. Passes through the configuration mode, reads another burst, and
+//	   compares the counters again
+//
+//	Run the simulation program this with no arguments, and then check
+//	whether or not the last line contains "SUCCESS" or not.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2015-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#include <stdlib.h>
+#include "verilated.h"
+#include "Vspixpressperf.h"
+#include "Vdualflexpressperf.h"
+#include "Vqflexpressperf.h"
+#include "byteswap.h"
+#include "qflex_tb.h"
+
+#define	NSINGLE		64
+#define	LONGBURST	256
+
+// Performance counters (OPT_PERF), found on the configuration port
+const unsigned	R_PERF = 0x08, NPERF = 6,
+		PERF_SNAPSHOT = 1, PERF_CLEAR = 2;
+
+// cfg_user_mode
+// {{{
+// Returns true if a write of v to the configuration register would leave
+// the controller in its configuration (user) mode
+template<class VA>	bool	cfg_user_mode(unsigned v) {
+	return (v & CFG_USERMODE) != 0;
+}
+
+// spixpress's configuration mode follows CS_n, bit 8, instead
+template<>	bool	cfg_user_mode<Vspixpressperf>(unsigned v) {
+	return (v & CFG_USER_CS_n) == 0;
+}
+// }}}
+
+// PERF_TB
+// {{{
+// Wraps any of the test benches below, counting from the bus alone the same
+// events the performance counters should count
+template <class TB, class VA>	class	PERF_TB : public TB {
+	bool		m_cfgmode, m_lastrd;
+	unsigned	m_outstanding, m_lastaddr;
+	uint32_t	m_perf[NPERF], m_perfsnap[NPERF];
+public:
+	PERF_TB(void) {
+		// {{{
+		m_cfgmode = false;
+		m_lastrd  = false;
+		m_outstanding = 0;
+		m_lastaddr = 0;
+		for(unsigned k=0; k<NPERF; k++)
+			m_perf[k] = m_perfsnap[k] = 0;
+		// }}}
+	}
+
+	// perfmon
+	// {{{
+	// Called before every clock edge.  A memory read is counted as
+	// pipelined if it is to the address following the last read, and
+	// arrives before that read has been acknowledged.
+	void	perfmon(void) {
+		VA		*core = TESTB<VA>::m_core;
+		unsigned	addr = core->i_wb_addr, acks;
+		bool		rd, pipe, cfgw, clear = false;
+		uint32_t	evt[NPERF];
+
+		acks = (core->o_wb_ack) ? 1 : 0;
+		rd   = (core->i_wb_stb)&&(!core->o_wb_stall)
+				&&(!core->i_wb_we)&&(!m_cfgmode);
+		pipe = (rd)&&(m_lastrd)&&(m_outstanding > acks)
+				&&(addr == m_lastaddr + 1);
+		cfgw = (core->i_cfg_stb)&&(!core->o_wb_stall)
+				&&(core->i_wb_we);
+
+		evt[0] = 1;
+		evt[1] = (rd) ? 1:0;
+		evt[2] = (pipe) ? 1:0;
+		evt[3] = (rd && !pipe) ? 1:0;
+		evt[4] = ((core->i_wb_cyc)&&(core->o_wb_stall)
+			&&((core->i_wb_stb)||(core->i_cfg_stb))) ? 1:0;
+		evt[5] = (m_cfgmode) ? 1:0;
+
+		if ((cfgw)&&((addr & 0x1f) == R_PERF)) {
+			if (core->i_wb_data & PERF_SNAPSHOT)
+				for(unsigned k=0; k<NPERF; k++)
+					m_perfsnap[k] = m_perf[k];
+			clear = (core->i_wb_data & PERF_CLEAR) != 0;
+		}
+
+		for(unsigned k=0; k<NPERF; k++)
+			m_perf[k] = (clear) ? 0 : m_perf[k] + evt[k];
+
+		if ((cfgw)&&(((addr & 0x1f) < R_PERF)
+				||((addr & 0x1f) >= R_PERF + NPERF)))
+			m_cfgmode = cfg_user_mode<VA>(core->i_wb_data);
+
+		if (!core->i_wb_cyc)
+			m_outstanding = 0;
+		else {
+			m_outstanding -= (m_outstanding > 0) ? acks : 0;
+			if (((core->i_wb_stb)||(core->i_cfg_stb))
+					&&(!core->o_wb_stall))
+				m_outstanding++;
+		}
+
+		if (((core->i_wb_stb)||(core->i_cfg_stb))
+				&&(!core->o_wb_stall)) {
+			m_lastrd   = rd;
+			m_lastaddr = addr;
+		}
+	}
+	// }}}
+
+	void	tick(void) {
+		TESTB<VA>::eval();
+		perfmon();
+		TB::tick();
+	}
+
+	// perfclear
+	// {{{
+	// Clears the controller's performance counters
+	void	perfclear(void) {
+		this->cfg_write(R_PERF, PERF_SNAPSHOT | PERF_CLEAR);
+	}
+	// }}}
+
+	// perfcheck
+	// {{{
+	// Takes a snapshot of the controller's performance counters, and
+	// compares each against the bookkeeping above.  Since configuration
+	// mode reads replace bits [16:8], this should only be called with
+	// the controller out of configuration mode.
+	bool	perfcheck(void) {
+		static const char *name[NPERF] = { "Clocks", "Reads",
+			"Pipelined", "New address", "Stalls", "Config mode" };
+		bool	pass = true;
+
+		this->cfg_write(R_PERF, PERF_SNAPSHOT);
+		for(unsigned k=0; k<NPERF; k++) {
+			unsigned	v = this->cfg_read(R_PERF + k);
+
+			printf("PERF: %-12s %10u, expected %10u%s\n", name[k],
+				v, m_perfsnap[k],
+				(v == m_perfsnap[k]) ? "" : " -- MISMATCH");
+			if (v != m_perfsnap[k])
+				pass = false;
+		}
+
+		return pass;
+	}
+	// }}}
+};
+// }}}
+
+// SPIFLASH_TB
+// {{{
+// spixpress, with its SPI pins attached to a FLASHSIM model
+class	SPIFLASH_TB : public WBFLASH_TB<Vspixpressperf> {
+	FLASHSIM	*m_flash;
+	int		m_lastsck;
+public:
+	SPIFLASH_TB(void) {
+		m_flash = new FLASHSIM(LGFLASHSZB);
+		m_lastsck = 0;
+	}
+
+	~SPIFLASH_TB(void) {
+		delete	m_flash;
+	}
+
+	unsigned operator[](const int index) { return (*m_flash)[index]; }
+
+	void	set(const unsigned addr, const unsigned val) {
+		m_flash->set(addr, val);
+	}
+
+	void	tick(void) {
+		if (m_lastsck)
+			(*m_flash)(m_core->o_spi_cs_n, 0, m_core->o_spi_mosi);
+		m_core->i_spi_miso = ((*m_flash)(m_core->o_spi_cs_n, 1,
+				m_core->o_spi_mosi)&2)?1:0;
+		m_lastsck = m_core->o_spi_sck;
+
+		WBFLASH_TB<Vspixpressperf>::tick();
+	}
+};
+// }}}
+
+// DUALFLASH_TB
+// {{{
+// dualflexpress, with its dual SPI pins attached to a FLASHSIM model
+class	DUALFLASH_TB : public WBFLASH_TB<Vdualflexpressperf> {
+	FLASHSIM	*m_flash;
+	int		m_lastsck;
+public:
+	DUALFLASH_TB(void) {
+		m_flash = new FLASHSIM(LGFLASHSZB);
+		m_lastsck = 0;
+	}
+
+	~DUALFLASH_TB(void) {
+		delete	m_flash;
+	}
+
+	unsigned operator[](const int index) { return (*m_flash)[index]; }
+
+	void	set(const unsigned addr, const unsigned val) {
+		m_flash->set(addr, val);
+	}
+
+	void	tick(void) {
+		int	idspi;
+
+		if (m_lastsck)
+			(*m_flash)(m_core->o_dspi_cs_n, 0, m_core->o_dspi_dat);
+
+		idspi = (*m_flash)(m_core->o_dspi_cs_n, 1, m_core->o_dspi_dat);
+
+		if (m_core->o_dspi_mod&2) {
+			if (m_core->o_dspi_mod&1) {
+				; // IDSPI is as given
+			} else
+				idspi = m_core->o_dspi_dat;
+		} else {
+			idspi &= 0x02;
+			idspi |= m_core->o_dspi_dat&1;
+		}
+
+		m_core->i_dspi_dat = idspi;
+		m_lastsck = m_core->o_dspi_sck;
+
+		WBFLASH_TB<Vdualflexpressperf>::tick();
+	}
+};
+// }}}
+
+typedef	PERF_TB<SPIFLASH_TB, Vspixpressperf>		SPIPERF_TB;
+typedef	PERF_TB<DUALFLASH_TB, Vdualflexpressperf>	DUALPERF_TB;
+typedef	PERF_TB<QFLEX_TB<Vqflexpressperf>, Vqflexpressperf>	QUADPERF_TB;
+
+// cfgmode
+// {{{
+// Pass through the configuration mode, without disturbing the flash's XIP
+// mode
+template<class TB>	void	cfgmode(TB *tb) {
+	tb->cfg_write(F_END);
+	tb->cfg_write(0);
+}
+
+// spixpress is only in its configuration mode while CS_n is low, so read
+// the status register instead
+template<>	void	cfgmode(SPIPERF_TB *tb) {
+	tb->cfg_write(F_RDSR);
+	tb->cfg_write(0);
+	tb->cfg_write(F_END);
+}
+// }}}
+
+// perftest
+// {{{
+template<class TB>	bool	perftest(TB *tb, const char *name) {
+	const unsigned	NWORDS = (1<<(LGFLASHSZB-2));
+
+	if (!startup(tb))
+		return false;
+
+	tb->perfclear();
+
+	// 1. Single word reads
+	for(int k=0; k<NSINGLE; k++) {
+		unsigned a = (rand() % (NWORDS/61)) * 61, rdv;
+
+		rdv = tb->wb_read(a<<2);
+		if ((tb->bombed())||(rdv != (*tb)[a])) {
+			printf("BOMB(%s): READ[%08x] %08x, EXPECTED %08x\n",
+				name, a<<2, rdv, (*tb)[a]);
+			return false;
+		}
+	}
+
+	// 2. A burst
+	if (0 == burstread(tb, name, LONGBURST, LONGBURST))
+		return false;
+
+	// 3. Compare the counters
+	if (!tb->perfcheck())
+		return false;
+
+	// 4. Through the configuration mode, and back
+	cfgmode(tb);
+	if (0 == burstread(tb, name, 2*LONGBURST, LONGBURST))
+		return false;
+	if (!tb->perfcheck())
+		return false;
+
+	printf("%-6s counters:  PASS\n", name);
+	return true;
+}
+// }}}
+
+int main(int  argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	SPIPERF_TB	*spi  = new SPIPERF_TB;
+	DUALPERF_TB	*dual = new DUALPERF_TB;
+	QUADPERF_TB	*quad = new QUADPERF_TB;
+	const unsigned	NWORDS = (1<<(LGFLASHSZB-2));
+
+	quad->opentrace("flashperf.vcd");
+
+	srand(0x3579);
+	for(unsigned i=0; i<NWORDS; i+= 61) {
+		unsigned v = rand();
+		spi->set(i, v);
+		dual->set(i, v);
+		quad->set(i, v);
+	} for(unsigned i=0; i<3*LONGBURST; i++) {
+		unsigned v = rand();
+		spi->set(LONGBURST+i, v);
+		dual->set(LONGBURST+i, v);
+		quad->set(LONGBURST+i, v);
+	}
+
+	if ((!perftest(spi, "SPI"))||(!perftest(dual, "Dual"))
+			||(!perftest(quad, "Quad")))
+		goto test_failure;
+
+	printf("SUCCESS!!\n");
+	exit(EXIT_SUCCESS);
+test_failure:
+	printf("FAIL-HERE\n");
+	for(int i=0; i<8; i++)
+		quad->tick();
+	printf("TEST FAILED\n");
+	exit(EXIT_FAILURE);
+}
@@ -0,0 +1,290 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	flashpfetch_tb.cpp
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	To determine whether or not the flashpfetch read-ahead stage
+//		works, and to measure how much it helps.  The same instruction
+//	fetch trace is run against both a bare qflexpress controller and the
+//	qflexpfetch (prefetch + qflexpress) harness.  Every word read is checked
+//	against the flash simulation, and the hit rate (requests acknowledged
+//	within two clocks) and average latency are reported for both.  The
+//	prefetch must match the data, and must beat the bare controller's
+//	latency on the trace.  A program/erase is then run through the
+//	configuration port, to make certain no stale prefetched data survives
+//	it.
+//
+//	Run the simulation program this with no arguments, and then check
+//	whether or not the last line contains "SUCCESS" or not.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2015-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#include <stdlib.h>
+#include "verilated.h"
+#include "Vqflexpress.h"
+#include "Vqflexpfetch.h"
+#include "byteswap.h"
+#include "qflex_tb.h"
+
+// The trace is built from NRUNS sequential runs of instructions.  Each run
+// starts at a random address within the first TRACEW words of flash, and
+// lasts for between MINRUN and MINRUN+RUNVAR-1 words.  Between requests,
+// the "CPU" idles for up to MAXBUBBLE clocks.  One run in four loops back
+// to its start once, as a CPU would for a short loop.
+#define	NRUNS		200
+#define	TRACEW		(SECTORSZW)
+#define	MINRUN		4
+#define	RUNVAR		29
+#define	MAXBUBBLE	4
+#define	HITCLOCKS	2
+
+template <class VA>	class	FETCH_TB : public QFLEX_TB<VA> {
+public:
+	unsigned long	m_nreads, m_nhits, m_nclocks;
+
+	FETCH_TB(void) {
+		m_nreads = m_nhits = m_nclocks = 0;
+	}
+
+	// fetch
+	// {{{
+	// Issue a single read, as an instruction fetch would, and record how
+	// many clocks it took from the request to its acknowledgement.
+	unsigned fetch(unsigned a) {
+		VA		*core = TESTB<VA>::m_core;
+		unsigned	clocks = 0, result;
+
+		core->i_wb_cyc  = 1;
+		core->i_wb_stb  = 1;
+		core->i_cfg_stb = 0;
+		core->i_wb_we   = 0;
+		core->i_wb_addr = (a>>2);
+
+		while((clocks < BOMBCOUNT)&&(core->o_wb_stall)) {
+			this->tick();
+			clocks++;
+		}
+
+		this->tick();
+		clocks++;
+		core->i_wb_stb = 0;
+
+		while((clocks < BOMBCOUNT)&&(!core->o_wb_ack)) {
+			this->tick();
+			clocks++;
+		}
+
+		result = core->o_wb_data;
+		core->i_wb_cyc = 0;
+
+		if (!core->o_wb_ack) {
+			printf("FETCH-BOMB: NO RESPONSE AFTER %d CLOCKS\n", clocks);
+			this->m_bomb = true;
+		}
+
+		m_nreads++;
+		m_nclocks += clocks;
+		if (clocks <= HITCLOCKS)
+			m_nhits++;
+
+		this->tick();
+		assert(!core->o_wb_ack);
+
+		return result;
+	}
+	// }}}
+
+	void	idle(int nclocks) {
+		for(int k=0; k<nclocks; k++)
+			this->tick();
+	}
+
+	void	clear_stats(void) {
+		m_nreads = m_nhits = m_nclocks = 0;
+	}
+
+	void	report(const char *name) {
+		printf("%-12s: %6ld reads, %6ld hits (%5.1f%%), %6.2f clocks/read\n",
+			name, m_nreads, m_nhits,
+			(m_nreads) ? 100.0 * m_nhits / (double)m_nreads : 0.0,
+			(m_nreads) ? m_nclocks / (double)m_nreads : 0.0);
+	}
+
+	double	latency(void) {
+		return (m_nreads) ? m_nclocks / (double)m_nreads : 0.0;
+	}
+};
+
+// runtrace
+// {{{
+// Run the same pseudo-random fetch trace against the given test bench,
+// checking every word returned against the flash simulation.  Returns
+// false on any mismatch.
+template <class TB>	bool	runtrace(TB *tb, unsigned seed) {
+	srand(seed);
+	for(int run=0; (run<NRUNS)&&(!tb->bombed()); run++) {
+		unsigned	start, len;
+		bool		loop;
+
+		start = rand() % (TRACEW - MINRUN - RUNVAR);
+		len   = MINRUN + (rand() % RUNVAR);
+		loop  = ((rand() & 3) == 0);
+
+		for(int pass=0; pass < ((loop) ? 2:1); pass++) {
+			for(unsigned k=0; k<len; k++) {
+				unsigned	rdv, exv;
+
+				tb->idle(rand() % (MAXBUBBLE+1));
+				rdv = tb->fetch((start+k)<<2);
+				exv = (*tb)[start+k];
+				if (rdv != exv) {
+					printf("BOMB(TRACE): READ[%08x] %08x, EXPECTED %08x\n",
+						(start+k)<<2, rdv, exv);
+					return false;
+				}
+			}
+		}
+	}
+
+	return !tb->bombed();
+}
+// }}}
+
+int main(int  argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	FETCH_TB<Vqflexpress>	*base = new FETCH_TB<Vqflexpress>;
+	FETCH_TB<Vqflexpfetch>	*tb   = new FETCH_TB<Vqflexpfetch>;
+	const unsigned	SEED = 0x51f7;
+	unsigned	rdv;
+
+	tb->opentrace("flashpfetch.vcd");
+
+	// Both flash simulations get the same contents
+	srand(0x1234);
+	for(int i=0; i<2*SECTORSZW; i++) {
+		unsigned v = rand();
+		base->set(i, v);
+		tb->set(i, v);
+	}
+
+	base->tick();
+	while(base->m_core->o_wb_stall)
+		base->tick();
+	tb->tick();
+	while(tb->m_core->o_wb_stall)
+		tb->tick();
+	printf("Startup completed, stall line has gone low\n");
+
+	// Baseline
+	// {{{
+	if (!runtrace(base, SEED))
+		goto test_failure;
+	base->report("QFLEXPRESS");
+	// }}}
+
+	// With the prefetch
+	// {{{
+	if (!runtrace(tb, SEED))
+		goto test_failure;
+	tb->report("PREFETCH");
+
+	if (tb->latency() >= base->latency()) {
+		printf("BOMB: The prefetch did not improve the average latency\n");
+		goto test_failure;
+	} if (tb->m_nhits <= base->m_nhits) {
+		printf("BOMB: The prefetch did not improve the hit rate\n");
+		goto test_failure;
+	}
+	// }}}
+
+	// Coherence across a configuration port program/erase
+	// {{{
+	// Fetch from the first few words of the second sector, so they sit
+	// in the prefetch buffer, then change them underneath it.
+	tb->clear_stats();
+	for(int k=0; k<4; k++)
+		(void)tb->fetch((SECTORSZW+k)<<2);
+
+	tb->take_offline();
+	printf("Status Register = 0x%02x\n", rdv = tb->flstatus());
+	printf("ID     Register = 0x%08x\n", rdv = tb->flreadid());
+	{	extern const unsigned DEVID;
+		if (rdv != DEVID) {
+			printf("BOMB: Pass-through ID read %08x, expected %08x\n",
+				rdv, DEVID);
+			goto test_failure;
+		}
+	}
+	tb->place_online();
+
+	tb->flerase(SECTORSZB);
+	for(int k=0; k<8; k++) {
+		rdv = tb->fetch((SECTORSZW+k)<<2);
+		if (rdv != 0xffffffff) {
+			printf("BOMB: Stale data after erase, READ[%08x] = %08x\n",
+				(SECTORSZW+k)<<2, rdv);
+			goto test_failure;
+		}
+	}
+
+	{	char	buf[4];
+		buf[0] = 0x12;
+		buf[1] = 0x34;
+		buf[2] = 0x56;
+		buf[3] = 0x78;
+		tb->flprogram(SECTORSZB+4, 4, buf);
+	}
+
+	for(int k=0; k<8; k++) {
+		unsigned	exv = (k == 1) ? 0x12345678 : 0xffffffff;
+		rdv = tb->fetch((SECTORSZW+k)<<2);
+		if (rdv != exv) {
+			printf("BOMB: Stale data after program, READ[%08x] = %08x, expected %08x\n",
+				(SECTORSZW+k)<<2, rdv, exv);
+			goto test_failure;
+		}
+	}
+	// }}}
+
+	if (tb->bombed())
+		goto test_failure;
+
+	printf("SUCCESS!!\n");
+	exit(EXIT_SUCCESS);
+test_failure:
+	printf("FAIL-HERE\n");
+	for(int i=0; i<8; i++)
+		tb->tick();
+	printf("TEST FAILED\n");
+	exit(EXIT_FAILURE);
+}
@@ -0,0 +1,566 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	flashpgm_tb.cpp
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	To determine whether or not the flashpgm page program and
+//		erase engine works, and how many bus transactions it saves.
+//	The test is run against two models of the qflexpgm harness: one
+//	sending pages with the normal page program command, and one with the
+//	quad page program command.  For each, the test
+//
+//	1. Programs a page through the configuration port, as software would
+//	   without the engine, counting the bus transactions required
+//	2. Programs the next page through the engine's page buffer, counting
+//	   the bus transactions required, and waiting on the engine's
+//	   interrupt rather than polling
+//	3. Reads both pages back, and compares the transaction counts
+//	4. Programs a page from a partially written buffer, to make certain
+//	   unwritten words are left alone
+//	5. Discards a buffer, to make certain none of it is then programmed
+//	6. Erases a 4kB subsector, and then a 64kB sector, through the engine,
+//	   checking that only the data within them has been erased, and
+//	   compares the bus transactions required against those used to
+//	   erase a sector through the configuration port
+//
+//	A third model, built with OPT_SUSPEND, is then used to
+//
+//	7. Erase a sector while reading words from another one.  Each read
+//	   should suspend the erase, and return the right value within a
+//	   bounded number of clocks, and the flash should never be read while
+//	   the erase is active.  The erase must still complete.
+//
+//	Run the simulation program this with no arguments, and then check
+//	whether or not the last line contains "SUCCESS" or not.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2015-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#include <stdlib.h>
+#include "verilated.h"
+#include "Vqflexpgm.h"
+#include "Vqflexpgmq.h"
+#include "Vqflexpgms.h"
+#include "byteswap.h"
+#include "qflex_tb.h"
+
+// The engine's registers, within the configuration space
+#define	R_PGMCTL	0x10
+#define	R_ERASE		0x11
+#define	R_POLLINT	0x12
+#define	R_SUSPLAT	0x13
+#define	PGM_BUSY	0x80000000
+#define	PGM_DONE	0x40000000
+#define	PGM_START	0x01
+#define	PGM_DISCARD	0x02
+#define	ERASE_4K	0x00000000
+#define	ERASE_64K	0x02000000
+#define	SUBSECTORSZB	(1<<12)
+
+#define	POLLINT		1000
+#define	DEF_SUSPLAT	2048
+#define	NSUSPREADS	32
+
+// The most clocks we'll wait for the engine to program a page, or to erase
+// a sector
+#define	PGM_CLOCKS	(1<<18)
+#define	ERASE_CLOCKS	(1<<22)
+// The most clocks we'll wait on a read while the erase is suspended
+#define	SUSP_CLOCKS	(1<<14)
+
+template <class VA>	class	PGM_TB : public QFLEX_TB<VA> {
+public:
+	unsigned long	m_nacks;
+
+	PGM_TB(void) {
+		m_nacks = 0;
+	}
+
+	virtual	void	tick(void) {
+		QFLEX_TB<VA>::tick();
+		if (TESTB<VA>::m_core->o_wb_ack)
+			m_nacks++;
+	}
+
+	// buffer_write
+	// {{{
+	// Write ln words into the page buffer, starting at byte address a,
+	// as a single pipelined bus cycle
+	void	buffer_write(unsigned a, unsigned ln, const unsigned *buf) {
+		VA		*core = TESTB<VA>::m_core;
+		unsigned long	start = m_nacks;
+		int		errcount = 0;
+
+		core->i_wb_cyc  = 1;
+		core->i_wb_stb  = 1;
+		core->i_cfg_stb = 0;
+		core->i_wb_we   = 1;
+		for(unsigned k=0; k<ln; k++) {
+			core->i_wb_addr = (a>>2)+k;
+			core->i_wb_data = buf[k];
+
+			while((errcount++ < BOMBCOUNT)&&(core->o_wb_stall))
+				this->tick();
+			this->tick();
+		}
+		core->i_wb_stb = 0;
+
+		while((errcount++ < BOMBCOUNT)&&(m_nacks - start < ln))
+			this->tick();
+		core->i_wb_cyc = 0;
+
+		if (errcount >= BOMBCOUNT) {
+			printf("BUF-BOMB: Only %ld of %d writes acknowledged\n",
+				m_nacks - start, ln);
+			this->m_bomb = true;
+		}
+
+		this->tick();
+	}
+	// }}}
+
+	// pgm_wait
+	// {{{
+	// Wait for the engine's interrupt, without using the bus
+	bool	pgm_wait(const unsigned maxclocks = PGM_CLOCKS) {
+		VA		*core = TESTB<VA>::m_core;
+		unsigned	clocks = 0;
+
+		while((clocks++ < maxclocks)&&(!core->o_int))
+			this->tick();
+
+		if (!core->o_int) {
+			printf("PGM-BOMB: No interrupt after %d clocks\n", clocks);
+			this->m_bomb = true;
+			return false;
+		} return true;
+	}
+	// }}}
+
+	// timed_read
+	// {{{
+	// Read one word through the memory port, and return in clocks how
+	// long it took.  Unlike wb_read(), this waits long enough for a
+	// program or erase to be suspended first.
+	unsigned timed_read(unsigned a, unsigned long &clocks) {
+		VA		*core = TESTB<VA>::m_core;
+		unsigned long	start = TESTB<VA>::m_tickcount;
+		int		errcount = 0;
+		unsigned	result;
+
+		core->i_wb_cyc  = 1;
+		core->i_wb_stb  = 1;
+		core->i_cfg_stb = 0;
+		core->i_wb_we   = 0;
+		core->i_wb_addr = a>>2;
+
+		while((errcount++ < SUSP_CLOCKS)&&(core->o_wb_stall))
+			this->tick();
+		this->tick();
+		core->i_wb_stb = 0;
+
+		while((errcount++ < SUSP_CLOCKS)&&(!core->o_wb_ack))
+			this->tick();
+
+		result = core->o_wb_data;
+		clocks = TESTB<VA>::m_tickcount - start;
+		core->i_wb_cyc = 0;
+
+		if (errcount >= SUSP_CLOCKS) {
+			printf("READ-BOMB: NO RESPONSE AFTER %d CLOCKS\n", errcount);
+			this->m_bomb = true;
+		}
+
+		this->tick();
+		return result;
+	}
+	// }}}
+
+	unsigned busy_reads(void) { return this->m_flash->busy_reads(); }
+
+	// check_page
+	// {{{
+	// Read a page back through the memory port, and compare it against
+	// what was expected
+	bool	check_page(unsigned a, const unsigned *exv) {
+		unsigned	rdbuf[PGLENW];
+
+		this->wb_read(a, PGLENW, rdbuf);
+		for(int k=0; k<PGLENW; k++) {
+			if (rdbuf[k] != exv[k]) {
+				printf("BOMB: READ[%08x] %08x, EXPECTED %08x\n",
+					a+4*k, rdbuf[k], exv[k]);
+				return false;
+			}
+		}
+
+		return !this->bombed();
+	}
+	// }}}
+};
+
+// runtests
+// {{{
+// Run the test described above against the given model.  Returns false
+// on any failure.
+template <class VA>	bool	runtests(PGM_TB<VA> *tb, const char *name) {
+	const unsigned	BASEPG = SECTORSZB, PGMPG = SECTORSZB + PGLENB,
+			PARTPG = SECTORSZB + 2*PGLENB,
+			DISCPG = SECTORSZB + 3*PGLENB;
+	char		bbuf[PGLENB];
+	unsigned	wbuf[PGLENW], exv[PGLENW], rdv;
+	unsigned long	start, basenacks, basecks, pgmnacks, pgmcks,
+			erasenacks, erasecks;
+
+	printf("\n%s:\n", name);
+
+	// Wait for the controller's startup sequence to complete
+	tb->tick();
+	while(tb->m_core->o_wb_stall)
+		tb->tick();
+
+	start = tb->m_tickcount;
+	erasenacks = tb->m_nacks;
+	tb->flerase(SECTORSZB);
+	erasenacks = tb->m_nacks - erasenacks;
+	erasecks   = tb->m_tickcount - start;
+
+	// 1. A page, programmed through the configuration port
+	// {{{
+	for(int k=0; k<PGLENB; k++)
+		bbuf[k] = rand();
+
+	start = tb->m_tickcount;
+	basenacks = tb->m_nacks;
+	tb->flprogram(BASEPG, PGLENB, bbuf);
+	basenacks = tb->m_nacks - basenacks;
+	basecks   = tb->m_tickcount - start;
+
+	for(int k=0; k<PGLENW; k++) {
+		unsigned	v;
+
+		v = ((bbuf[4*k  ]&0x0ff)<<24) | ((bbuf[4*k+1]&0x0ff)<<16)
+		  | ((bbuf[4*k+2]&0x0ff)<< 8) |  (bbuf[4*k+3]&0x0ff);
+		if ((*tb)[(BASEPG>>2)+k] != v) {
+			printf("BOMB: FLASH[%08x] %08x, EXPECTED %08x\n",
+				BASEPG+4*k, (*tb)[(BASEPG>>2)+k], v);
+			return false;
+		}
+	}
+	// }}}
+
+	// 2. A page, programmed through the engine
+	// {{{
+	for(int k=0; k<PGLENW; k++)
+		wbuf[k] = rand();
+
+	start = tb->m_tickcount;
+	pgmnacks = tb->m_nacks;
+	tb->buffer_write(PGMPG, PGLENW, wbuf);
+	tb->reg_write(R_PGMCTL, PGM_START);
+	pgmnacks = tb->m_nacks - pgmnacks;
+
+	rdv = tb->reg_read(R_PGMCTL);
+	if ((rdv & PGM_BUSY) == 0) {
+		printf("BOMB: PGMCTL = %08x, the engine never started\n", rdv);
+		return false;
+	}
+
+	if (!tb->pgm_wait())
+		return false;
+	pgmcks = tb->m_tickcount - start;
+
+	rdv = tb->reg_read(R_PGMCTL);
+	if (rdv != (PGM_DONE | PGMPG)) {
+		printf("BOMB: PGMCTL = %08x, expected %08x\n",
+			rdv, PGM_DONE | PGMPG);
+		return false;
+	}
+
+	tb->reg_write(R_PGMCTL, 0);
+	if (tb->m_core->o_int) {
+		printf("BOMB: The interrupt was not cleared\n");
+		return false;
+	}
+	// }}}
+
+	// 3. Read both back, and compare
+	// {{{
+	if (!tb->check_page(PGMPG, wbuf))
+		return false;
+
+	for(int k=0; k<PGLENW; k++)
+		exv[k] = (*tb)[(BASEPG>>2)+k];
+	if (!tb->check_page(BASEPG, exv))
+		return false;
+
+	printf("Configuration port: %4ld bus transactions, %7ld clocks\n",
+		basenacks, basecks);
+	printf("Program engine:     %4ld bus transactions, %7ld clocks\n",
+		pgmnacks, pgmcks);
+	if (pgmnacks * 3 > basenacks) {
+		printf("BOMB: The engine did not save enough bus transactions\n");
+		return false;
+	}
+	// }}}
+
+	// 4. A partially written page
+	// {{{
+	for(int k=0; k<PGLENW; k++)
+		exv[k] = 0xffffffff;
+
+	for(int k=0; k<PGLENW; k+= 7) {
+		exv[k] = rand();
+		tb->buffer_write(PARTPG + 4*k, 1, &exv[k]);
+	}
+	tb->reg_write(R_PGMCTL, PGM_START);
+	if (!tb->pgm_wait())
+		return false;
+	tb->reg_write(R_PGMCTL, 0);
+
+	if (!tb->check_page(PARTPG, exv))
+		return false;
+	// }}}
+
+	// 5. A discarded buffer
+	// {{{
+	for(int k=0; k<PGLENW; k++)
+		wbuf[k] = rand();
+	tb->buffer_write(DISCPG, PGLENW, wbuf);
+	tb->reg_write(R_PGMCTL, PGM_DISCARD);
+
+	for(int k=0; k<PGLENW; k++)
+		exv[k] = 0xffffffff;
+	exv[3] = wbuf[3];
+	tb->buffer_write(DISCPG + 12, 1, &exv[3]);
+	tb->reg_write(R_PGMCTL, PGM_START);
+	if (!tb->pgm_wait())
+		return false;
+	tb->reg_write(R_PGMCTL, 0);
+
+	if (!tb->check_page(DISCPG, exv))
+		return false;
+	// }}}
+
+	// 6. Erases
+	// {{{
+	// Fill the second subsector of sector one, and all of sector two,
+	// behind the controller's back
+	for(int k=0; k<SUBSECTORSZB/4; k++)
+		tb->set((SECTORSZB+SUBSECTORSZB)/4 + k, rand());
+	for(int k=0; k<SECTORSZW; k++)
+		tb->set(2*SECTORSZW + k, rand());
+
+	tb->reg_write(R_POLLINT, POLLINT);
+	if ((rdv = tb->reg_read(R_POLLINT)) != POLLINT) {
+		printf("BOMB: POLLINT = %d, expected %d\n", rdv, POLLINT);
+		return false;
+	}
+
+	// A subsector, given an address somewhere within it
+	tb->reg_write(R_ERASE, ERASE_4K | (SECTORSZB + SUBSECTORSZB + 0x124));
+	if (!tb->pgm_wait())
+		return false;
+	rdv = tb->reg_read(R_ERASE);
+	if (rdv != (PGM_DONE | ERASE_4K | (SECTORSZB + SUBSECTORSZB + 0x124))) {
+		printf("BOMB: ERASE = %08x after the erase\n", rdv);
+		return false;
+	}
+
+	for(int k=0; k<SUBSECTORSZB/4; k++) {
+		unsigned a = (SECTORSZB + SUBSECTORSZB)/4 + k;
+		if ((*tb)[a] != 0xffffffff) {
+			printf("BOMB: FLASH[%08x] = %08x after subsector erase\n",
+				a<<2, (*tb)[a]);
+			return false;
+		}
+	}
+
+	// Neither the pages programmed before it, nor the next sector,
+	// should've been touched
+	for(int k=0; k<PGLENW; k++)
+		exv[k] = (*tb)[(BASEPG>>2)+k];
+	if (exv[0] == 0xffffffff) {
+		printf("BOMB: The subsector erase erased too much\n");
+		return false;
+	} if (!tb->check_page(BASEPG, exv))
+		return false;
+	if ((*tb)[2*SECTORSZW] == 0xffffffff) {
+		printf("BOMB: The subsector erase erased too much\n");
+		return false;
+	}
+
+	// A whole sector
+	start = tb->m_tickcount;
+	pgmnacks = tb->m_nacks;
+	tb->reg_write(R_ERASE, ERASE_64K | (2*SECTORSZB));
+	pgmnacks = tb->m_nacks - pgmnacks;
+	if (!tb->pgm_wait(ERASE_CLOCKS))
+		return false;
+	pgmcks = tb->m_tickcount - start;
+	tb->reg_write(R_PGMCTL, 0);
+	if (tb->m_core->o_int) {
+		printf("BOMB: The interrupt was not cleared\n");
+		return false;
+	}
+
+	for(int k=0; k<SECTORSZW; k++) {
+		if ((*tb)[2*SECTORSZW+k] != 0xffffffff) {
+			printf("BOMB: FLASH[%08x] = %08x after sector erase\n",
+				(2*SECTORSZW+k)<<2, (*tb)[2*SECTORSZW+k]);
+			return false;
+		}
+	}
+
+	printf("Sector erase, configuration port: %6ld bus transactions, %8ld clocks\n",
+		erasenacks, erasecks);
+	printf("Sector erase, engine:             %6ld bus transactions, %8ld clocks\n",
+		pgmnacks, pgmcks);
+	if (pgmnacks != 1) {
+		printf("BOMB: The engine's erase took more than one transaction\n");
+		return false;
+	}
+	// }}}
+
+	return !tb->bombed();
+}
+// }}}
+
+// suspendtest
+// {{{
+// Erase a sector, while reading from another.  Each read should suspend the
+// erase.
+template <class VA>	bool	suspendtest(PGM_TB<VA> *tb, const char *name) {
+	const unsigned	ERASESC = 3*SECTORSZW, READSC = 4*SECTORSZW;
+	unsigned	rdv, nreads = 0;
+	unsigned long	clocks, maxclocks = 0;
+
+	printf("\n%s:\n", name);
+
+	// Wait for the controller's startup sequence to complete
+	tb->tick();
+	while(tb->m_core->o_wb_stall)
+		tb->tick();
+
+	for(int k=0; k<SECTORSZW; k++) {
+		tb->set(ERASESC + k, rand());
+		tb->set(READSC  + k, rand());
+	}
+
+	tb->reg_write(R_POLLINT, POLLINT);
+	if ((rdv = tb->reg_read(R_SUSPLAT)) != DEF_SUSPLAT) {
+		printf("BOMB: SUSPLAT = %d, expected %d\n", rdv, DEF_SUSPLAT);
+		return false;
+	}
+
+	// 7. Reads during an erase
+	// {{{
+	tb->reg_write(R_ERASE, ERASE_64K | (ERASESC<<2));
+
+	while((nreads < NSUSPREADS)&&(!tb->m_core->o_int)) {
+		unsigned	a = READSC + (rand() % SECTORSZW);
+
+		// Give the erase some time to make progress
+		for(int k=(rand() % (4*POLLINT)); k>0; k--)
+			tb->tick();
+
+		rdv = tb->timed_read(a<<2, clocks);
+		if (rdv != (*tb)[a]) {
+			printf("BOMB: READ[%08x] %08x, EXPECTED %08x during erase\n",
+				a<<2, rdv, (*tb)[a]);
+			return false;
+		} if (tb->bombed())
+			return false;
+
+		if (clocks > maxclocks)
+			maxclocks = clocks;
+		nreads++;
+	}
+
+	if (nreads < NSUSPREADS) {
+		printf("BOMB: The erase completed after only %d reads\n", nreads);
+		return false;
+	}
+
+	if (!tb->pgm_wait(ERASE_CLOCKS))
+		return false;
+	tb->reg_write(R_PGMCTL, 0);
+
+	for(int k=0; k<SECTORSZW; k++) {
+		if ((*tb)[ERASESC+k] != 0xffffffff) {
+			printf("BOMB: FLASH[%08x] = %08x after sector erase\n",
+				(ERASESC+k)<<2, (*tb)[ERASESC+k]);
+			return false;
+		}
+	}
+
+	printf("%d reads during the erase, each taking at most %ld clocks\n",
+		nreads, maxclocks);
+	if (tb->busy_reads() != 0) {
+		printf("BOMB: The flash was read %d times while erasing\n",
+			tb->busy_reads());
+		return false;
+	} if (maxclocks > DEF_SUSPLAT + 1024) {
+		printf("BOMB: Reads took too long during the erase\n");
+		return false;
+	}
+	// }}}
+
+	return !tb->bombed();
+}
+// }}}
+
+int main(int  argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	PGM_TB<Vqflexpgm>	*tb  = new PGM_TB<Vqflexpgm>;
+	PGM_TB<Vqflexpgmq>	*tbq = new PGM_TB<Vqflexpgmq>;
+	PGM_TB<Vqflexpgms>	*tbs = new PGM_TB<Vqflexpgms>;
+
+	tb->opentrace("flashpgm.vcd");
+
+	srand(0x1234);
+	if (!runtests(tb, "PAGE PROGRAM (0x02)"))
+		goto test_failure;
+	if (!runtests(tbq, "QUAD PAGE PROGRAM (0x32)"))
+		goto test_failure;
+	if (!suspendtest(tbs, "ERASE SUSPEND (0x75/0x7A)"))
+		goto test_failure;
+
+	printf("SUCCESS!!\n");
+	exit(EXIT_SUCCESS);
+test_failure:
+	printf("FAIL-HERE\n");
+	for(int i=0; i<8; i++)
+		tb->tick();
+	printf("TEST FAILED\n");
+	exit(EXIT_FAILURE);
+}
@@ -70,9 +70,12 @@ static	const unsigned
 	tRES   =   30 * SECONDS,
 // Shall we artificially speed up this process?
 	tPP    = 12 * MICROSECONDS,
-	tSE    = 15 * MILLISECONDS;
+	tSSE   =  2 * MILLISECONDS,
+	tSE    = 15 * MILLISECONDS,
+	tSUS   = 20 * MICROSECONDS;	// Program/erase suspend latency
 // or keep it at the original speed
 	// tPP    = 1200 * MICROSECONDS,
+	// tSSE   =  250 * MILLISECONDS,
 	// tSE    = 1500 * MILLISECONDS;
 
 FLASHSIM::FLASHSIM(const int lglen, bool debug,
@@ -91,7 +94,19 @@ FLASHSIM::FLASHSIM(const int lglen, bool debug,
 	m_creg = 0x001;	// Iinitial creg on delivery
 	m_mode = FM_SPI;
 	m_mode_byte = 0;
+	m_wrapsz = 0;	// Wrapped bursts are off on power up
+	m_erasesz = (1<<16);
 	m_idle_throttle = false;
+	m_dtr = false;
+	m_dtr_hi = 0;
+	m_qpi = false;
+	m_opi = false;
+	m_rsten = false;
+	m_cr2 = 0;
+	m_suspended = false;
+	m_susp_count = 0;
+	m_busy_reads = 0;
+	m_addr4 = false;
 
 	memset(m_mem, 0x0ff, m_membytes);
 }
@@ -151,11 +166,25 @@ bool	FLASHSIM::deep_sleep(void) const {
 
 #define	QOREG(A)	m_oreg = ((m_oreg & (~0x0ff))|((A)&0x0ff))
 
+void	FLASHSIM::check_read(void) {
+	// A read may only start if no program or erase is active, or if it
+	// has been suspended long enough
+	if ((m_write_count > 0)&&((!m_suspended)||(m_susp_count > 0))) {
+		if (m_debug) printf("FLASHSIM: READ WHILE BUSY\n");
+		m_busy_reads++;
+	}
+}
+
 int	FLASHSIM::operator()(const int csn, const int sck, const int dat) {
 	// Keep track of a timer to determine when page program and erase
 	// cycles complete.
 
-	if (m_write_count > 0) {
+	if (m_suspended) {
+		// A suspended program or erase makes no progress.  Once the
+		// suspend latency has passed, WIP clears and reads may begin.
+		if ((m_susp_count > 0)&&(0 == --m_susp_count))
+			m_sreg &= (~QSPIF_WIP_FLAG);
+	} else if (m_write_count > 0) {
 		if (0 == (--m_write_count)) {// When done with erase/page pgm,
 			m_sreg &= 0x0fc; // Clear the write in progress bit
 			if (m_debug) printf("Write complete, clearing WIP (inside SIM)\n");
@@ -188,13 +217,13 @@ int	FLASHSIM::operator()(const int csn, const int sck, const int dat) {
 			}
 			m_mode = FM_SPI;
 		} else if (m_state == QSPIF_SECTOR_ERASE) {
-			if (m_debug) printf("FLASHSIM: Actually Erasing sector, from %08x\n", m_addr);
-			m_write_count = tSE;
+			if (m_debug) printf("FLASHSIM: Actually Erasing %d bytes, from %08x\n", m_erasesz, m_addr);
+			m_write_count = (m_erasesz < (1u<<16)) ? tSSE : tSE;
 			m_state = QSPIF_IDLE;
 			m_sreg &= (~QSPIF_WEL_FLAG);
 			m_sreg |= (QSPIF_WIP_FLAG);
-			m_addr &= (-1<<16);
-			for(int i=0; i<(1<<16); i++)
+			m_addr &= ~(m_erasesz-1);
+			for(unsigned i=0; i<m_erasesz; i++)
 				m_mem[m_addr + i] = 0x0ff;
 			if (m_debug) printf("FLASHSIM: Now waiting %d ticks delay\n", m_write_count);
 		} else if (QSPIF_WRSR == m_state) {
@@ -240,17 +269,53 @@ int	FLASHSIM::operator()(const int csn, const int sck, const int dat) {
 				m_mode = FM_SPI;
 			else
 				m_state = QSPIF_DUAL_READ_IDLE;
+		} else if (m_state == QSPIF_SET_BURST) {
+			m_state = QSPIF_IDLE;
+			m_mode  = FM_SPI;
+		} else if (m_state == QSPIF_WRCR2) {
+			// Only address zero, the octal mode, is supported
+			if (m_addr == 0) {
+				m_opi = ((m_cr2 & 3) != 0);
+				m_dtr = ((m_cr2 & 3) == 2);
+				if (m_debug) printf("FLASHSIM: CR2 = %02x, %s\n",
+					m_cr2, (!m_opi) ? "SPI"
+					: ((m_dtr) ? "DTR OCTAL" : "OCTAL"));
+			}
+			m_state = QSPIF_IDLE;
+			m_sreg &= (~QSPIF_WEL_FLAG);
+		} else if (m_state == QSPIF_OCTAL_READ) {
+			m_state = QSPIF_IDLE;
+		} else if (m_state == QSPIF_RESET) {
+			if (m_debug) printf("FLASHSIM: SOFTWARE RESET\n");
+			m_state = QSPIF_IDLE;
+			m_opi = false;
+			m_dtr = false;
+			m_mode = FM_SPI;
+			m_sreg &= (~QSPIF_WEL_FLAG);
 		} else if (m_state == QSPIF_DUAL_READ_IDLE) {
 		} else if (m_state == QSPIF_QUAD_READ_IDLE) {
 		}
 
+		if (m_opi)
+			// Every command starts eight bits at a time
+			m_mode = FM_OSPI;
+		else if (m_mode == FM_SPI) {
+			m_dtr = false;
+			// In QPI mode, the next command comes in four bits
+			// at a time
+			if (m_qpi)
+				m_mode = FM_QSPI;
+		}
+
 		m_oreg = 0x0fe;
 		return dat;
 	} else if ((!m_last_sck)||(sck == m_last_sck)) {
 		// Only change on the falling clock edge
 		// printf("SFLASH-SKIP, CLK=%d -> %d\n", m_last_sck, sck);
 		m_last_sck = sck;
-		if (m_mode == FM_QSPI)
+		if (m_mode == FM_OSPI)
+			return (m_oreg>>8)&0x0ff;
+		else if (m_mode == FM_QSPI)
 			return (m_oreg>>8)&0x0f;
 		else if (m_mode == FM_DSPI)
 			return ((m_oreg>>8)&0x03)|(dat & 0x0c);
@@ -261,7 +326,11 @@ int	FLASHSIM::operator()(const int csn, const int sck, const int dat) {
 	// We'll only get here if ...
 	//	last_sck = 1, and sck = 0, thus transitioning on the
 	//	negative edge as with everything else in this interface
-	if (m_mode == FM_QSPI) {
+	if (m_mode == FM_OSPI) {
+		m_ireg   = (m_ireg << 8) | (dat & 0x0ff);
+		m_count += 8;
+		m_oreg <<= 8;
+	} else if (m_mode == FM_QSPI) {
 		m_ireg   = (m_ireg << 4) | (dat & 0x0f);
 		m_count += 4;
 		m_oreg <<= 4;
@@ -276,12 +345,15 @@ int	FLASHSIM::operator()(const int csn, const int sck, const int dat) {
 	}
 
 	// printf("PROCESS, COUNT = %d, IREG = %02x\n", m_count, m_ireg);
-	if (m_state == QSPIF_QUAD_READ_IDLE) {
+	if (m_mode == FM_OSPI) {
+		opi_process();
+	} else if (m_state == QSPIF_QUAD_READ_IDLE) {
 		// Cannot be in this state and deep power down
 		assert((m_sreg & QSPIF_DEEP_POWER_DOWN_FLAG)==0);
 
 		assert(quad_mode());
 		if (m_count == 24) {
+			check_read();
 			if (m_debug) printf("FLASHSIM: Entering from Quad-Read Idle to Quad-Read\n");
 			if (m_debug) printf("FLASHSIM: QI/O Idle Addr = %02x\n", m_ireg&0x0ffffff);
 			m_addr = (m_ireg) & m_memmask;
@@ -294,6 +366,7 @@ int	FLASHSIM::operator()(const int csn, const int sck, const int dat) {
 
 		assert(dual_mode());
 		if (m_count == 24) {
+			check_read();
 			if (m_debug) printf("DSPI: Entering from Dual-Read Idle to Dual-Read\n");
 			if (m_debug) printf("DSPI: DI/O Idle Addr = %02x\n", m_ireg&0x0ffffff);
 			m_addr = (m_ireg) & m_memmask;
@@ -330,7 +403,15 @@ int	FLASHSIM::operator()(const int csn, const int sck, const int dat) {
 			// Our clock won't support this command, so go
 			// to an invalid state
 			if (m_debug) printf("FLASHSIM: SLOW-READ (single-bit)\n");
+			check_read();
 			m_state = QSPIF_SLOW_READ;
+			m_addr4 = false;
+			break;
+		case 0x13: // Read data bytes, four byte address
+			if (m_debug) printf("FLASHSIM: SLOW-READ (single-bit, 4B)\n");
+			check_read();
+			m_state = QSPIF_SLOW_READ;
+			m_addr4 = true;
 			break;
 		case 0x04: // Write disable
 			m_state = QSPIF_IDLE;
@@ -348,7 +429,15 @@ int	FLASHSIM::operator()(const int csn, const int sck, const int dat) {
 			break;
 		case 0x0b: // Here's the read that we support
 			if (m_debug) printf("FLASHSIM: FAST-READ (single-bit)\n");
+			check_read();
+			m_state = QSPIF_FAST_READ;
+			m_addr4 = false;
+			break;
+		case 0x0c: // Fast read, four byte address
+			if (m_debug) printf("FLASHSIM: FAST-READ (single-bit, 4B)\n");
+			check_read();
 			m_state = QSPIF_FAST_READ;
+			m_addr4 = true;
 			break;
 		case 0x30:
 			if (m_debug) printf("FLASHSIM: CLEAR STATUS REGISTER COMMAND\n");
@@ -364,6 +453,16 @@ int	FLASHSIM::operator()(const int csn, const int sck, const int dat) {
 				if (m_debug) printf("FLASHSIM: pmem = %08lx\n", (unsigned long)m_pmem);
 			}
 			break;
+		case 0x38: // Enter QPI mode
+			if (0 == (m_creg & 0x02)) {
+				if (m_debug) printf("FLASHSIM: QUAD bit not set, cannot enter QPI mode\n");
+				m_state = QSPIF_INVALID;
+			} else {
+				if (m_debug) printf("FLASHSIM: ENTERING QPI MODE\n");
+				m_state = QSPIF_IDLE;
+				m_qpi = true;
+			}
+			break;
 		case 0x35: // Read configuration register
 			m_state = QSPIF_RDCR;
 			if (m_debug) printf("FLASHSIM: READING CONFIGURATION REGISTER: %02x\n", m_creg);
@@ -386,6 +485,31 @@ int	FLASHSIM::operator()(const int csn, const int sck, const int dat) {
 			if (m_debug) printf("FLASHSIM: READING FLAG-STATUS REGISTER\n");
 			QOREG(0);
 			break;
+		case 0x72: // Write configuration register two
+			if (2 != (m_sreg & 0x203)) {
+				if (m_debug) printf("FLASHSIM: WEL not set, cannot write CR2\n");
+				m_state = QSPIF_INVALID;
+			} else
+				m_state = QSPIF_WRCR2;
+			break;
+		case 0x75: // Program/erase suspend
+			if ((m_write_count > 0)&&(!m_suspended)) {
+				if (m_debug) printf("FLASHSIM: SUSPENDING PROGRAM/ERASE\n");
+				m_suspended  = true;
+				m_susp_count = tSUS;
+			} m_state = QSPIF_IDLE;
+			break;
+		case 0x7a: // Program/erase resume
+			if (m_suspended) {
+				if (m_debug) printf("FLASHSIM: RESUMING PROGRAM/ERASE\n");
+				m_suspended = false;
+				m_sreg |= QSPIF_WIP_FLAG;
+			} m_state = QSPIF_IDLE;
+			break;
+		case 0x77: // Set burst with wrap, three dummy bytes then W7-0
+			m_state = QSPIF_SET_BURST;
+			m_mode = FM_QSPI;
+			break;
 		case 0x81: // Write enhanced configuration register
 			QOREG(0);
 			break;
@@ -412,6 +536,7 @@ int	FLASHSIM::operator()(const int csn, const int sck, const int dat) {
 			break;
 		case 0xbb: // Fast Read Dual I/O
 			// printf("QSPI: DUAL-I/O-READ\n");
+			check_read();
 			m_state = QSPIF_DUAL_READ_CMD;
 			m_mode = FM_DSPI;
 			break;
@@ -423,23 +548,40 @@ int	FLASHSIM::operator()(const int csn, const int sck, const int dat) {
 			} else
 				m_state = QSPIF_BULK_ERASE;
 			break;
-		case 0xd8: // Sector Erase
+		case 0x20: // Subsector (4kB) Erase
+		case 0x52: // Block (32kB) Erase
+		case 0xd8: // Sector (64kB) Erase
 			if (2 != (m_sreg & 0x203)) {
 				if (m_debug) printf("FLASHSIM: WEL not set, cannot erase sector\n");
 				m_state = QSPIF_INVALID;
 			} else {
 				m_state = QSPIF_SECTOR_ERASE;
+				m_erasesz = ((m_ireg&0x0ff) == 0x20) ? (1<<12)
+					: (((m_ireg&0x0ff) == 0x52) ? (1<<15) : (1<<16));
 				if (m_debug) printf("FLASHSIM: SECTOR_ERASE COMMAND\n");
 			}
 			break;
 		case 0x0eb: // Here's the (other) read that we support
 			// printf("QSPI: QUAD-I/O-READ\n");
+			check_read();
+			m_state = QSPIF_QUAD_READ_CMD;
+			m_mode = FM_QSPI;
+			m_dtr  = false;
+			break;
+		case 0x0ed: // DTR Quad I/O read, both clock edges
+			if (m_debug) printf("QSPI: DTR QUAD-I/O-READ\n");
+			check_read();
 			m_state = QSPIF_QUAD_READ_CMD;
 			m_mode = FM_QSPI;
+			m_dtr  = true;
 			break;
+		case 0x0ff:	// Exit QPI mode, else a dummy command
+			if ((m_qpi)&&(m_debug))
+				printf("FLASHSIM: EXITING QPI MODE\n");
+			m_qpi = false;
+			// Fall through
 		case 0x000:	// Dummy implementation of CMD 8'h00
 		case 0x031:	// Dummy implementation of CMD 8'h31
-		case 0x0ff:	// Dummy implementation of CMD 8'hff
 			m_state = QSPIF_IDLE;
 			m_mode = FM_SPI;
 			break;
@@ -500,26 +642,28 @@ int	FLASHSIM::operator()(const int csn, const int sck, const int dat) {
 			QOREG(m_creg);
 			break;
 		case QSPIF_SLOW_READ:
-			if (m_count == 32) {
+			if (m_count == ((m_addr4) ? 40u : 32u)) {
 				m_addr = m_ireg & m_memmask;
 				if (m_debug) printf("READ, ADDR = %08x\n", m_addr);
 				assert((m_addr & (~(m_memmask)))==0);
 				// if (m_debug) printf("MEM[%06x] = %02x\n",
 				//	m_addr, m_mem[m_addr]&0x0ff);
 				QOREG(m_mem[m_addr++]);
-			} else if ((m_count >= 40)&&(0 == (m_sreg&0x01))) {
+			} else if ((m_count >= ((m_addr4) ? 48u : 40u))
+					&&(0 == (m_sreg&0x01))) {
 				// if (m_debug) printf("MEM[%06x] = %02x\n",
 				//	m_addr, m_mem[m_addr]&0x0ff);
 				QOREG(m_mem[m_addr++]);
 			} else m_oreg = 0;
 			break;
 		case QSPIF_FAST_READ:
-			if (m_count == 32) {
+			if (m_count == ((m_addr4) ? 40u : 32u)) {
 				m_addr = m_ireg & m_memmask;
 				if (m_debug) printf("FAST READ, ADDR = %08x\n", m_addr);
 				QOREG(0x0c3);
 				assert((m_addr & (~(m_memmask)))==0);
-			} else if ((m_count >= 40)&&(0 == (m_sreg&0x01))) {
+			} else if ((m_count >= ((m_addr4) ? 48u : 40u))
+					&&(0 == (m_sreg&0x01))) {
 				//if (m_count == 40)
 					//printf("DUMMY BYTE COMPLETE ...\n");
 				QOREG(m_mem[m_addr++]);
@@ -545,7 +689,10 @@ int	FLASHSIM::operator()(const int csn, const int sck, const int dat) {
 					m_addr-1, m_oreg);
 			} else m_oreg = 0;
 			break;
-		case QSPIF_QUAD_READ_CMD:
+		case QSPIF_QUAD_READ_CMD: {
+			// In DTR mode, NDUMMY counts clocks of eight bits each
+			const unsigned	ndummy = (m_dtr) ? 2*NDUMMY : NDUMMY;
+
 			// The command to go into quad read mode took 8 bits
 			// that changes the timings, else we'd use quad_Read
 			// below
@@ -557,35 +704,37 @@ int	FLASHSIM::operator()(const int csn, const int sck, const int dat) {
 			} else if (m_count == 32+8) {
 				m_mode_byte = (m_ireg) & 0x0ff;
 				if (m_debug) printf("QSPI: MODE BYTE = %02x\n", m_mode_byte);
-				if (NDUMMY == 2)
-					QOREG(m_mem[m_addr++]);
-			} else if ((m_count > 32+4*NDUMMY)&&(0 == (m_sreg&0x01))) {
-				QOREG(m_mem[m_addr++]);
+				if (ndummy == 2)
+					QOREG(m_mem[quad_rdaddr()]);
+			} else if ((m_count > 32+4*ndummy)&&(0 == (m_sreg&0x01))) {
+				QOREG(m_mem[quad_rdaddr()]);
 				// printf("QSPIF[%08x]/QR = %02x\n",
 					// m_addr-1, m_oreg);
 			} else m_oreg = 0;
-			break;
+			} break;
 		case QSPIF_DUAL_READ:
 			if (m_count == 32) {
 				m_mode_byte = (m_ireg & 0x0ff);
 				if (m_debug) printf("DSPI/DR: MODE BYTE = %02x\n", m_mode_byte);
 			}
-			QOREG(m_mem[m_addr++]);
+			QOREG(m_mem[quad_rdaddr()]);
 			if (m_debug) printf("DSPIF[%08x]/DR = %02x\n", m_addr-1, m_oreg & 0x0ff);
 			break;
-		case QSPIF_QUAD_READ:
+		case QSPIF_QUAD_READ: {
+			const unsigned	ndummy = (m_dtr) ? 2*NDUMMY : NDUMMY;
+
 			if (m_count == 24+4*2) {
 				m_mode_byte = (m_ireg & 0x0ff);
 				if (m_debug) printf("QSPI/QR: MODE BYTE = %02x\n", m_mode_byte);
-				if (NDUMMY == 2) {
-					QOREG(m_mem[m_addr++]);
+				if (ndummy == 2) {
+					QOREG(m_mem[quad_rdaddr()]);
 					if (m_debug) printf("QSPIF[%08x]/QR = %02x\n", m_addr-1, m_oreg & 0x0ff);
 				}
-			} else if ((m_count >= 24+4*NDUMMY)&&(0 == (m_sreg&0x01))) {
-				QOREG(m_mem[m_addr++]);
+			} else if ((m_count >= 24+4*ndummy)&&(0 == (m_sreg&0x01))) {
+				QOREG(m_mem[quad_rdaddr()]);
 				// if (m_debug) printf("QSPIF[%08x]/QR = %02x\n", m_addr-1, m_oreg & 0x0ff);
 			} else m_oreg = 0;
-			break;
+			} break;
 		case QSPIF_PP:
 			if (m_count == 32) {
 				m_addr = m_ireg & m_memmask;
@@ -615,10 +764,27 @@ int	FLASHSIM::operator()(const int csn, const int sck, const int dat) {
 			} break;
 		case QSPIF_SECTOR_ERASE:
 			if (m_count == 32) {
-				m_addr = m_ireg & 0x0ffc000;
+				m_addr = m_ireg & 0x0fff000;
 				if (m_debug) printf("SECTOR_ERASE ADDRESS = %08x\n", m_addr);
 				assert((m_addr & 0xfc00000)==0);
 			} break;
+		case QSPIF_WRCR2:
+			// Four address bytes, then the register value
+			if (m_count == 40)
+				m_addr = m_ireg;
+			else if (m_count == 48)
+				m_cr2 = m_ireg & 0x0ff;
+			break;
+		case QSPIF_SET_BURST:
+			if (m_count == 40) {
+				// W4 set disables wrapping, else W6-5 select
+				// an 8, 16, 32, or 64 byte burst
+				if (m_ireg & 0x010)
+					m_wrapsz = 0;
+				else
+					m_wrapsz = 8 << ((m_ireg >> 5)&3);
+				if (m_debug) printf("FLASHSIM: WRAP LENGTH = %d\n", m_wrapsz);
+			} break;
 		case QSPIF_RELEASE:
 			if (m_count >= 32) {
 				QOREG(DEVESD);
@@ -629,7 +795,9 @@ int	FLASHSIM::operator()(const int csn, const int sck, const int dat) {
 	} // else printf("SFLASH->count = %d\n", m_count);
 
 	m_last_sck = sck;
-	if (m_mode == FM_QSPI)
+	if (m_mode == FM_OSPI)
+		return (m_oreg>>8)&0x0ff;
+	else if (m_mode == FM_QSPI)
 		return (m_oreg>>8)&0x0f;
 	else if (m_mode == FM_DSPI)
 		return ((m_oreg>>8)&0x03)|(dat & 0x0c);
@@ -637,6 +805,206 @@ int	FLASHSIM::operator()(const int csn, const int sck, const int dat) {
 		return ((m_oreg & 0x0100)?2:0)|(dat & 0x0d);
 }
 
+//
+// opi_process
+//
+// Handle one byte of an octal (OPI) transaction.  Every octal command is
+// two bytes, the command followed by its complement, and most are then
+// followed by a four byte address.  Dummy cycles are counted in clocks, and
+// so in DTR mode each is worth two bytes.
+//
+void	FLASHSIM::opi_process(void) {
+	const unsigned	cmd = (m_ireg >> 8) & 0x0ff,
+			nclk = (m_dtr) ? 16 : 8;
+
+	if (m_count == 8) {
+		QOREG(0);
+	} else if (m_count == 16) {
+		QOREG(0);
+		if (((m_ireg ^ cmd) & 0x0ff) != 0x0ff) {
+			printf("FLASHSIM: INVALID OCTAL COMMAND: %02x,%02x\n",
+				cmd, m_ireg & 0x0ff);
+			m_state = QSPIF_INVALID;
+			assert(0 && "Octal command not followed by its complement\n");
+			return;
+		}
+
+		if (m_debug) printf("OPI FLASH CMD %02x\n", cmd);
+		if (cmd != 0x99)
+			m_rsten = false;
+		switch(cmd) {
+		case 0x04: // Write disable
+			m_state = QSPIF_IDLE;
+			m_sreg &= (~QSPIF_WEL_FLAG);
+			break;
+		case 0x05: // Read status register
+			m_state = QSPIF_RDSR;
+			break;
+		case 0x06: // Write enable
+			m_state = QSPIF_IDLE;
+			m_sreg |= QSPIF_WEL_FLAG;
+			if (m_debug) printf("FLASHSIM: WRITE-ENABLE COMMAND ACCEPTED\n");
+			break;
+		case 0x12: // Page program, four byte address
+			if (2 != (m_sreg & 0x203)) {
+				if (m_debug) printf("FLASHSIM: Cannot program at this time, SREG = %x\n", m_sreg);
+				m_state = QSPIF_INVALID;
+			} else
+				m_state = QSPIF_PP;
+			break;
+		case 0x21: // Subsector (4kB) Erase, four byte address
+		case 0xdc: // Sector (64kB) Erase, four byte address
+			if (2 != (m_sreg & 0x203)) {
+				if (m_debug) printf("FLASHSIM: WEL not set, cannot erase sector\n");
+				m_state = QSPIF_INVALID;
+			} else {
+				m_state = QSPIF_SECTOR_ERASE;
+				m_erasesz = (cmd == 0x21) ? (1<<12) : (1<<16);
+			}
+			break;
+		case 0x60: // Bulk Erase
+		case 0xc7:
+			if (2 != (m_sreg & 0x203)) {
+				if (m_debug) printf("FLASHSIM: WEL not set, cannot erase device\n");
+				m_state = QSPIF_INVALID;
+			} else
+				m_state = QSPIF_BULK_ERASE;
+			break;
+		case 0x66: // Reset enable
+			m_state = QSPIF_IDLE;
+			m_rsten = true;
+			break;
+		case 0x72: // Write configuration register two
+			if (2 != (m_sreg & 0x203)) {
+				if (m_debug) printf("FLASHSIM: WEL not set, cannot write CR2\n");
+				m_state = QSPIF_INVALID;
+			} else
+				m_state = QSPIF_WRCR2;
+			break;
+		case 0x99: // Reset, following a reset enable
+			m_state = (m_rsten) ? QSPIF_RESET : QSPIF_IDLE;
+			m_rsten = false;
+			break;
+		case 0x9f: // Read ID
+			m_state = QSPIF_RDID;
+			m_addr = 0;
+			break;
+		case 0xec: // Octal read
+		case 0xee: // DTR octal read
+			if ((cmd == 0xee) != m_dtr) {
+				printf("FLASHSIM: OCTAL READ %02x DOESN'T MATCH THE MODE\n", cmd);
+				m_state = QSPIF_INVALID;
+				assert(0 && "Octal read in the wrong mode\n");
+			} else
+				m_state = QSPIF_OCTAL_READ;
+			break;
+		default:
+			printf("FLASHSIM: UNRECOGNIZED OPI FLASH CMD: %02x\n", cmd);
+			m_state = QSPIF_INVALID;
+			assert(0 && "Unrecognized command\n");
+			break;
+		}
+	} else {
+		QOREG(0);
+		if (m_count == 48) {
+			// Four address bytes
+			m_addr = m_ireg & m_memmask;
+			if (m_debug) printf("FLASHSIM: OPI ADDR = %08x\n", m_addr);
+			if (m_state == QSPIF_SECTOR_ERASE)
+				m_addr &= ~(m_erasesz-1);
+			else if (m_state == QSPIF_PP) {
+				for(int i=0; i<256; i++)
+					m_pmem[i] = 0x0ff;
+			} else if (m_state == QSPIF_RDID)
+				m_addr = 0;
+		}
+
+		switch(m_state) {
+		case QSPIF_RDSR:
+			if (m_count >= 48 + nclk * FLASH_OPI_REGDUMMY)
+				QOREG(m_sreg);
+			break;
+		case QSPIF_RDID:
+			if (m_count >= 48 + nclk * FLASH_OPI_REGDUMMY) {
+				QOREG(DEVID >> (24-8*(m_addr&3)));
+				m_addr++;
+			} break;
+		case QSPIF_OCTAL_READ:
+			if ((m_count >= 48 + nclk * NDUMMY)
+					&&(0 == (m_sreg&0x01)))
+				QOREG(m_mem[m_addr++ & m_memmask]);
+			break;
+		case QSPIF_PP:
+			if (m_count > 48) {
+				m_pmem[m_addr & 0x0ff] = m_ireg & 0x0ff;
+				m_addr = (m_addr & (~0x0ff)) | ((m_addr+1)&0x0ff);
+			} break;
+		case QSPIF_WRCR2:
+			if (m_count == 56)
+				m_cr2 = m_ireg & 0x0ff;
+			break;
+		case QSPIF_SECTOR_ERASE:
+		case QSPIF_BULK_ERASE:
+			break;
+		default:
+			if ((m_debug)&&(!m_idle_throttle))
+				printf("TOO MANY CLOCKS, OPI FLASH IN IDLE\n");
+			m_idle_throttle = true;
+			break;
+		}
+	}
+}
+
+//
+// dtrtick
+//
+// Drive the flash from a DTR capable controller, whose data pins carry two
+// nibbles per clock.  On a falling edge in DTR mode, the first nibble is
+// processed as though it were clocked alone, and then the second, so that
+// all of the (single rate) counts above remain valid--they just advance
+// twice as fast.
+//
+int	FLASHSIM::dtrtick(const int csn, const int sck, const int dat) {
+	int	r;
+
+	if ((!m_dtr)||(csn)||(sck)||(!m_last_sck)) {
+		r = (*this)(csn, sck, dat & 0x0f) & 0x0f;
+		if (m_dtr)
+			return (m_dtr_hi << 4) | r;
+		return (r << 4) | r;
+	}
+
+	m_dtr_hi = (*this)(csn, 0, (dat >> 4) & 0x0f) & 0x0f;
+	(*this)(csn, 1, dat & 0x0f);
+	r = (*this)(csn, 0, dat & 0x0f) & 0x0f;
+
+	return (m_dtr_hi << 4) | r;
+}
+
+//
+// odtrtick
+//
+// The same as dtrtick, but for an octal flash in its DTR mode: two bytes per
+// clock, the first in [15:8] and the second in [7:0].
+//
+int	FLASHSIM::odtrtick(const int csn, const int sck, const int dat) {
+	const bool	dtr = (m_dtr)&&(m_mode == FM_OSPI);
+	int	r;
+
+	if ((!dtr)||(csn)||(sck)||(!m_last_sck)) {
+		r = (*this)(csn, sck, dat & 0x0ff) & 0x0ff;
+		if (dtr)
+			return (m_dtr_hi << 8) | r;
+		return (r << 8) | r;
+	}
+
+	m_dtr_hi = (*this)(csn, 0, (dat >> 8) & 0x0ff) & 0x0ff;
+	(*this)(csn, 1, dat & 0x0ff);
+	r = (*this)(csn, 0, dat & 0x0ff) & 0x0ff;
+
+	return (m_dtr_hi << 8) | r;
+}
+
 //
 // simtick
 //
@@ -54,6 +54,11 @@
 #define	FLASH_RDDELAY	0
 #endif
 
+// Octal (OPI) register reads, RDSR and RDID, need their own dummy cycles
+#ifndef	FLASH_OPI_REGDUMMY
+#define	FLASH_OPI_REGDUMMY	4
+#endif
+
 #define	QSPIF_WIP_FLAG			0x0001
 #define	QSPIF_WEL_FLAG			0x0002
 #define	QSPIF_DEEP_POWER_DOWN_FLAG	0x0200
@@ -80,13 +85,19 @@ class	FLASHSIM {
 		QSPIF_DUAL_READ_IDLE,
 		QSPIF_DUAL_READ_CMD,
 		QSPIF_DUAL_READ,
+		QSPIF_SET_BURST,
+		// Octal SPI states
+		QSPIF_WRCR2,
+		QSPIF_OCTAL_READ,
+		QSPIF_RESET,
 		QSPIF_INVALID
 	} QSPIF_STATE;
 
 	typedef	enum {
 		FM_SPI,
 		FM_DSPI,
-		FM_QSPI
+		FM_QSPI,
+		FM_OSPI
 	} FLASH_MODE;
 
 	QSPIF_STATE	m_state;
@@ -94,14 +105,51 @@ class	FLASHSIM {
 	int		m_last_sck;
 	unsigned	m_write_count, m_ireg, m_oreg, m_sreg, m_addr,
 			m_count, m_config, m_mode_byte, m_creg, m_membytes,
-			m_memmask;
+			m_memmask, m_wrapsz, m_erasesz;
 	bool		m_debug, m_idle_throttle;
 	FLASH_MODE	m_mode;
+	// Set while addresses and data move on both clock edges, following
+	// a 0xED (DTR quad I/O read) command
+	bool		m_dtr;
+	int		m_dtr_hi;
+	// Set while in QPI (4-4-4) mode, following a 0x38 command.  Every
+	// command, not just the quad reads, then starts in FM_QSPI
+	bool		m_qpi;
+	// Set while in an octal (OPI) mode, following a write to
+	// configuration register two.  m_dtr then selects DTR octal.
+	bool		m_opi, m_rsten;
+	unsigned	m_cr2;
+	// Set while a program or erase has been suspended (0x75).  The flash
+	// may only be read once m_susp_count has counted down to zero.  Reads
+	// started while a program or erase is active are counted in
+	// m_busy_reads, since on real hardware they'd return garbage.
+	bool		m_suspended;
+	unsigned	m_susp_count, m_busy_reads;
+	// Set by the four byte address single SPI reads, 0x13 and 0x0c
+	bool		m_addr4;
 
 	const	unsigned	CKDELAY, RDDELAY, NDUMMY;
 
 	int		*m_ckdelay, *m_rddelay;
 
+	// Return the next quad read address, and advance it--wrapping within
+	// the burst length if one has been set by the 0x77 command
+	unsigned	quad_rdaddr(void) {
+		unsigned	a = m_addr;
+
+		if (m_wrapsz)
+			m_addr = (a & ~(m_wrapsz-1)) | ((a+1)&(m_wrapsz-1));
+		else
+			m_addr = a+1;
+		return a;
+	}
+
+	// Process one octal byte, following its falling edge
+	void	opi_process(void);
+
+	// Check whether a read may start now
+	void	check_read(void);
+
 public:
 	FLASHSIM(const int lglen = 24, bool debug = false,
 		const int rddelay = FLASH_RDDELAY,
@@ -116,6 +164,11 @@ public:
 	bool	deep_sleep(void) const;
 	bool	dual_mode(void) { return (m_mode == FM_DSPI); }
 	bool	quad_mode(void) { return (m_mode == FM_QSPI); }
+	bool	dtr_mode(void) { return (m_dtr); }
+	bool	qpi_mode(void) { return (m_qpi); }
+	bool	opi_mode(void) { return (m_opi); }
+	bool	suspended(void) { return (m_suspended); }
+	unsigned busy_reads(void) const { return m_busy_reads; }
 	void	debug(const bool dbg) { m_debug = dbg; }
 	bool	debug(void) const { return m_debug; }
 	unsigned operator[](const int index) {
@@ -136,6 +189,16 @@ public:
 		return;}
 	int	operator()(const int csn, const int sck, const int dat);
 
+	// dtrtick accepts and returns eight bits of data: [7:4] from the
+	// first half of the clock, [3:0] from the second.  While in DTR mode,
+	// both nibbles are processed on every falling edge.  Otherwise, the
+	// single rate nibble is taken from [3:0] and returned in both halves.
+	int	dtrtick(const int csn, const int sck, const int dat);
+
+	// odtrtick is the octal equivalent of dtrtick: sixteen bits of data,
+	// [15:8] from the first half of the clock and [7:0] from the second.
+	int	odtrtick(const int csn, const int sck, const int dat);
+
 	// simtick applies various programmable delays to the inputs in 
 	// order to determine the outputs.  It's primary purpose is to
 	// support an ODDR based clock (and or other) components.
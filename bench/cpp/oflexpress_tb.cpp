@@ -0,0 +1,452 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	oflexpress_tb.cpp
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	To exercise the octal SPI flash controller, oflexpress, against
+//		the octal (OPI) extension of the FLASHSIM model.  Two
+//	controllers are built from the same source--one with OPT_DTR set, one
+//	without--and each is attached to its own FLASHSIM model holding the
+//	same data.  The test
+//
+//	1. Checks that each controller's startup sequence leaves its flash in
+//	   the matching octal mode, DTR or not
+//	2. Reads single words from both controllers
+//	3. Reads a long burst from both, and requires the DTR read to take
+//	   no more than 60% of the clocks taken by the single rate read
+//	4. Reads the flash's ID, then erases and programs each flash through
+//	   the configuration port--all in octal--and reads back the result
+//
+//	Run the simulation program this with no arguments, and then check
+//	whether or not the last line contains "SUCCESS" or not.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2015-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#include <stdlib.h>
+#include "verilated.h"
+#include "Voflexpress.h"
+#include "Voflexpresssdr.h"
+#include "byteswap.h"
+#include "flashsim.h"
+#include "wbflash_tb.h"
+
+#define	LGFLASHSZB	24
+// The number of dummy clocks the controllers are built with
+#define	OCTAL_NDUMMY	20
+
+#define NPAGES		256
+#define SZPAGEB		256
+#define PGLENB		SZPAGEB
+#define SZPAGEW		(SZPAGEB>>2)
+#define SECTORSZW	(NPAGES * SZPAGEW)
+#define SECTORSZB	(NPAGES * SZPAGEB)
+#define	PAGEOF(A)	((A)&(-1<< 8))
+
+#define	NSINGLE		64
+#define	LONGBURST	256
+
+static const unsigned	CFG_USERMODE  = 0x1000,
+	     		CFG_OSPEED    = 0x0800, // Octal I/O
+	     		CFG_WEDIR     = 0x0200, // Write
+	     		CFG_USER_CS_n = 0x0100;
+
+static const unsigned	F_END   = (CFG_USERMODE|CFG_USER_CS_n);
+
+// Octal (OPI) commands, each followed by its complement
+static const unsigned	O_WRDI = 0x04,
+			O_RDSR = 0x05,
+			O_WREN = 0x06,
+			O_PP   = 0x12,
+			O_SSE  = 0x21,	// 4kB erase, four byte address
+			O_RDID = 0x9f;
+
+template <class VA>	class	OFLEX_TB : public WBFLASH_TB<VA> {
+protected:
+	FLASHSIM	*m_flash;
+	int		m_lastsck;
+	// Set if the controller was built with OPT_DTR, and so moves two
+	// bytes per clock, one on each edge
+	bool		m_dtrio;
+public:
+	bool		m_writeout;
+
+	OFLEX_TB(bool dtrio) {
+		// {{{
+		m_flash = new FLASHSIM(LGFLASHSZB, false, 0, OCTAL_NDUMMY);
+		m_lastsck = 0;
+		m_dtrio = dtrio;
+		m_writeout = false;
+		// }}}
+	}
+
+	virtual	~OFLEX_TB(void) {
+		delete	m_flash;
+	}
+
+	unsigned operator[](const int index) { return (*m_flash)[index]; }
+
+	void	set(const unsigned addr, const unsigned val) {
+		m_flash->set(addr, val);
+	}
+
+	bool	opi_mode(void) { return m_flash->opi_mode(); }
+	bool	dtr_mode(void) { return m_flash->dtr_mode(); }
+
+	virtual	void	tick(void) {
+		// {{{
+		VA	*core = TESTB<VA>::m_core;
+		int	iospi;
+
+		if (m_dtrio) {
+			// Two bytes per clock: [15:8], then [7:0]
+			if (m_lastsck)
+				m_flash->odtrtick(core->o_ospi_cs_n, 0,
+					core->o_ospi_dat);
+			iospi = m_flash->odtrtick(core->o_ospi_cs_n, 1,
+					core->o_ospi_dat);
+		} else {
+			if (m_lastsck)
+				(*m_flash)(core->o_ospi_cs_n, 0,
+					core->o_ospi_dat);
+			iospi = (*m_flash)(core->o_ospi_cs_n, 1,
+					core->o_ospi_dat);
+		}
+
+		if (core->o_ospi_mod&2) {
+			if (core->o_ospi_mod&1) {
+				; // Octal read, the input is as given
+			} else
+				iospi = core->o_ospi_dat;
+		} else {
+			// MISO is bit one of each half
+			const int	miso = (m_dtrio) ? 0x0202 : 0x02;
+
+			iospi &= miso;
+			iospi |= core->o_ospi_dat & ~miso;
+		}
+
+		core->i_ospi_dat = iospi;
+		m_lastsck = core->o_ospi_sck;
+
+		if (m_writeout) {
+			printf("%08lx-OSPI: %s %s MOD=%d O=%04x I=%04x\n",
+				TESTB<VA>::m_tickcount,
+				(core->o_ospi_cs_n)?"   ":"CSN",
+				(core->o_ospi_sck)?"SCK":"   ",
+				core->o_ospi_mod, core->o_ospi_dat, iospi);
+		}
+
+		WBFLASH_TB<VA>::tick();
+		// }}}
+	}
+
+	// opiwrite, opicmd, opiaddr, opidummy, opiread
+	// {{{
+	// Send two bytes at octal speed.  In DTR mode, both go out in a
+	// single clock--the second from bits [23:16] of the configuration
+	// word.
+	void	opiwrite(unsigned b0, unsigned b1) {
+		const unsigned	w = CFG_USERMODE | CFG_OSPEED | CFG_WEDIR;
+
+		if (m_dtrio)
+			this->cfg_write(w | (b0 & 0x0ff) | ((b1 & 0x0ff)<<16));
+		else {
+			this->cfg_write(w | (b0 & 0x0ff));
+			this->cfg_write(w | (b1 & 0x0ff));
+		}
+	}
+
+	// Start a new command: the command byte and its complement
+	void	opicmd(unsigned cmd) {
+		this->cfg_write(F_END);
+		opiwrite(cmd, ~cmd);
+	}
+
+	void	opiaddr(unsigned addr) {
+		opiwrite(addr >> 24, addr >> 16);
+		opiwrite(addr >>  8, addr);
+	}
+
+	void	opidummy(int nclocks) {
+		for(int k=0; k<nclocks; k++)
+			this->cfg_write(CFG_USERMODE | CFG_OSPEED | CFG_WEDIR);
+	}
+
+	// Read one clock's worth of data: two bytes in DTR mode, else one
+	unsigned opiread(void) {
+		unsigned	v;
+
+		this->cfg_write(CFG_USERMODE | CFG_OSPEED);
+		v = this->cfg_read();
+		if (m_dtrio)
+			return ((v & 0x0ff)<<8) | ((v >> 16) & 0x0ff);
+		return v & 0x0ff;
+	}
+	// }}}
+
+	unsigned flreadid(void) {
+		// {{{
+		unsigned	r = 0;
+
+		opicmd(O_RDID);
+		opiaddr(0);
+		opidummy(FLASH_OPI_REGDUMMY);
+		if (m_dtrio) {
+			r = opiread();
+			r = (r << 16) | opiread();
+		} else for(int k=0; k<4; k++)
+			r = (r << 8) | opiread();
+		this->cfg_write(F_END);
+		this->cfg_write(0);
+
+		return r;
+		// }}}
+	}
+
+	int	flstatus(void) {
+		// {{{
+		unsigned	v;
+
+		opicmd(O_RDSR);
+		opiaddr(0);
+		opidummy(FLASH_OPI_REGDUMMY);
+		v = opiread() & 0x0ff;
+		this->cfg_write(F_END);
+		this->cfg_write(0);
+		return v;
+		// }}}
+	}
+
+	void	flwait(void) {
+		// {{{
+		opicmd(O_RDSR);
+		opiaddr(0);
+		opidummy(FLASH_OPI_REGDUMMY);
+		while(opiread() & 1)
+			; // Wait while the device is busy
+		this->cfg_write(F_END);
+		// }}}
+	}
+
+	void	flerase(unsigned sectoraddr) {
+		// {{{
+		opicmd(O_WREN);
+		this->cfg_write(F_END);
+
+		opicmd(O_SSE);
+		opiaddr(sectoraddr);
+		this->cfg_write(F_END);
+
+		flwait();
+		this->cfg_write(0);
+		// }}}
+	}
+
+	void	flpage_program(unsigned addr, int ln, const char *buf) {
+		// {{{
+		opicmd(O_WREN);
+		this->cfg_write(F_END);
+
+		opicmd(O_PP);
+		opiaddr(addr);
+		// Write the page data itself, two bytes at a time.  Should
+		// the length be odd, programming an extra 0xff won't change
+		// anything.
+		for(int i=0; i<ln; i+=2)
+			opiwrite(buf[i], (i+1 < ln) ? buf[i+1] : 0x0ff);
+		this->cfg_write(F_END);
+
+		flwait();
+		// }}}
+	}
+
+	void	flprogram(unsigned addr, int ln, const char *buf) {
+		// {{{
+		unsigned	start = addr;
+
+		while(start < addr + ln) {
+			int	wlen;
+
+			if (PAGEOF(addr+ln-1)!=PAGEOF(start))
+				wlen = PAGEOF(start+PGLENB)-start;
+			else
+				wlen = addr+ln-start;
+
+			flpage_program(start, wlen, &buf[start-addr]);
+			start = PAGEOF(start+PGLENB);
+		}
+
+		opicmd(O_WRDI);
+		this->cfg_write(F_END);
+		this->cfg_write(0);
+		// }}}
+	}
+};
+
+// cfgtest
+// {{{
+// Read the ID, then erase a sector and program a word within it, all through
+// the configuration port
+template<class TB>	bool	cfgtest(TB *tb, const char *name) {
+	unsigned	rdv;
+
+	rdv = tb->flreadid();
+	printf("%s: ID     Register = 0x%08x\n", name, rdv);
+	{	extern const unsigned DEVID;
+		if (rdv != DEVID) {
+			printf("BOMB(%s): ID read %08x, expected %08x\n",
+				name, rdv, DEVID);
+			return false;
+		}
+	}
+
+	rdv = tb->flstatus();
+	printf("%s: Status Register = 0x%02x\n", name, rdv);
+	if (rdv & 1) {
+		printf("BOMB(%s): The flash is busy\n", name);
+		return false;
+	}
+
+	tb->flerase(SECTORSZB);
+	for(int k=0; k<16; k++) {
+		rdv = tb->wb_read(SECTORSZB + 4*k);
+		if (rdv != 0xffffffff) {
+			printf("BOMB(%s): READ[%08x] %08x after erase\n",
+				name, SECTORSZB+4*k, rdv);
+			return false;
+		}
+	}
+
+	{	char	buf[4];
+		buf[0] = 0x12;
+		buf[1] = 0x34;
+		buf[2] = 0x56;
+		buf[3] = 0x78;
+		tb->flprogram(SECTORSZB+4, 4, buf);
+	}
+
+	if ((*tb)[SECTORSZW+1] != 0x12345678) {
+		printf("BOMB(%s): The flash was not programmed\n", name);
+		return false;
+	}
+	if (!checkread(tb, name, SECTORSZW+1))
+		return false;
+	if (!tb->opi_mode()) {
+		printf("BOMB(%s): The flash left its octal mode\n", name);
+		return false;
+	}
+
+	return !tb->bombed();
+}
+// }}}
+
+int main(int  argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	OFLEX_TB<Voflexpresssdr>	*sdr = new OFLEX_TB<Voflexpresssdr>(false);
+	OFLEX_TB<Voflexpress>		*dtr = new OFLEX_TB<Voflexpress>(true);
+	unsigned long		sdrclocks, dtrclocks;
+
+	dtr->opentrace("oflexpress.vcd");
+
+	srand(0x3456);
+	for(int i=0; i<2*SECTORSZW; i++) {
+		unsigned v = rand();
+		sdr->set(i, v);
+		dtr->set(i, v);
+	}
+
+	// 1. Startup
+	// {{{
+	if ((!startup(sdr))||(!startup(dtr)))
+		goto test_failure;
+
+	if ((!sdr->opi_mode())||(sdr->dtr_mode())) {
+		printf("BOMB: The SDR flash is not in its octal mode following startup\n");
+		goto test_failure;
+	}
+
+	if ((!dtr->opi_mode())||(!dtr->dtr_mode())) {
+		printf("BOMB: The DTR flash is not in its DTR octal mode following startup\n");
+		goto test_failure;
+	}
+	printf("Startup completed\n");
+	// }}}
+
+	// 2. Single word reads
+	// {{{
+	for(int k=0; k<NSINGLE; k++) {
+		unsigned a = rand() % (2*SECTORSZW);
+
+		if (!checkread(sdr, "SDR", a))
+			goto test_failure;
+		if (!checkread(dtr, "DTR", a))
+			goto test_failure;
+	}
+	printf("Single word reads:  PASS\n");
+	// }}}
+
+	// 3. Burst throughput
+	// {{{
+	sdrclocks = burstread(sdr, "SDR", SECTORSZW, LONGBURST);
+	dtrclocks = burstread(dtr, "DTR", SECTORSZW, LONGBURST);
+	if ((sdrclocks == 0)||(dtrclocks == 0))
+		goto test_failure;
+
+	printf("%d words: %ld clocks using DTR, %ld clocks without\n",
+		LONGBURST, dtrclocks, sdrclocks);
+	if (dtrclocks * 10 > sdrclocks * 6) {
+		printf("BOMB: The DTR read was not (much) faster\n");
+		goto test_failure;
+	}
+	// }}}
+
+	// 4. The configuration port
+	// {{{
+	if ((!cfgtest(sdr, "SDR"))||(!cfgtest(dtr, "DTR")))
+		goto test_failure;
+	printf("Configuration port: PASS\n");
+	// }}}
+
+	if ((sdr->bombed())||(dtr->bombed()))
+		goto test_failure;
+
+	printf("SUCCESS!!\n");
+	exit(EXIT_SUCCESS);
+test_failure:
+	printf("FAIL-HERE\n");
+	for(int i=0; i<8; i++)
+		dtr->tick();
+	printf("TEST FAILED\n");
+	exit(EXIT_FAILURE);
+}
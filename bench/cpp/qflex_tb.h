@@ -0,0 +1,336 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	qflex_tb.h
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	A generic test bench class for any core presenting the
+//		qflexpress port list--either qflexpress itself, or one of
+//	the front ends (prefetch, cache, etc) wrapped around it within
+//	bench/rtl.  The class connects the core to a FLASHSIM model, and then
+//	provides the basic flash commands (status, ID, erase, program) found
+//	in qflexpress_tb.cpp, so that the front-end test benches don't need to
+//	repeat them.
+//
+//	The bus itself comes from the BASE class, which needs to provide
+//	cfg_write() and cfg_read() for the configuration port.  This is
+//	normally WBFLASH_TB, but may be any other bus model (such as the AXI
+//	master of axi_tb.h) for a core with the same QSPI pins.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2015-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#ifndef	QFLEX_TB_H
+#define	QFLEX_TB_H
+
+#include "flashsim.h"
+#include "wbflash_tb.h"
+
+#define	LGFLASHSZB	24
+
+#define NPAGES		256
+#define SZPAGEB		256
+#define PGLENB		SZPAGEB
+#define SZPAGEW		(SZPAGEB>>2)
+#define PGLENW		SZPAGEW
+#define SECTORSZW	(NPAGES * SZPAGEW)
+#define SECTORSZB	(NPAGES * SZPAGEB)
+#define	RDBUFSZ		(NPAGES * SZPAGEW)
+#define	NSECTORS	((1<<LGFLASHSZB)/SECTORSZB)
+#define	SECTOROF(A)	((A)&(-1<<16))
+#define	SUBSECTOROF(A)	((A)&(-1<<12))
+#define	PAGEOF(A)	((A)&(-1<< 8))
+
+static const unsigned	CFG_USERMODE  = 0x1000,
+	     		CFG_QSPEED    = 0x0800, // Quad I/O
+	     		CFG_DSPEED    = 0x0400, // Dual I/O
+	     		CFG_WEDIR     = 0x0200, // Write
+	     		CFG_USER_CS_n = 0x0100;
+
+static const unsigned	F_RESET = (CFG_USERMODE|0x0ff),
+			F_EMPTY = (CFG_USERMODE|0x000),
+			F_WRR   = (CFG_USERMODE|0x001),
+			F_PP    = (CFG_USERMODE|0x002),
+			F_QPP   = (CFG_USERMODE|0x032),
+			F_READ  = (CFG_USERMODE|0x003),
+			F_WRDI  = (CFG_USERMODE|0x004),
+			F_RDSR1 = (CFG_USERMODE|0x005),
+			F_WREN  = (CFG_USERMODE|0x006),
+			F_MFRID = (CFG_USERMODE|0x09f),
+			F_SE    = (CFG_USERMODE|0x0d8),
+			F_END   = (CFG_USERMODE|CFG_USER_CS_n);
+static const unsigned	F_READID = F_MFRID,
+	     		F_RDSR   = F_RDSR1;
+
+template <class VA, class BASE = WBFLASH_TB<VA> >
+		class	QFLEX_TB : public BASE {
+protected:
+	FLASHSIM	*m_flash;
+	int		m_lastsck;
+public:
+	bool		m_writeout;
+	// Set when the controller leaves the flash in QPI (4-4-4) mode, so
+	// that every byte through the configuration port--opcodes included--
+	// must be sent at quad speed
+	bool		m_qpi;
+
+	QFLEX_TB(void) {
+		// {{{
+		m_flash = new FLASHSIM(LGFLASHSZB);
+		m_lastsck = 0;
+		m_writeout = false;
+		m_qpi = false;
+		// }}}
+	}
+
+	// cfgcmd, cfgrd
+	// {{{
+	// The configuration word to send a command (or address, or data)
+	// byte, and to read one
+	unsigned cfgcmd(const unsigned v) const {
+		return (m_qpi) ? (v | CFG_QSPEED | CFG_WEDIR) : v; }
+	unsigned cfgrd(void) const {
+		return (m_qpi) ? (CFG_USERMODE | CFG_QSPEED) : CFG_USERMODE; }
+	// }}}
+
+	virtual	~QFLEX_TB(void) {
+		delete	m_flash;
+	}
+
+	unsigned operator[](const int index) { return (*m_flash)[index]; }
+
+	void	load(const char *fname) {
+		m_flash->load(0,fname);
+	}
+
+	void	set(const unsigned addr, const unsigned val) {
+		m_flash->set(addr, val);
+	}
+
+	virtual	void	tick(void) {
+		// {{{
+		VA	*core = TESTB<VA>::m_core;
+		int	iqspi;
+
+		if (m_lastsck)
+			(*m_flash)(core->o_qspi_cs_n, 0, core->o_qspi_dat);
+
+		iqspi = (*m_flash)(core->o_qspi_cs_n, 1, core->o_qspi_dat);
+
+		if (core->o_qspi_mod&2) {
+			if (core->o_qspi_mod&1) {
+				; // IDSPI is as given
+			} else
+				iqspi = core->o_qspi_dat;
+		} else {
+			iqspi &= 0x02;
+			iqspi |= core->o_qspi_dat&1;
+			iqspi |= core->o_qspi_dat&0x0c;
+		}
+
+		core->i_qspi_dat = iqspi;
+		m_lastsck = core->o_qspi_sck;
+
+		if (m_writeout) {
+			printf("%08lx-QSPI: %s %s MOD=%d O=%x I=%x\n",
+				TESTB<VA>::m_tickcount,
+				(core->o_qspi_cs_n)?"   ":"CSN",
+				(core->o_qspi_sck)?"SCK":"   ",
+				core->o_qspi_mod, core->o_qspi_dat, iqspi);
+		}
+
+		BASE::tick();
+		// }}}
+	}
+
+	void	take_offline(void) {
+		// {{{
+		this->cfg_write(F_END);
+		// Enough 0xff's to cover the address and mode byte of an
+		// XIP read, leaving the flash out of XIP mode.  In QPI mode,
+		// these go out four bits at a time.
+		for(int k=0; k<((m_qpi) ? 4:2); k++)
+			this->cfg_write(cfgcmd(F_RESET));
+		this->cfg_write(F_END);
+		// }}}
+	}
+
+	virtual	void	place_online(void) {
+		// {{{
+		static	const	uint32_t QUAL_IO_READ = CFG_USERMODE|0xeb;
+		this->cfg_write(cfgcmd(QUAL_IO_READ));
+		// 3 address bytes
+		this->cfg_write(CFG_USERMODE | CFG_QSPEED | CFG_WEDIR);
+		this->cfg_write(CFG_USERMODE | CFG_QSPEED | CFG_WEDIR);
+		this->cfg_write(CFG_USERMODE | CFG_QSPEED | CFG_WEDIR);
+		// mode byte
+		this->cfg_write(CFG_USERMODE | CFG_QSPEED | CFG_WEDIR | 0xa0);
+		// Read a dummy byte
+		this->cfg_write(CFG_USERMODE | CFG_QSPEED);
+		// Close the interface
+		this->cfg_write(0);
+		// }}}
+	}
+
+	void	flsetwrap(int lgwrap) {
+		// {{{
+		// Set the flash's wrapped burst length to (1<<lgwrap) words,
+		// using the Winbond "Set burst with wrap" (0x77) command, or
+		// turn wrapping off if lgwrap is zero.  The wrap length is
+		// given in W6-5 of the last byte: 8, 16, 32, or 64 bytes.
+		// W4 set disables the wrap.
+		static	const	uint32_t SET_BURST = CFG_USERMODE|0x77;
+		unsigned	wrap;
+
+		assert(lgwrap >= 0 && lgwrap <= 4);
+		wrap = (lgwrap == 0) ? 0x10 : (((lgwrap-1)&3)<<5);
+
+		take_offline();
+		this->cfg_write(cfgcmd(SET_BURST));
+		// Three dummy bytes
+		this->cfg_write(CFG_USERMODE | CFG_QSPEED | CFG_WEDIR);
+		this->cfg_write(CFG_USERMODE | CFG_QSPEED | CFG_WEDIR);
+		this->cfg_write(CFG_USERMODE | CFG_QSPEED | CFG_WEDIR);
+		// The wrap byte
+		this->cfg_write(CFG_USERMODE | CFG_QSPEED | CFG_WEDIR | wrap);
+		this->cfg_write(F_END);
+		place_online();
+		// }}}
+	}
+
+	unsigned flreadid(void) {
+		// {{{
+		unsigned	r;
+
+		this->cfg_write(cfgcmd(F_READID));
+
+		this->cfg_write(cfgrd()); r = this->cfg_read() & 0x0ff;
+		this->cfg_write(cfgrd()); r = (r<<8) | (this->cfg_read() & 0x0ff);
+		this->cfg_write(cfgrd()); r = (r<<8) | (this->cfg_read() & 0x0ff);
+		this->cfg_write(cfgrd()); r = (r<<8) | (this->cfg_read() & 0x0ff);
+		this->cfg_write(F_END);
+
+		return r;
+		// }}}
+	}
+
+	int	flstatus(void) {
+		// {{{
+		unsigned	v;
+
+		this->cfg_write(cfgcmd(F_RDSR));
+		this->cfg_write(cfgrd());
+		v = this->cfg_read()  & 0x0ff;
+		this->cfg_write(F_END);
+		return v;
+		// }}}
+	}
+
+	void	flwait(void) {
+		// {{{
+		int	r;
+
+		this->cfg_write(cfgcmd(F_RDSR));
+		do {
+			this->cfg_write(cfgrd());
+			r = this->cfg_read();
+		} while (r & 1); // Wait while the device is busy
+		this->cfg_write(F_END);
+		// }}}
+	}
+
+	void	flerase(unsigned sectoraddr) {
+		// {{{
+		take_offline();
+
+		this->cfg_write(F_END);
+		this->cfg_write(cfgcmd(F_WREN));
+		this->cfg_write(F_END);
+
+		this->cfg_write(cfgcmd(F_SE));
+		this->cfg_write(cfgcmd(CFG_USERMODE|((sectoraddr >> 16)&0x0ff)));
+		this->cfg_write(cfgcmd(CFG_USERMODE|((sectoraddr >>  8)&0x0ff)));
+		this->cfg_write(cfgcmd(CFG_USERMODE|((sectoraddr      )&0x0ff)));
+		this->cfg_write(F_END);
+
+		flwait();
+
+		place_online();
+		// }}}
+	}
+
+	void	flpage_program(int addr, int ln, const char *buf) {
+		// {{{
+		flwait();
+
+		this->cfg_write(F_END);
+		this->cfg_write(cfgcmd(F_WREN));
+		this->cfg_write(F_END);
+
+		this->cfg_write(cfgcmd(F_PP));
+		this->cfg_write(cfgcmd(CFG_USERMODE|((addr >> 16)&0x0ff)));
+		this->cfg_write(cfgcmd(CFG_USERMODE|((addr >>  8)&0x0ff)));
+		this->cfg_write(cfgcmd(CFG_USERMODE|((addr      )&0x0ff)));
+
+		// Write the page data itself
+		for(int i=0; i<ln; i++)
+			this->cfg_write(cfgcmd(CFG_USERMODE|(buf[i] & 0x0ff)));
+		this->cfg_write(F_END);
+
+		flwait();
+		// }}}
+	}
+
+	void	flprogram(int addr, int ln, const char *buf) {
+		// {{{
+		int	start = addr;
+
+		take_offline();
+		while(start < addr + ln) {
+			int	wlen;
+
+			if (PAGEOF(addr+ln-1)!=PAGEOF(start))
+				wlen = PAGEOF(start+PGLENB)-start;
+			else
+				wlen = addr+ln-start;
+
+			flpage_program(start, wlen, &buf[start-addr]);
+			start = PAGEOF(start+PGLENB);
+		}
+		flwait();
+
+		place_online();
+		// }}}
+	}
+};
+
+#endif
@@ -0,0 +1,256 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	qflexack_tb.cpp
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	To determine whether or not the early acknowledgment option
+//		(OPT_EARLYACK) of the qflexpress controller works.  The
+//	controller is built with OPT_EARLYACK set, and with OPT_ENDIANSWAP
+//	clear, so that the first byte read from the flash is returned in
+//	bits [31:24].  The test
+//
+//	1. Reads single bytes, from each lane in turn, checking the byte and
+//	   that it is acknowledged two clocks earlier, less one, for each
+//	   byte of the word left to read
+//	2. Reads a burst where every word selects different lanes, checking
+//	   the bytes selected, and that the burst takes exactly as many
+//	   clocks as one reading full words--so that no read had to start
+//	   over with a new address
+//
+//	Run the simulation program this with no arguments, and then check
+//	whether or not the last line contains "SUCCESS" or not.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2015-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#include <stdlib.h>
+#include "verilated.h"
+#include "Vqflexpressack.h"
+#include "byteswap.h"
+#include "qflex_tb.h"
+
+#define	NSINGLE		64
+#define	LONGBURST	64
+
+// The clocks saved by skipping the last SKIP bytes of a word: two per byte
+// at single rate, less the one taken to shift the bytes into their lanes
+#define	EARLY_CLOCKS(SKIP)	(((SKIP)==0) ? 0 : (2*(SKIP)-1))
+
+class	ACK_TB : public QFLEX_TB<Vqflexpressack> {
+public:
+	ACK_TB(void) {
+		m_core->i_wb_sel = 0x0f;
+	}
+
+	// sel_read
+	// {{{
+	// Read len words, starting from word address a, in one pipelined
+	// burst, selecting the lanes sel[k] for the k'th word.  Returns the
+	// number of clocks from the first request to the last
+	// acknowledgment.  Unlike wb_read(), this doesn't then wait for the
+	// controller to finish reading the last word from the flash.
+	unsigned long	sel_read(unsigned a, int len, const unsigned *sel,
+				unsigned *buf) {
+		int		errcount = 0, cnt = 0, rdidx = 0;
+		int		THISBOMBCOUNT = BOMBCOUNT * len;
+		unsigned long	start;
+
+		while((errcount++ < BOMBCOUNT)&&(m_core->o_wb_stall))
+			tick();
+		if (errcount >= BOMBCOUNT) {
+			printf("SEL-READ: Stalled, never started\n");
+			m_bomb = true;
+			return 0;
+		}
+
+		errcount = 0;
+		m_core->i_wb_cyc  = 1;
+		m_core->i_wb_stb  = 1;
+		m_core->i_cfg_stb = 0;
+		m_core->i_wb_we   = 0;
+		m_core->i_wb_addr = a;
+		m_core->i_wb_sel  = sel[0];
+		start = m_tickcount;
+
+		do {
+			int	s;
+
+			s = (m_core->o_wb_stall==0)?0:1;
+			tick();
+			cnt += (s^1);
+			m_core->i_wb_addr += (s^1);
+			if (cnt < len)
+				m_core->i_wb_sel = sel[cnt];
+			if (m_core->o_wb_ack)
+				buf[rdidx++] = m_core->o_wb_data;
+		} while((cnt < len)&&(errcount++ < THISBOMBCOUNT));
+
+		m_core->i_wb_stb = 0;
+
+		while((rdidx < len)&&(errcount++ < THISBOMBCOUNT)) {
+			tick();
+			if (m_core->o_wb_ack)
+				buf[rdidx++] = m_core->o_wb_data;
+		}
+
+		// Release the bus
+		m_core->i_wb_cyc = 0;
+		m_core->i_wb_sel = 0x0f;
+
+		if (errcount >= THISBOMBCOUNT) {
+			printf("SEL-READ: NO RESPONSE AFTER %d CLOCKS\n",
+				errcount);
+			m_bomb = true;
+			return 0;
+		}
+
+		return m_tickcount - start;
+	}
+	// }}}
+};
+
+// lanemask
+// {{{
+// The bits of a word selected by sel
+static unsigned	lanemask(unsigned sel) {
+	unsigned	m = 0;
+
+	for(int k=0; k<4; k++)
+		if (sel & (1<<k))
+			m |= 0x0ff << (8*k);
+	return m;
+}
+// }}}
+
+// checksel
+// {{{
+// Check the selected lanes of each word read against the flash
+static bool	checksel(ACK_TB *tb, unsigned a, int len, const unsigned *sel,
+			const unsigned *buf) {
+	for(int k=0; k<len; k++) {
+		unsigned	m = lanemask(sel[k]);
+
+		if ((buf[k] & m) != ((*tb)[a+k] & m)) {
+			printf("BOMB: READ[%08x]&%08x = %08x, EXPECTED %08x\n",
+				(a+k)<<2, m, buf[k] & m, (*tb)[a+k] & m);
+			return false;
+		}
+	} return true;
+}
+// }}}
+
+int main(int  argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	ACK_TB		*tb = new ACK_TB;
+	const unsigned	NWORDS = (1<<(LGFLASHSZB-2));
+	unsigned	sel[LONGBURST], rdbuf[LONGBURST];
+	unsigned long	fullclocks, clocks;
+
+	tb->opentrace("qflexack.vcd");
+
+	srand(0x9abc);
+	for(unsigned i=0; i<NWORDS; i+= 61)
+		tb->set(i, rand());
+	for(unsigned i=0; i<2*LONGBURST; i++)
+		tb->set(i, rand());
+
+	if (!startup(tb))
+		goto test_failure;
+
+	// 1. Single bytes, from each lane
+	// {{{
+	sel[0] = 0x0f;
+	for(int k=0; k<NSINGLE; k++) {
+		unsigned a = (rand() % (NWORDS/61)) * 61;
+
+		fullclocks = tb->sel_read(a, 1, sel, rdbuf);
+		if ((fullclocks == 0)||(!checksel(tb, a, 1, sel, rdbuf)))
+			goto test_failure;
+
+		// Lane 3 (the MSBs) is read first, so selecting lane N
+		// skips the last N bytes of the word
+		for(int lane=3; lane>=0; lane--) {
+			unsigned	bsel = 1<<lane;
+
+			clocks = tb->sel_read(a, 1, &bsel, rdbuf);
+			if ((clocks == 0)||(!checksel(tb, a, 1, &bsel, rdbuf)))
+				goto test_failure;
+			if (clocks + EARLY_CLOCKS(lane) != fullclocks) {
+				printf("BOMB: Lane %d took %ld clocks, "
+					"expected %ld\n", lane, clocks,
+					fullclocks - EARLY_CLOCKS(lane));
+				goto test_failure;
+			}
+		}
+	}
+	printf("Single bytes:   PASS (%ld clocks for a word, %ld for its first byte)\n",
+		fullclocks, fullclocks - EARLY_CLOCKS(3));
+	// }}}
+
+	// 2. A burst, selecting different lanes in each word
+	// {{{
+	for(int k=0; k<LONGBURST; k++)
+		sel[k] = 0x0f;
+	fullclocks = tb->sel_read(LONGBURST, LONGBURST, sel, rdbuf);
+	if ((fullclocks == 0)||(!checksel(tb, LONGBURST, LONGBURST, sel, rdbuf)))
+		goto test_failure;
+
+	// Any lanes at all, save the last word which is read in full so
+	// that both bursts end at the same time
+	for(int k=0; k<LONGBURST-1; k++)
+		sel[k] = (rand() % 15) + 1;
+	clocks = tb->sel_read(LONGBURST, LONGBURST, sel, rdbuf);
+	if ((clocks == 0)||(!checksel(tb, LONGBURST, LONGBURST, sel, rdbuf)))
+		goto test_failure;
+
+	printf("%d words: %ld clocks, %ld selecting full words\n",
+		LONGBURST, clocks, fullclocks);
+	if (clocks != fullclocks) {
+		printf("BOMB: The burst didn't continue past an early ack\n");
+		goto test_failure;
+	}
+	printf("Bursts:         PASS\n");
+	// }}}
+
+	if (tb->bombed())
+		goto test_failure;
+
+	printf("SUCCESS!!\n");
+	exit(EXIT_SUCCESS);
+test_failure:
+	printf("FAIL-HERE\n");
+	for(int i=0; i<8; i++)
+		tb->tick();
+	printf("TEST FAILED\n");
+	exit(EXIT_FAILURE);
+}
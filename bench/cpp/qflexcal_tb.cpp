@@ -0,0 +1,315 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	qflexcal_tb.cpp
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	To demonstrate read delay calibration.  The qflexpress
+//		controller is built with a speed register (OPT_SPEEDREG), a
+//	clock divider of up to three, and read delays of up to seven clocks.
+//	The data returned by the flash is then delayed by a varying number of
+//	clocks, much as a board trace and the I/O pads might delay it.  For
+//	each such delay, and each clock divider, the test
+//
+//	1. Sweeps the controller's read delay, reading a known region of the
+//	   flash at each setting, to find the window of delays that work
+//	2. Requires that this window not be empty, and that it move by one
+//	   delay whenever the trace delay does
+//	3. Selects the center of the window, and then checks both single and
+//	   burst reads at that setting
+//
+//	This is the same algorithm as FLASHDRVR::calibrate() in sw/, and the
+//	flashcal utility built upon it.
+//
+//	Run the simulation program this with no arguments, and then check
+//	whether or not the last line contains "SUCCESS" or not.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2015-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#include <stdlib.h>
+#include "verilated.h"
+#include "Vqflexpresscal.h"
+#include "byteswap.h"
+#include "qflex_tb.h"
+
+#define	NSINGLE		32
+#define	CALWORDS	64
+#define	LONGBURST	128
+
+// The speed register, within the configuration space
+#define	R_SPEED		0x01
+#define	SPEED(DIV,DLY,NDUMMY)	(((DIV)<<24)|((DLY)<<20)|(NDUMMY))
+#define	SPEED_MASK	0xfff0001f
+
+// As built in rtl/Makefile: OPT_CLKDIV=3, RDDELAY=7, and NDUMMY=6
+#define	CLKDIV		3
+#define	MAXDELAY	7
+#define	NDUMMY		6
+
+// The longest trace delay we'll emulate
+#define	MAXTRACE	8
+
+class	CAL_TB : public QFLEX_TB<Vqflexpresscal> {
+	int	m_trace[MAXTRACE], m_tidx;
+public:
+	// The number of clocks from the flash's data pins back to the
+	// controller, beyond those of the simulation
+	int	m_tracedelay;
+
+	CAL_TB(void) : m_tidx(0), m_tracedelay(0) {
+		for(int k=0; k<MAXTRACE; k++)
+			m_trace[k] = 0;
+	}
+
+	virtual	void	tick(void) {
+		// {{{
+		// o_qspi_sck is the level of SCK, since the clock is divided
+		int	iqspi;
+
+		iqspi = (*m_flash)(m_core->o_qspi_cs_n, m_core->o_qspi_sck,
+				m_core->o_qspi_dat);
+
+		if (m_core->o_qspi_mod&2) {
+			if (m_core->o_qspi_mod&1) {
+				; // IQSPI is as given
+			} else
+				iqspi = m_core->o_qspi_dat;
+		} else {
+			iqspi &= 0x02;
+			iqspi |= m_core->o_qspi_dat&1;
+			iqspi |= m_core->o_qspi_dat&0x0c;
+		}
+
+		// Delay the returned data by m_tracedelay clocks
+		m_tidx = (m_tidx + 1) % MAXTRACE;
+		m_trace[m_tidx] = iqspi;
+		m_core->i_qspi_dat = m_trace[(m_tidx + MAXTRACE - m_tracedelay)
+						% MAXTRACE];
+
+		WBFLASH_TB<Vqflexpresscal>::tick();
+		// }}}
+	}
+
+	// regionok
+	// {{{
+	// Returns true if CALWORDS words, starting at word address a, read
+	// back as expected at the current speed
+	bool	regionok(unsigned a) {
+		unsigned	rdbuf[CALWORDS];
+
+		wb_read(a<<2, CALWORDS, rdbuf);
+		for(int k=0; k<CALWORDS; k++)
+			if (rdbuf[k] != (*this)[a+k])
+				return false;
+		return true;
+	}
+	// }}}
+
+	// calibrate
+	// {{{
+	// Sweep the read delay, and then settle at the center of the longest
+	// window of passing delays.  Returns the window as a bit mask.
+	unsigned calibrate(unsigned clkdiv, unsigned a, unsigned *center) {
+		unsigned	window = 0, bestlen = 0;
+
+		*center = 0;
+		for(unsigned dly=0; dly<=MAXDELAY; dly++) {
+			reg_write(R_SPEED, SPEED(clkdiv, dly, NDUMMY));
+			if (regionok(a))
+				window |= (1<<dly);
+		}
+
+		for(unsigned lo=0; lo<=MAXDELAY; lo++) {
+			unsigned	hi = lo;
+
+			if (0 == (window & (1<<lo)))
+				continue;
+			while((hi < MAXDELAY)&&(window & (1<<(hi+1))))
+				hi++;
+			if (hi+1-lo > bestlen) {
+				bestlen = hi+1-lo;
+				*center = (lo+hi)/2;
+			} lo = hi;
+		}
+
+		reg_write(R_SPEED, SPEED(clkdiv, *center, NDUMMY));
+		return window;
+	}
+	// }}}
+};
+
+// checkread
+// {{{
+bool	checkread(CAL_TB *tb, unsigned a) {
+	unsigned	rdv, exv;
+
+	rdv = tb->wb_read(a<<2);
+	exv = (*tb)[a];
+	if (rdv != exv) {
+		printf("BOMB: READ[%08x] %08x, EXPECTED %08x\n",
+			a<<2, rdv, exv);
+		return false;
+	}
+
+	return !tb->bombed();
+}
+// }}}
+
+// checkreads
+// {{{
+// Single reads from random addresses, followed by one long burst
+bool	checkreads(CAL_TB *tb) {
+	unsigned	*rdbuf = new unsigned[LONGBURST];
+	bool		pass = true;
+
+	for(int k=0; k<NSINGLE; k++) {
+		if (!checkread(tb, rand() % (2*SECTORSZW)))
+			return false;
+	}
+
+	tb->wb_read(SECTORSZW<<2, LONGBURST, rdbuf);
+	for(int k=0; k<LONGBURST; k++) {
+		if (rdbuf[k] != (*tb)[SECTORSZW+k]) {
+			printf("BOMB: READ[%08x] %08x, EXPECTED %08x\n",
+				(SECTORSZW+k)<<2, rdbuf[k],
+				(*tb)[SECTORSZW+k]);
+			pass = false;
+			break;
+		}
+	}
+
+	delete[] rdbuf;
+	return (pass)&&(!tb->bombed());
+}
+// }}}
+
+// edges
+// {{{
+// Return the lowest and highest delays within a window
+void	edges(unsigned window, int *lo, int *hi) {
+	*lo = -1; *hi = -1;
+	for(int dly=0; dly<=MAXDELAY; dly++) {
+		if (window & (1<<dly)) {
+			if (*lo < 0)
+				*lo = dly;
+			*hi = dly;
+		}
+	}
+}
+// }}}
+
+int main(int  argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	CAL_TB	*tb = new CAL_TB;
+	unsigned	rdv;
+
+	tb->opentrace("qflexcal.vcd");
+
+	srand(0x6789);
+	for(int i=0; i<2*SECTORSZW; i++)
+		tb->set(i, rand());
+
+	// Startup
+	// {{{
+	// The startup script only writes to the flash, so it works no matter
+	// the trace delay
+	if (!startup(tb))
+		goto test_failure;
+
+	rdv = tb->reg_read(R_SPEED) & SPEED_MASK;
+	if (rdv != SPEED(CLKDIV, MAXDELAY, NDUMMY)) {
+		printf("BOMB: SPEED = %08x following reset, expected %08x\n",
+			rdv, SPEED(CLKDIV, MAXDELAY, NDUMMY));
+		goto test_failure;
+	}
+	printf("Startup completed\n");
+	// }}}
+
+	for(unsigned clkdiv=1; clkdiv<=CLKDIV; clkdiv++) {
+		int	lastlo = -1, lasthi = -1;
+
+		for(int trace=1; trace<=4; trace++) {
+			unsigned	window, center;
+			int		lo, hi;
+
+			tb->m_tracedelay = trace;
+			window = tb->calibrate(clkdiv, rand() % SECTORSZW,
+					&center);
+			edges(window, &lo, &hi);
+
+			printf("CLKDIV=%d, TRACE=%d: WINDOW %02x, RDDELAY <= %d\n",
+				clkdiv, trace, window, center);
+
+			if (tb->bombed())
+				goto test_failure;
+
+			if (window == 0) {
+				printf("BOMB: No read delay works\n");
+				goto test_failure;
+			}
+
+			// Unless clipped by the ends of the range, the window
+			// should follow the trace delay clock for clock
+			if ((lastlo > 0)&&(lasthi < MAXDELAY)
+					&&(lo > 0)&&(hi < MAXDELAY)
+					&&((lo != lastlo+1)||(hi != lasthi+1))) {
+				printf("BOMB: The window didn't follow the trace\n");
+				goto test_failure;
+			}
+
+			lastlo = lo; lasthi = hi;
+
+			rdv = tb->reg_read(R_SPEED) & SPEED_MASK;
+			if (rdv != SPEED(clkdiv, center, NDUMMY)) {
+				printf("BOMB: SPEED = %08x, expected %08x\n",
+					rdv, SPEED(clkdiv, center, NDUMMY));
+				goto test_failure;
+			}
+
+			if (!checkreads(tb))
+				goto test_failure;
+		}
+	}
+
+	if (tb->bombed())
+		goto test_failure;
+
+	printf("SUCCESS!!\n");
+	exit(EXIT_SUCCESS);
+test_failure:
+	printf("FAIL-HERE\n");
+	for(int i=0; i<8; i++)
+		tb->tick();
+	printf("TEST FAILED\n");
+	exit(EXIT_FAILURE);
+}
@@ -0,0 +1,588 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	qflexcs_tb.cpp
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	To determine whether or not the multiple chip select (NCS)
+//		option of the qflexpress controller allows reads from one
+//	flash device while another is being erased or programmed.  The
+//	controller is built with NCS=2, and attached to two FLASHSIM models
+//	sharing SCK and the data pins, each with its own chip select.  The
+//	test
+//
+//	1. Reads from both devices, and across the boundary between them,
+//	   and measures the clocks taken by a burst from the first device
+//	2. Erases a subsector of the second device.  While the erase is in
+//	   progress, it alternates between polling the second device's status
+//	   register through the configuration port, and reading bursts from
+//	   the first device--checking that every burst takes no longer than
+//	   before
+//	3. Programs a page of the second device, reading from the first in
+//	   the same fashion
+//	4. Returns the second device to XIP mode, and checks the result
+//	5. Checks that neither device was ever read while busy
+//
+//	The same is then repeated with the flashpgm engine in front of the
+//	controller, both built with NCS=2.  Rather than polling the second
+//	device through the configuration port, the test
+//
+//	6. Starts an erase of the same subsector of the second device through
+//	   the engine's ERASE register, and reads bursts from the first device
+//	   until the engine is done.  Each burst may now wait on one of the
+//	   engine's status polls, but no longer.
+//	7. Writes a page into the engine's buffer at the second device's bus
+//	   address, programs it, and reads from the first device in the same
+//	   fashion
+//	8. Checks the result, with the second device left in XIP mode by the
+//	   engine, and that neither device was ever read while busy
+//
+//	Run the simulation program this with no arguments, and then check
+//	whether or not the last line contains "SUCCESS" or not.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2015-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#include <stdlib.h>
+#include "verilated.h"
+#include "Vqflexpresscs2.h"
+#include "Vqflexpgmcs2.h"
+#include "qflex_tb.h"
+
+#define	NCHIPS		2
+#define	LONGBURST	64
+#define	CODEWORDS	8192	// The region of the first device read from
+// The number of bus words within each device
+#define	CHIPWORDS	(1u<<(LGFLASHSZB-2))
+// The device select field of a configuration word, bits [15:13]
+#define	CFG_CHIP(C)	((C)<<13)
+// The subsector (4kB) of the second device to be erased and programmed
+#define	UPDADDR		0x012000
+#define	SUBSECTORSZB	4096
+
+// The engine's registers, within the configuration space
+#define	R_PGMCTL	0x10
+#define	R_ERASE		0x11
+#define	R_POLLINT	0x12
+#define	PGM_BUSY	0x80000000
+#define	PGM_DONE	0x40000000
+#define	PGM_START	0x01
+#define	ERASE_4K	0x00000000
+// The device select field of the engine's ERASE register, bits [28:26]
+#define	PGM_CHIP(C)	((C)<<26)
+// Clocks between the engine's status polls, and the most clocks any one of
+// those polls may hold off a read of the other device
+#define	POLLINT		1000
+#define	POLL_CLOCKS	256
+
+static const unsigned	F_SSE = (CFG_USERMODE|0x020);
+
+template <class VA>	class	QFLEXCS_TB : public WBFLASH_TB<VA> {
+	FLASHSIM	*m_flash[NCHIPS];
+	int		m_lastsck;
+public:
+	QFLEXCS_TB(void) {
+		// {{{
+		for(int k=0; k<NCHIPS; k++)
+			m_flash[k] = new FLASHSIM(LGFLASHSZB);
+		m_lastsck = 0;
+		// }}}
+	}
+
+	~QFLEXCS_TB(void) {
+		for(int k=0; k<NCHIPS; k++)
+			delete	m_flash[k];
+	}
+
+	FLASHSIM *flash(const int chip) { return m_flash[chip]; }
+
+	// Words are indexed by their bus address, so the second device
+	// follows the first
+	unsigned operator[](const unsigned a) {
+		return (*m_flash[a / CHIPWORDS])[a % CHIPWORDS]; }
+
+	void	set(const unsigned a, const unsigned v) {
+		m_flash[a / CHIPWORDS]->set(a % CHIPWORDS, v);
+	}
+
+	void	tick(void) {
+		// {{{
+		VA	*core = TESTB<VA>::m_core;
+		int	iqspi = 0;
+
+		// Both devices see SCK and the data pins, but each only its
+		// own chip select.  The data returned is that of the device
+		// selected.
+		for(int k=0; k<NCHIPS; k++) {
+			int	csn = (core->o_qspi_cs_n >> k) & 1, v;
+
+			if (m_lastsck)
+				(*m_flash[k])(csn, 0, core->o_qspi_dat);
+			v = (*m_flash[k])(csn, 1, core->o_qspi_dat);
+			if (!csn)
+				iqspi = v;
+		}
+
+		if (core->o_qspi_mod&2) {
+			if (core->o_qspi_mod&1) {
+				; // IDSPI is as given
+			} else
+				iqspi = core->o_qspi_dat;
+		} else {
+			iqspi &= 0x02;
+			iqspi |= core->o_qspi_dat&1;
+			iqspi |= core->o_qspi_dat&0x0c;
+		}
+
+		core->i_qspi_dat = iqspi;
+		m_lastsck = core->o_qspi_sck;
+
+		WBFLASH_TB<VA>::tick();
+		// }}}
+	}
+
+	// chip_write
+	// {{{
+	// Every configuration mode write carries the device it's for
+	void	chip_write(const int chip, const unsigned v) {
+		this->cfg_write(v | CFG_CHIP(chip));
+	}
+	// }}}
+
+	void	take_offline(const int chip) {
+		// {{{
+		chip_write(chip, F_END);
+		chip_write(chip, F_RESET);
+		chip_write(chip, F_RESET);
+		chip_write(chip, F_END);
+		// }}}
+	}
+
+	void	place_online(const int chip) {
+		// {{{
+		static	const	uint32_t QUAL_IO_READ = CFG_USERMODE|0xeb;
+		chip_write(chip, QUAL_IO_READ);
+		// 3 address bytes
+		chip_write(chip, CFG_USERMODE | CFG_QSPEED | CFG_WEDIR);
+		chip_write(chip, CFG_USERMODE | CFG_QSPEED | CFG_WEDIR);
+		chip_write(chip, CFG_USERMODE | CFG_QSPEED | CFG_WEDIR);
+		// mode byte
+		chip_write(chip, CFG_USERMODE | CFG_QSPEED | CFG_WEDIR | 0xa0);
+		// Read a dummy byte
+		chip_write(chip, CFG_USERMODE | CFG_QSPEED);
+		// Close the interface
+		this->cfg_write(0);
+		// }}}
+	}
+
+	// flstatus
+	// {{{
+	// Read a device's status register, and then leave configuration mode
+	// so that the other devices may be read.  Returns -1 if the
+	// controller doesn't report the device it was asked for.
+	int	flstatus(const int chip) {
+		unsigned	v;
+
+		chip_write(chip, F_RDSR);
+		chip_write(chip, CFG_USERMODE);
+		v = this->cfg_read();
+		chip_write(chip, F_END);
+		this->cfg_write(0);
+
+		if (((v >> 13)&7) != (unsigned)chip) {
+			printf("BOMB: Device %d selected, %d reported\n",
+				chip, (v>>13)&7);
+			return -1;
+		} return v & 0x0ff;
+	}
+	// }}}
+
+	// flerase, flpage_program
+	// {{{
+	// Start a subsector erase, or a page program, of the given device,
+	// returning as soon as the command has been sent
+	void	flerase(const int chip, const unsigned addr) {
+		chip_write(chip, F_WREN);
+		chip_write(chip, F_END);
+
+		chip_write(chip, F_SSE);
+		chip_write(chip, CFG_USERMODE|((addr >> 16)&0x0ff));
+		chip_write(chip, CFG_USERMODE|((addr >>  8)&0x0ff));
+		chip_write(chip, CFG_USERMODE|((addr      )&0x0ff));
+		chip_write(chip, F_END);
+		this->cfg_write(0);
+	}
+
+	void	flpage_program(const int chip, const unsigned addr,
+			const char *buf) {
+		chip_write(chip, F_WREN);
+		chip_write(chip, F_END);
+
+		chip_write(chip, F_PP);
+		chip_write(chip, CFG_USERMODE|((addr >> 16)&0x0ff));
+		chip_write(chip, CFG_USERMODE|((addr >>  8)&0x0ff));
+		chip_write(chip, CFG_USERMODE|((addr      )&0x0ff));
+		for(int i=0; i<PGLENB; i++)
+			chip_write(chip, CFG_USERMODE|(buf[i] & 0x0ff));
+		chip_write(chip, F_END);
+		this->cfg_write(0);
+	}
+	// }}}
+
+	// pgm_busy
+	// {{{
+	// Returns one if the flashpgm engine is still busy, zero once it is
+	// done, or -1 if it reports the wrong device
+	int	pgm_busy(const unsigned reg, const int chip) {
+		unsigned	v = this->reg_read(reg);
+
+		if (((v >> 26)&7) != (unsigned)chip) {
+			printf("BOMB: Device %d given to the engine, %d reported\n",
+				chip, (v>>26)&7);
+			return -1;
+		} return (v & PGM_BUSY) ? 1 : 0;
+	}
+	// }}}
+};
+
+// burstread
+// {{{
+// Read LONGBURST words with one pipelined request, check them, and return
+// the number of clocks it took--or zero on failure
+template <class VA>
+unsigned long	burstread(QFLEXCS_TB<VA> *tb, unsigned a) {
+	unsigned	*rdbuf = new unsigned[LONGBURST];
+	unsigned long	start, clocks;
+	int		errcount = 0;
+
+	while((errcount++ < BOMBCOUNT)&&(tb->m_core->o_wb_stall))
+		tb->tick();
+
+	start = tb->m_tickcount;
+	tb->wb_read(a<<2, LONGBURST, rdbuf);
+	clocks = tb->m_tickcount - start;
+
+	for(int k=0; k<LONGBURST; k++) {
+		if (rdbuf[k] != (*tb)[a+k]) {
+			printf("BOMB: READ[%08x] %08x, EXPECTED %08x\n",
+				(a+k)<<2, rdbuf[k], (*tb)[a+k]);
+			clocks = 0;
+			break;
+		}
+	}
+
+	delete[] rdbuf;
+	if (tb->bombed())
+		return 0;
+	return clocks;
+}
+// }}}
+
+// busyread
+// {{{
+// Read bursts from device zero for as long as device one remains busy,
+// polling its status between bursts.  Returns the number of bursts read,
+// or -1 on failure.
+template <class VA>
+int	busyread(QFLEXCS_TB<VA> *tb, unsigned long idleclocks,
+			unsigned long &maxclocks) {
+	unsigned	a = 0;
+	int		nbursts = 0, sr;
+
+	while(((sr = tb->flstatus(1)) > 0)&&(sr & 1)) {
+		unsigned long	clocks = burstread(tb, a);
+
+		if (clocks == 0)
+			return -1;
+		if (clocks > idleclocks) {
+			printf("BOMB: A burst took %ld clocks while device 1 was busy, %ld otherwise\n",
+				clocks, idleclocks);
+			return -1;
+		} if (clocks > maxclocks)
+			maxclocks = clocks;
+
+		nbursts++;
+		a = (a + LONGBURST) % CODEWORDS;
+	}
+
+	if (sr < 0)
+		return -1;
+	return nbursts;
+}
+// }}}
+
+// pgmread
+// {{{
+// As busyread(), but while the flashpgm engine works on device one, polling
+// the given engine register between bursts.  The engine holds off a burst
+// while it polls the device's status, so each may take up to POLL_CLOCKS
+// longer than when idle.
+template <class VA>
+int	pgmread(QFLEXCS_TB<VA> *tb, const unsigned reg,
+			unsigned long idleclocks, unsigned long &maxclocks) {
+	unsigned	a = 0;
+	int		nbursts = 0, busy;
+
+	while((busy = tb->pgm_busy(reg, 1)) > 0) {
+		unsigned long	clocks = burstread(tb, a);
+
+		if (clocks == 0)
+			return -1;
+		if (clocks > idleclocks + POLL_CLOCKS) {
+			printf("BOMB: A burst took %ld clocks while the engine was busy, %ld otherwise\n",
+				clocks, idleclocks);
+			return -1;
+		} if (clocks > maxclocks)
+			maxclocks = clocks;
+
+		nbursts++;
+		a = (a + LONGBURST) % CODEWORDS;
+	}
+
+	if (busy < 0)
+		return -1;
+	return nbursts;
+}
+// }}}
+
+// fill
+// {{{
+// Load both devices with the same random data before each run
+template <class VA>
+void	fill(QFLEXCS_TB<VA> *tb) {
+	const unsigned	UPDWORD = CHIPWORDS + (UPDADDR>>2);
+
+	srand(0x7531);
+	for(unsigned i=0; i<CODEWORDS+LONGBURST; i++)
+		tb->set(i, rand());
+	for(unsigned i=0; i<LONGBURST; i++) {
+		tb->set(CHIPWORDS - LONGBURST + i, rand());
+		tb->set(CHIPWORDS + i, rand());
+	}
+	for(unsigned i=0; i<SUBSECTORSZB/4; i++)
+		tb->set(UPDWORD + i, rand());
+}
+// }}}
+
+// check_update
+// {{{
+// Read the updated subsector of device one back through the memory port.
+// All of it should be erased, save the page programmed at pgaddr.
+template <class VA>
+bool	check_update(QFLEXCS_TB<VA> *tb, const unsigned pgaddr,
+			const char *page) {
+	const unsigned	UPDWORD = CHIPWORDS + (UPDADDR>>2);
+
+	for(unsigned i=0; i<SUBSECTORSZB/4; i++) {
+		unsigned	a = UPDWORD + i, exv = 0xffffffff, rdv;
+		unsigned	pgword = ((a - CHIPWORDS)<<2) - pgaddr;
+
+		if (pgword < PGLENB) {
+			exv = 0;
+			for(int k=0; k<4; k++)
+				exv = (exv << 8) | (page[pgword+k] & 0x0ff);
+		}
+
+		rdv = tb->wb_read(a<<2);
+		if (rdv != exv) {
+			printf("BOMB: READ[%08x] %08x, EXPECTED %08x\n",
+				a<<2, rdv, exv);
+			return false;
+		}
+	}
+
+	return !tb->bombed();
+}
+// }}}
+
+// check_busy_reads
+// {{{
+template <class VA>
+bool	check_busy_reads(QFLEXCS_TB<VA> *tb) {
+	for(int k=0; k<NCHIPS; k++) {
+		if (tb->flash(k)->busy_reads() != 0) {
+			printf("BOMB: Device %d was read %d times while busy\n",
+				k, tb->flash(k)->busy_reads());
+			return false;
+		}
+	} return true;
+}
+// }}}
+
+int main(int  argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	QFLEXCS_TB<Vqflexpresscs2>	*tb = new QFLEXCS_TB<Vqflexpresscs2>;
+	QFLEXCS_TB<Vqflexpgmcs2>	*pgm = new QFLEXCS_TB<Vqflexpgmcs2>;
+	const unsigned	UPDWORD = CHIPWORDS + (UPDADDR>>2),
+			PGADDR  = UPDADDR + 3*PGLENB,
+			ENGADDR = UPDADDR + 5*PGLENB;
+	char		*page = new char[PGLENB];
+	unsigned	wbuf[PGLENW], rdv;
+	unsigned long	idleclocks, maxclocks = 0;
+	int		nbursts;
+
+	tb->opentrace("qflexcs.vcd");
+
+	fill(tb);
+	for(unsigned i=0; i<PGLENB; i++)
+		page[i] = rand();
+
+	if (!startup(tb))
+		goto test_failure;
+
+	// 1. Reads from both devices
+	// {{{
+	if ((0 == burstread(tb, CHIPWORDS))||(0 == burstread(tb, UPDWORD)))
+		goto test_failure;
+	// A burst crossing from one device to the next
+	if (0 == burstread(tb, CHIPWORDS - LONGBURST/2))
+		goto test_failure;
+	if (0 == (idleclocks = burstread(tb, 0)))
+		goto test_failure;
+	printf("Reads from both devices:  PASS (%ld clocks per burst)\n",
+		idleclocks);
+	// }}}
+
+	// 2. Erase, while reading from the other device
+	// {{{
+	tb->take_offline(1);
+	tb->flerase(1, UPDADDR);
+	if ((nbursts = busyread(tb, idleclocks, maxclocks)) < 0)
+		goto test_failure;
+	printf("Erase:    %4d bursts from device 0 while device 1 was busy\n",
+		nbursts);
+	if (nbursts == 0) {
+		printf("BOMB: The erase completed before any reads\n");
+		goto test_failure;
+	}
+	// }}}
+
+	// 3. Program, while reading from the other device
+	// {{{
+	tb->take_offline(1);
+	tb->flpage_program(1, PGADDR, page);
+	if ((nbursts = busyread(tb, idleclocks, maxclocks)) < 0)
+		goto test_failure;
+	printf("Program:  %4d bursts from device 0 while device 1 was busy\n",
+		nbursts);
+	printf("Longest burst, while busy: %ld clocks, %ld when idle\n",
+		maxclocks, idleclocks);
+	// }}}
+
+	// 4. Check the result
+	// {{{
+	tb->place_online(1);
+	if (!check_update(tb, PGADDR, page))
+		goto test_failure;
+	printf("Device 1 erased and programmed:  PASS\n");
+	// }}}
+
+	// 5. Neither device may be read while busy
+	// {{{
+	if (!check_busy_reads(tb))
+		goto test_failure;
+	// }}}
+
+	if (tb->bombed())
+		goto test_failure;
+	tb->closetrace();
+
+	// 6. Through flashpgm: an erase, while reading from the other device
+	// {{{
+	printf("\nThrough flashpgm:\n");
+	pgm->opentrace("qflexpgmcs.vcd");
+	fill(pgm);
+
+	if (!startup(pgm))
+		goto test_failure;
+
+	maxclocks = 0;
+	pgm->reg_write(R_POLLINT, POLLINT);
+	pgm->reg_write(R_ERASE, PGM_CHIP(1) | ERASE_4K | UPDADDR);
+	if ((nbursts = pgmread(pgm, R_ERASE, idleclocks, maxclocks)) < 0)
+		goto test_failure;
+	printf("Erase:    %4d bursts from device 0 while device 1 was busy\n",
+		nbursts);
+	if (nbursts == 0) {
+		printf("BOMB: The erase completed before any reads\n");
+		goto test_failure;
+	}
+	// }}}
+
+	// 7. A page, programmed from the buffer at device one's bus address
+	// {{{
+	for(int k=0; k<PGLENW; k++)
+		wbuf[k] = ((page[4*k  ]&0x0ff)<<24) | ((page[4*k+1]&0x0ff)<<16)
+			| ((page[4*k+2]&0x0ff)<< 8) |  (page[4*k+3]&0x0ff);
+
+	pgm->wb_write((CHIPWORDS<<2) + ENGADDR, PGLENW, wbuf);
+	pgm->reg_write(R_PGMCTL, PGM_START);
+	if ((nbursts = pgmread(pgm, R_PGMCTL, idleclocks, maxclocks)) < 0)
+		goto test_failure;
+	printf("Program:  %4d bursts from device 0 while device 1 was busy\n",
+		nbursts);
+	printf("Longest burst, while busy: %ld clocks, %ld when idle\n",
+		maxclocks, idleclocks);
+
+	rdv = pgm->reg_read(R_PGMCTL);
+	if (rdv != (PGM_DONE | PGM_CHIP(1) | ENGADDR)) {
+		printf("BOMB: PGMCTL = %08x, expected %08x\n",
+			rdv, PGM_DONE | PGM_CHIP(1) | ENGADDR);
+		goto test_failure;
+	}
+	pgm->reg_write(R_PGMCTL, 0);
+	// }}}
+
+	// 8. Check the result
+	// {{{
+	if (!check_update(pgm, ENGADDR, page))
+		goto test_failure;
+	printf("Device 1 erased and programmed:  PASS\n");
+
+	if (!check_busy_reads(pgm))
+		goto test_failure;
+	// }}}
+
+	if (pgm->bombed())
+		goto test_failure;
+
+	delete[] page;
+
+	printf("SUCCESS!!\n");
+	exit(EXIT_SUCCESS);
+test_failure:
+	printf("FAIL-HERE\n");
+	for(int i=0; i<8; i++)
+		tb->tick();
+	printf("TEST FAILED\n");
+	exit(EXIT_FAILURE);
+}
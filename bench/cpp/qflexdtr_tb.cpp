@@ -0,0 +1,243 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	qflexdtr_tb.cpp
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	To determine whether or not the DTR (double transfer rate)
+//		quad read mode of the qflexpress controller works, and how
+//	much faster it is than the normal quad I/O read.  Two controllers are
+//	built from the same source--one with OPT_DTR set, one without--and each
+//	is attached to its own FLASHSIM model holding the same data.  The test
+//
+//	1. Checks that the DTR controller's startup sequence leaves the flash
+//	   in DTR XIP mode
+//	2. Reads single words from both controllers
+//	3. Reads a long burst from both, and requires the DTR read to take
+//	   no more than 60% of the clocks taken by the normal read.  SCK runs
+//	   at the system clock rate in both cases, so this is also a measure
+//	   per SCK
+//	4. Reads the flash's ID, then erases and programs it through the
+//	   configuration port, returning to DTR reads afterwards and reading
+//	   back the result
+//
+//	Run the simulation program this with no arguments, and then check
+//	whether or not the last line contains "SUCCESS" or not.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2015-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#include <stdlib.h>
+#include "verilated.h"
+#include "Vqflexpress.h"
+#include "Vqflexpressdtr.h"
+#include "byteswap.h"
+#include "qflex_tb.h"
+
+#define	NSINGLE		64
+#define	LONGBURST	256
+
+class	DTR_TB : public QFLEX_TB<Vqflexpressdtr> {
+public:
+	virtual	void	tick(void) {
+		// {{{
+		// The DTR controller's data pins are eight bits wide: the
+		// nibble for the first half of SCK in [7:4], the nibble for
+		// the second in [3:0].
+		int	iqspi;
+
+		if (m_lastsck)
+			m_flash->dtrtick(m_core->o_qspi_cs_n, 0,
+				m_core->o_qspi_dat);
+
+		iqspi = m_flash->dtrtick(m_core->o_qspi_cs_n, 1,
+				m_core->o_qspi_dat);
+
+		if (m_core->o_qspi_mod&2) {
+			if (m_core->o_qspi_mod&1) {
+				; // IDSPI is as given
+			} else
+				iqspi = m_core->o_qspi_dat;
+		} else {
+			// MISO is bit one of each half
+			iqspi &= 0x22;
+			iqspi |= m_core->o_qspi_dat & 0xdd;
+		}
+
+		m_core->i_qspi_dat = iqspi;
+		m_lastsck = m_core->o_qspi_sck;
+
+		WBFLASH_TB<Vqflexpressdtr>::tick();
+		// }}}
+	}
+
+	virtual	void	place_online(void) {
+		// {{{
+		static	const	uint32_t DTR_IO_READ = CFG_USERMODE|0xed;
+		//
+		// The configuration port only speaks single rate, and so
+		// each nibble it sends is seen on both edges.  0x00, 0x0a
+		// therefore becomes a zero address followed by a mode byte
+		// of 0xaa.
+		this->cfg_write(DTR_IO_READ);
+		this->cfg_write(CFG_USERMODE | CFG_QSPEED | CFG_WEDIR);
+		this->cfg_write(CFG_USERMODE | CFG_QSPEED | CFG_WEDIR | 0x0a);
+		// A dummy byte
+		this->cfg_write(CFG_USERMODE | CFG_QSPEED | CFG_WEDIR);
+		// Read a dummy byte
+		this->cfg_write(CFG_USERMODE | CFG_QSPEED);
+		// Close the interface
+		this->cfg_write(0);
+		// }}}
+	}
+
+	bool	flash_dtr(void) { return m_flash->dtr_mode(); }
+};
+
+int main(int  argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	QFLEX_TB<Vqflexpress>	*sdr = new QFLEX_TB<Vqflexpress>;
+	DTR_TB			*dtr = new DTR_TB;
+	unsigned		rdv;
+	unsigned long		sdrclocks, dtrclocks;
+
+	dtr->opentrace("qflexdtr.vcd");
+
+	srand(0x2345);
+	for(int i=0; i<2*SECTORSZW; i++) {
+		unsigned v = rand();
+		sdr->set(i, v);
+		dtr->set(i, v);
+	}
+
+	// 1. Startup
+	// {{{
+	if ((!startup(sdr))||(!startup(dtr)))
+		goto test_failure;
+
+	if (!checkread(dtr, "DTR", 0))
+		goto test_failure;
+	if (!dtr->flash_dtr()) {
+		printf("BOMB: The flash is not in DTR mode following startup\n");
+		goto test_failure;
+	}
+	printf("Startup completed\n");
+	// }}}
+
+	// 2. Single word reads
+	// {{{
+	for(int k=0; k<NSINGLE; k++) {
+		unsigned a = rand() % (2*SECTORSZW);
+
+		if (!checkread(sdr, "SDR", a))
+			goto test_failure;
+		if (!checkread(dtr, "DTR", a))
+			goto test_failure;
+	}
+	printf("Single word reads:  PASS\n");
+	// }}}
+
+	// 3. Burst throughput
+	// {{{
+	sdrclocks = burstread(sdr, "SDR", SECTORSZW, LONGBURST);
+	dtrclocks = burstread(dtr, "DTR", SECTORSZW, LONGBURST);
+	if ((sdrclocks == 0)||(dtrclocks == 0))
+		goto test_failure;
+
+	printf("%d words: %ld clocks using DTR, %ld clocks without\n",
+		LONGBURST, dtrclocks, sdrclocks);
+	if (dtrclocks * 10 > sdrclocks * 6) {
+		printf("BOMB: The DTR read was not (much) faster\n");
+		goto test_failure;
+	}
+	// }}}
+
+	// 4. The configuration port
+	// {{{
+	dtr->take_offline();
+	if (dtr->flash_dtr()) {
+		printf("BOMB: The flash remained in DTR mode\n");
+		goto test_failure;
+	}
+	printf("ID     Register = 0x%08x\n", rdv = dtr->flreadid());
+	{	extern const unsigned DEVID;
+		if (rdv != DEVID) {
+			printf("BOMB: ID read %08x, expected %08x\n",
+				rdv, DEVID);
+			goto test_failure;
+		}
+	}
+	dtr->place_online();
+
+	dtr->flerase(SECTORSZB);
+	if (!dtr->flash_dtr()) {
+		printf("BOMB: DTR mode was not restored after the erase\n");
+		goto test_failure;
+	}
+	for(int k=0; k<16; k++) {
+		rdv = dtr->wb_read(SECTORSZB + 4*k);
+		if (rdv != 0xffffffff) {
+			printf("BOMB: READ[%08x] %08x after erase\n",
+				SECTORSZB+4*k, rdv);
+			goto test_failure;
+		}
+	}
+
+	{	char	buf[4];
+		buf[0] = 0x12;
+		buf[1] = 0x34;
+		buf[2] = 0x56;
+		buf[3] = 0x78;
+		dtr->flprogram(SECTORSZB+4, 4, buf);
+	}
+
+	if (!checkread(dtr, "DTR", SECTORSZW+1))
+		goto test_failure;
+	if ((*dtr)[SECTORSZW+1] != 0x12345678) {
+		printf("BOMB: The flash was not programmed\n");
+		goto test_failure;
+	}
+	printf("Configuration port: PASS\n");
+	// }}}
+
+	if ((sdr->bombed())||(dtr->bombed()))
+		goto test_failure;
+
+	printf("SUCCESS!!\n");
+	exit(EXIT_SUCCESS);
+test_failure:
+	printf("FAIL-HERE\n");
+	for(int i=0; i<8; i++)
+		dtr->tick();
+	printf("TEST FAILED\n");
+	exit(EXIT_FAILURE);
+}
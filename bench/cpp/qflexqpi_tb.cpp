@@ -0,0 +1,242 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	qflexqpi_tb.cpp
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	To determine whether or not the qflexpress controller works
+//		with the flash in QPI (4-4-4) mode, and how many clocks that
+//	saves.  Two controllers are built from the same source--one with
+//	OPT_QPI set, one without--and each is attached to its own FLASHSIM
+//	model holding the same data.  The test
+//
+//	1. Checks that the QPI controller's startup sequence leaves the flash
+//	   in QPI mode
+//	2. Reads single words from both controllers
+//	3. Reads the flash's status and ID registers through both
+//	   configuration ports, requiring the QPI reads to take fewer clocks
+//	4. Breaks out of XIP mode, returns to it, and reads a random word,
+//	   again requiring QPI to take fewer clocks
+//	5. Erases and programs the flash in QPI mode, reading back the
+//	   result
+//
+//	Run the simulation program this with no arguments, and then check
+//	whether or not the last line contains "SUCCESS" or not.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2015-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#include <stdlib.h>
+#include "verilated.h"
+#include "Vqflexpress.h"
+#include "Vqflexpressqpi.h"
+#include "byteswap.h"
+#include "qflex_tb.h"
+
+#define	NSINGLE		64
+#define	NREPEAT		16
+
+class	QPI_TB : public QFLEX_TB<Vqflexpressqpi> {
+public:
+	QPI_TB(void) {
+		m_qpi = true;
+	}
+
+	bool	flash_qpi(void) { return m_flash->qpi_mode(); }
+};
+
+// cfgclocks
+// {{{
+// Read the status and ID registers NREPEAT times, and return the number of
+// clocks taken--or zero on failure
+template<class TB>	unsigned long	cfgclocks(TB *tb) {
+	unsigned long	start;
+
+	tb->take_offline();
+	start = tb->m_tickcount;
+	for(int k=0; k<NREPEAT; k++) {
+		extern const unsigned DEVID;
+		unsigned	rdv;
+
+		if ((rdv = tb->flstatus()) & 1) {
+			printf("BOMB: Status register %02x, device is busy\n",
+				rdv);
+			return 0;
+		} if ((rdv = tb->flreadid()) != DEVID) {
+			printf("BOMB: ID read %08x, expected %08x\n",
+				rdv, DEVID);
+			return 0;
+		}
+	}
+
+	start = tb->m_tickcount - start;
+	tb->place_online();
+	return (tb->bombed()) ? 0 : start;
+}
+// }}}
+
+// xipclocks
+// {{{
+// Leave XIP mode and return to it NREPEAT times, reading a random word each
+// time, and return the number of clocks taken--or zero on failure
+template<class TB>	unsigned long	xipclocks(TB *tb, const char *name) {
+	unsigned long	start;
+
+	start = tb->m_tickcount;
+	for(int k=0; k<NREPEAT; k++) {
+		tb->take_offline();
+		tb->place_online();
+		if (!checkread(tb, name, rand() % (2*SECTORSZW)))
+			return 0;
+	}
+
+	return tb->m_tickcount - start;
+}
+// }}}
+
+int main(int  argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	QFLEX_TB<Vqflexpress>	*spi = new QFLEX_TB<Vqflexpress>;
+	QPI_TB			*qpi = new QPI_TB;
+	unsigned long		spiclocks, qpiclocks;
+
+	qpi->opentrace("qflexqpi.vcd");
+
+	srand(0x3456);
+	for(int i=0; i<2*SECTORSZW; i++) {
+		unsigned v = rand();
+		spi->set(i, v);
+		qpi->set(i, v);
+	}
+
+	// 1. Startup
+	// {{{
+	if ((!startup(spi))||(!startup(qpi)))
+		goto test_failure;
+
+	if (!checkread(qpi, "QPI", 0))
+		goto test_failure;
+	if (!qpi->flash_qpi()) {
+		printf("BOMB: The flash is not in QPI mode following startup\n");
+		goto test_failure;
+	}
+	printf("Startup completed\n");
+	// }}}
+
+	// 2. Single word reads
+	// {{{
+	for(int k=0; k<NSINGLE; k++) {
+		unsigned a = rand() % (2*SECTORSZW);
+
+		if (!checkread(spi, "SPI", a))
+			goto test_failure;
+		if (!checkread(qpi, "QPI", a))
+			goto test_failure;
+	}
+	printf("Single word reads:  PASS\n");
+	// }}}
+
+	// 3. Configuration port reads
+	// {{{
+	spiclocks = cfgclocks(spi);
+	qpiclocks = cfgclocks(qpi);
+	if ((spiclocks == 0)||(qpiclocks == 0))
+		goto test_failure;
+
+	printf("Status and ID reads: %ld clocks using QPI, %ld clocks without\n",
+		qpiclocks, spiclocks);
+	if (qpiclocks >= spiclocks) {
+		printf("BOMB: QPI configuration reads were not faster\n");
+		goto test_failure;
+	}
+	// }}}
+
+	// 4. Returning to XIP mode
+	// {{{
+	spiclocks = xipclocks(spi, "SPI");
+	qpiclocks = xipclocks(qpi, "QPI");
+	if ((spiclocks == 0)||(qpiclocks == 0))
+		goto test_failure;
+
+	printf("XIP break and read:  %ld clocks using QPI, %ld clocks without\n",
+		qpiclocks, spiclocks);
+	if (qpiclocks >= spiclocks) {
+		printf("BOMB: Returning to XIP mode was not faster in QPI\n");
+		goto test_failure;
+	}
+	// }}}
+
+	// 5. Erase and program
+	// {{{
+	qpi->flerase(SECTORSZB);
+	if (!qpi->flash_qpi()) {
+		printf("BOMB: The flash left QPI mode\n");
+		goto test_failure;
+	}
+	for(int k=0; k<16; k++) {
+		unsigned rdv = qpi->wb_read(SECTORSZB + 4*k);
+		if (rdv != 0xffffffff) {
+			printf("BOMB: READ[%08x] %08x after erase\n",
+				SECTORSZB+4*k, rdv);
+			goto test_failure;
+		}
+	}
+
+	{	char	buf[4];
+		buf[0] = 0x12;
+		buf[1] = 0x34;
+		buf[2] = 0x56;
+		buf[3] = 0x78;
+		qpi->flprogram(SECTORSZB+4, 4, buf);
+	}
+
+	if (!checkread(qpi, "QPI", SECTORSZW+1))
+		goto test_failure;
+	if ((*qpi)[SECTORSZW+1] != 0x12345678) {
+		printf("BOMB: The flash was not programmed\n");
+		goto test_failure;
+	}
+	printf("Erase and program:  PASS\n");
+	// }}}
+
+	if ((spi->bombed())||(qpi->bombed()))
+		goto test_failure;
+
+	printf("SUCCESS!!\n");
+	exit(EXIT_SUCCESS);
+test_failure:
+	printf("FAIL-HERE\n");
+	for(int i=0; i<8; i++)
+		qpi->tick();
+	printf("TEST FAILED\n");
+	exit(EXIT_FAILURE);
+}
@@ -0,0 +1,256 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	qflexremap_tb.cpp
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	To determine whether or not the address remapping of the
+//		qflexpress controller (OPT_REMAP) works.  Two images are
+//	placed in the flash, one at sector zero and one at sector eight.  The
+//	test
+//
+//	1. Runs the startup sequence, and checks that the remapping registers
+//	   are clear and that the first image is read as is
+//	2. Sets the OFFSET register to sector eight, and checks that both
+//	   single reads and a burst crossing a sector boundary now return the
+//	   second image
+//	3. Maps bus sector one back onto flash sector zero through a window,
+//	   and reads a burst across the boundary between the offset sector and
+//	   the window
+//	4. Sets an offset wrapping past the end of the flash
+//	5. Clears the registers, and checks that the first image returns
+//
+//	Run the simulation program this with no arguments, and then check
+//	whether or not the last line contains "SUCCESS" or not.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2015-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#include <stdlib.h>
+#include "verilated.h"
+#include "Vqflexpressmap.h"
+#include "byteswap.h"
+#include "qflex_tb.h"
+
+#define	NSINGLE		64
+#define	LONGBURST	256
+
+// The remapping registers, within the configuration space
+#define	R_OFFSET	0x02
+#define	R_REMAP(N)	(0x04+(N))
+#define	REMAP_EN	0x80000000
+#define	REMAP(BUS,FLASH)	(REMAP_EN|((BUS)<<16)|(FLASH))
+#define	OFFSET(SECTOR)	((SECTOR)<<16)
+
+// Where the second image lives, in sectors
+#define	IMAGE_B		8
+
+class	REMAP_TB : public QFLEX_TB<Vqflexpressmap> {
+public:
+	// setreg
+	// {{{
+	// Write a remapping register, and check that it reads back
+	bool	setreg(unsigned addr, unsigned v) {
+		unsigned	rdv;
+
+		reg_write(addr, v);
+		rdv = reg_read(addr);
+		if (rdv != v) {
+			printf("BOMB: REG[%d] <= %08x, READ %08x\n",
+				addr, v, rdv);
+			return false;
+		}
+
+		return !bombed();
+	}
+	// }}}
+};
+
+// where
+// {{{
+// Where a bus word address should be found in the flash, given the
+// remapping we've set up
+typedef	unsigned (*MAPFN)(unsigned);
+
+static unsigned	no_map(unsigned a) { return a; }
+static unsigned	offset_map(unsigned a) {
+	return (a + IMAGE_B * SECTORSZW) & ((NSECTORS*SECTORSZW)-1);
+}
+static unsigned	window_map(unsigned a) {
+	if (a / SECTORSZW == 1)
+		return a - SECTORSZW;
+	return offset_map(a);
+}
+static unsigned	wrap_map(unsigned a) {
+	return (a + (NSECTORS-1) * SECTORSZW) & ((NSECTORS*SECTORSZW)-1);
+}
+// }}}
+
+// checkread
+// {{{
+bool	checkread(REMAP_TB *tb, MAPFN fn, unsigned a) {
+	unsigned	rdv, exv;
+
+	rdv = tb->wb_read(a<<2);
+	exv = (*tb)[fn(a)];
+	if (rdv != exv) {
+		printf("BOMB: READ[%08x] %08x, EXPECTED %08x from %08x\n",
+			a<<2, rdv, exv, fn(a)<<2);
+		return false;
+	}
+
+	return !tb->bombed();
+}
+// }}}
+
+// singlereads
+// {{{
+bool	singlereads(REMAP_TB *tb, MAPFN fn) {
+	for(int k=0; k<NSINGLE; k++) {
+		if (!checkread(tb, fn, rand() % (2*SECTORSZW)))
+			return false;
+	} return true;
+}
+// }}}
+
+// burstread
+// {{{
+// Read LONGBURST words with one pipelined request, centered on the boundary
+// at the start of the given bus sector
+bool	burstread(REMAP_TB *tb, MAPFN fn, unsigned sector = 1) {
+	unsigned	*rdbuf = new unsigned[LONGBURST];
+	unsigned	a = sector * SECTORSZW - LONGBURST/2;
+	bool		pass = true;
+
+	tb->wb_read(a<<2, LONGBURST, rdbuf);
+
+	for(int k=0; k<LONGBURST; k++) {
+		if (rdbuf[k] != (*tb)[fn(a+k)]) {
+			printf("BOMB: READ[%08x] %08x, EXPECTED %08x from %08x\n",
+				(a+k)<<2, rdbuf[k], (*tb)[fn(a+k)],
+				fn(a+k)<<2);
+			pass = false;
+			break;
+		}
+	}
+
+	delete[] rdbuf;
+	return (pass)&&(!tb->bombed());
+}
+// }}}
+
+int main(int  argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	REMAP_TB	*tb = new REMAP_TB;
+
+	tb->opentrace("qflexremap.vcd");
+
+	// Two different images, each three sectors long, and something in the
+	// last sector for the offset to wrap onto
+	srand(0x5678);
+	for(int i=0; i<3*SECTORSZW; i++) {
+		tb->set(i, rand());
+		tb->set(IMAGE_B*SECTORSZW + i, rand());
+	} for(int i=0; i<SECTORSZW; i++)
+		tb->set((NSECTORS-1)*SECTORSZW + i, rand());
+
+	// 1. Startup, with no remapping
+	// {{{
+	if (!startup(tb))
+		goto test_failure;
+
+	for(int k=0; k<5; k++) {
+		unsigned	addr = (k==0) ? R_OFFSET : R_REMAP(k-1);
+		if (0 != tb->reg_read(addr)) {
+			printf("BOMB: REG[%d] not clear following reset\n",
+				addr);
+			goto test_failure;
+		}
+	}
+
+	if ((!singlereads(tb, no_map))||(!burstread(tb, no_map)))
+		goto test_failure;
+	printf("No remapping:   PASS\n");
+	// }}}
+
+	// 2. Switch to the second image
+	// {{{
+	if (!tb->setreg(R_OFFSET, OFFSET(IMAGE_B)))
+		goto test_failure;
+	if ((!singlereads(tb, offset_map))||(!burstread(tb, offset_map)))
+		goto test_failure;
+	printf("Offset:         PASS\n");
+	// }}}
+
+	// 3. Send bus sector one back to flash sector zero
+	// {{{
+	if (!tb->setreg(R_REMAP(2), REMAP(1, 0)))
+		goto test_failure;
+	if ((!singlereads(tb, window_map))||(!burstread(tb, window_map)))
+		goto test_failure;
+	printf("Window:         PASS\n");
+	// }}}
+
+	// 4. Wrap past the end of the flash
+	// {{{
+	if (!tb->setreg(R_REMAP(2), 0))
+		goto test_failure;
+	if (!tb->setreg(R_OFFSET, OFFSET(NSECTORS-1)))
+		goto test_failure;
+	// (The flash simulator doesn't wrap a read past its end, so the
+	// burst is kept from crossing it)
+	if ((!singlereads(tb, wrap_map))||(!burstread(tb, wrap_map, 2)))
+		goto test_failure;
+	printf("Wrapped offset: PASS\n");
+	// }}}
+
+	// 5. And back to no remapping at all
+	// {{{
+	if (!tb->setreg(R_OFFSET, 0))
+		goto test_failure;
+	if ((!singlereads(tb, no_map))||(!burstread(tb, no_map)))
+		goto test_failure;
+	printf("Cleared:        PASS\n");
+	// }}}
+
+	if (tb->bombed())
+		goto test_failure;
+
+	printf("SUCCESS!!\n");
+	exit(EXIT_SUCCESS);
+test_failure:
+	printf("FAIL-HERE\n");
+	for(int i=0; i<8; i++)
+		tb->tick();
+	printf("TEST FAILED\n");
+	exit(EXIT_FAILURE);
+}
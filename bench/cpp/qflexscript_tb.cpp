@@ -0,0 +1,170 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	qflexscript_tb.cpp
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	To determine whether or not a startup script loaded through
+//		OPT_STARTUP_FILE works.  Two controllers are built from the
+//	same source--one using its built-in script, the other given the
+//	spansion.hex script assembled by sw/flashscript--and each is attached
+//	to its own FLASHSIM model holding the same data.  The test
+//
+//	1. Checks that the loaded script leaves the flash in XIP mode, that
+//	   it waits for its register write to complete before reading, and
+//	   that it does so in fewer clocks than the built-in script
+//	2. Reads single words from both controllers
+//	3. Reads the flash's ID through the configuration port, returning to
+//	   XIP mode afterwards
+//
+//	Run the simulation program this with no arguments, and then check
+//	whether or not the last line contains "SUCCESS" or not.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2015-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#include <stdlib.h>
+#include "verilated.h"
+#include "Vqflexpress.h"
+#include "Vqflexpressscr.h"
+#include "byteswap.h"
+#include "qflex_tb.h"
+
+#define	NSINGLE		64
+
+template <class VA>	class	SCRIPT_TB : public QFLEX_TB<VA> {
+public:
+	bool	flash_xip(void) { return this->m_flash->xip_mode(); }
+	unsigned busy_reads(void) { return this->m_flash->busy_reads(); }
+};
+
+// startclocks
+// {{{
+// Run the startup script, returning the number of clocks it took--or zero
+// if it never completed
+template<class TB>	unsigned long	startclocks(TB *tb) {
+	if (!startup(tb))
+		return 0;
+	return tb->m_tickcount;
+}
+// }}}
+
+int main(int  argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	SCRIPT_TB<Vqflexpress>		*rom = new SCRIPT_TB<Vqflexpress>;
+	SCRIPT_TB<Vqflexpressscr>	*scr = new SCRIPT_TB<Vqflexpressscr>;
+	unsigned		rdv;
+	unsigned long		romclocks, scrclocks;
+
+	scr->opentrace("qflexscript.vcd");
+
+	srand(0x3456);
+	for(int i=0; i<2*SECTORSZW; i++) {
+		unsigned v = rand();
+		rom->set(i, v);
+		scr->set(i, v);
+	}
+
+	// 1. Startup
+	// {{{
+	romclocks = startclocks(rom);
+	scrclocks = startclocks(scr);
+	if ((romclocks == 0)||(scrclocks == 0))
+		goto test_failure;
+
+	if (!scr->flash_xip()) {
+		printf("BOMB: The flash is not in XIP mode following startup\n");
+		goto test_failure;
+	}
+
+	if (scr->busy_reads() != 0) {
+		printf("BOMB: The script read from the flash while it was busy\n");
+		goto test_failure;
+	}
+
+	printf("Startup: %ld clocks using spansion.hex, %ld clocks built-in\n",
+		scrclocks, romclocks);
+	if (scrclocks >= romclocks) {
+		printf("BOMB: The loaded script was no faster\n");
+		goto test_failure;
+	}
+	// }}}
+
+	// 2. Single word reads
+	// {{{
+	for(int k=0; k<NSINGLE; k++) {
+		unsigned a = rand() % (2*SECTORSZW);
+
+		if (!checkread(rom, "ROM", a))
+			goto test_failure;
+		if (!checkread(scr, "SCR", a))
+			goto test_failure;
+	}
+	printf("Single word reads:  PASS\n");
+	// }}}
+
+	// 3. The configuration port
+	// {{{
+	scr->take_offline();
+	if (scr->flash_xip()) {
+		printf("BOMB: The flash remained in XIP mode\n");
+		goto test_failure;
+	}
+	printf("ID     Register = 0x%08x\n", rdv = scr->flreadid());
+	{	extern const unsigned DEVID;
+		if (rdv != DEVID) {
+			printf("BOMB: ID read %08x, expected %08x\n",
+				rdv, DEVID);
+			goto test_failure;
+		}
+	}
+	scr->place_online();
+
+	for(int k=0; k<16; k++) {
+		if (!checkread(scr, "SCR", SECTORSZW + k))
+			goto test_failure;
+	}
+	printf("Configuration port: PASS\n");
+	// }}}
+
+	if ((rom->bombed())||(scr->bombed()))
+		goto test_failure;
+
+	printf("SUCCESS!!\n");
+	exit(EXIT_SUCCESS);
+test_failure:
+	printf("FAIL-HERE\n");
+	for(int i=0; i<8; i++)
+		scr->tick();
+	printf("TEST FAILED\n");
+	exit(EXIT_FAILURE);
+}
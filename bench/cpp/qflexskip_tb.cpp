@@ -0,0 +1,222 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	qflexskip_tb.cpp
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	A benchmark of the skip ahead window (SKIPAHEAD) of the
+//		qflexpress controller.  Three controllers are built from the
+//	same source, with SKIPAHEAD set to zero, one, and two words, each
+//	attached to its own FLASHSIM model holding the same data.  Each is
+//	then given the same instruction fetch trace: runs of sequential
+//	words, broken by short forward branches, loops back to the start of
+//	the run, and jumps elsewhere in the flash.  As a CPU's prefetch
+//	would, the trace presents the next address as soon as the last has
+//	been accepted.  The test
+//
+//	1. Checks every word fetched, for all three controllers
+//	2. Reports the clocks each took, and the number of clocks per fetch
+//	3. Checks that skipping a single word takes fewer clocks than
+//	   starting over with a new address
+//
+//	Run the simulation program this with no arguments, and then check
+//	whether or not the last line contains "SUCCESS" or not.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2015-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#include <stdlib.h>
+#include "verilated.h"
+#include "Vqflexpress.h"
+#include "Vqflexpressskip1.h"
+#include "Vqflexpressskip2.h"
+#include "byteswap.h"
+#include "qflex_tb.h"
+
+#define	NFETCH		4096
+#define	CODEWORDS	8192	// The size of the region fetched from
+
+// gentrace
+// {{{
+// Build a fetch trace of n word addresses.  Each run of sequential words
+// ends with a branch: half of them forward by one to three words, a
+// quarter back to the start of the run, and the rest anywhere at all.
+static void	gentrace(int n, unsigned *trace) {
+	unsigned	a = 0, runstart = 0;
+	int		k = 0;
+
+	while(k < n) {
+		int	runlen = 2 + (rand() % 7), br = rand() % 4;
+
+		for(int i=0; (i<runlen)&&(k<n); i++)
+			trace[k++] = a++;
+		a--;
+
+		if (br < 2)
+			// Skip over one to three words
+			a += 2 + (rand() % 3);
+		else if (br == 2)
+			a = runstart;
+		else
+			a = rand() % CODEWORDS;
+
+		a %= CODEWORDS;
+		runstart = a;
+	}
+}
+// }}}
+
+// traceread
+// {{{
+// Fetch every word of the trace within a single bus cycle, presenting
+// each address as soon as the one before it has been accepted.  Returns
+// the number of clocks taken--or zero on failure.
+template<class TB>	unsigned long	traceread(TB *tb, const char *name,
+			int n, const unsigned *trace) {
+	int		errcount = 0, cnt = 0, rdidx = 0;
+	unsigned long	start;
+
+	while((errcount++ < BOMBCOUNT)&&(tb->m_core->o_wb_stall))
+		tb->tick();
+
+	errcount = 0;
+	start = tb->m_tickcount;
+	tb->m_core->i_wb_cyc  = 1;
+	tb->m_core->i_wb_stb  = 1;
+	tb->m_core->i_cfg_stb = 0;
+	tb->m_core->i_wb_we   = 0;
+	tb->m_core->i_wb_addr = trace[0];
+
+	while((rdidx < n)&&(errcount++ < BOMBCOUNT * n)) {
+		int	s = (tb->m_core->o_wb_stall) ? 1:0;
+
+		tb->tick();
+		if ((tb->m_core->i_wb_stb)&&(!s)) {
+			if (++cnt < n)
+				tb->m_core->i_wb_addr = trace[cnt];
+			else
+				tb->m_core->i_wb_stb = 0;
+		}
+
+		if (tb->m_core->o_wb_ack) {
+			unsigned	exv = (*tb)[trace[rdidx]];
+
+			if (tb->m_core->o_wb_data != exv) {
+				printf("BOMB(%s): FETCH #%d, READ[%08x] %08x, EXPECTED %08x\n",
+					name, rdidx, trace[rdidx]<<2,
+					tb->m_core->o_wb_data, exv);
+				tb->m_core->i_wb_cyc = 0;
+				tb->m_core->i_wb_stb = 0;
+				return 0;
+			}
+			rdidx++;
+		}
+	}
+
+	tb->m_core->i_wb_cyc = 0;
+	tb->m_core->i_wb_stb = 0;
+
+	if (rdidx < n) {
+		printf("BOMB(%s): NO RESPONSE AFTER %d CLOCKS\n",
+			name, errcount);
+		return 0;
+	}
+
+	tb->tick();
+	return tb->m_tickcount - start;
+}
+// }}}
+
+int main(int  argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	QFLEX_TB<Vqflexpress>		*base  = new QFLEX_TB<Vqflexpress>;
+	QFLEX_TB<Vqflexpressskip1>	*skip1 = new QFLEX_TB<Vqflexpressskip1>;
+	QFLEX_TB<Vqflexpressskip2>	*skip2 = new QFLEX_TB<Vqflexpressskip2>;
+	unsigned	*trace = new unsigned[NFETCH];
+	unsigned long	bclocks, clocks1, clocks2;
+
+	skip1->opentrace("qflexskip.vcd");
+
+	srand(0xbcde);
+	for(unsigned i=0; i<CODEWORDS+4; i++) {
+		unsigned v = rand();
+		base->set(i, v);
+		skip1->set(i, v);
+		skip2->set(i, v);
+	}
+
+	if ((!startup(base))||(!startup(skip1))||(!startup(skip2)))
+		goto test_failure;
+
+	gentrace(NFETCH, trace);
+
+	// 1. Fetch the trace, checking every word
+	// {{{
+	bclocks = traceread(base,  "SKIP0", NFETCH, trace);
+	clocks1 = traceread(skip1, "SKIP1", NFETCH, trace);
+	clocks2 = traceread(skip2, "SKIP2", NFETCH, trace);
+	if ((bclocks == 0)||(clocks1 == 0)||(clocks2 == 0))
+		goto test_failure;
+	// }}}
+
+	// 2. Report the clocks each took
+	// {{{
+	printf("%d fetches:\n", NFETCH);
+	printf("  SKIPAHEAD=0: %7ld clocks, %5.2f per fetch\n",
+		bclocks, bclocks / (double)NFETCH);
+	printf("  SKIPAHEAD=1: %7ld clocks, %5.2f per fetch, %5.1f%% saved\n",
+		clocks1, clocks1 / (double)NFETCH,
+		100.0 * (1.0 - clocks1 / (double)bclocks));
+	printf("  SKIPAHEAD=2: %7ld clocks, %5.2f per fetch, %5.1f%% saved\n",
+		clocks2, clocks2 / (double)NFETCH,
+		100.0 * (1.0 - clocks2 / (double)bclocks));
+	// }}}
+
+	// 3. Skipping a word should beat a new address
+	// {{{
+	if (clocks1 >= bclocks) {
+		printf("BOMB: Skipping ahead saved nothing\n");
+		goto test_failure;
+	}
+	// }}}
+
+	delete[] trace;
+
+	printf("SUCCESS!!\n");
+	exit(EXIT_SUCCESS);
+test_failure:
+	printf("FAIL-HERE\n");
+	for(int i=0; i<8; i++)
+		skip1->tick();
+	printf("TEST FAILED\n");
+	exit(EXIT_FAILURE);
+}
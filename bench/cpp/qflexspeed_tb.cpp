@@ -0,0 +1,338 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	qflexspeed_tb.cpp
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	To determine whether or not the speed register of the
+//		qflexpress and dualflexpress controllers (OPT_SPEEDREG) works.
+//	Each controller is built with a clock divider of three, and attached
+//	to a FLASHSIM model.  The test, run on each in turn,
+//
+//	1. Runs the startup sequence at the reset speed, and checks that the
+//	   speed register reads back the build time values
+//	2. Reads single words, and then a long burst
+//	3. Switches the clock divider to one, and reads again, requiring the
+//	   burst to take no more than 60% of the clocks it took before
+//	4. Reads the flash's ID through the configuration port at the new
+//	   speed, returning to XIP mode afterwards
+//	5. Writes values out of range, checking that they are clipped, and
+//	   then reads once more with a divider of two
+//
+//	Run the simulation program this with no arguments, and then check
+//	whether or not the last line contains "SUCCESS" or not.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2015-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#include <stdlib.h>
+#include "verilated.h"
+#include "Vqflexpressspd.h"
+#include "Vdualflexpressspd.h"
+#include "byteswap.h"
+#include "qflex_tb.h"
+
+#define	NSINGLE		64
+#define	LONGBURST	256
+
+// The speed register, within the configuration space
+#define	R_SPEED		0x01
+#define	SPEED(DIV,DLY,NDUMMY)	(((DIV)<<24)|((DLY)<<20)|(NDUMMY))
+#define	SPEED_MASK	0xfff0001f
+
+// As built in rtl/Makefile: OPT_CLKDIV=3 and RDDELAY=0.  NDUMMY is left at
+// each controller's default: six for qflexpress, and eight for dualflexpress.
+#define	CLKDIV		3
+
+// QSPEED_TB
+// {{{
+class	QSPEED_TB : public QFLEX_TB<Vqflexpressspd> {
+public:
+	virtual	void	tick(void) {
+		// {{{
+		// With a divided clock, o_qspi_sck is the level of SCK itself,
+		// rather than a request for an SCK cycle
+		int	iqspi;
+
+		iqspi = (*m_flash)(m_core->o_qspi_cs_n, m_core->o_qspi_sck,
+				m_core->o_qspi_dat);
+
+		if (m_core->o_qspi_mod&2) {
+			if (m_core->o_qspi_mod&1) {
+				; // IQSPI is as given
+			} else
+				iqspi = m_core->o_qspi_dat;
+		} else {
+			iqspi &= 0x02;
+			iqspi |= m_core->o_qspi_dat&1;
+			iqspi |= m_core->o_qspi_dat&0x0c;
+		}
+
+		m_core->i_qspi_dat = iqspi;
+
+		WBFLASH_TB<Vqflexpressspd>::tick();
+		// }}}
+	}
+};
+// }}}
+
+// DSPEED_TB
+// {{{
+// dualflexpress, with its dual SPI pins attached to a FLASHSIM model
+class	DSPEED_TB : public WBFLASH_TB<Vdualflexpressspd> {
+	FLASHSIM	*m_flash;
+public:
+	DSPEED_TB(void) {
+		m_flash = new FLASHSIM(LGFLASHSZB);
+	}
+
+	~DSPEED_TB(void) {
+		delete	m_flash;
+	}
+
+	unsigned operator[](const int index) { return (*m_flash)[index]; }
+
+	void	set(const unsigned addr, const unsigned val) {
+		m_flash->set(addr, val);
+	}
+
+	virtual	void	tick(void) {
+		// {{{
+		// As above, o_dspi_sck is the level of SCK itself
+		int	idspi;
+
+		idspi = (*m_flash)(m_core->o_dspi_cs_n, m_core->o_dspi_sck,
+				m_core->o_dspi_dat);
+
+		if (m_core->o_dspi_mod&2) {
+			if (m_core->o_dspi_mod&1) {
+				; // IDSPI is as given
+			} else
+				idspi = m_core->o_dspi_dat;
+		} else {
+			idspi &= 0x02;
+			idspi |= m_core->o_dspi_dat&1;
+		}
+
+		m_core->i_dspi_dat = idspi;
+
+		WBFLASH_TB<Vdualflexpressspd>::tick();
+		// }}}
+	}
+
+	void	take_offline(void) {
+		cfg_write(F_END);
+		cfg_write(F_RESET);
+		cfg_write(F_RESET);
+		cfg_write(F_END);
+	}
+
+	void	place_online(void) {
+		// {{{
+		static	const	uint32_t DUAL_IO_READ = CFG_USERMODE|0xbb;
+		cfg_write(DUAL_IO_READ);
+		// 3 address bytes
+		cfg_write(CFG_USERMODE | CFG_DSPEED | CFG_WEDIR);
+		cfg_write(CFG_USERMODE | CFG_DSPEED | CFG_WEDIR);
+		cfg_write(CFG_USERMODE | CFG_DSPEED | CFG_WEDIR);
+		// mode byte
+		cfg_write(CFG_USERMODE | CFG_DSPEED | CFG_WEDIR | 0xa0);
+		// Read a dummy byte
+		cfg_write(CFG_USERMODE | CFG_DSPEED);
+		// Close the interface
+		cfg_write(0);
+		// }}}
+	}
+
+	unsigned flreadid(void) {
+		// {{{
+		unsigned	r;
+
+		cfg_write(F_READID);
+
+		cfg_write(CFG_USERMODE); r = cfg_read() & 0x0ff;
+		cfg_write(CFG_USERMODE); r = (r<<8) | (cfg_read() & 0x0ff);
+		cfg_write(CFG_USERMODE); r = (r<<8) | (cfg_read() & 0x0ff);
+		cfg_write(CFG_USERMODE); r = (r<<8) | (cfg_read() & 0x0ff);
+		cfg_write(F_END);
+
+		return r;
+		// }}}
+	}
+};
+// }}}
+
+// setspeed
+// {{{
+// Write the speed register, and check what was kept
+template<class TB>	bool	setspeed(TB *tb, const char *name,
+			unsigned v, unsigned exv) {
+	unsigned	rdv;
+
+	tb->reg_write(R_SPEED, v);
+	rdv = tb->reg_read(R_SPEED) & SPEED_MASK;
+	if (rdv != exv) {
+		printf("BOMB(%s): SPEED <= %08x, READ %08x, EXPECTED %08x\n",
+			name, v, rdv, exv);
+		return false;
+	}
+
+	return !tb->bombed();
+}
+// }}}
+
+// singlereads
+// {{{
+template<class TB>	bool	singlereads(TB *tb, const char *name) {
+	for(int k=0; k<NSINGLE; k++) {
+		if (0 == checkread(tb, name, rand() % (2*SECTORSZW)))
+			return false;
+	} return true;
+}
+// }}}
+
+// speedtest
+// {{{
+// Run the test above on one controller, whose reset speed uses ndummy dummy
+// cycles, clipped into ndmin--ndmax
+template<class TB>	bool	speedtest(TB *tb, const char *name,
+			unsigned ndummy, unsigned ndmin, unsigned ndmax) {
+	unsigned	rdv;
+	unsigned long	slowclocks, fastclocks;
+
+	for(int i=0; i<2*SECTORSZW; i++)
+		tb->set(i, rand());
+
+	// 1. Startup, at the reset speed
+	// {{{
+	if (!startup(tb))
+		return false;
+
+	rdv = tb->reg_read(R_SPEED) & SPEED_MASK;
+	if (rdv != SPEED(CLKDIV, 0, ndummy)) {
+		printf("BOMB(%s): SPEED = %08x following reset, expected %08x\n",
+			name, rdv, SPEED(CLKDIV, 0, ndummy));
+		return false;
+	}
+	printf("%s: Startup completed\n", name);
+	// }}}
+
+	// 2. Reads at the reset speed
+	// {{{
+	if (!singlereads(tb, name))
+		return false;
+	if (0 == (slowclocks = burstread(tb, name, SECTORSZW, LONGBURST)))
+		return false;
+	printf("%s: Reads, divided by %d:  PASS\n", name, CLKDIV);
+	// }}}
+
+	// 3. Switch to the fastest speed, and read again
+	// {{{
+	if (!setspeed(tb, name, SPEED(1, 0, ndummy), SPEED(1, 0, ndummy)))
+		return false;
+	if (!singlereads(tb, name))
+		return false;
+	if (0 == (fastclocks = burstread(tb, name, SECTORSZW, LONGBURST)))
+		return false;
+
+	printf("%s: %d words: %ld clocks divided by one, %ld divided by %d\n",
+		name, LONGBURST, fastclocks, slowclocks, CLKDIV);
+	if (fastclocks * 10 > slowclocks * 6) {
+		printf("BOMB(%s): The faster clock was not (much) faster\n",
+			name);
+		return false;
+	}
+	// }}}
+
+	// 4. The configuration port, at the faster speed
+	// {{{
+	tb->take_offline();
+	printf("%s: ID     Register = 0x%08x\n", name, rdv = tb->flreadid());
+	{	extern const unsigned DEVID;
+		if (rdv != DEVID) {
+			printf("BOMB(%s): ID read %08x, expected %08x\n",
+				name, rdv, DEVID);
+			return false;
+		}
+	}
+	tb->place_online();
+	if (!singlereads(tb, name))
+		return false;
+	printf("%s: Configuration port: PASS\n", name);
+	// }}}
+
+	// 5. Out of range values are clipped
+	// {{{
+	if (!setspeed(tb, name, SPEED(0, 15, 31), SPEED(1, 0, ndmax)))
+		return false;
+	if (!setspeed(tb, name, SPEED(255, 0, 0), SPEED(CLKDIV, 0, ndmin)))
+		return false;
+	if (!setspeed(tb, name, SPEED(2, 0, ndummy), SPEED(2, 0, ndummy)))
+		return false;
+	if (!singlereads(tb, name))
+		return false;
+	printf("%s: Speed register: PASS\n", name);
+	// }}}
+
+	return !tb->bombed();
+}
+// }}}
+
+int main(int  argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	QSPEED_TB	*qtb = new QSPEED_TB;
+	DSPEED_TB	*dtb = new DSPEED_TB;
+
+	qtb->opentrace("qflexspeed.vcd");
+	dtb->opentrace("dflexspeed.vcd");
+
+	srand(0x3456);
+
+	// qflexpress: NDUMMY=6, clipped into 2--16
+	if (!speedtest(qtb, "QUAD", 6, 2, 16))
+		goto test_failure;
+
+	// dualflexpress: NDUMMY=8, clipped into 4--31
+	if (!speedtest(dtb, "DUAL", 8, 4, 31))
+		goto test_failure;
+
+	printf("SUCCESS!!\n");
+	exit(EXIT_SUCCESS);
+test_failure:
+	printf("FAIL-HERE\n");
+	for(int i=0; i<8; i++) {
+		qtb->tick();
+		dtb->tick();
+	}
+	printf("TEST FAILED\n");
+	exit(EXIT_FAILURE);
+}
@@ -0,0 +1,298 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	qflexwide_tb.cpp
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	To determine whether or not the wide (DW=64 and DW=128) bus
+//		options of the qflexpress and dualflexpress controllers work.
+//	Three of each controller are built from the same source, one with each
+//	of DW=32, 64, and 128, each attached to its own FLASHSIM model holding
+//	the same data.  The test, run on the quad and then the dual
+//	controllers,
+//
+//	1. Reads single bus words from the wide controllers, and checks that
+//	   each holds the flash words at its address, the first in its most
+//	   significant bits
+//	2. Reads the same burst from all three, checking the data, and
+//	   comparing the number of bus beats and clocks each took.  The wide
+//	   controllers should need a half and a quarter of the beats, in (up
+//	   to a clock or two at the end) no more clocks.
+//
+//	Run the simulation program this with no arguments, and then check
+//	whether or not the last line contains "SUCCESS" or not.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2015-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#include <stdlib.h>
+#include "verilated.h"
+#include "Vqflexpress.h"
+#include "Vqflexpressw64.h"
+#include "Vqflexpressw128.h"
+#include "Vdualflexpress.h"
+#include "Vdualflexpressw64.h"
+#include "Vdualflexpressw128.h"
+#include "byteswap.h"
+#include "qflex_tb.h"
+#include "wbwide_tb.h"
+
+#define	NSINGLE		64
+#define	LONGBURST	256	// In 32-bit words
+// How many more clocks a wide burst may take, while its last word is
+// assembled
+#define	SLACK_CLOCKS	4
+
+typedef	QFLEX_TB<Vqflexpress>	NARROW_TB;
+typedef	QFLEX_TB<Vqflexpressw64,  WBWIDE_TB<Vqflexpressw64,  2> > W64_TB;
+typedef	QFLEX_TB<Vqflexpressw128, WBWIDE_TB<Vqflexpressw128, 4> > W128_TB;
+
+// DFLEX_TB
+// {{{
+// dualflexpress, with its dual SPI pins attached to a FLASHSIM model
+template <class VA, class BASE = WBFLASH_TB<VA> >
+		class	DFLEX_TB : public BASE {
+	FLASHSIM	*m_flash;
+	int		m_lastsck;
+public:
+	DFLEX_TB(void) {
+		m_flash = new FLASHSIM(LGFLASHSZB);
+		m_lastsck = 0;
+	}
+
+	virtual	~DFLEX_TB(void) {
+		delete	m_flash;
+	}
+
+	unsigned operator[](const int index) { return (*m_flash)[index]; }
+
+	void	set(const unsigned addr, const unsigned val) {
+		m_flash->set(addr, val);
+	}
+
+	virtual	void	tick(void) {
+		// {{{
+		VA	*core = TESTB<VA>::m_core;
+		int	idspi;
+
+		if (m_lastsck)
+			(*m_flash)(core->o_dspi_cs_n, 0, core->o_dspi_dat);
+
+		idspi = (*m_flash)(core->o_dspi_cs_n, 1, core->o_dspi_dat);
+
+		if (core->o_dspi_mod&2) {
+			if (core->o_dspi_mod&1) {
+				; // IDSPI is as given
+			} else
+				idspi = core->o_dspi_dat;
+		} else {
+			idspi &= 0x02;
+			idspi |= core->o_dspi_dat&1;
+		}
+
+		core->i_dspi_dat = idspi;
+		m_lastsck = core->o_dspi_sck;
+
+		BASE::tick();
+		// }}}
+	}
+};
+// }}}
+
+typedef	DFLEX_TB<Vdualflexpress>	DNARROW_TB;
+typedef	DFLEX_TB<Vdualflexpressw64,  WBWIDE_TB<Vdualflexpressw64,  2> > DW64_TB;
+typedef	DFLEX_TB<Vdualflexpressw128, WBWIDE_TB<Vdualflexpressw128, 4> > DW128_TB;
+
+// checkwide
+// {{{
+// Check nwords 32-bit words, read from a controller with NW words per bus
+// word, against the flash starting at word address a.  Verilator places
+// the least significant word of a wide port first, while the first word
+// read from the flash lands in the most significant bits.
+template<class TB>	bool	checkwide(TB *tb, const char *name, int NW,
+			unsigned a, int nwords, const unsigned *buf) {
+	for(int k=0; k<nwords; k++) {
+		unsigned	exv = (*tb)[a + (k/NW)*NW + (NW-1-(k%NW))];
+
+		if (buf[k] != exv) {
+			printf("BOMB(%s): READ[%08x].%d %08x, EXPECTED %08x\n",
+				name, (a+(k/NW)*NW)<<2, k%NW, buf[k], exv);
+			return false;
+		}
+	} return true;
+}
+// }}}
+
+// singlereads
+// {{{
+// Read NSINGLE bus words from random addresses, one at a time
+template<class TB>	bool	singlereads(TB *tb, const char *name,
+			int NW, unsigned nwords) {
+	unsigned	rdbuf[4];
+
+	for(int k=0; k<NSINGLE; k++) {
+		unsigned a = (rand() % (nwords/NW)) * NW;
+
+		tb->wide_read(a/NW, 1, rdbuf);
+		if ((tb->bombed())||(!checkwide(tb, name, NW, a, NW, rdbuf)))
+			return false;
+	} return true;
+}
+// }}}
+
+// burstread
+// {{{
+// Read LONGBURST words in a single pipelined burst of LONGBURST/NW bus
+// words, check them, and return the number of clocks taken--or zero on
+// failure
+template<class TB>	unsigned long	burstread(TB *tb, const char *name,
+			int NW, unsigned a) {
+	unsigned	*rdbuf = new unsigned[LONGBURST];
+	unsigned long	start, clocks;
+
+	start = tb->m_tickcount;
+	tb->wide_read(a/NW, LONGBURST/NW, rdbuf);
+	clocks = tb->m_tickcount - start;
+
+	if ((tb->bombed())||(!checkwide(tb, name, NW, a, LONGBURST, rdbuf)))
+		clocks = 0;
+
+	delete[] rdbuf;
+	return clocks;
+}
+// }}}
+
+// widetest
+// {{{
+// Run the test above on one set of three controllers, returning false on any
+// failure
+template<class NTB, class WTB, class XTB>	bool	widetest(
+			const char *name, NTB *narrow, WTB *w64, XTB *w128) {
+	const unsigned	NWORDS = (1<<(LGFLASHSZB-2)), BURSTADDR = 4*LONGBURST;
+	unsigned	*rdbuf = new unsigned[LONGBURST];
+	unsigned long	nclocks, w64clocks, w128clocks, start;
+	bool		pass = false;
+
+	for(unsigned i=0; i<NWORDS; i+= 61) {
+		unsigned v = rand();
+		narrow->set(i, v);
+		w64->set(i, v);
+		w128->set(i, v);
+	} for(unsigned i=0; i<2*LONGBURST; i++) {
+		unsigned v = rand();
+		narrow->set(BURSTADDR+i, v);
+		w64->set(BURSTADDR+i, v);
+		w128->set(BURSTADDR+i, v);
+	}
+
+	if ((!startup(narrow))||(!startup(w64))||(!startup(w128)))
+		goto done;
+
+	// 1. Single bus word reads
+	// {{{
+	if ((!singlereads(w64, "W64", 2, NWORDS))
+			||(!singlereads(w128, "W128", 4, NWORDS)))
+		goto done;
+	printf("%s: Single reads:   PASS\n", name);
+	// }}}
+
+	// 2. A long burst
+	// {{{
+	start = narrow->m_tickcount;
+	narrow->wb_read(BURSTADDR<<2, LONGBURST, rdbuf);
+	nclocks = narrow->m_tickcount - start;
+	for(int k=0; k<LONGBURST; k++) {
+		if (rdbuf[k] != (*narrow)[BURSTADDR+k]) {
+			printf("BOMB(NARROW): READ[%08x] %08x, EXPECTED %08x\n",
+				(BURSTADDR+k)<<2, rdbuf[k],
+				(*narrow)[BURSTADDR+k]);
+			goto done;
+		}
+	}
+
+	w64clocks  = burstread(w64,  "W64",  2, BURSTADDR);
+	w128clocks = burstread(w128, "W128", 4, BURSTADDR);
+	if ((narrow->bombed())||(w64clocks == 0)||(w128clocks == 0))
+		goto done;
+
+	printf("%s: %d words: %4ld clocks, %3d beats at DW=32\n",
+		name, LONGBURST, nclocks, LONGBURST);
+	printf("%s: %d words: %4ld clocks, %3d beats at DW=64\n",
+		name, LONGBURST, w64clocks, LONGBURST/2);
+	printf("%s: %d words: %4ld clocks, %3d beats at DW=128\n",
+		name, LONGBURST, w128clocks, LONGBURST/4);
+	if ((w64clocks > nclocks + SLACK_CLOCKS)
+			||(w128clocks > nclocks + SLACK_CLOCKS)) {
+		printf("BOMB(%s): The wide bursts should take no more clocks\n",
+			name);
+		goto done;
+	}
+	printf("%s: Bursts:         PASS\n", name);
+	// }}}
+
+	pass = true;
+done:
+	delete[] rdbuf;
+	return pass;
+}
+// }}}
+
+int main(int  argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	NARROW_TB	*narrow = new NARROW_TB;
+	W64_TB		*w64    = new W64_TB;
+	W128_TB		*w128   = new W128_TB;
+	DNARROW_TB	*dnarrow = new DNARROW_TB;
+	DW64_TB		*dw64    = new DW64_TB;
+	DW128_TB	*dw128   = new DW128_TB;
+
+	w128->opentrace("qflexwide.vcd");
+	dw128->opentrace("dflexwide.vcd");
+
+	srand(0x789a);
+
+	if (!widetest("QUAD", narrow, w64, w128))
+		goto test_failure;
+	if (!widetest("DUAL", dnarrow, dw64, dw128))
+		goto test_failure;
+
+	printf("SUCCESS!!\n");
+	exit(EXIT_SUCCESS);
+test_failure:
+	printf("FAIL-HERE\n");
+	for(int i=0; i<8; i++) {
+		w128->tick();
+		dw128->tick();
+	}
+	printf("TEST FAILED\n");
+	exit(EXIT_FAILURE);
+}
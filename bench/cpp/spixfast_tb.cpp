@@ -0,0 +1,197 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	spixfast_tb.cpp
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	To determine whether or not the fast read (OPT_FASTREAD) and
+//		four byte address options of the spixpress controller work.
+//	Two controllers are built from the same source: one as is, using the
+//	8'h03 read command, and one with OPT_FASTREAD set and LGFLASHSZ=25,
+//	using the 8'h0c (four byte address fast read) command.  Each is
+//	attached to its own FLASHSIM model.  The test
+//
+//	1. Reads single words from both controllers, and checks that a fast
+//	   read with a four byte address takes exactly sixteen clocks more
+//	   than a normal read: eight for the dummy byte, eight for the extra
+//	   address byte
+//	2. Reads a burst from both, where the difference should remain
+//	   sixteen clocks, since only the first word sends an address
+//	3. Reads from above 16MB, where only a four byte address will reach
+//
+//	Run the simulation program this with no arguments, and then check
+//	whether or not the last line contains "SUCCESS" or not.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2015-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#include <stdlib.h>
+#include "verilated.h"
+#include "Vspixpress.h"
+#include "Vspixpressfast.h"
+#include "flashsim.h"
+#include "wbflash_tb.h"
+
+#define	NSINGLE		64
+#define	LONGBURST	64
+// The extra clocks of each new address: a dummy byte and an address byte
+#define	EXTRA_CLOCKS	16
+
+static const unsigned	CFG_USER_CS_n = 0x0100;
+
+template <class VA>	class	SPIX_TB : public WBFLASH_TB<VA> {
+	FLASHSIM	*m_flash;
+	int		m_flash_last_sck;
+public:
+	const unsigned	m_lgflashsz;
+
+	SPIX_TB(const unsigned lgflashsz) : m_lgflashsz(lgflashsz) {
+		m_flash = new FLASHSIM(lgflashsz);
+		m_flash_last_sck = 0;
+	}
+
+	~SPIX_TB(void) {
+		delete	m_flash;
+	}
+
+	unsigned operator[](const int index) { return (*m_flash)[index]; }
+
+	void	set(const unsigned addr, const unsigned val) {
+		m_flash->set(addr, val);
+	}
+
+	void	tick(void) {
+		VA	*core = TESTB<VA>::m_core;
+
+		if (m_flash_last_sck)
+			(*m_flash)(core->o_spi_cs_n, 0, core->o_spi_mosi);
+		core->i_spi_miso = ((*m_flash)(core->o_spi_cs_n, 1,
+				core->o_spi_mosi)&2)?1:0;
+		m_flash_last_sck = core->o_spi_sck;
+
+		WBFLASH_TB<VA>::tick();
+	}
+
+	// The configuration (user) mode follows CS_n, bit 8
+	bool	cfg_user_mode(unsigned v) {
+		return (v & CFG_USER_CS_n) == 0;
+	}
+};
+
+int main(int  argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	SPIX_TB<Vspixpress>	*slow = new SPIX_TB<Vspixpress>(24);
+	SPIX_TB<Vspixpressfast>	*fast = new SPIX_TB<Vspixpressfast>(25);
+	const unsigned		NWORDS = (1<<(24-2)), HIWORD = NWORDS;
+	unsigned long		slowclocks, fastclocks;
+
+	fast->opentrace("spixfast.vcd");
+
+	srand(0x4567);
+	for(unsigned i=0; i<NWORDS; i+= 61) {
+		unsigned v = rand();
+		slow->set(i, v);
+		fast->set(i, v);
+		// Something different for the upper half of the larger flash
+		fast->set(HIWORD+i, ~v);
+	}
+	for(unsigned i=0; i<2*LONGBURST; i++) {
+		unsigned v = rand();
+		slow->set(i, v);
+		fast->set(i, v);
+		fast->set(HIWORD+i, ~v);
+	}
+
+	slow->tick();
+	fast->tick();
+
+	// 1. Single word reads
+	// {{{
+	for(int k=0; k<NSINGLE; k++) {
+		unsigned a = (rand() % (NWORDS/61)) * 61;
+
+		slowclocks = checkread(slow, "SLOW", a);
+		fastclocks = checkread(fast, "FAST", a);
+		if ((slowclocks == 0)||(fastclocks == 0))
+			goto test_failure;
+		if (fastclocks != slowclocks + EXTRA_CLOCKS) {
+			printf("BOMB: A single read took %ld clocks, %ld without OPT_FASTREAD\n",
+				fastclocks, slowclocks);
+			goto test_failure;
+		}
+	}
+	printf("Single word reads:  PASS (%ld clocks, %ld without OPT_FASTREAD)\n",
+		fastclocks, slowclocks);
+	// }}}
+
+	// 2. Bursts
+	// {{{
+	slowclocks = burstread(slow, "SLOW", LONGBURST, LONGBURST);
+	fastclocks = burstread(fast, "FAST", LONGBURST, LONGBURST);
+	if ((slowclocks == 0)||(fastclocks == 0))
+		goto test_failure;
+
+	printf("%d words: %ld clocks using OPT_FASTREAD, %ld clocks without\n",
+		LONGBURST, fastclocks, slowclocks);
+	if (fastclocks != slowclocks + EXTRA_CLOCKS) {
+		printf("BOMB: The burst should only have cost %d extra clocks\n",
+			EXTRA_CLOCKS);
+		goto test_failure;
+	}
+	// }}}
+
+	// 3. Four byte addresses
+	// {{{
+	for(int k=0; k<NSINGLE; k++) {
+		unsigned a = HIWORD + (rand() % (NWORDS/61)) * 61;
+
+		if (0 == checkread(fast, "FAST", a))
+			goto test_failure;
+	}
+
+	if (0 == burstread(fast, "FAST", HIWORD + LONGBURST, LONGBURST))
+		goto test_failure;
+	printf("Reads beyond 16MB:  PASS\n");
+	// }}}
+
+	if ((slow->bombed())||(fast->bombed()))
+		goto test_failure;
+
+	printf("SUCCESS!!\n");
+	exit(EXIT_SUCCESS);
+test_failure:
+	printf("FAIL-HERE\n");
+	for(int i=0; i<8; i++)
+		fast->tick();
+	printf("TEST FAILED\n");
+	exit(EXIT_FAILURE);
+}
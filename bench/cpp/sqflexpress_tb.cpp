@@ -0,0 +1,445 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	sqflexpress_tb.cpp
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	To determine whether or not the striped, dual device, quad
+//		SPI flash controller, sqflexpress, works, and how much faster
+//	it is than a single quad SPI flash controller.  Two FLASHSIM models are
+//	attached to sqflexpress, one on each nibble of its data pins, while a
+//	third, holding the same data, is attached to a plain qflexpress
+//	controller.  The test
+//
+//	1. Checks that both devices are left in XIP mode following startup
+//	2. Reads single words from both controllers
+//	3. Reads a long burst from both, and requires the striped read to
+//	   take no more than 60% of the clocks taken by the single device
+//	4. Reads the ID of both devices, then erases and programs them
+//	   through the configuration port, splitting each byte between the
+//	   two, returning to XIP reads afterwards and reading back the result
+//
+//	Run the simulation program this with no arguments, and then check
+//	whether or not the last line contains "SUCCESS" or not.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2015-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#include <stdlib.h>
+#include "verilated.h"
+#include "Vqflexpress.h"
+#include "Vsqflexpress.h"
+#include "byteswap.h"
+#include "qflex_tb.h"
+
+#define	NSINGLE		64
+#define	LONGBURST	256
+#define	NCHIPS		2
+
+class	STRIPE_TB : public WBFLASH_TB<Vsqflexpress> {
+	FLASHSIM	*m_flash[NCHIPS];
+	int		m_lastsck;
+
+	// both
+	// {{{
+	// Commands, addresses, and the mode byte go to both devices: chip
+	// zero's byte is in bits [7:0] of the configuration word, chip one's
+	// in [23:16]
+	unsigned both(const unsigned v) const {
+		return v | ((v & 0x0ff) << 16); }
+	// }}}
+
+	// nibbles
+	// {{{
+	// Gathers either the lower (chip zero) or the upper (chip one)
+	// nibbles of each of the four bytes of v
+	static unsigned nibbles(const unsigned v, const int chip) {
+		unsigned	r = 0;
+
+		for(int k=3; k>=0; k--)
+			r = (r << 4) | ((v >> (8*k + 4*chip)) & 0x0f);
+		return r;
+	}
+	// }}}
+public:
+	STRIPE_TB(void) {
+		// {{{
+		for(int k=0; k<NCHIPS; k++)
+			m_flash[k] = new FLASHSIM(LGFLASHSZB);
+		m_lastsck = 0;
+		// }}}
+	}
+
+	virtual	~STRIPE_TB(void) {
+		for(int k=0; k<NCHIPS; k++)
+			delete	m_flash[k];
+	}
+
+	// operator[], set
+	// {{{
+	// Word w is split into two halfwords, one in each device, found in
+	// word w/2 of each: the upper half if w is even, the lower if odd
+	unsigned operator[](const int index) {
+		unsigned	r = 0, half[NCHIPS];
+
+		for(int k=0; k<NCHIPS; k++) {
+			half[k] = (*m_flash[k])[index>>1];
+			if (0 == (index & 1))
+				half[k] >>= 16;
+			half[k] &= 0x0ffff;
+		}
+
+		for(int k=3; k>=0; k--) {
+			r = (r << 8) | (((half[1] >> (4*k)) & 0x0f) << 4)
+					| ((half[0] >> (4*k)) & 0x0f);
+		}
+		return r;
+	}
+
+	void	set(const unsigned addr, const unsigned val) {
+		for(int k=0; k<NCHIPS; k++) {
+			unsigned	v = (*m_flash[k])[addr>>1];
+
+			if (addr & 1)
+				v = (v & 0xffff0000) | nibbles(val, k);
+			else
+				v = (v & 0x0000ffff) | (nibbles(val, k) << 16);
+			m_flash[k]->set(addr>>1, v);
+		}
+	}
+	// }}}
+
+	bool	xip_mode(void) {
+		return m_flash[0]->xip_mode() && m_flash[1]->xip_mode(); }
+
+	virtual	void	tick(void) {
+		// {{{
+		int	iqspi = 0;
+
+		for(int k=0; k<NCHIPS; k++) {
+			int	odat, idat;
+
+			odat = (m_core->o_qspi_dat >> (4*k)) & 0x0f;
+
+			if (m_lastsck)
+				(*m_flash[k])(m_core->o_qspi_cs_n, 0, odat);
+
+			idat = (*m_flash[k])(m_core->o_qspi_cs_n, 1, odat);
+
+			if (m_core->o_qspi_mod&2) {
+				if (m_core->o_qspi_mod&1) {
+					; // IDSPI is as given
+				} else
+					idat = odat;
+			} else {
+				idat &= 0x02;
+				idat |= odat&1;
+				idat |= odat&0x0c;
+			}
+
+			iqspi |= (idat & 0x0f) << (4*k);
+		}
+
+		m_core->i_qspi_dat = iqspi;
+		m_lastsck = m_core->o_qspi_sck;
+
+		WBFLASH_TB<Vsqflexpress>::tick();
+		// }}}
+	}
+
+	void	take_offline(void) {
+		// {{{
+		cfg_write(F_END);
+		cfg_write(both(F_RESET));
+		cfg_write(both(F_RESET));
+		cfg_write(F_END);
+		// }}}
+	}
+
+	void	place_online(void) {
+		// {{{
+		static	const	uint32_t QUAL_IO_READ = CFG_USERMODE|0xeb;
+		cfg_write(both(QUAL_IO_READ));
+		// 3 address bytes
+		cfg_write(CFG_USERMODE | CFG_QSPEED | CFG_WEDIR);
+		cfg_write(CFG_USERMODE | CFG_QSPEED | CFG_WEDIR);
+		cfg_write(CFG_USERMODE | CFG_QSPEED | CFG_WEDIR);
+		// mode byte
+		cfg_write(both(CFG_USERMODE | CFG_QSPEED | CFG_WEDIR | 0xa0));
+		// Read a dummy byte
+		cfg_write(CFG_USERMODE | CFG_QSPEED);
+		// Close the interface
+		cfg_write(0);
+		// }}}
+	}
+
+	// flreadid
+	// {{{
+	// Returns the ID of device chip
+	unsigned flreadid(const int chip) {
+		unsigned	r = 0;
+
+		take_offline();
+		cfg_write(both(F_READID));
+		for(int k=0; k<4; k++) {
+			cfg_write(CFG_USERMODE);
+			r = (r << 8) | ((cfg_read() >> (16*chip)) & 0x0ff);
+		}
+		cfg_write(F_END);
+		place_online();
+
+		return r;
+	}
+	// }}}
+
+	void	flwait(void) {
+		// {{{
+		int	r;
+
+		cfg_write(both(F_RDSR));
+		do {
+			cfg_write(CFG_USERMODE);
+			r = cfg_read();
+		} while (r & 0x010001); // Wait while either device is busy
+		cfg_write(F_END);
+		// }}}
+	}
+
+	void	flwren(void) {
+		cfg_write(F_END);
+		cfg_write(both(F_WREN));
+		cfg_write(F_END);
+	}
+
+	void	flsendaddr(const unsigned chipaddr) {
+		// {{{
+		cfg_write(both(CFG_USERMODE|((chipaddr >> 16)&0x0ff)));
+		cfg_write(both(CFG_USERMODE|((chipaddr >>  8)&0x0ff)));
+		cfg_write(both(CFG_USERMODE|((chipaddr      )&0x0ff)));
+		// }}}
+	}
+
+	// flerase
+	// {{{
+	// Erases the (logical) sector containing addr.  As each device holds
+	// half of it, a logical sector is twice the size of a device's sector
+	void	flerase(unsigned addr) {
+		take_offline();
+		flwren();
+
+		cfg_write(both(F_SE));
+		flsendaddr(SECTOROF(addr >> 1));
+		cfg_write(F_END);
+
+		flwait();
+
+		place_online();
+	}
+	// }}}
+
+	// flpage_program
+	// {{{
+	// Programs ln bytes into each device, starting at chipaddr, from the
+	// 2*ln bytes of buf.  Each device byte holds a nibble from each of
+	// two logical bytes.
+	void	flpage_program(unsigned chipaddr, int ln, const char *buf) {
+		flwait();
+		flwren();
+
+		cfg_write(both(F_PP));
+		flsendaddr(chipaddr);
+
+		for(int i=0; i<ln; i++) {
+			unsigned	b0 = buf[2*i] & 0x0ff,
+					b1 = buf[2*i+1] & 0x0ff,
+					c0, c1;
+
+			c0 = ((b0 & 0x0f) << 4) | (b1 & 0x0f);
+			c1 = (b0 & 0xf0) | (b1 >> 4);
+			cfg_write(CFG_USERMODE | c0 | (c1 << 16));
+		}
+		cfg_write(F_END);
+
+		flwait();
+	}
+	// }}}
+
+	// flprogram
+	// {{{
+	// Both addr and ln must be even, since every byte of each device holds
+	// a nibble from two logical bytes
+	void	flprogram(unsigned addr, int ln, const char *buf) {
+		unsigned	start = addr >> 1, last = (addr + ln) >> 1;
+
+		assert(((addr | ln) & 1) == 0);
+
+		take_offline();
+		while(start < last) {
+			unsigned	wlen;
+
+			if (PAGEOF(last-1) != PAGEOF(start))
+				wlen = PAGEOF(start+PGLENB)-start;
+			else
+				wlen = last-start;
+
+			flpage_program(start, wlen, &buf[2*start-addr]);
+			start = PAGEOF(start+PGLENB);
+		}
+
+		place_online();
+	}
+	// }}}
+};
+
+int main(int  argc, char **argv) {
+	Verilated::commandArgs(argc, argv);
+	QFLEX_TB<Vqflexpress>	*qspi = new QFLEX_TB<Vqflexpress>;
+	STRIPE_TB		*sq = new STRIPE_TB;
+	unsigned		rdv;
+	unsigned long		qclocks, sqclocks;
+	const unsigned		PGMADDR = 2*SECTORSZB;
+
+	sq->opentrace("sqflexpress.vcd");
+
+	srand(0x3456);
+	// Fill two of each device's sectors, so that the erase below has
+	// something to erase
+	for(int i=0; i<4*SECTORSZW; i++) {
+		unsigned v = rand();
+		qspi->set(i, v);
+		sq->set(i, v);
+	}
+
+	// 1. Startup
+	// {{{
+	if ((!startup(qspi))||(!startup(sq)))
+		goto test_failure;
+
+	if (!checkread(sq, "STRIPED", 0))
+		goto test_failure;
+	if (!sq->xip_mode()) {
+		printf("BOMB: Both devices are not in XIP mode following startup\n");
+		goto test_failure;
+	}
+	printf("Startup completed\n");
+	// }}}
+
+	// 2. Single word reads
+	// {{{
+	for(int k=0; k<NSINGLE; k++) {
+		unsigned a = rand() % (2*SECTORSZW);
+
+		if (!checkread(qspi, "QSPI", a))
+			goto test_failure;
+		if (!checkread(sq, "STRIPED", a))
+			goto test_failure;
+	}
+	printf("Single word reads:  PASS\n");
+	// }}}
+
+	// 3. Burst throughput
+	// {{{
+	qclocks  = burstread(qspi, "QSPI", SECTORSZW, LONGBURST);
+	sqclocks = burstread(sq, "STRIPED", SECTORSZW, LONGBURST);
+	if ((qclocks == 0)||(sqclocks == 0))
+		goto test_failure;
+
+	printf("%d words: %ld clocks striped, %ld clocks with one device\n",
+		LONGBURST, sqclocks, qclocks);
+	if (sqclocks * 10 > qclocks * 6) {
+		printf("BOMB: The striped read was not (much) faster\n");
+		goto test_failure;
+	}
+	// }}}
+
+	// 4. The configuration port
+	// {{{
+	for(int k=0; k<NCHIPS; k++) {
+		extern const unsigned DEVID;
+
+		rdv = sq->flreadid(k);
+		printf("ID     Register[%d] = 0x%08x\n", k, rdv);
+		if (rdv != DEVID) {
+			printf("BOMB: ID read %08x, expected %08x\n",
+				rdv, DEVID);
+			goto test_failure;
+		}
+	}
+
+	sq->flerase(PGMADDR);
+	if (!sq->xip_mode()) {
+		printf("BOMB: XIP mode was not restored after the erase\n");
+		goto test_failure;
+	}
+	for(int k=0; k<16; k++) {
+		rdv = sq->wb_read(PGMADDR + 4*k);
+		if (rdv != 0xffffffff) {
+			printf("BOMB: READ[%08x] %08x after erase\n",
+				PGMADDR+4*k, rdv);
+			goto test_failure;
+		}
+	}
+
+	{	char	buf[8];
+		buf[0] = 0x12;
+		buf[1] = 0x34;
+		buf[2] = 0x56;
+		buf[3] = 0x78;
+		buf[4] = 0x9a;
+		buf[5] = 0xbc;
+		buf[6] = 0xde;
+		buf[7] = 0xf0;
+		sq->flprogram(PGMADDR+4, 8, buf);
+	}
+
+	if ((!checkread(sq, "STRIPED", (PGMADDR>>2)+1))
+			||(!checkread(sq, "STRIPED", (PGMADDR>>2)+2)))
+		goto test_failure;
+	if (((*sq)[(PGMADDR>>2)+1] != 0x12345678)
+			||((*sq)[(PGMADDR>>2)+2] != 0x9abcdef0)) {
+		printf("BOMB: The flash was not programmed\n");
+		goto test_failure;
+	}
+	printf("Configuration port: PASS\n");
+	// }}}
+
+	if ((qspi->bombed())||(sq->bombed()))
+		goto test_failure;
+
+	printf("SUCCESS!!\n");
+	exit(EXIT_SUCCESS);
+test_failure:
+	printf("FAIL-HERE\n");
+	for(int i=0; i<8; i++)
+		sq->tick();
+	printf("TEST FAILED\n");
+	exit(EXIT_FAILURE);
+}
@@ -74,7 +74,7 @@ public:
 		// }}}
 	}
 
-	unsigned cfg_read(void) {
+	unsigned cfg_read(const unsigned a = 0) {
 		// {{{
 		int		errcount = 0;
 		unsigned	result;
@@ -85,7 +85,7 @@ public:
 		TESTB<VA>::m_core->i_wb_stb = 0;
 		TESTB<VA>::m_core->i_cfg_stb = 1;
 		TESTB<VA>::m_core->i_wb_we  = 0;
-		TESTB<VA>::m_core->i_wb_addr= 0; // (a>>2);
+		TESTB<VA>::m_core->i_wb_addr= a;
 
 		if (TESTB<VA>::m_core->o_wb_stall) {
 			while((errcount++ < BOMBCOUNT)&&(TESTB<VA>::m_core->o_wb_stall)) {
@@ -248,7 +248,9 @@ public:
 		// }}}
 	}
 
-	void	cfg_write(unsigned v) {
+	void	cfg_write(unsigned v) { cfg_write(0, v); }
+
+	void	cfg_write(unsigned a, unsigned v) {
 		// {{{
 		int errcount = 0;
 
@@ -257,7 +259,7 @@ public:
 		TESTB<VA>::m_core->i_wb_stb = 0;
 		TESTB<VA>::m_core->i_cfg_stb = 1;
 		TESTB<VA>::m_core->i_wb_we  = 1;
-		TESTB<VA>::m_core->i_wb_addr= 0;
+		TESTB<VA>::m_core->i_wb_addr= a;
 		TESTB<VA>::m_core->i_wb_data= v;
 		// TESTB<VA>::m_core->i_wb_sel = 0x0f;
 
@@ -292,6 +294,76 @@ public:
 		// }}}
 	}
 
+	// reg_read, reg_write
+	// {{{
+	// Access one of the configuration registers beyond the first, such as
+	// those of a front end.  Unlike cfg_read() and cfg_write(), these
+	// return once the register has been acknowledged, rather than waiting
+	// for the stall line to drop, so that a front end left busy by a
+	// write can then be polled.
+	unsigned reg_read(unsigned addr) {
+		VA		*core = TESTB<VA>::m_core;
+		int		errcount = 0;
+		unsigned	result;
+
+		core->i_wb_cyc  = 1;
+		core->i_wb_stb  = 0;
+		core->i_cfg_stb = 1;
+		core->i_wb_we   = 0;
+		core->i_wb_addr = addr;
+
+		while((errcount++ < BOMBCOUNT)&&(core->o_wb_stall))
+			TICK();
+		TICK();
+		core->i_cfg_stb = 0;
+
+		while((errcount++ < BOMBCOUNT)&&(!core->o_wb_ack))
+			TICK();
+
+		result = core->o_wb_data;
+		core->i_wb_cyc = 0;
+		core->i_wb_addr = 0;
+
+		if (errcount >= BOMBCOUNT) {
+			printf("REG-BOMB: NO RESPONSE AFTER %d CLOCKS\n", errcount);
+			m_bomb = true;
+		}
+
+		TICK();
+		return result;
+	}
+
+	void	reg_write(unsigned addr, unsigned v) {
+		VA		*core = TESTB<VA>::m_core;
+		int		errcount = 0;
+
+		core->i_wb_cyc  = 1;
+		core->i_wb_stb  = 0;
+		core->i_cfg_stb = 1;
+		core->i_wb_we   = 1;
+		core->i_wb_addr = addr;
+		core->i_wb_data = v;
+
+		while((errcount++ < BOMBCOUNT)&&(core->o_wb_stall))
+			TICK();
+		TICK();
+		core->i_cfg_stb = 0;
+
+		while((errcount++ < BOMBCOUNT)&&(!core->o_wb_ack))
+			TICK();
+
+		core->i_wb_cyc = 0;
+		core->i_wb_addr = 0;
+
+		if (errcount >= BOMBCOUNT) {
+			printf("REG-BOMB: NO RESPONSE AFTER %d CLOCKS\n", errcount);
+			m_bomb = true;
+		}
+
+		TICK();
+	}
+	// }}}
+
 	void	wb_write(unsigned a, unsigned v) {
 		// {{{
 		int errcount = 0;
@@ -400,3 +472,73 @@ public:
 	bool	bombed(void) const { return m_bomb; }
 };
 
+
+#ifndef	STARTUP_CLOCKS
+#define	STARTUP_CLOCKS	(1<<20)
+#endif
+
+// startup
+// {{{
+// Wait for the startup script to complete, returning false if it never does
+template<class TB>	bool	startup(TB *tb) {
+	tb->tick();
+	while((tb->m_core->o_wb_stall)&&(tb->m_tickcount < STARTUP_CLOCKS))
+		tb->tick();
+	if (tb->m_core->o_wb_stall) {
+		printf("BOMB: The startup sequence never completed\n");
+		return false;
+	} return true;
+}
+// }}}
+
+// checkread
+// {{{
+// Read one word, check it against the flash model, and return the number of
+// clocks it took--or zero on failure
+template<class TB>	unsigned long	checkread(TB *tb, const char *name,
+			unsigned a) {
+	unsigned	rdv, exv;
+	unsigned long	start = tb->m_tickcount;
+
+	rdv = tb->wb_read(a<<2);
+	exv = (*tb)[a];
+	if (rdv != exv) {
+		printf("BOMB(%s): READ[%08x] %08x, EXPECTED %08x\n",
+			name, a<<2, rdv, exv);
+		return 0;
+	}
+
+	if (tb->bombed())
+		return 0;
+	return tb->m_tickcount - start;
+}
+// }}}
+
+// burstread
+// {{{
+// Read ln words with one pipelined request, check them, and return the
+// number of clocks it took--or zero on failure
+template<class TB>	unsigned long	burstread(TB *tb, const char *name,
+			unsigned a, unsigned ln) {
+	unsigned	*rdbuf = new unsigned[ln];
+	unsigned long	start, clocks;
+
+	start = tb->m_tickcount;
+	tb->wb_read(a<<2, ln, rdbuf);
+	clocks = tb->m_tickcount - start;
+
+	for(unsigned k=0; k<ln; k++) {
+		if (rdbuf[k] != (*tb)[a+k]) {
+			printf("BOMB(%s): READ[%08x] %08x, EXPECTED %08x\n",
+				name, (a+k)<<2, rdbuf[k], (*tb)[a+k]);
+			clocks = 0;
+			break;
+		}
+	}
+
+	delete[] rdbuf;
+	if (tb->bombed())
+		return 0;
+	return clocks;
+}
+// }}}
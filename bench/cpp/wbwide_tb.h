@@ -0,0 +1,256 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	wbwide_tb.h
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	A Wishbone master model for controllers built with a bus
+//		wider than 32 bits, such as qflexpress or dualflexpress with
+//	DW set to 64 or 128.  Verilator presents a 64-bit port as a QData,
+//	and anything wider as an array of 32-bit words, so the bus width is
+//	given here as NW, the number of 32-bit words per bus word.
+//
+//	wide_read() reads a pipelined burst of bus words, returning each as
+//	NW 32-bit words, least significant first.  cfg_write() and cfg_read()
+//	address the configuration register at offset zero, using the low
+//	32 bits of the bus, so that this class may be used as the BASE of
+//	QFLEX_TB.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2015-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#ifndef	WBWIDE_TB_H
+#define	WBWIDE_TB_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <verilated.h>
+#include <verilated_vcd_c.h>
+#include "testb.h"
+
+static const int	WIDE_BOMBCOUNT = 2048;
+
+// getword, setword
+// {{{
+// Access the k'th 32-bit word of a wide Verilator port, whether it is
+// presented as a QData or as an array of words
+static inline unsigned	getword(const QData v, int k) {
+	return (unsigned)(v >> (32*k)); }
+
+template<class W> static inline unsigned getword(const W &v, int k) {
+	return v[k]; }
+
+static inline void	setword(QData &v, int k, unsigned w) {
+	v &= ~(0x0ffffffffull << (32*k));
+	v |= ((QData)w) << (32*k);
+}
+
+template<class W> static inline void setword(W &v, int k, unsigned w) {
+	v[k] = w; }
+// }}}
+
+template <class VA, int NW>	class	WBWIDE_TB : public TESTB<VA> {
+public:
+	bool	m_bomb;
+
+	WBWIDE_TB(void) {
+		// {{{
+		m_bomb = false;
+		TESTB<VA>::m_core->i_wb_cyc = 0;
+		TESTB<VA>::m_core->i_wb_stb = 0;
+		TESTB<VA>::m_core->i_cfg_stb = 0;
+		// }}}
+	}
+
+	bool	bombed(void) const { return m_bomb; }
+
+	virtual	void	tick(void) {
+		// {{{
+		TESTB<VA>::tick();
+		assert((TESTB<VA>::m_core->i_wb_cyc)
+			||(!TESTB<VA>::m_core->o_wb_ack));
+		// }}}
+	}
+
+	// set_data
+	// {{{
+	// Place a 32-bit value into the low word of the bus, clearing the rest
+	void	set_data(unsigned v) {
+		for(int k=0; k<NW; k++)
+			setword(TESTB<VA>::m_core->i_wb_data, k, (k==0) ? v : 0);
+	}
+	// }}}
+
+	unsigned cfg_read(const unsigned a = 0) {
+		// {{{
+		int		errcount = 0;
+		unsigned	result;
+
+		TESTB<VA>::m_core->i_wb_cyc = 1;
+		TESTB<VA>::m_core->i_wb_stb = 0;
+		TESTB<VA>::m_core->i_cfg_stb = 1;
+		TESTB<VA>::m_core->i_wb_we  = 0;
+		TESTB<VA>::m_core->i_wb_addr= a;
+
+		while((errcount++ < WIDE_BOMBCOUNT)
+				&&(TESTB<VA>::m_core->o_wb_stall))
+			tick();
+		tick();
+
+		TESTB<VA>::m_core->i_cfg_stb = 0;
+
+		while((errcount++ < WIDE_BOMBCOUNT)
+				&&(!TESTB<VA>::m_core->o_wb_ack))
+			tick();
+
+		result = getword(TESTB<VA>::m_core->o_wb_data, 0);
+
+		// Release the bus
+		TESTB<VA>::m_core->i_wb_cyc = 0;
+
+		if (errcount >= WIDE_BOMBCOUNT) {
+			printf("WIDE/SR-BOMB: NO RESPONSE AFTER %d CLOCKS\n",
+				errcount);
+			m_bomb = true;
+		} tick();
+
+		assert(!TESTB<VA>::m_core->o_wb_ack);
+
+		while(TESTB<VA>::m_core->o_wb_stall)
+			tick();
+
+		return result;
+		// }}}
+	}
+
+	void	cfg_write(unsigned v) { cfg_write(0, v); }
+
+	void	cfg_write(unsigned a, unsigned v) {
+		// {{{
+		int	errcount = 0;
+
+		TESTB<VA>::m_core->i_wb_cyc = 1;
+		TESTB<VA>::m_core->i_wb_stb = 0;
+		TESTB<VA>::m_core->i_cfg_stb = 1;
+		TESTB<VA>::m_core->i_wb_we  = 1;
+		TESTB<VA>::m_core->i_wb_addr= a;
+		set_data(v);
+
+		while((errcount++ < WIDE_BOMBCOUNT)
+				&&(TESTB<VA>::m_core->o_wb_stall))
+			tick();
+		tick();
+
+		TESTB<VA>::m_core->i_cfg_stb = 0;
+
+		while((errcount++ < WIDE_BOMBCOUNT)
+				&&(!TESTB<VA>::m_core->o_wb_ack))
+			tick();
+		tick();
+
+		// Release the bus
+		TESTB<VA>::m_core->i_wb_cyc = 0;
+		TESTB<VA>::m_core->i_wb_we  = 0;
+
+		if (errcount >= WIDE_BOMBCOUNT) {
+			printf("WIDE/SW-BOMB: NO RESPONSE AFTER %d CLOCKS\n",
+				errcount);
+			m_bomb = true;
+		} tick();
+
+		assert(!TESTB<VA>::m_core->o_wb_ack);
+
+		while(TESTB<VA>::m_core->o_wb_stall)
+			tick();
+		// }}}
+	}
+
+	// wide_read
+	// {{{
+	// Read len bus words, starting from bus word address a, in a single
+	// pipelined burst.  buf must have room for len*NW 32-bit words.
+	void	wide_read(unsigned a, int len, unsigned *buf) {
+		int	errcount = 0;
+		int	THISBOMBCOUNT = WIDE_BOMBCOUNT * len;
+		int	cnt, rdidx;
+
+		TESTB<VA>::m_core->i_wb_cyc  = 1;
+		TESTB<VA>::m_core->i_wb_stb  = 1;
+		TESTB<VA>::m_core->i_cfg_stb = 0;
+		TESTB<VA>::m_core->i_wb_we   = 0;
+		TESTB<VA>::m_core->i_wb_addr = a;
+
+		rdidx = 0; cnt = 0;
+
+		do {
+			int	s;
+
+			s = (TESTB<VA>::m_core->o_wb_stall==0)?0:1;
+			tick();
+			TESTB<VA>::m_core->i_wb_addr += (s^1);
+			cnt += (s^1);
+			if (TESTB<VA>::m_core->o_wb_ack) {
+				for(int k=0; k<NW; k++)
+					buf[rdidx*NW+k] = getword(
+						TESTB<VA>::m_core->o_wb_data,k);
+				rdidx++;
+			}
+		} while((cnt < len)&&(errcount++ < THISBOMBCOUNT));
+
+		TESTB<VA>::m_core->i_wb_stb = 0;
+
+		while((rdidx < len)&&(errcount++ < THISBOMBCOUNT)) {
+			tick();
+			if (TESTB<VA>::m_core->o_wb_ack) {
+				for(int k=0; k<NW; k++)
+					buf[rdidx*NW+k] = getword(
+						TESTB<VA>::m_core->o_wb_data,k);
+				rdidx++;
+			}
+		}
+
+		// Release the bus
+		TESTB<VA>::m_core->i_wb_cyc = 0;
+
+		if (errcount >= THISBOMBCOUNT) {
+			printf("WIDE/PR-BOMB: NO RESPONSE AFTER %d CLOCKS\n",
+				errcount);
+			m_bomb = true;
+		}
+		tick();
+		assert(!TESTB<VA>::m_core->o_wb_ack);
+	}
+	// }}}
+};
+
+#endif
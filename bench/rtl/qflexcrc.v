@@ -0,0 +1,127 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	qflexcrc.v
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	A simulation top level, placing the flashcrc verification
+//		engine in front of the qflexpress controller.  The ports are
+//	those of qflexpress, so that the same test bench models can drive
+//	either, plus the engine's AXI-Stream port.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2018-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+`default_nettype	none
+// }}}
+module	qflexcrc #(
+		// {{{
+		parameter	LGFLASHSZ = 24,
+		parameter	OPT_CLKDIV = 0,
+		parameter	RDDELAY = 0,
+		parameter	NDUMMY = 6,
+		localparam	AW = LGFLASHSZ-2,
+		localparam	DW = 32
+		// }}}
+	) (
+		// {{{
+		input	wire			i_clk, i_reset,
+		//
+		input	wire			i_wb_cyc, i_wb_stb,
+						i_cfg_stb, i_wb_we,
+		input	wire	[(AW-1):0]	i_wb_addr,
+		input	wire	[(DW-1):0]	i_wb_data,
+		//
+		output	wire			o_wb_stall,
+		output	wire			o_wb_ack,
+		output	wire	[(DW-1):0]	o_wb_data,
+		//
+		output	wire		o_qspi_sck,
+		output	wire		o_qspi_cs_n,
+		output	wire	[1:0]	o_qspi_mod,
+		output	wire	[3:0]	o_qspi_dat,
+		input	wire	[3:0]	i_qspi_dat,
+		//
+		output	wire		M_AXIS_TVALID,
+		input	wire		M_AXIS_TREADY,
+		output	wire	[31:0]	M_AXIS_TDATA,
+		output	wire		M_AXIS_TLAST
+		// }}}
+	);
+
+	wire			fl_cyc, fl_stb, fl_cfg_stb, fl_we,
+				fl_stall, fl_ack;
+	wire	[(AW-1):0]	fl_addr;
+	wire	[(DW-1):0]	fl_data, fl_idata;
+
+	flashcrc #(
+		// {{{
+		.AW(AW), .OPT_STREAM(1'b1)
+		// }}}
+	) crc(
+		// {{{
+		.i_clk(i_clk), .i_reset(i_reset),
+		.i_wb_cyc(i_wb_cyc), .i_wb_stb(i_wb_stb),
+			.i_cfg_stb(i_cfg_stb), .i_wb_we(i_wb_we),
+			.i_wb_addr(i_wb_addr), .i_wb_data(i_wb_data),
+		.o_wb_stall(o_wb_stall), .o_wb_ack(o_wb_ack),
+			.o_wb_data(o_wb_data),
+		.o_fl_cyc(fl_cyc), .o_fl_stb(fl_stb),
+			.o_fl_cfg_stb(fl_cfg_stb), .o_fl_we(fl_we),
+			.o_fl_addr(fl_addr), .o_fl_data(fl_data),
+		.i_fl_stall(fl_stall), .i_fl_ack(fl_ack),
+			.i_fl_data(fl_idata),
+		.M_AXIS_TVALID(M_AXIS_TVALID), .M_AXIS_TREADY(M_AXIS_TREADY),
+		.M_AXIS_TDATA(M_AXIS_TDATA), .M_AXIS_TLAST(M_AXIS_TLAST)
+		// }}}
+	);
+
+	qflexpress #(
+		// {{{
+		.LGFLASHSZ(LGFLASHSZ), .OPT_CLKDIV(OPT_CLKDIV),
+		.RDDELAY(RDDELAY), .NDUMMY(NDUMMY)
+		// }}}
+	) flash(
+		// {{{
+		.i_clk(i_clk), .i_reset(i_reset),
+		.i_wb_cyc(fl_cyc), .i_wb_stb(fl_stb), .i_cfg_stb(fl_cfg_stb),
+			.i_wb_we(fl_we), .i_wb_addr(fl_addr),
+			.i_wb_data(fl_data), .i_wb_sel(4'hf),
+		.o_wb_stall(fl_stall), .o_wb_ack(fl_ack),
+			.o_wb_data(fl_idata),
+		.o_qspi_sck(o_qspi_sck), .o_qspi_cs_n(o_qspi_cs_n),
+		.o_qspi_mod(o_qspi_mod), .o_qspi_dat(o_qspi_dat),
+		.i_qspi_dat(i_qspi_dat)
+		// }}}
+	);
+
+endmodule
@@ -0,0 +1,636 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	axiqflexpress.v
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	An AXI4 version of the qflexpress controller.  The memory is
+//		read through a read-only AXI4 slave port, whereas the
+//	configuration register is reached through an AXI-Lite slave port.
+//	Both are placed in front of a qflexpress controller, which then does
+//	all of the actual work.  All of the qflexpress options (OPT_CLKDIV,
+//	RDDELAY, NDUMMY, etc.) are passed straight through.
+//
+//	Memory port
+//	- Each AXI4 read burst is broken into single word requests, issued
+//	  back to back to the controller.  Since each arrives before the
+//	  word before it has been returned, the controller keeps the flash's
+//	  quad read going from one word to the next, so that an INCR burst
+//	  costs one address cycle followed by 8 clocks per word.  Successive
+//	  bursts continue the same quad read when the first address of the
+//	  next burst follows the last of the one before.
+//	- WRAP bursts are issued in their wrapped order.  If the controller's
+//	  LGWRAP parameter matches the burst, and the flash has been set to
+//	  wrap at the same length, the wrap costs nothing.  Otherwise, the
+//	  controller starts a new read at the wrap point.
+//	- FIXED bursts re-read the same word.
+//	- Up to (1<<LGFIFO) AR requests may be outstanding.  Data are returned
+//	  in order, with the ID of the request they belong to.  Read data
+//	  are buffered, (1<<LGFIFO) words deep, so that a stalled R channel
+//	  doesn't lose any data.  No new word is requested from the
+//	  controller without room to hold it.
+//	- ARSIZE may be less than the bus width, in which case the full word
+//	  is returned on every beat.  ARLOCK, ARCACHE, ARPROT, and ARQOS are
+//	  not used, and so have been left out of the port list.
+//
+//	Configuration port
+//	- Writes and reads of the AXI-Lite port become configuration port
+//	  writes and reads of the controller.  The word address, from
+//	  S_AXIL_*ADDR[6:2], is passed along with them.  Byte strobes are
+//	  not supported, and so have been left off of the port.
+//	- Configuration requests wait for any memory bursts in progress to
+//	  complete, and take priority over any bursts that haven't yet
+//	  started.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2018-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+`default_nettype	none
+// }}}
+module	axiqflexpress #(
+		// {{{
+		// LGFLASHSZ
+		// {{{
+		// LGFLASHSZ is the log, base two, of the flash size in bytes.
+		// It also sets the width of S_AXI_ARADDR.
+		parameter	LGFLASHSZ = 24,
+		// }}}
+		// C_S_AXI_ID_WIDTH
+		// {{{
+		// The number of bits in the AXI4 ARID and RID fields
+		parameter	C_S_AXI_ID_WIDTH = 2,
+		// }}}
+		// LGFIFO
+		// {{{
+		// LGFIFO is the log, base two, of both the number of AR
+		// requests that may be queued, and the number of read words
+		// that may be buffered on their way to the R channel.
+		parameter	LGFIFO = 3,
+		// }}}
+		// qflexpress options
+		// {{{
+		// These are all passed straight through to the controller.
+		// See qflexpress.v for their descriptions.  OPT_PIPE is
+		// always set, since the bursts depend upon it.
+		parameter [0:0]	OPT_CFG = 1'b1,
+		parameter [0:0]	OPT_STARTUP = 1'b1,
+		parameter	OPT_CLKDIV = 0,
+		parameter [0:0]	OPT_ENDIANSWAP = 1'b1,
+		parameter	RDDELAY = 0,
+		parameter	NDUMMY = 6,
+		parameter	OPT_STARTUP_FILE = "",
+		parameter	LGWRAP = 0,
+		// }}}
+		localparam	IW = C_S_AXI_ID_WIDTH,
+		localparam	AW = LGFLASHSZ-2,
+		localparam	DW = 32,
+		localparam	DEPTH = (1<<LGFIFO),
+		// The AR queue holds { ID, ADDR, LEN, SIZE, BURST }
+		localparam	ARQW = IW + LGFLASHSZ + 8 + 3 + 2
+		// }}}
+	) (
+		// {{{
+		input	wire			i_clk, i_reset,
+		// AXI4 memory read port
+		// {{{
+		input	wire			S_AXI_ARVALID,
+		output	wire			S_AXI_ARREADY,
+		input	wire	[IW-1:0]	S_AXI_ARID,
+		input	wire	[LGFLASHSZ-1:0]	S_AXI_ARADDR,
+		input	wire	[7:0]		S_AXI_ARLEN,
+		input	wire	[2:0]		S_AXI_ARSIZE,
+		input	wire	[1:0]		S_AXI_ARBURST,
+		//
+		output	wire			S_AXI_RVALID,
+		input	wire			S_AXI_RREADY,
+		output	wire	[IW-1:0]	S_AXI_RID,
+		output	wire	[DW-1:0]	S_AXI_RDATA,
+		output	wire			S_AXI_RLAST,
+		output	wire	[1:0]		S_AXI_RRESP,
+		// }}}
+		// AXI-Lite configuration port
+		// {{{
+		input	wire			S_AXIL_AWVALID,
+		output	wire			S_AXIL_AWREADY,
+		input	wire	[6:0]		S_AXIL_AWADDR,
+		//
+		input	wire			S_AXIL_WVALID,
+		output	wire			S_AXIL_WREADY,
+		input	wire	[DW-1:0]	S_AXIL_WDATA,
+		//
+		output	reg			S_AXIL_BVALID,
+		input	wire			S_AXIL_BREADY,
+		output	wire	[1:0]		S_AXIL_BRESP,
+		//
+		input	wire			S_AXIL_ARVALID,
+		output	wire			S_AXIL_ARREADY,
+		input	wire	[6:0]		S_AXIL_ARADDR,
+		//
+		output	reg			S_AXIL_RVALID,
+		input	wire			S_AXIL_RREADY,
+		output	reg	[DW-1:0]	S_AXIL_RDATA,
+		output	wire	[1:0]		S_AXIL_RRESP,
+		// }}}
+		// The QSPI flash itself
+		// {{{
+		output	wire		o_qspi_sck,
+		output	wire		o_qspi_cs_n,
+		output	wire	[1:0]	o_qspi_mod,
+		output	wire	[3:0]	o_qspi_dat,
+		input	wire	[3:0]	i_qspi_dat
+		// }}}
+		// }}}
+	);
+
+	// Signal declarations
+	// {{{
+	// The AR queue
+	reg	[ARQW-1:0]	arq	[0:DEPTH-1];
+	reg	[LGFIFO:0]	arq_wr, arq_rd;
+	wire			arq_empty, arq_full;
+	wire	[IW-1:0]	arq_id;
+	wire	[LGFLASHSZ-1:0]	arq_addr;
+	wire	[7:0]		arq_len;
+	wire	[2:0]		arq_size;
+	wire	[1:0]		arq_burst;
+
+	// The burst walker
+	reg	[8:0]		bw_count;
+	reg	[IW-1:0]	bw_id;
+	reg	[LGFLASHSZ-1:0]	bw_addr, bw_wrapmask, bw_sizemask, next_addr;
+	reg	[2:0]		bw_size;
+	reg	[1:0]		bw_burst;
+	wire			bw_load;
+	wire	[LGFLASHSZ-1:0]	bw_incr;
+
+	// The read return buffer
+	reg	[IW:0]		rb_tag	[0:DEPTH-1];
+	reg	[DW-1:0]	rb_data	[0:DEPTH-1];
+	reg	[LGFIFO:0]	rb_wr, rb_ack, rb_rd;
+	wire			rb_full;
+
+	// The configuration port
+	reg			cfg_busy, cfg_stb, cfg_we;
+	reg	[4:0]		cfg_addr;
+	reg	[DW-1:0]	cfg_data;
+	wire			cfg_want_wr, cfg_want_rd, cfg_want, cfg_start;
+
+	// The controller's bus
+	wire			fl_cyc, fl_stb, fl_cfg_stb, fl_we,
+				fl_stall, fl_ack;
+	wire	[AW-1:0]	fl_addr;
+	wire	[DW-1:0]	fl_data, fl_idata;
+	wire			mem_issue;
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// The AR queue
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	assign	arq_empty = (arq_wr == arq_rd);
+	assign	arq_full  = (arq_wr[LGFIFO] != arq_rd[LGFIFO])
+			&&(arq_wr[LGFIFO-1:0] == arq_rd[LGFIFO-1:0]);
+
+	assign	S_AXI_ARREADY = !arq_full;
+
+	initial	arq_wr = 0;
+	always @(posedge i_clk)
+	if (i_reset)
+		arq_wr <= 0;
+	else if (S_AXI_ARVALID && S_AXI_ARREADY)
+		arq_wr <= arq_wr + 1'b1;
+
+	always @(posedge i_clk)
+	if (S_AXI_ARVALID && S_AXI_ARREADY)
+		arq[arq_wr[LGFIFO-1:0]] <= { S_AXI_ARID, S_AXI_ARADDR,
+				S_AXI_ARLEN, S_AXI_ARSIZE, S_AXI_ARBURST };
+
+	initial	arq_rd = 0;
+	always @(posedge i_clk)
+	if (i_reset)
+		arq_rd <= 0;
+	else if (bw_load)
+		arq_rd <= arq_rd + 1'b1;
+
+	assign	{ arq_id, arq_addr, arq_len, arq_size, arq_burst }
+				= arq[arq_rd[LGFIFO-1:0]];
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// The burst walker: break each burst into word requests
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// A new burst may only start once the last one has been completely
+	// requested, and only if no configuration request is waiting
+	assign	bw_load = (!arq_empty)&&(bw_count == 0)
+				&&(!cfg_want)&&(!cfg_busy);
+
+	// bw_count is the number of beats yet to be requested
+	initial	bw_count = 0;
+	always @(posedge i_clk)
+	if (i_reset)
+		bw_count <= 0;
+	else if (bw_load)
+		bw_count <= { 1'b0, arq_len } + 1'b1;
+	else if (mem_issue)
+		bw_count <= bw_count - 1'b1;
+
+	always @(posedge i_clk)
+	if (bw_load)
+	begin
+		bw_id    <= arq_id;
+		bw_addr  <= arq_addr;
+		bw_size  <= arq_size;
+		bw_burst <= arq_burst;
+		// A wrapping burst wraps at (LEN+1)*(1<<SIZE) bytes
+		bw_wrapmask <= (({ {(LGFLASHSZ-8){1'b0}}, arq_len } + 1'b1)
+						<< arq_size) - 1'b1;
+	end else if (mem_issue)
+		bw_addr <= next_addr;
+
+	// next_addr
+	// {{{
+	always @(*)
+		bw_sizemask = (1 << bw_size) - 1;
+
+	assign	bw_incr = (bw_addr & ~bw_sizemask) + (1 << bw_size);
+
+	always @(*)
+	case(bw_burst)
+	2'b00:	next_addr = bw_addr;	// FIXED
+	2'b10:	next_addr = (bw_addr & ~bw_wrapmask)
+				| (bw_incr & bw_wrapmask);	// WRAP
+	default: next_addr = bw_incr;	// INCR
+	endcase
+	// }}}
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// The read return buffer, and the R channel
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	// Each word has its slot, and its { ID, LAST } tag, assigned when it
+	// is requested.  The data are then filled in as they are returned.
+	assign	rb_full = (rb_wr[LGFIFO] != rb_rd[LGFIFO])
+			&&(rb_wr[LGFIFO-1:0] == rb_rd[LGFIFO-1:0]);
+
+	initial	rb_wr  = 0;
+	initial	rb_ack = 0;
+	initial	rb_rd  = 0;
+	always @(posedge i_clk)
+	if (i_reset)
+	begin
+		rb_wr  <= 0;
+		rb_ack <= 0;
+		rb_rd  <= 0;
+	end else begin
+		if (mem_issue)
+			rb_wr  <= rb_wr + 1'b1;
+		if ((fl_ack)&&(!cfg_busy))
+			rb_ack <= rb_ack + 1'b1;
+		if ((S_AXI_RVALID)&&(S_AXI_RREADY))
+			rb_rd  <= rb_rd + 1'b1;
+	end
+
+	always @(posedge i_clk)
+	if (mem_issue)
+		rb_tag[rb_wr[LGFIFO-1:0]] <= { bw_id, (bw_count == 1) };
+
+	always @(posedge i_clk)
+	if ((fl_ack)&&(!cfg_busy))
+		rb_data[rb_ack[LGFIFO-1:0]] <= fl_idata;
+
+	assign	S_AXI_RVALID = (rb_rd != rb_ack);
+	assign	{ S_AXI_RID, S_AXI_RLAST } = rb_tag[rb_rd[LGFIFO-1:0]];
+	assign	S_AXI_RDATA  = rb_data[rb_rd[LGFIFO-1:0]];
+	assign	S_AXI_RRESP  = 2'b00;
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// The AXI-Lite configuration port
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	assign	cfg_want_wr = (S_AXIL_AWVALID)&&(S_AXIL_WVALID)&&(!S_AXIL_BVALID);
+	assign	cfg_want_rd = (S_AXIL_ARVALID)&&(!S_AXIL_RVALID);
+	assign	cfg_want    = (cfg_want_wr)||(cfg_want_rd);
+
+	// Only start once all memory reads have been returned
+	assign	cfg_start = (cfg_want)&&(!cfg_busy)&&(bw_count == 0)
+				&&(rb_ack == rb_wr);
+
+	// Writes take priority over reads
+	assign	S_AXIL_AWREADY = (cfg_start)&&(cfg_want_wr);
+	assign	S_AXIL_WREADY  = (cfg_start)&&(cfg_want_wr);
+	assign	S_AXIL_ARREADY = (cfg_start)&&(!cfg_want_wr);
+
+	// cfg_busy, cfg_stb
+	// {{{
+	initial	cfg_busy = 1'b0;
+	initial	cfg_stb  = 1'b0;
+	always @(posedge i_clk)
+	if (i_reset)
+	begin
+		cfg_busy <= 1'b0;
+		cfg_stb  <= 1'b0;
+	end else if (cfg_start)
+	begin
+		cfg_busy <= 1'b1;
+		cfg_stb  <= 1'b1;
+	end else begin
+		if (!fl_stall)
+			cfg_stb  <= 1'b0;
+		if (fl_ack)
+			cfg_busy <= 1'b0;
+	end
+	// }}}
+
+	// cfg_we, cfg_addr, cfg_data
+	// {{{
+	always @(posedge i_clk)
+	if (cfg_start)
+	begin
+		cfg_we   <= cfg_want_wr;
+		cfg_addr <= (cfg_want_wr) ? S_AXIL_AWADDR[6:2]
+					: S_AXIL_ARADDR[6:2];
+		cfg_data <= S_AXIL_WDATA;
+	end
+	// }}}
+
+	// S_AXIL_BVALID
+	// {{{
+	initial	S_AXIL_BVALID = 1'b0;
+	always @(posedge i_clk)
+	if (i_reset)
+		S_AXIL_BVALID <= 1'b0;
+	else if ((cfg_busy)&&(fl_ack)&&(cfg_we))
+		S_AXIL_BVALID <= 1'b1;
+	else if (S_AXIL_BREADY)
+		S_AXIL_BVALID <= 1'b0;
+	// }}}
+
+	// S_AXIL_RVALID, S_AXIL_RDATA
+	// {{{
+	initial	S_AXIL_RVALID = 1'b0;
+	always @(posedge i_clk)
+	if (i_reset)
+		S_AXIL_RVALID <= 1'b0;
+	else if ((cfg_busy)&&(fl_ack)&&(!cfg_we))
+		S_AXIL_RVALID <= 1'b1;
+	else if (S_AXIL_RREADY)
+		S_AXIL_RVALID <= 1'b0;
+
+	always @(posedge i_clk)
+	if ((cfg_busy)&&(fl_ack)&&(!cfg_we))
+		S_AXIL_RDATA <= fl_idata;
+	// }}}
+
+	assign	S_AXIL_BRESP = 2'b00;
+	assign	S_AXIL_RRESP = 2'b00;
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// The controller itself
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// A word may be requested any time the burst has words left, and
+	// there's room to hold the result
+	assign	fl_stb     = (bw_count != 0)&&(!rb_full);
+	assign	mem_issue  = (fl_stb)&&(!fl_stall);
+	assign	fl_cfg_stb = cfg_stb;
+	assign	fl_we      = (cfg_busy)&&(cfg_we);
+	assign	fl_cyc     = (fl_stb)||(cfg_busy)||(rb_ack != rb_wr);
+	assign	fl_addr    = (cfg_busy) ? { {(AW-5){1'b0}}, cfg_addr }
+					: bw_addr[LGFLASHSZ-1:2];
+	assign	fl_data    = cfg_data;
+
+	qflexpress #(
+		// {{{
+		.LGFLASHSZ(LGFLASHSZ), .OPT_PIPE(1'b1), .OPT_CFG(OPT_CFG),
+		.OPT_STARTUP(OPT_STARTUP), .OPT_CLKDIV(OPT_CLKDIV),
+		.OPT_ENDIANSWAP(OPT_ENDIANSWAP), .RDDELAY(RDDELAY),
+		.NDUMMY(NDUMMY), .OPT_STARTUP_FILE(OPT_STARTUP_FILE),
+		.LGWRAP(LGWRAP)
+		// }}}
+	) flash(
+		// {{{
+		.i_clk(i_clk), .i_reset(i_reset),
+		.i_wb_cyc(fl_cyc), .i_wb_stb(fl_stb), .i_cfg_stb(fl_cfg_stb),
+			.i_wb_we(fl_we), .i_wb_addr(fl_addr),
+			.i_wb_data(fl_data), .i_wb_sel(4'hf),
+		.o_wb_stall(fl_stall), .o_wb_ack(fl_ack),
+			.o_wb_data(fl_idata),
+		.o_qspi_sck(o_qspi_sck), .o_qspi_cs_n(o_qspi_cs_n),
+		.o_qspi_mod(o_qspi_mod), .o_qspi_dat(o_qspi_dat),
+		.i_qspi_dat(i_qspi_dat)
+		// }}}
+	);
+	// }}}
+
+	// Make Verilator happy
+	// {{{
+	// verilator lint_off UNUSED
+	wire	[3:0]	unused;
+	assign	unused = { S_AXIL_AWADDR[1:0], S_AXIL_ARADDR[1:0] };
+	// verilator lint_on  UNUSED
+	// }}}
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//
+// Formal properties
+// {{{
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+`ifdef	FORMAL
+	// The controller's own bus properties, now asserted rather than
+	// assumed since it is no longer at the top level, check that the
+	// bus it is given is a legal one.  Here we check the AXI side.
+	reg	f_past_valid;
+	wire	[LGFIFO:0]	f_arq_fill, f_rb_fill, f_rb_pending;
+
+	initial	f_past_valid = 1'b0;
+	always @(posedge i_clk)
+		f_past_valid <= 1'b1;
+
+	always @(*)
+	if (!f_past_valid)
+		assume(i_reset);
+
+	////////////////////////////////////////////////////////////////////////
+	//
+	// AXI input assumptions
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset)))
+	begin
+		if ($past(S_AXI_ARVALID && !S_AXI_ARREADY))
+		begin
+			assume(S_AXI_ARVALID);
+			assume($stable(S_AXI_ARID));
+			assume($stable(S_AXI_ARADDR));
+			assume($stable(S_AXI_ARLEN));
+			assume($stable(S_AXI_ARSIZE));
+			assume($stable(S_AXI_ARBURST));
+		end
+
+		if ($past(S_AXIL_AWVALID && !S_AXIL_AWREADY))
+		begin
+			assume(S_AXIL_AWVALID);
+			assume($stable(S_AXIL_AWADDR));
+		end
+
+		if ($past(S_AXIL_WVALID && !S_AXIL_WREADY))
+		begin
+			assume(S_AXIL_WVALID);
+			assume($stable(S_AXIL_WDATA));
+		end
+
+		if ($past(S_AXIL_ARVALID && !S_AXIL_ARREADY))
+		begin
+			assume(S_AXIL_ARVALID);
+			assume($stable(S_AXIL_ARADDR));
+		end
+	end
+
+	// Bursts are legal: no wider than the bus, and wrapping bursts are
+	// 2, 4, 8, or 16 beats long and aligned
+	always @(*)
+	if (S_AXI_ARVALID)
+	begin
+		assume(S_AXI_ARSIZE <= 3'd2);
+		assume(S_AXI_ARBURST != 2'b11);
+		if (S_AXI_ARBURST == 2'b10)
+		begin
+			assume((S_AXI_ARLEN == 1)||(S_AXI_ARLEN == 3)
+				||(S_AXI_ARLEN == 7)||(S_AXI_ARLEN == 15));
+			assume((S_AXI_ARADDR & ((1<<S_AXI_ARSIZE)-1)) == 0);
+		end
+	end
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// AXI output properties
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset)))
+	begin
+		if ($past(S_AXI_RVALID && !S_AXI_RREADY))
+		begin
+			assert(S_AXI_RVALID);
+			assert($stable(S_AXI_RID));
+			assert($stable(S_AXI_RDATA));
+			assert($stable(S_AXI_RLAST));
+		end
+
+		if ($past(S_AXIL_RVALID && !S_AXIL_RREADY))
+		begin
+			assert(S_AXIL_RVALID);
+			assert($stable(S_AXIL_RDATA));
+		end
+
+		if ($past(S_AXIL_BVALID && !S_AXIL_BREADY))
+			assert(S_AXIL_BVALID);
+	end
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Internal invariants
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	assign	f_arq_fill   = arq_wr - arq_rd;
+	assign	f_rb_fill    = rb_wr - rb_rd;
+	assign	f_rb_pending = rb_wr - rb_ack;
+
+	always @(*)
+	begin
+		assert(f_arq_fill <= DEPTH);
+		assert(f_rb_fill  <= DEPTH);
+		assert(f_rb_pending <= f_rb_fill);
+		assert(bw_count <= 9'd256);
+	end
+
+	// Memory and configuration requests never overlap
+	always @(*)
+	if (cfg_busy)
+	begin
+		assert(bw_count == 0);
+		assert(rb_ack == rb_wr);
+	end
+
+	always @(*)
+	if (cfg_stb)
+		assert(cfg_busy);
+
+	// Only one AXI-Lite response may be outstanding at a time
+	always @(*)
+	if (cfg_busy)
+		assert(!S_AXIL_BVALID && !S_AXIL_RVALID);
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Cover properties
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset)))
+	begin
+		cover(S_AXI_RVALID && S_AXI_RREADY && S_AXI_RLAST);
+		cover(S_AXIL_RVALID);
+		cover(S_AXIL_BVALID);
+	end
+	// }}}
+`endif
+// }}}
+endmodule
@@ -75,6 +75,13 @@ module	dualflexpress #(
 		// where LGFLASHSZ goes up to 32.
 		parameter	LGFLASHSZ=24,
 		// }}}
+		// DW
+		// {{{
+		// DW is the width of the bus, 32, 64, or 128 bits.  Each bus
+		// word is read as DW/2 clocks of one continuous dual I/O read,
+		// and is otherwise as described in qflexpress.v.
+		parameter	DW=32,
+		// }}}
 		// OPT_PIPE
 		// {{{
 		// OPT_PIPE makes it possible to string multiple requests
@@ -110,11 +117,15 @@ module	dualflexpress #(
 		// {{{
 		// Normally, I place the first byte read from the flash, and
 		// the lowest flash address, into bits [7:0], and then shift
-		// it up--to where upon return it is found in bits [31:24].
-		// This is ideal for a big endian systems, not so much for
-		// little endian systems.  The endian swap allows the bus to
-		// swap the return values in order to support little endian
-		// systems.
+		// it up--to where upon return it is found in the top byte of
+		// the bus word, bits [DW-1:DW-8].  This is ideal for a big
+		// endian systems, not so much for little endian systems.  The
+		// endian swap reverses the order of every byte in the bus
+		// word, so that the first byte read is returned in bits [7:0]
+		// instead.  On a wide bus, the first 32-bit word read is then
+		// found in the most significant bits normally, or in the least
+		// significant bits with the swap.  Configuration port reads
+		// are never swapped.
 		parameter [0:0]	OPT_ENDIANSWAP = 1'b1,
 		// }}}
 		// OPT_ODDR
@@ -161,9 +172,47 @@ module	dualflexpress #(
 		// For dealing with multiple flash devices, the
 		// OPT_STARTUP_FILE allows a hex file to be provided containing
 		// the necessary script to place the design into the proper
-		// initial configuration
+		// initial configuration.  If not given, the built-in script
+		// below is used.  The flashscript utility in sw/ will assemble
+		// these files.
 		parameter	OPT_STARTUP_FILE="",
 		// }}}
+		// OPT_SPEEDREG
+		// {{{
+		// OPT_SPEEDREG adds a speed register to the configuration
+		// port, found where i_wb_addr[4:0] == SPEED_ADDR (5'h01), so
+		// that software can adjust the clock divider, the number of
+		// dummy cycles, and the read delay once the flash has been
+		// configured to run faster.  OPT_CLKDIV, NDUMMY, and RDDELAY
+		// then only set the values following a reset--the startup
+		// script always runs at OPT_CLKDIV--and OPT_CLKDIV and RDDELAY
+		// become the largest values allowed.  The register's fields
+		// are
+		//
+		//	[31:24]	The clock divider, 1--OPT_CLKDIV
+		//	[23:20]	The read delay, 0--RDDELAY
+		//	[4:0]	The dummy cycles, NDUMMY_MIN--31
+		//
+		// and are otherwise as described in qflexpress.v.
+		parameter [0:0]	OPT_SPEEDREG = 1'b0,
+		localparam [0:0]	OPT_SPEED = OPT_SPEEDREG && OPT_CFG,
+		localparam [4:0]	SPEED_ADDR = 5'h01,
+		// The mode byte takes four clocks, two bits at a time
+		localparam		NDUMMY_MIN = 4,
+		localparam		NDUMMY_MAX = 31,
+		// }}}
+		// OPT_PERF
+		// {{{
+		// OPT_PERF adds a set of performance counters to the
+		// configuration port, found where i_wb_addr[4:0] is between
+		// PERF_ADDR (5'h08) and 5'h0d.  They count clocks, memory
+		// reads, pipelined and new address memory reads, stalled
+		// clocks, and clocks spent in configuration mode, and are
+		// otherwise as described in qflexpress.v.
+		parameter [0:0]	OPT_PERF = 1'b0,
+		localparam [0:0]	OPT_PERFCTR = OPT_PERF && OPT_CFG,
+		localparam [4:0]	PERF_ADDR = 5'h08,
+		// }}}
 		//
 		//
 		//
@@ -178,11 +227,14 @@ module	dualflexpress #(
 		localparam [1:0]	DUAL_READ = 	2'b11,
 		localparam [7:0] DIO_READ_CMD = 8'hbb,
 		//
-		localparam	AW=LGFLASHSZ-2,
-		localparam	DW=32
+		localparam	LGDW=$clog2(DW/8),
+		localparam	AW=LGFLASHSZ-LGDW,
+		// NDATA: The number of clocks per bus word, two bits each
+		localparam	NDATA = DW/2,
+		localparam	CTRW = (DW > 32) ? 7 : 6
 		//
 `ifdef	FORMAL
-		, localparam	F_LGDEPTH=$clog2(12+16+1+NDUMMY+RDDELAY+(OPT_ADDR32 ? 4:0))
+		, localparam	F_LGDEPTH=$clog2(12+NDATA+1+NDUMMY+RDDELAY+(OPT_ADDR32 ? 4:0))
 		// reg	f_past_valid;
 `endif
 		// }}}
@@ -218,9 +270,24 @@ module	dualflexpress #(
 	//	12		address clocks, 2-bits each
 	//	 4		extra address clocks, for 32bit addressing
 	//	NDUMMY		dummy clocks, including two mode bytes
-	//	16		data clocks
+	//	NDATA		data clocks, 16 for a 32-bit bus
 	//	(RDDELAY clocks not counted here)
-	reg	[5:0]	clk_ctr;
+	reg	[CTRW-1:0]	clk_ctr;
+
+	//
+	// Speed register (OPT_SPEEDREG)
+	//
+	reg	[7:0]	r_clkdiv;
+	reg	[4:0]	r_ndummy;
+	reg	[3:0]	r_rddelay;
+	reg		speed_pending, rd_idle;
+	wire		speed_sel, speed_stb, speed_write, speed_apply;
+
+	//
+	// Performance counters (OPT_PERF)
+	//
+	wire		perf_sel, perf_stb, perf_write;
+	wire	[31:0]	perf_data;
 
 	//
 	// User override logic
@@ -231,10 +298,23 @@ module	dualflexpress #(
 	//
 	assign	bus_request  = (i_wb_stb)&&(!o_wb_stall)
 					&&(!i_wb_we)&&(!cfg_mode);
-	assign	cfg_stb      = (OPT_CFG)&&(i_cfg_stb)&&(!o_wb_stall);
+	assign	speed_sel    = (OPT_SPEED)&&(i_wb_addr[4:0] == SPEED_ADDR);
+	assign	speed_stb    = (OPT_SPEED)&&(i_cfg_stb)&&(!o_wb_stall)
+					&&(speed_sel);
+	assign	speed_write  = (speed_stb)&&(i_wb_we);
+	assign	perf_sel     = (OPT_PERFCTR)
+				&&(i_wb_addr[4:3] == PERF_ADDR[4:3])
+				&&(i_wb_addr[2:1] != 2'b11);
+	assign	perf_stb     = (OPT_PERFCTR)&&(i_cfg_stb)&&(!o_wb_stall)
+					&&(perf_sel);
+	assign	perf_write   = (perf_stb)&&(i_wb_we)
+					&&(i_wb_addr[2:0] == PERF_ADDR[2:0]);
+	assign	cfg_stb      = (OPT_CFG)&&(i_cfg_stb)&&(!o_wb_stall)
+					&&(!speed_sel)&&(!perf_sel);
 	assign	cfg_noop     = ((cfg_stb)&&((!i_wb_we)||(!i_wb_data[CFG_MODE])
 					||(i_wb_data[USER_CS_n])))
-				||((!OPT_CFG)&&(i_cfg_stb)&&(!o_wb_stall));
+				||((!OPT_CFG)&&(i_cfg_stb)&&(!o_wb_stall))
+				||((speed_stb)&&(!i_wb_we))||(perf_stb);
 	assign	user_request = (cfg_stb)&&(i_wb_we)&&(i_wb_data[CFG_MODE]);
 
 	assign	cfg_write    = (user_request)&&(!i_wb_data[USER_CS_n]);
@@ -305,7 +385,10 @@ module	dualflexpress #(
 		// }}}
 	end else begin : CKSTB_GEN
 		// {{{
+		// The divider is r_clkdiv, which only differs from OPT_CLKDIV
+		// when the speed register (OPT_SPEEDREG) has been written
 		reg	[CKDV_BITS-1:0]	clk_counter;
+		reg			gen_pre, gen_stb, gen_pos;
 
 		initial	clk_counter = OPT_CLKDIV;
 		always @(posedge i_clk)
@@ -314,28 +397,41 @@ module	dualflexpress #(
 		else if (clk_counter != 0)
 			clk_counter <= clk_counter - 1;
 		else if (bus_request)
-			clk_counter <= (pipe_req ? OPT_CLKDIV : 0);
+			clk_counter <= (pipe_req ? r_clkdiv[CKDV_BITS-1:0] : 0);
 		else if ((maintenance)||(!o_dspi_cs_n && o_wb_stall))
-			clk_counter <= OPT_CLKDIV;
+			clk_counter <= r_clkdiv[CKDV_BITS-1:0];
 
-		initial	ckpre = (OPT_CLKDIV == 1);
-		initial	ckstb = 1'b0;
-		initial	ckpos = (OPT_CLKDIV == 1);
+		initial	gen_pre = 1'b0;
+		initial	gen_stb = 1'b0;
+		initial	gen_pos = 1'b0;
 		always @(posedge i_clk)
 		if (i_reset)
 		begin
-			ckpre <= (OPT_CLKDIV == 1);
-			ckstb <= 1'b0;
-			ckpos <= (OPT_CLKDIV == 1);
-		end else // if (OPT_CLKDIV > 1)
+			gen_pre <= 1'b0;
+			gen_stb <= 1'b0;
+			gen_pos <= 1'b0;
+		end else // if (r_clkdiv > 1)
 		begin
-			ckpre <= (clk_counter == 2);
-			ckstb <= (clk_counter == 1);
-			ckpos <= (clk_counter == (OPT_CLKDIV+1)/2+1);
+			gen_pre <= (clk_counter == 2);
+			gen_stb <= (clk_counter == 1);
+			gen_pos <= (clk_counter == (r_clkdiv+1)/2+1);
 		end
 
+		// A divider of one, selected at run time, can't use the
+		// registered strobes above, and so it uses those of CKSTB_ONE
 		always @(*)
-			ckneg = ckstb;
+		if ((OPT_SPEED)&&(r_clkdiv == 1))
+		begin
+			ckpre = (clk_counter == 1);
+			ckstb = (clk_counter == 0);
+			ckpos = (clk_counter == 1);
+			ckneg = (clk_counter == 0);
+		end else begin
+			ckpre = gen_pre;
+			ckstb = gen_stb;
+			ckpos = gen_pos;
+			ckneg = gen_stb;
+		end
 `ifdef	FORMAL
 		// {{{
 		always @(*)
@@ -400,60 +496,69 @@ module	dualflexpress #(
 		//			mode, or 4-bits at a time in DUAL_WRITE
 		//			mode.  Ignored otherwis
 		//
-		integer k;
-		initial begin
-		for(k=0; k<(1<<M_LGADDR); k=k+1)
-			m_cmd_word[k] = -1;
-		// cmd_word= m_ctr_flag, m_mod[1:0],
-		//			m_cs_n, m_clk, m_data[3:0]
-		// Start off idle
-		//	This is really redundant since all of our commands are
-		//	idle's.
-		m_cmd_word[5'h0a] = -1;
-		//
-		// Since we don't know what mode we started in, whether the
-		// device was left in XIP mode or some other mode, we'll start
-		// by exiting any mode we might have been in.
-		//
-		// The key to doing this is to issue a non-command, that can
-		// also be interpreted as an XIP address with an incorrect
-		// mode bit.  That will get us out of any XIP mode, and back
-		// into a SPI mode we might use.  The command is issued in
-		// NORMAL_SPI mode, however, since we don't know if the device
-		// is initially in XIP or not.
-		//
-		// The following is for WINBOND
-		//
-		// Exit any QSPI mode we might've been in
-		m_cmd_word[5'h0f] = { 1'b0, NORMAL_SPI, 8'hff }; // Addr 1-2
-		m_cmd_word[5'h10] = { 1'b0, NORMAL_SPI, 8'hff }; // Addr 3-Mode
-		m_cmd_word[5'h11] = { 1'b0, NORMAL_SPI, 8'hff }; // Extra
-		// Idle
-		m_cmd_word[5'h12] = { 1'b1, 10'h3f };
-		// Idle
-		// Enter into QSPI mode, 0xeb, 0,0,0
-		// 0xeb
-		m_cmd_word[5'h13] = { 1'b0, NORMAL_SPI, DIO_READ_CMD };
-		// Addr #1
-		m_cmd_word[5'h14] = { 1'b0, DUAL_WRITE, 8'h01 };
-		// Addr #2
-		m_cmd_word[5'h15] = { 1'b0, DUAL_WRITE, 8'h20 };
-		// Addr #3
-		m_cmd_word[5'h16] = { 1'b0, DUAL_WRITE, 8'h48 };
-		// Mode byte
-		m_cmd_word[5'h17] = { 1'b0, DUAL_WRITE, 8'ha0 };
-		// Dummy clocks, x10 for this flash
-		m_cmd_word[5'h18] = { 1'b0, DUAL_WRITE, 8'h00 };
-		m_cmd_word[5'h19] = { 1'b0, DUAL_WRITE, 8'h00 };
-		m_cmd_word[5'h1a] = { 1'b0, DUAL_WRITE, 8'h00 };
-		m_cmd_word[5'h1b] = { 1'b0, DUAL_WRITE, 8'h00 };
-		m_cmd_word[5'h1c] = { 1'b0, DUAL_WRITE, 8'h00 };
-		// Now read a byte for form
-		m_cmd_word[5'h1d] = { 1'b0, DUAL_READ, 8'h00 };
-		// Idle
-		m_cmd_word[5'h1e] = -1;
-		m_cmd_word[5'h1f] = -1;
-		// Then we are in business!
+		if (OPT_STARTUP_FILE != 0)
+		begin : LOAD_STARTUP_FILE
+			// A script loaded from a file replaces the one below.
+			// It must hold all 32 words, in the format above, and
+			// the last two must be maximum length idles.  See the
+			// flashscript utility in sw/.
+			initial	$readmemh(OPT_STARTUP_FILE, m_cmd_word);
+		end else begin : DEFAULT_STARTUP
+			integer k;
+			initial begin
+			for(k=0; k<(1<<M_LGADDR); k=k+1)
+				m_cmd_word[k] = -1;
+			// cmd_word= m_ctr_flag, m_mod[1:0],
+			//			m_cs_n, m_clk, m_data[3:0]
+			// Start off idle
+			//	This is really redundant since all of our commands are
+			//	idle's.
+			m_cmd_word[5'h0a] = -1;
+			//
+			// Since we don't know what mode we started in, whether the
+			// device was left in XIP mode or some other mode, we'll start
+			// by exiting any mode we might have been in.
+			//
+			// The key to doing this is to issue a non-command, that can
+			// also be interpreted as an XIP address with an incorrect
+			// mode bit.  That will get us out of any XIP mode, and back
+			// into a SPI mode we might use.  The command is issued in
+			// NORMAL_SPI mode, however, since we don't know if the device
+			// is initially in XIP or not.
+			//
+			// The following is for WINBOND
+			//
+			// Exit any QSPI mode we might've been in
+			m_cmd_word[5'h0f] = { 1'b0, NORMAL_SPI, 8'hff }; // Addr 1-2
+			m_cmd_word[5'h10] = { 1'b0, NORMAL_SPI, 8'hff }; // Addr 3-Mode
+			m_cmd_word[5'h11] = { 1'b0, NORMAL_SPI, 8'hff }; // Extra
+			// Idle
+			m_cmd_word[5'h12] = { 1'b1, 10'h3f };
+			// Idle
+			// Enter into QSPI mode, 0xeb, 0,0,0
+			// 0xeb
+			m_cmd_word[5'h13] = { 1'b0, NORMAL_SPI, DIO_READ_CMD };
+			// Addr #1
+			m_cmd_word[5'h14] = { 1'b0, DUAL_WRITE, 8'h01 };
+			// Addr #2
+			m_cmd_word[5'h15] = { 1'b0, DUAL_WRITE, 8'h20 };
+			// Addr #3
+			m_cmd_word[5'h16] = { 1'b0, DUAL_WRITE, 8'h48 };
+			// Mode byte
+			m_cmd_word[5'h17] = { 1'b0, DUAL_WRITE, 8'ha0 };
+			// Dummy clocks, x10 for this flash
+			m_cmd_word[5'h18] = { 1'b0, DUAL_WRITE, 8'h00 };
+			m_cmd_word[5'h19] = { 1'b0, DUAL_WRITE, 8'h00 };
+			m_cmd_word[5'h1a] = { 1'b0, DUAL_WRITE, 8'h00 };
+			m_cmd_word[5'h1b] = { 1'b0, DUAL_WRITE, 8'h00 };
+			m_cmd_word[5'h1c] = { 1'b0, DUAL_WRITE, 8'h00 };
+			// Now read a byte for form
+			m_cmd_word[5'h1d] = { 1'b0, DUAL_READ, 8'h00 };
+			// Idle
+			m_cmd_word[5'h1e] = -1;
+			m_cmd_word[5'h1f] = -1;
+			// Then we are in business!
+			end
 		end
 
 		reg	m_final;
@@ -819,7 +924,7 @@ module	dualflexpress #(
 			data_pipe <= 0;
 
 			data_pipe[8+LGFLASHSZ-1:0] <= {
-					i_wb_addr, 2'b00, 4'ha, 4'h0 };
+				i_wb_addr, {(LGDW){1'b0}}, 4'ha, 4'h0 };
 
 			if (i_cfg_stb)
 				// High speed configuration I/O
@@ -859,7 +964,7 @@ module	dualflexpress #(
 	always @(posedge i_clk)
 	if ((i_reset)||(!i_wb_cyc))
 		pre_ack <= 1'b0;
-	else if ((bus_request)||(cfg_write))
+	else if ((bus_request)||(cfg_write)||(speed_write))
 		pre_ack <= 1'b1;
 	// }}}
 
@@ -915,11 +1020,13 @@ module	dualflexpress #(
 		// Notice that this is only for
 		// regular bus reads, and so the check for
 		// !pipe_req
-		clk_ctr <= 6'd12+6'd16+NDUMMY + (OPT_ADDR32 ? 4:0)+(OPT_ODDR ? 0:1);
+		clk_ctr <= 12 + NDATA + r_ndummy + (OPT_ADDR32 ? 4:0)
+						+ (OPT_ODDR ? 0:1);
 	else if (bus_request) // && pipe_req
 		// Otherwise, if this is a piped read, we'll
-		// reset the counter back to eight.
-		clk_ctr <= 6'd16;
+		// reset the counter back to sixteen, or more for
+		// a wider bus.
+		clk_ctr <= NDATA;
 	else if (cfg_ls_write)
 		clk_ctr <= 6'd8 + ((OPT_ODDR) ? 0:1);
 	else if (cfg_write)
@@ -946,7 +1053,7 @@ module	dualflexpress #(
 		if ((cfg_mode)&&(clk_ctr <= 1))
 			// Config mode has no pipe instructions
 			o_dspi_sck <= 1'b0;
-		else if (clk_ctr[5:0] > 6'd1)
+		else if (clk_ctr > 1)
 			o_dspi_sck <= 1'b1;
 		else
 			o_dspi_sck <= 1'b0;
@@ -961,7 +1068,7 @@ module	dualflexpress #(
 		if ((cfg_mode)&&(clk_ctr <= 1))
 			// Config mode has no pipe instructions
 			o_dspi_sck <= 1'b1;
-		else if (clk_ctr[5:0] > 6'd1)
+		else if (clk_ctr > 1)
 			o_dspi_sck <= 1'b0;
 		else
 			o_dspi_sck <= 1'b1;
@@ -1007,7 +1114,7 @@ module	dualflexpress #(
 		o_dspi_mod <= DUAL_WRITE;
 	else if ((cfg_ls_write)||((cfg_mode)&&(!cfg_speed)))
 		o_dspi_mod <= NORMAL_SPI;
-	else if ((ckstb)&&(clk_ctr <= 6'd17)&&((!cfg_mode)||(!cfg_dir)))
+	else if ((ckstb)&&(clk_ctr <= NDATA + 1)&&((!cfg_mode)||(!cfg_dir)))
 		o_dspi_mod <= DUAL_READ;
 	// }}}
 
@@ -1019,6 +1126,8 @@ module	dualflexpress #(
 		o_wb_stall <= 1'b1;
 	else if (maintenance)
 		o_wb_stall <= 1'b1;
+	else if ((speed_write)||((speed_pending)&&(!speed_apply)))
+		o_wb_stall <= 1'b1;
 	else if ((RDDELAY > 0)&&((i_cfg_stb)||(i_wb_stb))&&(!o_wb_stall))
 		o_wb_stall <= 1'b1;
 	else if ((RDDELAY == 0)&&((cfg_write)||(bus_request)))
@@ -1043,6 +1152,8 @@ module	dualflexpress #(
 		dly_ack <= 1'b0;
 	else if ((ckstb)&&(clk_ctr == 1))
 		dly_ack <= (i_wb_cyc)&&(pre_ack);
+	else if (speed_apply)
+		dly_ack <= (i_wb_cyc)&&(pre_ack);
 	else if ((i_wb_stb)&&(!o_wb_stall)&&(!bus_request))
 		dly_ack <= 1'b1;
 	else if (cfg_noop)
@@ -1075,6 +1186,8 @@ module	dualflexpress #(
 		always @(posedge i_clk)
 		if (i_reset)
 			actual_sck <= 1'b0;
+		else if ((OPT_SPEED)&&(r_clkdiv == 1))
+			actual_sck <= (!o_dspi_sck)&&(clk_ctr > 0);
 		else
 			actual_sck <= (o_dspi_sck)&&(ckpre)&&(clk_ctr > 0);
 
@@ -1095,6 +1208,7 @@ module	dualflexpress #(
 			read_sck = actual_sck;
 			o_wb_ack = dly_ack;
 			xtra_stall = 1'b0;
+			rd_idle  = 1'b1;
 		end
 
 `ifdef	FORMAL
@@ -1167,17 +1281,34 @@ module	dualflexpress #(
 				not_done = 1'b1;
 			if ((clk_ctr == 1)&&(!ckstb))
 				not_done = 1'b1;
+			if (speed_pending)
+				not_done = 1'b1;
 		end
 		// }}}
 
+		// o_wb_ack, read_sck, xtra_stall
+		// {{{
+		// The delay is r_rddelay, which is RDDELAY unless it has been
+		// changed through the speed register (OPT_SPEEDREG)
 		always @(*)
-			o_wb_ack = ack_pipe[RDDELAY-1];
+		if (r_rddelay == 0)
+		begin
+			o_wb_ack = dly_ack;
+			read_sck = actual_sck;
+		end else begin
+			o_wb_ack = ack_pipe[r_rddelay-1];
+			read_sck = sck_pipe[r_rddelay-1];
+		end
 
 		always @(*)
-			read_sck = sck_pipe[RDDELAY-1];
+			xtra_stall = |(stall_pipe
+					& ({(RDDELAY){1'b1}} >> (RDDELAY-r_rddelay)));
 
+		// The speed register may only be changed once nothing remains
+		// in these pipelines
 		always @(*)
-			xtra_stall = |stall_pipe;
+			rd_idle = (sck_pipe == 0)&&(ack_pipe == 0);
+		// }}}
 
 `ifdef	FORMAL
 		integer	k;
@@ -1187,6 +1318,7 @@ module	dualflexpress #(
 		else begin
 			f_extra = 0;
 			for(k=0; k<RDDELAY; k=k+1)
+			if (k < r_rddelay)
 				f_extra = f_extra + (ack_pipe[k] ? 1 : 0);
 		end
 `endif // FORMAL
@@ -1196,6 +1328,8 @@ module	dualflexpress #(
 
 	// o_wb_data
 	// {{{
+	integer	bk;
+
 	always @(posedge i_clk)
 	begin
 		if (read_sck)
@@ -1203,26 +1337,43 @@ module	dualflexpress #(
 			if (OPT_ENDIANSWAP && !cfg_mode)
 			begin
 				// {{{
+				// Each byte shifts in at the top, and then moves
+				// down one byte at a time, so that the first byte
+				// read ends up in the LSBs
 				if (!o_dspi_mod[1])
 				begin
-					o_wb_data <= { o_wb_data[30:24], i_dspi_dat[1],
-						o_wb_data[22:16], o_wb_data[31],
-						o_wb_data[14:8], o_wb_data[23],
-						o_wb_data[6:0], o_wb_data[15] };
+					for(bk=0; bk<DW/8-1; bk=bk+1)
+						o_wb_data[bk*8 +: 8] <= {
+							o_wb_data[bk*8 +: 7],
+							o_wb_data[bk*8+15] };
+					o_wb_data[DW-8 +: 8] <= {
+						o_wb_data[DW-8 +: 7], i_dspi_dat[1] };
 				end else begin
-					o_wb_data <= { o_wb_data[29:24], i_dspi_dat,
-						o_wb_data[21:16], o_wb_data[31:30],
-						o_wb_data[13:8], o_wb_data[23:22],
-						o_wb_data[5:0], o_wb_data[15:14]};
+					for(bk=0; bk<DW/8-1; bk=bk+1)
+						o_wb_data[bk*8 +: 8] <= {
+							o_wb_data[bk*8 +: 6],
+							o_wb_data[bk*8+14 +: 2] };
+					o_wb_data[DW-8 +: 8] <= {
+						o_wb_data[DW-8 +: 6], i_dspi_dat };
 				end
 				// }}}
 			end else if (!o_dspi_mod[1])
 				// No endian-swapping
-				o_wb_data <= { o_wb_data[30:0], i_dspi_dat[1] };
+				o_wb_data <= { o_wb_data[DW-2:0], i_dspi_dat[1] };
 			else
-				o_wb_data <= { o_wb_data[29:0], i_dspi_dat };
+				o_wb_data <= { o_wb_data[DW-3:0], i_dspi_dat };
 		end
 
+		// Register reads clear any bits above the first 32
+		if (((speed_stb)||(perf_stb))&&(!i_wb_we))
+			o_wb_data <= 0;
+
+		if ((speed_stb)&&(!i_wb_we))
+			o_wb_data[31:0] <= { r_clkdiv, r_rddelay, 15'h0, r_ndummy };
+
+		if ((perf_stb)&&(!i_wb_we))
+			o_wb_data[31:0] <= perf_data;
+
 		if ((OPT_CFG)&&(cfg_mode))
 			o_wb_data[16:8] <= { 4'h0, cfg_mode, 1'b0, cfg_speed,
 				cfg_dir, cfg_cs };
@@ -1243,7 +1394,7 @@ module	dualflexpress #(
 	always @(posedge i_clk)
 	if ((i_reset)||(!OPT_CFG))
 		cfg_mode <= 1'b0;
-	else if ((i_cfg_stb)&&(!o_wb_stall)&&(i_wb_we))
+	else if ((cfg_stb)&&(i_wb_we))
 		cfg_mode <= i_wb_data[CFG_MODE];
 	// }}}
 
@@ -1253,7 +1404,7 @@ module	dualflexpress #(
 	always @(posedge i_clk)
 	if ((i_reset)||(!OPT_CFG))
 		cfg_cs <= 1'b0;
-	else if ((i_cfg_stb)&&(!o_wb_stall)&&(i_wb_we))
+	else if ((cfg_stb)&&(i_wb_we))
 		cfg_cs    <= (!i_wb_data[USER_CS_n])&&(i_wb_data[CFG_MODE]);
 	// }}}
 
@@ -1266,13 +1417,162 @@ module	dualflexpress #(
 	begin
 		cfg_speed <= 1'b0;
 		cfg_dir   <= 1'b0;
-	end else if ((i_cfg_stb)&&(!o_wb_stall)&&(i_wb_we))
+	end else if ((cfg_stb)&&(i_wb_we))
 	begin
 		cfg_speed <= i_wb_data[DSPEED_BIT];
 		cfg_dir   <= i_wb_data[DIR_BIT];
 	end
 	// }}}
 
+	// r_clkdiv, r_ndummy, r_rddelay: the speed register
+	// {{{
+	generate if (OPT_SPEED)
+	begin : GEN_SPEEDREG
+		// {{{
+		reg	[7:0]	new_clkdiv;
+		reg	[4:0]	new_ndummy;
+		reg	[3:0]	new_rddelay;
+
+		// speed_pending
+		// {{{
+		// Set from the time a new speed is written until it can be
+		// applied: when the flash is idle, and the read delay
+		// pipeline is empty
+		initial	speed_pending = 1'b0;
+		always @(posedge i_clk)
+		if (i_reset)
+			speed_pending <= 1'b0;
+		else if (speed_write)
+			speed_pending <= 1'b1;
+		else if (speed_apply)
+			speed_pending <= 1'b0;
+
+		assign	speed_apply = (speed_pending)&&(!maintenance)
+					&&(clk_ctr == 0)&&(!dly_ack)&&(rd_idle);
+		// }}}
+
+		// new_*: The values written, clipped into range
+		// {{{
+		always @(posedge i_clk)
+		if (speed_write)
+		begin
+			if (OPT_ODDR)
+				new_clkdiv <= 0;
+			else if (i_wb_data[31:24] == 0)
+				new_clkdiv <= 1;
+			else if (i_wb_data[31:24] > OPT_CLKDIV)
+				new_clkdiv <= OPT_CLKDIV;
+			else
+				new_clkdiv <= i_wb_data[31:24];
+
+			if (i_wb_data[23:20] > RDDELAY)
+				new_rddelay <= RDDELAY;
+			else
+				new_rddelay <= i_wb_data[23:20];
+
+			if (i_wb_data[4:0] < NDUMMY_MIN)
+				new_ndummy <= NDUMMY_MIN;
+			else if (i_wb_data[4:0] > NDUMMY_MAX)
+				new_ndummy <= NDUMMY_MAX;
+			else
+				new_ndummy <= i_wb_data[4:0];
+		end
+		// }}}
+
+		// r_clkdiv, r_ndummy, r_rddelay
+		// {{{
+		initial	r_clkdiv  = OPT_CLKDIV;
+		initial	r_ndummy  = NDUMMY;
+		initial	r_rddelay = RDDELAY;
+		always @(posedge i_clk)
+		if (i_reset)
+		begin
+			r_clkdiv  <= OPT_CLKDIV;
+			r_ndummy  <= NDUMMY;
+			r_rddelay <= RDDELAY;
+		end else if (speed_apply)
+		begin
+			r_clkdiv  <= new_clkdiv;
+			r_ndummy  <= new_ndummy;
+			r_rddelay <= new_rddelay;
+		end
+		// }}}
+`ifdef	FORMAL
+`ifdef	F_FREETIMING
+		// {{{
+		// Any value may be written, but only values within range are
+		// ever applied, and those within range are kept as written
+		always @(posedge i_clk)
+		if ((f_past_valid)&&($past(speed_write)))
+		begin
+			if (OPT_ODDR)
+				assert(new_clkdiv == 0);
+			else begin
+				assert(new_clkdiv >= 1);
+				assert(new_clkdiv <= OPT_CLKDIV);
+				if (($past(i_wb_data[31:24]) >= 1)
+					&&($past(i_wb_data[31:24]) <= OPT_CLKDIV))
+					assert(new_clkdiv == $past(i_wb_data[31:24]));
+			end
+
+			assert(new_rddelay <= RDDELAY);
+			if ($past(i_wb_data[23:20]) <= RDDELAY)
+				assert(new_rddelay == $past(i_wb_data[23:20]));
+
+			assert(new_ndummy >= NDUMMY_MIN);
+			assert(new_ndummy <= NDUMMY_MAX);
+			if (($past(i_wb_data[4:0]) >= NDUMMY_MIN)
+				&&($past(i_wb_data[4:0]) <= NDUMMY_MAX))
+				assert(new_ndummy == $past(i_wb_data[4:0]));
+		end
+
+		// The speed only ever changes between reads, once the read
+		// delay pipeline has emptied
+		always @(posedge i_clk)
+		if ((f_past_valid)&&(!$past(i_reset))&&(($changed(r_clkdiv))
+			||($changed(r_ndummy))||($changed(r_rddelay))))
+		begin
+			assert($past(speed_apply));
+			assert($past(clk_ctr) == 0);
+			assert($past(rd_idle));
+		end
+
+		always @(*)
+		if (speed_pending)
+			assert(!maintenance);
+		// }}}
+`else
+		always @(*)
+		if (speed_pending)
+		begin
+			assert(new_clkdiv  == OPT_CLKDIV);
+			assert(new_ndummy  == NDUMMY);
+			assert(new_rddelay == RDDELAY);
+			assert(!maintenance);
+		end
+`endif
+`endif
+		// }}}
+	end else begin : NO_SPEEDREG
+		// {{{
+		always @(*)
+		begin
+			speed_pending = 1'b0;
+			r_clkdiv  = OPT_CLKDIV;
+			r_ndummy  = NDUMMY;
+			r_rddelay = RDDELAY;
+		end
+
+		assign	speed_apply = 1'b0;
+
+		// verilator lint_off UNUSED
+		wire	unused_speed;
+		assign	unused_speed = &{ 1'b0, rd_idle };
+		// verilator lint_on  UNUSED
+		// }}}
+	end endgenerate
+	// }}}
+
 	// r_last_cfg
 	// {{{
 	initial	r_last_cfg = 1'b0;
@@ -1280,6 +1580,88 @@ module	dualflexpress #(
 		r_last_cfg <= cfg_mode;
 	// }}}
 
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Performance counters (OPT_PERF)
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	generate if (OPT_PERFCTR)
+	begin : GEN_PERF
+		// {{{
+		// The counters are, in order from PERF_ADDR: clocks, memory
+		// reads, pipelined reads, new address reads, stalled clocks,
+		// and configuration mode clocks
+		localparam	NPERF = 6;
+		wire	[NPERF-1:0]	perf_evt;
+		reg	[32*NPERF-1:0]	perf_count, perf_snap;
+		reg	[31:0]		r_perf_data;
+		integer			pk;
+
+		assign	perf_evt = { cfg_mode,
+			(i_wb_cyc)&&((i_wb_stb)||(i_cfg_stb))&&(o_wb_stall),
+			(bus_request)&&(!pipe_req), (bus_request)&&(pipe_req),
+			bus_request, 1'b1 };
+
+		// perf_count
+		// {{{
+		initial	perf_count = 0;
+		always @(posedge i_clk)
+		if ((i_reset)||((perf_write)&&(i_wb_data[1])))
+			perf_count <= 0;
+		else for(pk=0; pk<NPERF; pk=pk+1)
+			perf_count[32*pk +: 32] <= perf_count[32*pk +: 32]
+						+ { 31'h0, perf_evt[pk] };
+		// }}}
+
+		// perf_snap
+		// {{{
+		initial	perf_snap = 0;
+		always @(posedge i_clk)
+		if (i_reset)
+			perf_snap <= 0;
+		else if ((perf_write)&&(i_wb_data[0]))
+			perf_snap <= perf_count;
+		// }}}
+
+		// perf_data
+		// {{{
+		always @(*)
+		case(i_wb_addr[2:0])
+		3'h0:	 r_perf_data = perf_snap[ 31:  0];
+		3'h1:	 r_perf_data = perf_snap[ 63: 32];
+		3'h2:	 r_perf_data = perf_snap[ 95: 64];
+		3'h3:	 r_perf_data = perf_snap[127: 96];
+		3'h4:	 r_perf_data = perf_snap[159:128];
+		3'h5:	 r_perf_data = perf_snap[191:160];
+		default: r_perf_data = 0;
+		endcase
+
+		assign	perf_data = r_perf_data;
+		// }}}
+`ifdef	FORMAL
+		// Every memory read is either pipelined, or not
+		always @(*)
+		begin
+			assert(perf_count[63:32] == perf_count[95:64]
+						+ perf_count[127:96]);
+			assert(perf_snap[63:32] == perf_snap[95:64]
+						+ perf_snap[127:96]);
+		end
+`endif
+		// }}}
+	end else begin : NO_PERF
+		// {{{
+		assign	perf_data = 0;
+
+		// verilator lint_off UNUSED
+		wire	unused_perf;
+		assign	unused_perf = &{ 1'b0, perf_write };
+		// verilator lint_on  UNUSED
+		// }}}
+	end endgenerate
 	// }}}
 	////////////////////////////////////////////////////////////////////////
 	//
@@ -1303,8 +1685,8 @@ module	dualflexpress #(
 	// Make Verilator happy
 	// {{{
 	// verilator lint_off UNUSED
-	wire	[19:0]	unused;
-	assign	unused = { i_wb_data[31:12] };
+	wire	[DW-13:0]	unused;
+	assign	unused = { i_wb_data[DW-1:12] };
 	// verilator lint_on  UNUSED
 	// }}}
 ////////////////////////////////////////////////////////////////////////////////
@@ -1319,16 +1701,23 @@ module	dualflexpress #(
 `ifdef	FORMAL
 	// Declarations
 	// {{{
-	localparam	F_MEMDONE   = NDUMMY+12+16+(OPT_ADDR32 ? 4:0)+(OPT_ODDR ? 0:1);
+	localparam	F_MEMDONE   = NDUMMY+12+NDATA+(OPT_ADDR32 ? 4:0)+(OPT_ODDR ? 0:1);
 	localparam	F_MEMACK    = F_MEMDONE + RDDELAY;
-	localparam	F_PIPEDONE  = 16;
+	localparam	F_PIPEDONE  = NDATA;
 	localparam	F_PIPEACK   = F_PIPEDONE + RDDELAY;
 	localparam	F_CFGLSDONE = 8+(OPT_ODDR ? 0:1);
 	localparam	F_CFGLSACK  = F_CFGLSDONE + RDDELAY;
 	localparam	F_CFGHSDONE = 4+(OPT_ODDR ? 0:1);
 	localparam	F_CFGHSACK  = RDDELAY+F_CFGHSDONE;
-	localparam	F_ACKCOUNT = (12+16+1+NDUMMY+RDDELAY+(OPT_ADDR32 ? 4:0))
+	localparam	F_ACKCOUNT = (12+NDATA+1+NDUMMY+RDDELAY+(OPT_ADDR32 ? 4:0))
 				*(OPT_ODDR ? 1 : (OPT_CLKDIV+1));
+	// F_FREETIMING: Check reads against the speed in use, rather than
+	// against a fixed sequence.  The bus is then held to no fixed delay.
+`ifdef	F_FREETIMING
+	localparam [0:0]	F_OPT_FREETIMING = 1'b1;
+`else
+	localparam [0:0]	F_OPT_FREETIMING = 1'b0;
+`endif
 	genvar	k;
 
 	wire	[(F_LGDEPTH-1):0]	f_nreqs, f_nacks,
@@ -1337,7 +1726,8 @@ module	dualflexpress #(
 	reg	[(OPT_ADDR32 ? 29:21):0]	fv_addr;
 	reg	[31:0]	fv_data;
 	reg	[F_MEMACK:0] f_memread;
-	reg	[32:0]	f_past_data;
+	reg	[DW:0]	f_past_data;
+	wire	[DW-1:0]	f_swap_data;
 	reg	[F_PIPEACK:0]	f_piperead;
 	reg	[F_CFGHSACK:0]	f_cfghsread;
 	reg	[F_CFGHSACK:0]	f_cfghswrite;
@@ -1374,6 +1764,34 @@ module	dualflexpress #(
 	always @(*)
 		`ASSUME((!i_wb_stb)||(!i_cfg_stb));
 
+`ifndef	F_FREETIMING
+	// The properties below follow every read and configuration port
+	// transfer through a fixed sequence of clocks.  That sequence is
+	// written in terms of OPT_CLKDIV, NDUMMY, and RDDELAY.  The speed
+	// register (OPT_SPEEDREG) is therefore only ever rewritten with these
+	// same values here.
+	always @(*)
+	if ((OPT_SPEED)&&(i_cfg_stb)&&(i_wb_we)&&(speed_sel))
+	begin
+		`ASSUME(i_wb_data[31:24] == OPT_CLKDIV);
+		`ASSUME(i_wb_data[23:20] == RDDELAY);
+		`ASSUME(i_wb_data[4:0]   == NDUMMY);
+	end
+
+	always @(*)
+	begin
+		assert(r_clkdiv  == OPT_CLKDIV);
+		assert(r_ndummy  == NDUMMY);
+		assert(r_rddelay == RDDELAY);
+	end
+`else
+	// F_FREETIMING replaces the fixed sequence with the properties under
+	// "Free timing" below: the speed register may be written with any
+	// value, and every new read is then checked against the speed in use.
+	// Without the fixed sequence, these are only checked as far as a
+	// bounded model check reaches.
+`endif
+
 	always @(posedge i_clk)
 	if ((f_past_valid)&&(!$past(i_reset))
 			&&($past(i_wb_stb))&&($past(o_wb_stall)))
@@ -1385,14 +1803,16 @@ module	dualflexpress #(
 		`ASSUME(i_cfg_stb);
 
 	fwb_slave #(.AW(AW), .DW(DW),.F_LGDEPTH(F_LGDEPTH),
-			.F_MAX_STALL((OPT_CLKDIV<3) ? (F_ACKCOUNT+1):0),
-			.F_MAX_ACK_DELAY((OPT_CLKDIV<3) ? F_ACKCOUNT : 0),
+			.F_MAX_STALL((F_OPT_FREETIMING) ? 0
+				: ((OPT_CLKDIV<3) ? (F_ACKCOUNT+1):0)),
+			.F_MAX_ACK_DELAY((F_OPT_FREETIMING) ? 0
+				: ((OPT_CLKDIV<3) ? F_ACKCOUNT : 0)),
 			.F_OPT_RMW_BUS_OPTION(0),
 			.F_OPT_CLK2FFLOGIC(1'b0),
 			.F_OPT_DISCONTINUOUS(1))
 		f_wbm(i_clk, i_reset,
 			i_wb_cyc, (i_wb_stb)||(i_cfg_stb), i_wb_we, i_wb_addr,
-				i_wb_data, 4'hf,
+				i_wb_data, {(DW/8){1'b1}},
 			o_wb_ack, o_wb_stall, o_wb_data, 1'b0,
 			f_nreqs, f_nacks, f_outstanding);
 
@@ -1402,6 +1822,10 @@ module	dualflexpress #(
 	always @(posedge i_clk)
 	if ((f_past_valid)&&(!$past(i_wb_stb))||($past(o_wb_stall)))
 		assert(f_outstanding <= 1 + f_extra);
+
+	always @(*)
+	if (speed_pending)
+		assert(o_wb_stall);
 	// }}}
 	////////////////////////////////////////////////////////////////////////
 	//
@@ -1486,16 +1910,21 @@ module	dualflexpress #(
 		assert(f_outstanding >= 1 + f_extra);
 
 	always @(posedge i_clk)
-	if ((f_past_valid)&&(clk_ctr == 0)&&(!dly_ack)
+	if ((f_past_valid)&&(clk_ctr == 0)&&(!dly_ack)&&(!speed_pending)
 			&&((!$past(i_wb_stb|i_cfg_stb))||($past(o_wb_stall))))
 		assert(f_outstanding == f_extra);
 
+	// A speed register write remains outstanding until it is applied
+	always @(*)
+	if ((speed_pending)&&(i_wb_cyc)&&(pre_ack))
+		assert(f_outstanding >= 1 + f_extra);
+
 	always @(*)
 	if ((i_wb_cyc)&&(pre_ack)&&(!o_dspi_cs_n))
 		assert((f_outstanding >= 1 + f_extra)||((OPT_CFG)&&(cfg_mode)));
 
 	always @(*)
-	if ((cfg_mode)&&(!dly_ack)&&(clk_ctr == 0))
+	if ((cfg_mode)&&(!dly_ack)&&(clk_ctr == 0)&&(!speed_pending))
 		assert(f_outstanding == f_extra);
 
 	always @(*)
@@ -1536,6 +1965,7 @@ module	dualflexpress #(
 			&&(!$past(o_dspi_cs_n,2))&&(!cfg_mode))
 		assert(o_dspi_sck != $past(o_dspi_sck));
 	// }}}
+`ifndef	F_FREETIMING
 	////////////////////////////////////////////////////////////////////////
 	//
 	// Read requests
@@ -1554,17 +1984,16 @@ module	dualflexpress #(
 		//
 		if (!$past(o_dspi_cs_n))
 		begin
-			assert(clk_ctr == 6'd16);
+			assert(clk_ctr == F_PIPEDONE);
 			assert(o_dspi_mod == DUAL_READ);
 		end else begin
-			assert(clk_ctr == 6'd28 + NDUMMY
-				+ (OPT_ADDR32 ? 4:0) + (OPT_ODDR ? 0:1));
+			assert(clk_ctr == F_MEMDONE);
 			assert(o_dspi_mod == DUAL_WRITE);
 		end
 	end
 
 	always @(*)
-		assert(clk_ctr <= 6'd32 + NDUMMY
+		assert(clk_ctr <= 16 + NDATA + NDUMMY
 			+ (OPT_ADDR32 ? 4:0)
 			+ (OPT_ODDR ? 0:1));
 
@@ -1587,7 +2016,7 @@ module	dualflexpress #(
 				assert(o_dspi_mod == NORMAL_SPI);
 			else if ((cfg_dir)&&(clk_ctr > 0))
 				assert(o_dspi_mod == DUAL_WRITE);
-		end else if (clk_ctr > 5'd16)
+		end else if (clk_ctr > F_PIPEDONE)
 			assert(o_dspi_mod == DUAL_WRITE);
 		else if (clk_ctr > 0)
 			assert(o_dspi_mod == DUAL_READ);
@@ -1626,13 +2055,14 @@ module	dualflexpress #(
 	begin
 		// Make sure all of the bits are set
 		fv_addr <= 0;
-		// Now set as many bits as we have address bits
-		fv_addr[AW-1:0] <= i_wb_addr;
+		// Now set as many bits as we have address bits, counting
+		// in 32-bit words
+		fv_addr[LGFLASHSZ-3:0] <= i_wb_addr << (LGDW-2);
 	end
 
 	always @(posedge i_clk)
 	if ((i_wb_stb || i_cfg_stb) && !o_wb_stall && i_wb_we)
-		fv_data <= i_wb_data;
+		fv_data <= i_wb_data[31:0];
 	// }}}
 	////////////////////////////////////////////////////////////////////////
 	//
@@ -1705,9 +2135,9 @@ module	dualflexpress #(
 		if ($past(ckpos,RDDELAY))
 		begin
 			if ($past(o_dspi_mod,RDDELAY) == NORMAL_SPI)
-				f_past_data <= { f_past_data[31:0], i_dspi_dat[1] };
+				f_past_data <= { f_past_data[DW-1:0], i_dspi_dat[1] };
 			else if ($past(o_dspi_mod,RDDELAY) == DUAL_READ)
-				f_past_data <= { f_past_data[30:0], i_dspi_dat[1:0] };
+				f_past_data <= { f_past_data[DW-2:0], i_dspi_dat[1:0] };
 		end
 		// }}}
 	end else begin
@@ -1716,12 +2146,35 @@ module	dualflexpress #(
 		if (ckpos)
 		begin
 			if (o_dspi_mod == NORMAL_SPI)
-				f_past_data <= { f_past_data[31:0], i_dspi_dat[1] };
+				f_past_data <= { f_past_data[DW-1:0], i_dspi_dat[1] };
 			else if (o_dspi_mod == DUAL_READ)
-				f_past_data <= { f_past_data[30:0], i_dspi_dat[1:0] };
+				f_past_data <= { f_past_data[DW-2:0], i_dspi_dat[1:0] };
 		end
 		// }}}
 	end endgenerate
+
+	// f_swap_data: f_past_data, with the first byte read in the LSBs
+	generate for(k=0; k<DW/8; k=k+1)
+	begin : F_SWAP_DATA
+		assign	f_swap_data[k*8 +: 8] = f_past_data[DW-8-k*8 +: 8];
+	end endgenerate
+	// }}}
+
+	// F_DATA: o_wb_data against i_dspi_dat, two bits per clock
+	// {{{
+	generate for(k=0; k<NDATA; k=k+1)
+	begin : F_DATA
+		always @(posedge i_clk)
+		if ((OPT_ODDR)&&((f_memread[F_MEMACK])||(f_piperead[F_PIPEACK])))
+		begin
+			if (OPT_ENDIANSWAP)
+				assert(o_wb_data[(k/4)*8 + 6 - 2*(k%4) +: 2]
+					== $past(i_dspi_dat, NDATA-k));
+			else
+				assert(o_wb_data[DW-2-k*2 +: 2]
+					== $past(i_dspi_dat, NDATA-k));
+		end
+	end endgenerate
 	// }}}
 
 	// o_dspi_dat against f_memread, fv_addr
@@ -1777,52 +2230,13 @@ module	dualflexpress #(
 	end
 	// }}}
 
-	// o_wb_data against i_dspi_dat (via f_past_data if necessary)
+	// o_wb_data against f_past_data if necessary
 	// {{{
 	always @(posedge i_clk)
 	if (OPT_ODDR)
 	begin
-		if (f_memread[F_MEMACK] && OPT_ENDIANSWAP)
-		begin
-			// {{{
-			assert(o_wb_data[ 7: 6] == $past(i_dspi_dat,16));
-			assert(o_wb_data[ 5: 4] == $past(i_dspi_dat,15));
-			assert(o_wb_data[ 3: 2] == $past(i_dspi_dat,14));
-			assert(o_wb_data[ 1: 0] == $past(i_dspi_dat,13));
-			assert(o_wb_data[15:14] == $past(i_dspi_dat,12));
-			assert(o_wb_data[13:12] == $past(i_dspi_dat,11));
-			assert(o_wb_data[11:10] == $past(i_dspi_dat,10));
-			assert(o_wb_data[ 9: 8] == $past(i_dspi_dat,9));
-			assert(o_wb_data[23:22] == $past(i_dspi_dat,8));
-			assert(o_wb_data[21:20] == $past(i_dspi_dat,7));
-			assert(o_wb_data[19:18] == $past(i_dspi_dat,6));
-			assert(o_wb_data[17:16] == $past(i_dspi_dat,5));
-			assert(o_wb_data[31:30] == $past(i_dspi_dat,4));
-			assert(o_wb_data[29:28] == $past(i_dspi_dat,3));
-			assert(o_wb_data[27:26] == $past(i_dspi_dat,2));
-			assert(o_wb_data[25:24] == $past(i_dspi_dat,1));
-			// }}}
-		end else if (f_memread[F_MEMACK])
-		begin
-			// {{{
-			assert(o_wb_data[31:30] == $past(i_dspi_dat,16));
-			assert(o_wb_data[29:28] == $past(i_dspi_dat,15));
-			assert(o_wb_data[27:26] == $past(i_dspi_dat,14));
-			assert(o_wb_data[25:24] == $past(i_dspi_dat,13));
-			assert(o_wb_data[23:22] == $past(i_dspi_dat,12));
-			assert(o_wb_data[21:20] == $past(i_dspi_dat,11));
-			assert(o_wb_data[19:18] == $past(i_dspi_dat,10));
-			assert(o_wb_data[17:16] == $past(i_dspi_dat, 9));
-			assert(o_wb_data[15:14] == $past(i_dspi_dat, 8));
-			assert(o_wb_data[13:12] == $past(i_dspi_dat, 7));
-			assert(o_wb_data[11:10] == $past(i_dspi_dat, 6));
-			assert(o_wb_data[ 9: 8] == $past(i_dspi_dat, 5));
-			assert(o_wb_data[ 7: 6] == $past(i_dspi_dat, 4));
-			assert(o_wb_data[ 5: 4] == $past(i_dspi_dat, 3));
-			assert(o_wb_data[ 3: 2] == $past(i_dspi_dat, 2));
-			assert(o_wb_data[ 1: 0] == $past(i_dspi_dat, 1));
-			// }}}
-		end else if (|f_memread)
+		// The data itself is checked above, within F_DATA
+		if ((|f_memread)&&(!f_memread[F_MEMACK]))
 		begin
 			// {{{
 			if (!OPT_PIPE)
@@ -1833,15 +2247,9 @@ module	dualflexpress #(
 			// }}}
 		end
 	end else if (f_memread[F_MEMACK] && OPT_ENDIANSWAP)
-		// {{{
-		assert((!o_wb_ack)||(
-			   o_wb_data[ 7: 0] == f_past_data[31:24]
-			&& o_wb_data[15: 8] == f_past_data[23:16]
-			&& o_wb_data[23:16] == f_past_data[15: 8]
-			&& o_wb_data[31:24] == f_past_data[ 7: 0]));
-		// }}}
+		assert((!o_wb_ack)||(o_wb_data == f_swap_data));
 	else if (f_memread[F_MEMACK]) // 25
-		assert((!o_wb_ack)||(o_wb_data == f_past_data[31:0]));
+		assert((!o_wb_ack)||(o_wb_data == f_past_data[DW-1:0]));
 	else if (|f_memread)
 	begin
 		// {{{
@@ -1912,64 +2320,19 @@ module	dualflexpress #(
 	end endgenerate
 	// }}}
 
-	// o_wb_data against f_piperead, i_dspi_dat and f_past_data
+	// o_wb_data against f_piperead and f_past_data
 	// {{{
 	always @(posedge  i_clk)
 	if (OPT_ODDR)
 	begin
-		if (f_piperead[F_PIPEACK] && OPT_ENDIANSWAP)
-		begin
-			// {{{
-			assert(o_wb_data[ 7: 6] == $past(i_dspi_dat,16));
-			assert(o_wb_data[ 5: 4] == $past(i_dspi_dat,15));
-			assert(o_wb_data[ 3: 2] == $past(i_dspi_dat,14));
-			assert(o_wb_data[ 1: 0] == $past(i_dspi_dat,13));
-			assert(o_wb_data[15:14] == $past(i_dspi_dat,12));
-			assert(o_wb_data[13:12] == $past(i_dspi_dat,11));
-			assert(o_wb_data[11:10] == $past(i_dspi_dat,10));
-			assert(o_wb_data[ 9: 8] == $past(i_dspi_dat,9));
-			assert(o_wb_data[23:22] == $past(i_dspi_dat,8));
-			assert(o_wb_data[21:20] == $past(i_dspi_dat,7));
-			assert(o_wb_data[19:18] == $past(i_dspi_dat,6));
-			assert(o_wb_data[17:16] == $past(i_dspi_dat,5));
-			assert(o_wb_data[31:30] == $past(i_dspi_dat,4));
-			assert(o_wb_data[29:28] == $past(i_dspi_dat,3));
-			assert(o_wb_data[27:26] == $past(i_dspi_dat,2));
-			assert(o_wb_data[25:24] == $past(i_dspi_dat,1));
-			// }}}
-		end else if (f_piperead[F_PIPEACK])
-		begin
-			// {{{
-			assert(o_wb_data[31:30] == $past(i_dspi_dat,16));
-			assert(o_wb_data[29:28] == $past(i_dspi_dat,15));
-			assert(o_wb_data[27:26] == $past(i_dspi_dat,14));
-			assert(o_wb_data[25:24] == $past(i_dspi_dat,13));
-			assert(o_wb_data[23:22] == $past(i_dspi_dat,12));
-			assert(o_wb_data[21:20] == $past(i_dspi_dat,11));
-			assert(o_wb_data[19:18] == $past(i_dspi_dat,10));
-			assert(o_wb_data[17:16] == $past(i_dspi_dat, 9));
-			assert(o_wb_data[15:14] == $past(i_dspi_dat, 8));
-			assert(o_wb_data[13:12] == $past(i_dspi_dat, 7));
-			assert(o_wb_data[11:10] == $past(i_dspi_dat, 6));
-			assert(o_wb_data[ 9: 8] == $past(i_dspi_dat, 5));
-			assert(o_wb_data[ 7: 6] == $past(i_dspi_dat, 4));
-			assert(o_wb_data[ 5: 4] == $past(i_dspi_dat, 3));
-			assert(o_wb_data[ 3: 2] == $past(i_dspi_dat, 2));
-			assert(o_wb_data[ 1: 0] == $past(i_dspi_dat, 1));
-			// }}}
-		end else if ((|f_piperead)&&(!f_piperead[RDDELAY]))
+		// The data itself is checked above, within F_DATA
+		if ((|f_piperead)&&(!f_piperead[F_PIPEACK])
+				&&(!f_piperead[RDDELAY]))
 			assert(!o_wb_ack);
 	end else if (f_piperead[F_PIPEACK] && OPT_ENDIANSWAP)
-	begin
-		// {{{
-		assert((!o_wb_ack)||(
-			   o_wb_data[ 7: 0] == f_past_data[31:24]
-			&& o_wb_data[15: 8] == f_past_data[23:16]
-			&& o_wb_data[23:16] == f_past_data[15: 8]
-			&& o_wb_data[31:24] == f_past_data[ 7: 0]));
-		// }}}
-	end else if (f_piperead[F_PIPEACK]) // 25
-		assert((!o_wb_ack)||(o_wb_data == f_past_data[31:0]));
+		assert((!o_wb_ack)||(o_wb_data == f_swap_data));
+	else if (f_piperead[F_PIPEACK]) // 25
+		assert((!o_wb_ack)||(o_wb_data == f_past_data[DW-1:0]));
 	else if (|f_piperead)
 	begin
 		// {{{
@@ -2492,6 +2855,35 @@ module	dualflexpress #(
 			|| f_cfghsread[F_CFGHSACK]);
 	end
 	// }}}
+`else
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Free timing
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// Every new address is followed by r_ndummy dummy clocks
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset))&&($past(bus_request))
+			&&(!$past(pipe_req)))
+	begin
+		assert(!o_dspi_cs_n);
+		assert(o_dspi_mod == DUAL_WRITE);
+		assert(clk_ctr == F_MEMDONE - NDUMMY + $past(r_ndummy));
+	end
+
+	// The speed in use always remains within its limits
+	always @(*)
+	begin
+		assert(r_clkdiv  <= OPT_CLKDIV);
+		assert(r_rddelay <= RDDELAY);
+		if (!OPT_ODDR)
+			assert(r_clkdiv >= 1);
+	end
+	// }}}
+`endif
 	////////////////////////////////////////////////////////////////////////
 	//
 	// Cover Properties
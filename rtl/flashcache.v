@@ -0,0 +1,747 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	flashcache.v
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	A small read cache, designed to sit between a bus master
+//		(typically a CPU's instruction fetch) and the memory port of
+//	either the qflexpress or dualflexpress controllers.  CPUs executing in
+//	place from flash spend most of their time in loops, re-reading the
+//	same few hundred words.  Without a cache, every one of those reads
+//	costs a full flash transaction.
+//
+//	The cache may be either direct mapped, or two way set associative
+//	(OPT_TWOWAY).  It holds (1<<LGLINES) lines per way, each of
+//	(1<<LGLINE) words.
+//
+//	- A read hitting in the cache is acknowledged on the next clock.
+//	- A read missing the cache stalls the bus while the line containing
+//	  it is read from the controller, using a single pipelined request of
+//	  (1<<LGLINE) sequential words.  The requested word is acknowledged as
+//	  soon as it arrives.  On a two way cache, the line replaced is the
+//	  least recently used of the two.
+//	- If OPT_WRAPFILL is set, the line is instead requested critical word
+//	  first: starting from the word that missed, and wrapping around
+//	  from the end of the line back to its beginning.  The miss is then
+//	  acknowledged with the first word returned.  This works with any
+//	  controller, but is only fast when the controller's LGWRAP
+//	  parameter matches LGLINE and the flash has been set to wrap its
+//	  bursts to the same length, so that the wrap costs no new address.
+//	- Configuration port requests, as well as any memory port writes, are
+//	  passed straight through.  Any such write invalidates the entire
+//	  cache, since it may be part of an erase or program sequence.
+//	  Likewise, while the controller has been placed into its
+//	  configuration mode, reads are passed through and not cached.
+//
+//	The cache also keeps a set of statistics, which may be read through
+//	the configuration port.  Configuration port requests with
+//	i_wb_addr[4:2] == 3'b110 are answered by the cache rather than being
+//	passed to the controller:
+//
+//	5'h18	Hit count
+//	5'h19	Miss count
+//	5'h1a	Invalidation count
+//	5'h1b	Cache geometry: { 14'h0, OPT_WRAPFILL, OPT_TWOWAY,
+//			8'h(LGLINES), 8'h(LGLINE) }
+//
+//	Writing to any of these registers clears all three counters.  The
+//	addresses of every other configuration register, whether decoded by
+//	the controllers or by the other front ends, are listed in the
+//	configuration port address map of the README.  Software addressing
+//	any of these is unaffected by the cache.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2018-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+`default_nettype	none
+// }}}
+module	flashcache #(
+		// {{{
+		// AW
+		// {{{
+		// AW is the number of word address bits.  This needs to match
+		// the controller behind us, where it is given by LGFLASHSZ-2.
+		parameter	AW = 22,
+		// }}}
+		// LGLINE
+		// {{{
+		// LGLINE is the log, base two, of the number of words in each
+		// cache line.  It must be at least one.
+		parameter	LGLINE = 3,
+		// }}}
+		// LGLINES
+		// {{{
+		// LGLINES is the log, base two, of the number of lines in each
+		// way of the cache.  The cache as a whole will then hold
+		// (1<<(LGLINE+LGLINES)) words per way.
+		parameter	LGLINES = 6,
+		// }}}
+		// OPT_TWOWAY
+		// {{{
+		// If set, the cache will be two way set associative.
+		// Otherwise it will be direct mapped.
+		parameter [0:0]	OPT_TWOWAY = 1'b0,
+		// }}}
+		// OPT_WRAPFILL
+		// {{{
+		// If set, lines are filled critical word first, wrapping around
+		// the end of the line, rather than from the start of the line.
+		parameter [0:0]	OPT_WRAPFILL = 1'b0,
+		// }}}
+		// CFG_MODE
+		// {{{
+		// CFG_MODE is the bit of the configuration register which,
+		// when written, places the controller into (or takes it out
+		// of) configuration mode.
+		parameter [4:0]	CFG_MODE = 12,
+		// }}}
+		localparam	DW = 32,
+		localparam	LGMEM = LGLINE + LGLINES,
+		localparam	TW = AW - LGMEM,
+		localparam [LGLINE:0]	LINESZ = (1<<LGLINE),
+		localparam [2:0]	STAT_ADDR = 3'b110
+		// }}}
+	) (
+		// {{{
+		input	wire			i_clk, i_reset,
+		// Incoming bus requests
+		// {{{
+		input	wire			i_wb_cyc, i_wb_stb,
+						i_cfg_stb, i_wb_we,
+		input	wire	[(AW-1):0]	i_wb_addr,
+		input	wire	[(DW-1):0]	i_wb_data,
+		//
+		output	wire			o_wb_stall,
+		output	reg			o_wb_ack,
+		output	reg	[(DW-1):0]	o_wb_data,
+		// }}}
+		// Outgoing requests, to the flash controller
+		// {{{
+		output	reg			o_fl_cyc, o_fl_stb,
+						o_fl_cfg_stb, o_fl_we,
+		output	reg	[(AW-1):0]	o_fl_addr,
+		output	reg	[(DW-1):0]	o_fl_data,
+		//
+		input	wire			i_fl_stall,
+		input	wire			i_fl_ack,
+		input	wire	[(DW-1):0]	i_fl_data
+		// }}}
+		// }}}
+	);
+
+	// Signal declarations
+	// {{{
+	reg			cfg_mode, fill_busy, fill_way, rd_wait,
+				pt_busy, pt_live;
+	reg	[(AW-1):0]	rd_addr;
+	reg	[LGLINE:0]	fill_reqs, fill_acks;
+
+	// The cache itself.  Way zero is always present, way one only when
+	// OPT_TWOWAY is set.  lru[set] gives the way to be replaced next.
+	reg	[(1<<LGLINES)-1:0]	valid0, valid1, lru;
+	reg	[TW-1:0]		tag0	[0:(1<<LGLINES)-1];
+	reg	[TW-1:0]		tag1	[0:(1<<LGLINES)-1];
+	reg	[(DW-1):0]		mem0	[0:(1<<LGMEM)-1];
+	reg	[(DW-1):0]		mem1	[0:(1<<LGMEM)-1];
+
+	reg	[31:0]		hit_count, miss_count, inval_count;
+
+	wire			stat_sel, stat_request, rd_request, pt_request,
+				hit0, hit1, rd_hit, rd_miss, invalidate, victim,
+				fill_ack, fill_last, pt_ack;
+	wire	[LGLINES-1:0]	req_set, fill_set;
+	wire	[TW-1:0]	req_tag, fill_tag;
+	wire	[LGMEM-1:0]	req_maddr, fill_maddr;
+	wire	[LGLINE-1:0]	fill_first, fill_word;
+	// }}}
+
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Request decoding
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	assign	stat_sel     = (i_wb_addr[4:2] == STAT_ADDR);
+	assign	stat_request = (i_cfg_stb)&&(!o_wb_stall)&&(stat_sel);
+
+	// Memory reads are ours.  Everything else gets passed through
+	assign	rd_request = (i_wb_stb)&&(!o_wb_stall)&&(!i_wb_we)&&(!cfg_mode);
+	assign	pt_request = (!o_wb_stall)&&(((i_cfg_stb)&&(!stat_sel))
+				||((i_wb_stb)&&((i_wb_we)||(cfg_mode))));
+	assign	invalidate = (pt_request)&&(i_wb_we);
+
+	assign	req_set   = i_wb_addr[LGLINE +: LGLINES];
+	assign	req_tag   = i_wb_addr[AW-1:LGMEM];
+	assign	req_maddr = i_wb_addr[LGMEM-1:0];
+
+	assign	hit0 = (valid0[req_set])&&(tag0[req_set] == req_tag);
+	assign	hit1 = (OPT_TWOWAY)&&(valid1[req_set])
+				&&(tag1[req_set] == req_tag);
+
+	assign	rd_hit  = (rd_request)&&((hit0)||(hit1));
+	assign	rd_miss = (rd_request)&&(!hit0)&&(!hit1);
+
+	// Replace an invalid way first, the least recently used way second
+	assign	victim = (OPT_TWOWAY)&&((!valid0[req_set]) ? 1'b0
+			: (!valid1[req_set]) ? 1'b1 : lru[req_set]);
+
+	assign	fill_set   = rd_addr[LGLINE +: LGLINES];
+	assign	fill_tag   = rd_addr[AW-1:LGMEM];
+	// fill_word is the word within the line that the next return will
+	// be for: the fill starts with the word that missed if OPT_WRAPFILL
+	// is set, or with the first word of the line otherwise
+	assign	fill_first = (OPT_WRAPFILL) ? rd_addr[LGLINE-1:0] : 0;
+	assign	fill_word  = fill_acks[LGLINE-1:0] + fill_first;
+	assign	fill_maddr = { rd_addr[LGMEM-1:LGLINE], fill_word };
+	assign	fill_ack   = (fill_busy)&&(i_fl_ack);
+	assign	fill_last  = (fill_ack)&&(fill_acks == LINESZ-1'b1);
+
+	assign	pt_ack     = (pt_busy)&&(i_fl_ack);
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// The cache tags and data
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// valid0, valid1, tag0, tag1
+	// {{{
+	// On a miss, the victim's line is invalidated and given its new tag
+	// at once.  It then becomes valid when the last word of the fill
+	// returns.
+	initial	valid0 = 0;
+	initial	valid1 = 0;
+	always @(posedge i_clk)
+	if ((i_reset)||(invalidate))
+	begin
+		valid0 <= 0;
+		valid1 <= 0;
+	end else if (rd_miss)
+	begin
+		if (!victim)
+			valid0[req_set] <= 1'b0;
+		else
+			valid1[req_set] <= 1'b0;
+	end else if (fill_last)
+	begin
+		if (!fill_way)
+			valid0[fill_set] <= 1'b1;
+		else if (OPT_TWOWAY)
+			valid1[fill_set] <= 1'b1;
+	end
+
+	always @(posedge i_clk)
+	if ((rd_miss)&&(!victim))
+		tag0[req_set] <= req_tag;
+
+	always @(posedge i_clk)
+	if ((rd_miss)&&(victim))
+		tag1[req_set] <= req_tag;
+	// }}}
+
+	// lru
+	// {{{
+	initial	lru = 0;
+	always @(posedge i_clk)
+	if ((i_reset)||(!OPT_TWOWAY))
+		lru <= 0;
+	else if (rd_hit)
+		lru[req_set] <= !hit1;
+	else if (fill_last)
+		lru[fill_set] <= !fill_way;
+	// }}}
+
+	// mem0, mem1
+	// {{{
+	always @(posedge i_clk)
+	if ((fill_ack)&&(!fill_way))
+		mem0[fill_maddr] <= i_fl_data;
+
+	always @(posedge i_clk)
+	if ((fill_ack)&&(fill_way))
+		mem1[fill_maddr] <= i_fl_data;
+	// }}}
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Line fills
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// fill_busy, fill_way, fill_reqs, fill_acks, rd_addr
+	// {{{
+	// Once started, a fill always runs to completion, even if the master
+	// abandons its request, so that the line is never left half written.
+	initial	fill_busy = 1'b0;
+	always @(posedge i_clk)
+	if (i_reset)
+		fill_busy <= 1'b0;
+	else if (rd_miss)
+		fill_busy <= 1'b1;
+	else if (fill_last)
+		fill_busy <= 1'b0;
+
+	always @(posedge i_clk)
+	if (rd_miss)
+	begin
+		fill_way  <= victim;
+		fill_reqs <= 0;
+		fill_acks <= 0;
+		rd_addr   <= i_wb_addr;
+	end else begin
+		if ((o_fl_stb)&&(!i_fl_stall)&&(fill_busy))
+			fill_reqs <= fill_reqs + 1'b1;
+		if (fill_ack)
+			fill_acks <= fill_acks + 1'b1;
+	end
+	// }}}
+
+	// rd_wait
+	// {{{
+	// True while the master is waiting on the word which missed
+	initial	rd_wait = 1'b0;
+	always @(posedge i_clk)
+	if ((i_reset)||(!i_wb_cyc))
+		rd_wait <= 1'b0;
+	else if (rd_miss)
+		rd_wait <= 1'b1;
+	else if ((fill_ack)&&(fill_word == rd_addr[LGLINE-1:0]))
+		rd_wait <= 1'b0;
+	// }}}
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Pass through requests, and snooping on the configuration mode
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// pt_busy, pt_live
+	// {{{
+	initial	pt_busy = 1'b0;
+	initial	pt_live = 1'b0;
+	always @(posedge i_clk)
+	if (i_reset)
+	begin
+		pt_busy <= 1'b0;
+		pt_live <= 1'b0;
+	end else if (pt_request)
+	begin
+		pt_busy <= 1'b1;
+		pt_live <= 1'b1;
+	end else begin
+		if (pt_ack)
+			pt_busy <= 1'b0;
+		if ((!i_wb_cyc)||(pt_ack))
+			pt_live <= 1'b0;
+	end
+	// }}}
+
+	// cfg_mode
+	// {{{
+	initial	cfg_mode = 1'b0;
+	always @(posedge i_clk)
+	if (i_reset)
+		cfg_mode <= 1'b0;
+	else if ((pt_request)&&(i_cfg_stb)&&(i_wb_we))
+		cfg_mode <= i_wb_data[CFG_MODE];
+	// }}}
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Downstream bus control
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// o_fl_cyc, o_fl_stb, o_fl_cfg_stb
+	// {{{
+	initial	o_fl_cyc     = 1'b0;
+	initial	o_fl_stb     = 1'b0;
+	initial	o_fl_cfg_stb = 1'b0;
+	always @(posedge i_clk)
+	if (i_reset)
+	begin
+		o_fl_cyc     <= 1'b0;
+		o_fl_stb     <= 1'b0;
+		o_fl_cfg_stb <= 1'b0;
+	end else if (rd_miss)
+	begin
+		o_fl_cyc     <= 1'b1;
+		o_fl_stb     <= 1'b1;
+		o_fl_cfg_stb <= 1'b0;
+	end else if (pt_request)
+	begin
+		o_fl_cyc     <= 1'b1;
+		o_fl_stb     <= i_wb_stb;
+		o_fl_cfg_stb <= i_cfg_stb;
+	end else if (fill_busy)
+	begin
+		if ((o_fl_stb)&&(!i_fl_stall)&&(fill_reqs == LINESZ-1'b1))
+			o_fl_stb <= 1'b0;
+		if (fill_last)
+			o_fl_cyc <= 1'b0;
+	end else if (pt_busy)
+	begin
+		if (!i_fl_stall)
+		begin
+			o_fl_stb     <= 1'b0;
+			o_fl_cfg_stb <= 1'b0;
+		end
+
+		if (pt_ack)
+			o_fl_cyc <= 1'b0;
+	end
+	// }}}
+
+	// o_fl_we, o_fl_addr, o_fl_data
+	// {{{
+	initial	o_fl_we = 1'b0;
+	always @(posedge i_clk)
+	if (rd_miss)
+	begin
+		o_fl_we   <= 1'b0;
+		if (OPT_WRAPFILL)
+			o_fl_addr <= i_wb_addr;
+		else
+			o_fl_addr <= { i_wb_addr[AW-1:LGLINE], {(LGLINE){1'b0}} };
+	end else if (pt_request)
+	begin
+		o_fl_we   <= i_wb_we;
+		o_fl_addr <= i_wb_addr;
+		o_fl_data <= i_wb_data;
+	end else if ((fill_busy)&&(o_fl_stb)&&(!i_fl_stall))
+		o_fl_addr[LGLINE-1:0] <= o_fl_addr[LGLINE-1:0] + 1'b1;
+	// }}}
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Statistics
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	initial	hit_count   = 0;
+	initial	miss_count  = 0;
+	initial	inval_count = 0;
+	always @(posedge i_clk)
+	if ((i_reset)||((stat_request)&&(i_wb_we)))
+	begin
+		hit_count   <= 0;
+		miss_count  <= 0;
+		inval_count <= 0;
+	end else begin
+		if (rd_hit)
+			hit_count   <= hit_count + 1;
+		if (rd_miss)
+			miss_count  <= miss_count + 1;
+		if (invalidate)
+			inval_count <= inval_count + 1;
+	end
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Upstream bus returns
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	assign	o_wb_stall = (fill_busy)||(pt_busy);
+
+	// o_wb_ack
+	// {{{
+	initial	o_wb_ack = 1'b0;
+	always @(posedge i_clk)
+	if ((i_reset)||(!i_wb_cyc))
+		o_wb_ack <= 1'b0;
+	else
+		o_wb_ack <= (rd_hit)||(stat_request)
+			||((rd_wait)&&(fill_ack)
+				&&(fill_word == rd_addr[LGLINE-1:0]))
+			||((pt_ack)&&(pt_live));
+	// }}}
+
+	// o_wb_data
+	// {{{
+	always @(posedge i_clk)
+	if (stat_request)
+	begin
+		case(i_wb_addr[1:0])
+		2'b00: o_wb_data <= hit_count;
+		2'b01: o_wb_data <= miss_count;
+		2'b10: o_wb_data <= inval_count;
+		2'b11: begin
+			o_wb_data <= 0;
+			o_wb_data[17]   <= OPT_WRAPFILL;
+			o_wb_data[16]   <= OPT_TWOWAY;
+			o_wb_data[15:8] <= LGLINES[7:0];
+			o_wb_data[ 7:0] <= LGLINE[7:0];
+			end
+		endcase
+	end else if ((fill_busy)||(pt_busy))
+		o_wb_data <= i_fl_data;
+	else if (hit1)
+		o_wb_data <= mem1[req_maddr];
+	else
+		o_wb_data <= mem0[req_maddr];
+	// }}}
+	// }}}
+
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//
+// Formal properties
+// {{{
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+`ifdef	FORMAL
+	localparam	F_LGDEPTH = 4;
+	reg	f_past_valid;
+	wire	[F_LGDEPTH-1:0]	f_nreqs, f_nacks, f_outstanding;
+	reg	[F_LGDEPTH-1:0]	f_dnreqs;
+
+	initial	f_past_valid = 1'b0;
+	always @(posedge i_clk)
+		f_past_valid <= 1'b1;
+
+	always @(*)
+	if (!f_past_valid)
+		assume(i_reset);
+
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Upstream bus properties
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	always @(*)
+		assume(!i_wb_stb || !i_cfg_stb);
+
+	fwb_slave #(.AW(AW), .DW(DW),.F_LGDEPTH(F_LGDEPTH),
+			.F_MAX_STALL(0), .F_MAX_ACK_DELAY(0),
+			.F_OPT_RMW_BUS_OPTION(0),
+			.F_OPT_CLK2FFLOGIC(1'b0),
+			.F_OPT_DISCONTINUOUS(1))
+		f_wbm(i_clk, i_reset,
+			i_wb_cyc, (i_wb_stb)||(i_cfg_stb), i_wb_we, i_wb_addr,
+				i_wb_data, 4'hf,
+			o_wb_ack, o_wb_stall, o_wb_data, 1'b0,
+			f_nreqs, f_nacks, f_outstanding);
+
+	always @(*)
+	if (i_wb_cyc)
+		assert(f_outstanding == (rd_wait ? 1:0)
+				+ ((pt_busy && pt_live) ? 1:0)
+				+ (o_wb_ack ? 1:0));
+
+	always @(*)
+		assert(!fill_busy || !pt_busy);
+
+	always @(*)
+	if (rd_wait)
+		assert(fill_busy);
+
+	always @(*)
+	if (pt_live)
+		assert(pt_busy);
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Downstream bus properties
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	initial	f_dnreqs = 0;
+	always @(posedge i_clk)
+	if ((i_reset)||(!o_fl_cyc))
+		f_dnreqs <= 0;
+	else case({ (o_fl_stb || o_fl_cfg_stb) && !i_fl_stall, i_fl_ack })
+	2'b10: f_dnreqs <= f_dnreqs + 1;
+	2'b01: f_dnreqs <= f_dnreqs - 1;
+	default: begin end
+	endcase
+
+	always @(*)
+	if (f_dnreqs == 0)
+		assume(!i_fl_ack);
+
+	always @(*)
+		assert(o_fl_cyc == (fill_busy || pt_busy));
+
+	always @(*)
+		assert(!o_fl_stb || !o_fl_cfg_stb);
+
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset))
+			&&($past(o_fl_stb || o_fl_cfg_stb))&&($past(i_fl_stall))
+			&&(o_fl_cyc))
+	begin
+		assert(o_fl_stb     == $past(o_fl_stb));
+		assert(o_fl_cfg_stb == $past(o_fl_cfg_stb));
+		assert(o_fl_addr    == $past(o_fl_addr));
+		assert(o_fl_we      == $past(o_fl_we));
+	end
+
+	always @(*)
+	if (fill_busy)
+	begin
+		assert(!o_fl_cfg_stb && !o_fl_we);
+		assert(fill_acks <= fill_reqs);
+		assert(fill_reqs <= LINESZ);
+		assert(o_fl_stb == (fill_reqs < LINESZ));
+		assert(f_dnreqs == fill_reqs - fill_acks);
+		assert(o_fl_addr[AW-1:LGLINE] == rd_addr[AW-1:LGLINE]);
+		if (o_fl_stb)
+			assert(o_fl_addr[LGLINE-1:0]
+				== fill_reqs[LGLINE-1:0] + fill_first);
+	end
+
+	always @(*)
+	if (pt_busy)
+		assert(f_dnreqs + ((o_fl_stb || o_fl_cfg_stb) ? 1:0) == 1);
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Cache properties
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	(* anyconst *)	reg	[AW-1:0]	f_addr;
+	(* anyconst *)	reg	[DW-1:0]	f_data;
+
+	wire	[LGLINES-1:0]	f_set;
+	wire	[TW-1:0]	f_tag;
+	wire	[LGMEM-1:0]	f_maddr;
+	reg	[AW-1:0]	f_rdaddr;
+
+	assign	f_set   = f_addr[LGLINE +: LGLINES];
+	assign	f_tag   = f_addr[AW-1:LGMEM];
+	assign	f_maddr = f_addr[LGMEM-1:0];
+
+	// The flash always returns f_data for f_addr
+	always @(*)
+	if ((fill_ack)&&({ rd_addr[AW-1:LGLINE], fill_word } == f_addr))
+		assume(i_fl_data == f_data);
+
+	// The line being filled is never valid
+	always @(*)
+	if (fill_busy)
+	begin
+		if (!fill_way)
+		begin
+			assert(!valid0[fill_set]);
+			assert(tag0[fill_set] == fill_tag);
+		end else begin
+			assert(OPT_TWOWAY);
+			assert(!valid1[fill_set]);
+			assert(tag1[fill_set] == fill_tag);
+		end
+	end
+
+	always @(*)
+	if (!OPT_TWOWAY)
+		assert(valid1 == 0);
+
+	// Any valid line holding f_addr must hold f_data
+	always @(*)
+	if ((valid0[f_set])&&(tag0[f_set] == f_tag))
+		assert(mem0[f_maddr] == f_data);
+
+	always @(*)
+	if ((valid1[f_set])&&(tag1[f_set] == f_tag))
+		assert(mem1[f_maddr] == f_data);
+
+	// ... as must any part of a line that has already been filled
+	wire	[LGLINE-1:0]	f_fillidx;
+
+	assign	f_fillidx = f_addr[LGLINE-1:0] - fill_first;
+
+	always @(*)
+	if ((fill_busy)&&(rd_addr[AW-1:LGLINE] == f_addr[AW-1:LGLINE])
+			&&({ 1'b0, f_fillidx } < fill_acks))
+	begin
+		if (!fill_way)
+			assert(mem0[f_maddr] == f_data);
+		else
+			assert(mem1[f_maddr] == f_data);
+	end
+
+	// So that anything we return for f_addr is f_data
+	always @(posedge i_clk)
+	if (rd_request)
+		f_rdaddr <= i_wb_addr;
+
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset))&&(o_wb_ack)
+			&&($past(rd_hit || (fill_ack && rd_wait)))
+			&&(f_rdaddr == f_addr))
+		assert(o_wb_data == f_data);
+
+	always @(*)
+	if (rd_wait)
+		assert(f_rdaddr == rd_addr);
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Cover properties
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset)))
+	begin
+		cover(o_wb_ack && $past(rd_hit));
+		cover(o_wb_ack && $past(rd_hit) && $past(o_wb_ack,2)
+			&& $past(rd_hit,2));
+		cover(fill_last && fill_way);
+		cover($past(invalidate) && valid0 == 0);
+	end
+	// }}}
+`endif
+// }}}
+endmodule
@@ -0,0 +1,498 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	flashcfgfifo.v
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	A configuration port FIFO, designed to sit between the bus and
+//		any of the flash controllers.  Every write to a controller's
+//	configuration port stalls the bus until its byte has been shifted out
+//	to the flash.  A master programming a page through that port then
+//	spends most of its time waiting on the controller, one byte at a
+//	time.  With this front end, the master instead writes its
+//	configuration words into a FIFO, at up to one write per clock, and
+//	goes on about its business while the FIFO drains them into the
+//	controller's configuration port, in order, one at a time.  Any bytes
+//	read back from the flash along the way may be kept in a second FIFO,
+//	to be read back later.  Nothing about the flash protocol changes:
+//	the words written are the same ones that would otherwise have been
+//	written to the configuration register itself.
+//
+//	- Configuration port requests with i_wb_addr[4:1] == 4'b0111 are
+//	  answered by the front end, rather than being passed to the
+//	  controller.  These addresses are otherwise unused by the
+//	  controllers and the other front ends, as listed in the
+//	  configuration port address map of the README.
+//
+//	5'h0e	CFGQ
+//		Write:	{ 15'h0, rxen, 16'h(configuration word) }
+//			Places the configuration word into the FIFO, to be
+//			written to the controller's configuration register
+//			(address zero) in turn.  All sixteen bits are kept,
+//			so that the chip select field of a controller with
+//			several devices (NCS), bits [15:13], reaches the
+//			controller as well.  If rxen is set, the low
+//			eight bits returned by the controller following this
+//			write--the byte read from the flash--will be placed
+//			into the receive FIFO.  Writes stall while the FIFO
+//			is full.
+//		Read:	{ busy, 15'h(words in the FIFO), 16'h(bytes received) }
+//	5'h0f	CFGRX
+//		Read:	{ valid, 23'h0, 8'h(byte) }.  Reads, and removes, the
+//			oldest byte from the receive FIFO.  If the receive
+//			FIFO is empty, valid will be clear.
+//		Write:	Empties the receive FIFO.
+//
+//	- All other requests are passed straight through to the controller.
+//	- While the FIFO is draining, the bus is stalled for everything other
+//	  than the front end's own registers.  A master wishing to know when
+//	  its bytes have been sent, such as before polling the flash's status
+//	  register, may read CFGQ until its busy bit clears.
+//	- The FIFO stops draining while the receive FIFO is full, so no byte
+//	  is ever lost.  A master waiting on room in a full FIFO must then
+//	  read some bytes out of the receive FIFO first.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2018-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+`default_nettype	none
+// }}}
+module	flashcfgfifo #(
+		// {{{
+		// AW
+		// {{{
+		// AW is the number of word address bits.  This needs to match
+		// the controller behind us, where it is given by LGFLASHSZ-2.
+		parameter	AW = 22,
+		// }}}
+		// LGFIFO
+		// {{{
+		// Both FIFOs hold 2^LGFIFO entries.  The default, 512, is
+		// enough for a whole page program command--write enable,
+		// command, address, 256 data bytes and all--to be written at
+		// once.  LGFIFO may be no more than 14.
+		parameter	LGFIFO = 9,
+		// }}}
+		localparam	DW = 32,
+		localparam	CW = 16,
+		localparam [4:0]	CFGQ_ADDR = 5'h0e
+		// }}}
+	) (
+		// {{{
+		input	wire			i_clk, i_reset,
+		// Incoming bus requests
+		// {{{
+		input	wire			i_wb_cyc, i_wb_stb,
+						i_cfg_stb, i_wb_we,
+		input	wire	[(AW-1):0]	i_wb_addr,
+		input	wire	[(DW-1):0]	i_wb_data,
+		//
+		output	wire			o_wb_stall,
+		output	wire			o_wb_ack,
+		output	wire	[(DW-1):0]	o_wb_data,
+		// }}}
+		// Outgoing requests, to the flash controller
+		// {{{
+		output	reg			o_fl_cyc, o_fl_stb,
+						o_fl_cfg_stb, o_fl_we,
+		output	reg	[(AW-1):0]	o_fl_addr,
+		output	reg	[(DW-1):0]	o_fl_data,
+		//
+		input	wire			i_fl_stall,
+		input	wire			i_fl_ack,
+		input	wire	[(DW-1):0]	i_fl_data
+		// }}}
+		// }}}
+	);
+
+	// Local declarations
+	// {{{
+	reg	[CW:0]		tx_mem	[0:(1<<LGFIFO)-1];
+	reg	[LGFIFO:0]	tx_wr, tx_rd;
+	wire	[LGFIFO:0]	tx_fill;
+	reg	[7:0]		rx_mem	[0:(1<<LGFIFO)-1];
+	reg	[LGFIFO:0]	rx_wr, rx_rd;
+	wire	[LGFIFO:0]	rx_fill;
+
+	reg			eng_stb, eng_ackwait, eng_rxen;
+	reg	[CW-1:0]	eng_word;
+	wire			eng_busy, eng_load, eng_ack;
+
+	wire	[3:0]		pt_pending;
+	wire			l_ack;
+	reg	[DW-1:0]	l_data;
+
+	wire			cfgq_sel, local_request, local_stb,
+				tx_push, tx_full, rx_push, rx_pop, rx_clear,
+				rx_full;
+	// }}}
+
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Request decoding
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// The front end's registers are ours.  Everything else gets passed
+	// through.
+	assign	cfgq_sel      = (i_wb_addr[4:1] == CFGQ_ADDR[4:1]);
+	assign	local_request = (i_cfg_stb)&&(cfgq_sel);
+	assign	local_stb     = (local_request)&&(!o_wb_stall);
+
+	assign	tx_push  = (local_stb)&&(i_wb_we)&&(!i_wb_addr[0]);
+	assign	rx_pop   = (local_stb)&&(!i_wb_we)&&(i_wb_addr[0])
+				&&(rx_fill != 0);
+	assign	rx_clear = (local_stb)&&(i_wb_we)&&(i_wb_addr[0]);
+
+	// passthru
+	// {{{
+	// Passes all other requests through to the controller, stalling local
+	// requests until those have been acknowledged.  Writes to the FIFO
+	// also wait for room in it.
+	flashpassthru #(
+		// {{{
+		.DW(DW)
+		// }}}
+	) passthru(
+		// {{{
+		.i_clk(i_clk), .i_reset(i_reset),
+		.i_wb_cyc(i_wb_cyc), .i_wb_stb((i_wb_stb)||(i_cfg_stb)),
+		.i_local(local_request),
+			.i_local_stall((i_wb_we)&&(tx_full)&&(!i_wb_addr[0])),
+			.i_local_data(l_data),
+		.i_busy(eng_busy), .i_busy_accept(1'b0), .i_busy_ack(1'b0),
+		.i_fl_stall(i_fl_stall), .i_fl_ack(i_fl_ack),
+			.i_fl_data(i_fl_data),
+		.o_wb_stall(o_wb_stall), .o_wb_ack(o_wb_ack),
+			.o_wb_data(o_wb_data),
+		.o_pending(pt_pending), .o_local_ack(l_ack)
+		// }}}
+	);
+	// }}}
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// The transmit FIFO
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	assign	tx_fill = tx_wr - tx_rd;
+	assign	tx_full = (tx_fill == (1<<LGFIFO));
+
+	always @(posedge i_clk)
+	if (tx_push)
+		tx_mem[tx_wr[LGFIFO-1:0]] <= i_wb_data[CW:0];
+
+	initial	tx_wr = 0;
+	always @(posedge i_clk)
+	if (i_reset)
+		tx_wr <= 0;
+	else if (tx_push)
+		tx_wr <= tx_wr + 1;
+
+	initial	tx_rd = 0;
+	always @(posedge i_clk)
+	if (i_reset)
+		tx_rd <= 0;
+	else if (eng_load)
+		tx_rd <= tx_rd + 1;
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// The drain engine
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// One configuration word is issued at a time.  Since the controller
+	// stalls until each byte has been sent anyway, little is lost by
+	// waiting on each acknowledgment before issuing the next.  The next
+	// word is only taken from the FIFO once there's room in the receive
+	// FIFO for whatever it might return.
+	assign	eng_busy = (tx_fill != 0)||(eng_stb)||(eng_ackwait);
+	assign	eng_load = (!eng_stb)&&(!eng_ackwait)&&(tx_fill != 0)
+				&&(!rx_full);
+	assign	eng_ack  = (eng_ackwait)&&(i_fl_ack);
+
+	// eng_stb, eng_ackwait
+	// {{{
+	initial	eng_stb     = 1'b0;
+	initial	eng_ackwait = 1'b0;
+	always @(posedge i_clk)
+	if (i_reset)
+	begin
+		eng_stb     <= 1'b0;
+		eng_ackwait <= 1'b0;
+	end else if (eng_load)
+		eng_stb <= 1'b1;
+	else if ((eng_stb)&&(!i_fl_stall))
+	begin
+		eng_stb     <= 1'b0;
+		eng_ackwait <= 1'b1;
+	end else if (eng_ack)
+		eng_ackwait <= 1'b0;
+	// }}}
+
+	// eng_word, eng_rxen
+	// {{{
+	always @(posedge i_clk)
+	if (eng_load)
+		{ eng_rxen, eng_word } <= tx_mem[tx_rd[LGFIFO-1:0]];
+	// }}}
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// The receive FIFO
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	assign	rx_fill = rx_wr - rx_rd;
+	assign	rx_full = (rx_fill == (1<<LGFIFO));
+	assign	rx_push = (eng_ack)&&(eng_rxen);
+
+	always @(posedge i_clk)
+	if (rx_push)
+		rx_mem[rx_wr[LGFIFO-1:0]] <= i_fl_data[7:0];
+
+	initial	rx_wr = 0;
+	always @(posedge i_clk)
+	if (i_reset)
+		rx_wr <= 0;
+	else if (rx_push)
+		rx_wr <= rx_wr + 1;
+
+	initial	rx_rd = 0;
+	always @(posedge i_clk)
+	if (i_reset)
+		rx_rd <= 0;
+	else if (rx_clear)
+		rx_rd <= rx_wr;
+	else if (rx_pop)
+		rx_rd <= rx_rd + 1;
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Downstream bus control
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	always @(*)
+	if (eng_busy)
+	begin
+		o_fl_cyc     = 1'b1;
+		o_fl_stb     = 1'b0;
+		o_fl_cfg_stb = eng_stb;
+		o_fl_we      = 1'b1;
+		o_fl_addr    = 0;
+		o_fl_data    = { {(DW-CW){1'b0}}, eng_word };
+	end else begin
+		o_fl_cyc     = i_wb_cyc;
+		o_fl_stb     = i_wb_stb;
+		o_fl_cfg_stb = (i_cfg_stb)&&(!cfgq_sel);
+		o_fl_we      = i_wb_we;
+		o_fl_addr    = i_wb_addr;
+		o_fl_data    = i_wb_data;
+	end
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Upstream bus returns
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// l_data
+	// {{{
+	always @(posedge i_clk)
+	if (!i_wb_addr[0])
+		l_data <= { eng_busy, {(14-LGFIFO){1'b0}}, tx_fill,
+					{(15-LGFIFO){1'b0}}, rx_fill };
+	else
+		l_data <= { (rx_fill != 0), 23'h0,
+					rx_mem[rx_rd[LGFIFO-1:0]] };
+	// }}}
+	// }}}
+
+	// Make verilator happy
+	// {{{
+	// verilator lint_off UNUSED
+	wire	unused;
+	assign	unused = &{ 1'b0, i_wb_data[31:17], i_fl_data[31:8] };
+	// verilator lint_on  UNUSED
+	// }}}
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//
+// Formal properties
+// {{{
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+`ifdef	FORMAL
+	localparam	F_LGDEPTH = 4;
+	reg	f_past_valid;
+	wire	[F_LGDEPTH-1:0]	f_nreqs, f_nacks, f_outstanding;
+	reg	[3:0]		f_dnreqs;
+
+	initial	f_past_valid = 1'b0;
+	always @(posedge i_clk)
+		f_past_valid <= 1'b1;
+
+	always @(*)
+	if (!f_past_valid)
+		assume(i_reset);
+
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Upstream bus properties
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	always @(*)
+		assume(!i_wb_stb || !i_cfg_stb);
+
+	fwb_slave #(.AW(AW), .DW(DW),.F_LGDEPTH(F_LGDEPTH),
+			.F_MAX_STALL(0), .F_MAX_ACK_DELAY(0),
+			.F_OPT_RMW_BUS_OPTION(0),
+			.F_OPT_CLK2FFLOGIC(1'b0),
+			.F_OPT_DISCONTINUOUS(1))
+		f_wbm(i_clk, i_reset,
+			i_wb_cyc, (i_wb_stb)||(i_cfg_stb), i_wb_we, i_wb_addr,
+				i_wb_data, 4'hf,
+			o_wb_ack, o_wb_stall, o_wb_data, 1'b0,
+			f_nreqs, f_nacks, f_outstanding);
+
+	always @(*)
+	if (i_wb_cyc)
+		assert(f_outstanding == pt_pending + (l_ack ? 1:0));
+
+	always @(*)
+	if (l_ack)
+		assert(pt_pending == 0);
+
+	always @(*)
+	if (eng_busy)
+		assert(pt_pending == 0);
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// FIFO properties
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	always @(*)
+	begin
+		assert(tx_fill <= (1<<LGFIFO));
+		assert(rx_fill <= (1<<LGFIFO));
+		assert(!eng_stb || !eng_ackwait);
+		if (eng_stb || eng_ackwait)
+			assert(!rx_full);
+	end
+
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset))&&($past(eng_stb))
+			&&($past(i_fl_stall)))
+	begin
+		assert(eng_stb);
+		assert(o_fl_data == $past(o_fl_data));
+	end
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Downstream bus properties
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// Count the requests the controller has accepted, but not yet
+	// acknowledged, since the cycle line was last raised.
+	initial	f_dnreqs = 0;
+	always @(posedge i_clk)
+	if ((i_reset)||(!o_fl_cyc))
+		f_dnreqs <= 0;
+	else case({ (o_fl_stb || o_fl_cfg_stb) && !i_fl_stall, i_fl_ack })
+	2'b10: f_dnreqs <= f_dnreqs + 1;
+	2'b01: f_dnreqs <= f_dnreqs - 1;
+	default: begin end
+	endcase
+
+	always @(*)
+	if (!o_fl_cyc || f_dnreqs == 0)
+		assume(!i_fl_ack);
+
+	always @(*)
+		assert(!o_fl_stb || !o_fl_cfg_stb);
+
+	always @(*)
+	if (!o_fl_cyc)
+		assert(!o_fl_stb && !o_fl_cfg_stb);
+
+	always @(*)
+	if (o_fl_cyc && !eng_busy)
+		assert(f_dnreqs == pt_pending);
+
+	always @(*)
+	if (eng_busy)
+		assert(f_dnreqs == (eng_ackwait ? 1:0));
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Cover properties
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset)))
+	begin
+		cover(tx_fill == 3);
+		cover(rx_push && rx_fill == 2);
+		cover($past(eng_busy) && !eng_busy && rx_fill == 2);
+		cover($past(eng_busy) && !eng_busy && o_wb_ack && rx_fill != 0
+			&& $past(tx_push,4));
+	end
+	// }}}
+`endif
+// }}}
+endmodule
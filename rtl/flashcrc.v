@@ -0,0 +1,677 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	flashcrc.v
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	A flash verification engine, designed to sit between the bus
+//		and any of the flash controllers.  Given an address range,
+//	the engine reads the range from the flash, as one long pipelined
+//	burst at the controller's full speed, and calculates the CRC32 of
+//	what it reads.  A driver wishing to verify a newly written image may
+//	then compare this one number against the CRC32 of the image it
+//	wrote, rather than reading every word of the image back across the
+//	bus.
+//
+//	The same read also checks whether the range is blank (erased).  The
+//	address of the first word read that isn't 32'hffff_ffff is kept in
+//	the BLANK register.  If the blank check bit is set when the engine
+//	is started, the engine stops at that word, rather than reading on to
+//	the end of the range--making for a quick erase verification.
+//
+//	If OPT_STREAM is set, the words read may also be sent out of an
+//	AXI-Stream master port, M_AXIS_*, for a DMA to copy into memory.
+//	This is intended for boot loaders copying large images from flash to
+//	RAM, without the CPU's help and without the overhead of a bus request
+//	per word.  The first byte read from the flash is placed in
+//	M_AXIS_TDATA[7:0], and M_AXIS_TLAST is set on the last word of the
+//	range.  A small FIFO holds the words waiting on M_AXIS_TREADY, and
+//	requests to the flash are only issued while there's room in the FIFO
+//	for their results.  The CRC of the streamed data is calculated as
+//	well, and may be checked once done.
+//
+//	The CRC is the common (Ethernet, zlib, gzip) CRC32: the reflected
+//	polynomial 32'hedb88320, starting from 32'hffff_ffff, with the result
+//	complemented.  It is calculated across the flash bytes in address
+//	order, so that crc32(0, image, length) from zlib, run over the bytes
+//	written into the flash, will return the same value.
+//
+//	- Configuration port requests with i_wb_addr[4:2] == 3'b111 are
+//	  answered by the engine, rather than being passed to the controller.
+//	  (See the configuration port address map in the README.)
+//
+//	5'h1c	CRCADDR
+//		The byte address of the first word to be read.  Bits [1:0]
+//		are ignored.
+//	5'h1d	CRCLEN
+//		Read:	{ busy, 7'h0, 24'h(words left to read) }
+//		Write:	{ blank check, stream, 6'h0,
+//				24'h(number of words to read) }
+//			Writing a nonzero length starts the engine, reading
+//			from CRCADDR.  If the blank check bit is set, the
+//			engine stops at the first word that isn't blank.  If
+//			the stream bit is set, and OPT_STREAM, the words are
+//			also sent to the stream port.  (A streaming engine
+//			never stops early.)  While the engine is busy, or
+//			while any words remain in the stream FIFO, writes to
+//			this register are ignored.
+//	5'h1e	CRC
+//		Read:	The CRC32 of the last range read.  Only valid once
+//			the engine is no longer busy.
+//	5'h1f	BLANK
+//		Read:	{ blank, 7'h0, 24'h(byte address) }.  Once the engine
+//			is done, the blank bit will be set if every word read
+//			was 32'hffff_ffff.  Otherwise, the address is that of
+//			the first word read that wasn't.
+//
+//	- All other requests are passed straight through to the controller.
+//	- While the engine is busy, the bus is stalled for everything other
+//	  than the engine's own registers.
+//
+//	OPT_ENDIANSWAP must match the controller's, so that the engine knows
+//	which byte of each word was read from the flash first.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2018-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+`default_nettype	none
+// }}}
+module	flashcrc #(
+		// {{{
+		// AW
+		// {{{
+		// AW is the number of word address bits.  This needs to match
+		// the controller behind us, where it is given by LGFLASHSZ-2.
+		parameter	AW = 22,
+		// }}}
+		// OPT_ENDIANSWAP
+		// {{{
+		// This needs to match the controller behind us.  If set, the
+		// first byte of each word read from the flash is found in bits
+		// [7:0], otherwise in bits [31:24].
+		parameter [0:0]	OPT_ENDIANSWAP = 1'b1,
+		// }}}
+		// OPT_STREAM, LGFIFO
+		// {{{
+		// Set OPT_STREAM to enable the AXI-Stream port.  Its FIFO will
+		// then hold 2^LGFIFO words.
+		parameter [0:0]	OPT_STREAM = 1'b0,
+		parameter	LGFIFO = 4,
+		// }}}
+		localparam	DW = 32,
+		localparam [2:0]	CRC_ADDR = 3'b111,
+		localparam [31:0]	CRC_POLY = 32'hedb8_8320
+		// }}}
+	) (
+		// {{{
+		input	wire			i_clk, i_reset,
+		// Incoming bus requests
+		// {{{
+		input	wire			i_wb_cyc, i_wb_stb,
+						i_cfg_stb, i_wb_we,
+		input	wire	[(AW-1):0]	i_wb_addr,
+		input	wire	[(DW-1):0]	i_wb_data,
+		//
+		output	wire			o_wb_stall,
+		output	wire			o_wb_ack,
+		output	wire	[(DW-1):0]	o_wb_data,
+		// }}}
+		// Outgoing requests, to the flash controller
+		// {{{
+		output	reg			o_fl_cyc, o_fl_stb,
+						o_fl_cfg_stb, o_fl_we,
+		output	reg	[(AW-1):0]	o_fl_addr,
+		output	reg	[(DW-1):0]	o_fl_data,
+		//
+		input	wire			i_fl_stall,
+		input	wire			i_fl_ack,
+		input	wire	[(DW-1):0]	i_fl_data,
+		// }}}
+		// The stream port, if OPT_STREAM
+		// {{{
+		output	wire			M_AXIS_TVALID,
+		input	wire			M_AXIS_TREADY,
+		output	wire	[31:0]		M_AXIS_TDATA,
+		output	wire			M_AXIS_TLAST
+		// }}}
+		// }}}
+	);
+
+	// Local declarations
+	// {{{
+	reg			crc_busy;
+	reg	[1:0]		crc_wait;
+	reg	[23:0]		crc_base;
+	reg	[AW-1:0]	crc_addr;
+	reg	[23:0]		crc_reqs, crc_acks;
+	wire	[23:0]		crc_outstanding;
+	reg			crc_blankchk, crc_stream, blank_found;
+	wire			stream_room, stream_busy;
+	reg	[AW-1:0]	crc_rdaddr, blank_addr;
+	wire	[31:0]		blank_wide;
+	reg	[31:0]		crc_reg, crc_next;
+	wire	[31:0]		crc_data;
+	integer			ik;
+
+	wire	[3:0]		pt_pending;
+	wire			l_ack;
+	reg	[DW-1:0]	l_data;
+
+	wire			crc_sel, local_request, addr_write, len_write,
+				crc_start, crc_stb, crc_accept, crc_ack,
+				nonblank, crc_stop;
+	// }}}
+
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Request decoding
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// The engine's registers are ours.  Everything else gets passed
+	// through.
+	assign	crc_sel       = (i_wb_addr[4:2] == CRC_ADDR);
+	assign	local_request = (i_cfg_stb)&&(crc_sel);
+
+	assign	addr_write = (local_request)&&(i_wb_we)&&(!o_wb_stall)
+				&&(i_wb_addr[1:0] == 2'b00);
+	assign	len_write  = (local_request)&&(i_wb_we)&&(!o_wb_stall)
+				&&(i_wb_addr[1:0] == 2'b01);
+	assign	crc_start  = (len_write)&&(!crc_busy)&&(!stream_busy)
+				&&(i_wb_data[23:0] != 0);
+
+	// passthru
+	// {{{
+	// Passes all other requests through to the controller, stalling local
+	// requests until those have been acknowledged
+	flashpassthru #(
+		// {{{
+		.DW(DW)
+		// }}}
+	) passthru(
+		// {{{
+		.i_clk(i_clk), .i_reset(i_reset),
+		.i_wb_cyc(i_wb_cyc), .i_wb_stb((i_wb_stb)||(i_cfg_stb)),
+		.i_local(local_request), .i_local_stall(1'b0),
+			.i_local_data(l_data),
+		.i_busy(crc_busy), .i_busy_accept(1'b0), .i_busy_ack(1'b0),
+		.i_fl_stall(i_fl_stall), .i_fl_ack(i_fl_ack),
+			.i_fl_data(i_fl_data),
+		.o_wb_stall(o_wb_stall), .o_wb_ack(o_wb_ack),
+			.o_wb_data(o_wb_data),
+		.o_pending(pt_pending), .o_local_ack(l_ack)
+		// }}}
+	);
+	// }}}
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// The read engine
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// crc_base
+	// {{{
+	initial	crc_base = 0;
+	always @(posedge i_clk)
+	if (i_reset)
+		crc_base <= 0;
+	else if (addr_write)
+		crc_base <= { i_wb_data[23:2], 2'b00 };
+	// }}}
+
+	assign	crc_stb = (crc_busy)&&(crc_wait == 0)&&(crc_reqs != 0)
+				&&((!crc_stream)||(stream_room));
+	assign	crc_accept = (crc_stb)&&(!i_fl_stall);
+	assign	crc_ack = (crc_busy)&&(crc_wait == 0)&&(i_fl_ack);
+	assign	crc_outstanding = crc_acks - crc_reqs;
+
+	// Stop a blank check at the first word that isn't blank
+	assign	nonblank = (crc_ack)&&(i_fl_data != 32'hffff_ffff);
+	assign	crc_stop = (nonblank)&&(crc_blankchk)&&(!crc_stream)
+				&&(!blank_found);
+
+	// crc_busy, crc_wait, crc_addr, crc_reqs, crc_acks
+	// {{{
+	// Requests are issued back to back, for as long as the controller
+	// will accept them, so that it may turn them into a single burst.
+	// crc_reqs counts the requests left to issue, crc_acks the
+	// acknowledgments left to be received.  When a blank check stops,
+	// only the requests already accepted remain to be acknowledged.
+	initial	crc_busy = 1'b0;
+	initial	crc_wait = 2'b00;
+	initial	crc_reqs = 0;
+	initial	crc_acks = 0;
+	always @(posedge i_clk)
+	if (i_reset)
+	begin
+		// {{{
+		crc_busy <= 1'b0;
+		crc_wait <= 2'b00;
+		crc_reqs <= 0;
+		crc_acks <= 0;
+		// }}}
+	end else if (!crc_busy)
+	begin
+		// {{{
+		crc_addr <= crc_base[AW+1:2];
+		if (crc_start)
+		begin
+			crc_busy <= 1'b1;
+			// Give any acknowledgment, from a request abandoned
+			// by the master, time to clear first
+			crc_wait <= 2'b11;
+			crc_reqs <= i_wb_data[23:0];
+			crc_acks <= i_wb_data[23:0];
+		end
+		// }}}
+	end else if (crc_wait != 0)
+		crc_wait <= crc_wait - 1;
+	else begin
+		// {{{
+		if (crc_accept)
+		begin
+			crc_addr <= crc_addr + 1;
+			crc_reqs <= crc_reqs - 1;
+		end
+
+		if (crc_ack)
+		begin
+			crc_acks <= crc_acks - 1;
+			if (crc_acks == 1)
+				crc_busy <= 1'b0;
+		end
+
+		if (crc_stop)
+		begin
+			crc_reqs <= 0;
+			crc_acks <= crc_outstanding
+					+ { 23'h0, crc_accept } - 1;
+			crc_busy <= (crc_outstanding
+					+ { 23'h0, crc_accept } > 1);
+		end
+		// }}}
+	end
+	// }}}
+
+	// crc_blankchk, crc_stream, crc_rdaddr, blank_found, blank_addr
+	// {{{
+	always @(posedge i_clk)
+	if (crc_start)
+	begin
+		crc_blankchk <= i_wb_data[31];
+		crc_stream   <= (OPT_STREAM)&&(i_wb_data[30]);
+	end
+
+	always @(posedge i_clk)
+	if (!crc_busy)
+		crc_rdaddr <= crc_base[AW+1:2];
+	else if (crc_ack)
+		crc_rdaddr <= crc_rdaddr + 1;
+
+	initial	blank_found = 1'b0;
+	always @(posedge i_clk)
+	if (i_reset)
+		blank_found <= 1'b0;
+	else if (crc_start)
+		blank_found <= 1'b0;
+	else if (nonblank)
+		blank_found <= 1'b1;
+
+	always @(posedge i_clk)
+	if (crc_start)
+		blank_addr <= 0;
+	else if ((nonblank)&&(!blank_found))
+		blank_addr <= crc_rdaddr;
+
+	assign	blank_wide = { {(32-AW-2){1'b0}}, blank_addr, 2'b00 };
+	// }}}
+
+	// crc_data
+	// {{{
+	// Place the first byte read from the flash into bits [7:0], since the
+	// reflected CRC works from the least significant bit up
+	generate if (OPT_ENDIANSWAP)
+	begin : NO_SWAP
+		assign	crc_data = i_fl_data;
+	end else begin : BYTE_SWAP
+		assign	crc_data = { i_fl_data[7:0], i_fl_data[15:8],
+					i_fl_data[23:16], i_fl_data[31:24] };
+	end endgenerate
+	// }}}
+
+	// crc_next, crc_reg
+	// {{{
+	// A full 32 bits of the CRC, one bit at a time, every clock
+	always @(*)
+	begin
+		crc_next = crc_reg ^ crc_data;
+		for(ik=0; ik<32; ik=ik+1)
+		if (crc_next[0])
+			crc_next = (crc_next >> 1) ^ CRC_POLY;
+		else
+			crc_next = (crc_next >> 1);
+	end
+
+	initial	crc_reg = 32'hffff_ffff;
+	always @(posedge i_clk)
+	if (i_reset)
+		crc_reg <= 32'hffff_ffff;
+	else if (crc_start)
+		crc_reg <= 32'hffff_ffff;
+	else if (crc_ack)
+		crc_reg <= crc_next;
+	// }}}
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// The stream port
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	generate if (OPT_STREAM)
+	begin : GEN_STREAM
+		// {{{
+		reg	[32:0]		fifo_mem	[0:(1<<LGFIFO)-1];
+		reg	[LGFIFO:0]	fifo_wr, fifo_rd;
+		wire	[LGFIFO:0]	fifo_fill;
+		wire	[23:0]		fifo_committed;
+		wire			fifo_write, fifo_read;
+
+		assign	fifo_write = (crc_ack)&&(crc_stream);
+		assign	fifo_read  = (M_AXIS_TVALID)&&(M_AXIS_TREADY);
+		assign	fifo_fill  = fifo_wr - fifo_rd;
+
+		always @(posedge i_clk)
+		if (fifo_write)
+			fifo_mem[fifo_wr[LGFIFO-1:0]] <= { (crc_acks == 1),
+								crc_data };
+
+		initial	fifo_wr = 0;
+		always @(posedge i_clk)
+		if (i_reset)
+			fifo_wr <= 0;
+		else if (fifo_write)
+			fifo_wr <= fifo_wr + 1;
+
+		initial	fifo_rd = 0;
+		always @(posedge i_clk)
+		if (i_reset)
+			fifo_rd <= 0;
+		else if (fifo_read)
+			fifo_rd <= fifo_rd + 1;
+
+		// Every request outstanding will need a place in the FIFO
+		assign	fifo_committed = crc_outstanding
+				+ { {(24-LGFIFO-1){1'b0}}, fifo_fill };
+		assign	stream_room = (fifo_committed < (1<<LGFIFO));
+		assign	stream_busy = (fifo_fill != 0);
+
+		assign	M_AXIS_TVALID = (fifo_fill != 0);
+		assign	{ M_AXIS_TLAST, M_AXIS_TDATA }
+					= fifo_mem[fifo_rd[LGFIFO-1:0]];
+`ifdef	FORMAL
+		always @(*)
+		begin
+			assert(fifo_fill <= (1<<LGFIFO));
+			if ((crc_busy)&&(crc_stream))
+				assert(fifo_committed <= (1<<LGFIFO));
+			if (fifo_fill != 0)
+				assert(!crc_busy || crc_stream);
+		end
+`endif
+		// }}}
+	end else begin : NO_STREAM
+		// {{{
+		assign	stream_room = 1'b1;
+		assign	stream_busy = 1'b0;
+
+		assign	M_AXIS_TVALID = 1'b0;
+		assign	M_AXIS_TDATA  = 32'h0;
+		assign	M_AXIS_TLAST  = 1'b0;
+
+		// verilator lint_off UNUSED
+		wire	unused_stream;
+		assign	unused_stream = &{ 1'b0, M_AXIS_TREADY };
+		// verilator lint_on  UNUSED
+		// }}}
+	end endgenerate
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Downstream bus control
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	always @(*)
+	if (crc_busy)
+	begin
+		o_fl_cyc     = 1'b1;
+		o_fl_stb     = crc_stb;
+		o_fl_cfg_stb = 1'b0;
+		o_fl_we      = 1'b0;
+		o_fl_addr    = crc_addr;
+		o_fl_data    = 0;
+	end else begin
+		o_fl_cyc     = i_wb_cyc;
+		o_fl_stb     = i_wb_stb;
+		o_fl_cfg_stb = (i_cfg_stb)&&(!crc_sel);
+		o_fl_we      = i_wb_we;
+		o_fl_addr    = i_wb_addr;
+		o_fl_data    = i_wb_data;
+	end
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Upstream bus returns
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// l_data
+	// {{{
+	always @(posedge i_clk)
+	case(i_wb_addr[1:0])
+	2'b00:	 l_data <= { 8'h0, crc_base };
+	2'b01:	 l_data <= { (crc_busy)||(stream_busy), 7'h0, crc_acks };
+	2'b10:	 l_data <= ~crc_reg;
+	2'b11:	 l_data <= { !blank_found, 7'h0, blank_wide[23:0] };
+	endcase
+	// }}}
+	// }}}
+
+	// Make verilator happy
+	// {{{
+	// verilator lint_off UNUSED
+	wire	unused;
+	assign	unused = &{ 1'b0, i_wb_data[29:24], blank_wide[31:24] };
+	// verilator lint_on  UNUSED
+	// }}}
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//
+// Formal properties
+// {{{
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+`ifdef	FORMAL
+	localparam	F_LGDEPTH = 4;
+	reg	f_past_valid;
+	wire	[F_LGDEPTH-1:0]	f_nreqs, f_nacks, f_outstanding;
+	reg	[23:0]		f_dnreqs;
+
+	initial	f_past_valid = 1'b0;
+	always @(posedge i_clk)
+		f_past_valid <= 1'b1;
+
+	always @(*)
+	if (!f_past_valid)
+		assume(i_reset);
+
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Upstream bus properties
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	always @(*)
+		assume(!i_wb_stb || !i_cfg_stb);
+
+	fwb_slave #(.AW(AW), .DW(DW),.F_LGDEPTH(F_LGDEPTH),
+			.F_MAX_STALL(0), .F_MAX_ACK_DELAY(0),
+			.F_OPT_RMW_BUS_OPTION(0),
+			.F_OPT_CLK2FFLOGIC(1'b0),
+			.F_OPT_DISCONTINUOUS(1))
+		f_wbm(i_clk, i_reset,
+			i_wb_cyc, (i_wb_stb)||(i_cfg_stb), i_wb_we, i_wb_addr,
+				i_wb_data, 4'hf,
+			o_wb_ack, o_wb_stall, o_wb_data, 1'b0,
+			f_nreqs, f_nacks, f_outstanding);
+
+	always @(*)
+	if (i_wb_cyc)
+		assert(f_outstanding == pt_pending + (l_ack ? 1:0));
+
+	always @(*)
+	if (l_ack)
+		assert(pt_pending == 0);
+
+	always @(*)
+	if (crc_busy)
+		assert(pt_pending == 0);
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Downstream bus properties
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// Count the requests the controller has accepted, but not yet
+	// acknowledged, since the cycle line was last raised.
+	initial	f_dnreqs = 0;
+	always @(posedge i_clk)
+	if ((i_reset)||(!o_fl_cyc))
+		f_dnreqs <= 0;
+	else case({ (o_fl_stb || o_fl_cfg_stb) && !i_fl_stall, i_fl_ack })
+	2'b10: f_dnreqs <= f_dnreqs + 1;
+	2'b01: f_dnreqs <= f_dnreqs - 1;
+	default: begin end
+	endcase
+
+	always @(*)
+	if (!o_fl_cyc || f_dnreqs == 0)
+		assume(!i_fl_ack);
+
+	always @(*)
+		assert(!o_fl_stb || !o_fl_cfg_stb);
+
+	always @(*)
+	if (!o_fl_cyc)
+		assert(!o_fl_stb && !o_fl_cfg_stb);
+
+	always @(*)
+	if (o_fl_cyc && !crc_busy)
+		assert(f_dnreqs == { 20'h0, pt_pending });
+
+	always @(*)
+	if (crc_busy)
+	begin
+		assert(crc_acks != 0);
+		assert(crc_reqs <= crc_acks);
+		assert(f_dnreqs == crc_outstanding);
+		if (crc_wait != 0)
+			assert(crc_reqs == crc_acks);
+		if ((crc_blankchk)&&(blank_found))
+			assert(crc_reqs == 0);
+	end else begin
+		assert(crc_wait == 0);
+		assert(crc_reqs == 0 && crc_acks == 0);
+	end
+
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset))
+			&&($past(M_AXIS_TVALID))&&(!$past(M_AXIS_TREADY)))
+	begin
+		assert(M_AXIS_TVALID);
+		assert(M_AXIS_TDATA == $past(M_AXIS_TDATA));
+		assert(M_AXIS_TLAST == $past(M_AXIS_TLAST));
+	end
+
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset))&&($past(crc_busy))
+			&&($past(o_fl_stb))&&($past(i_fl_stall)))
+	begin
+		assert(o_fl_stb);
+		assert(o_fl_addr == $past(o_fl_addr));
+	end
+
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset))&&(crc_busy)
+			&&($past(crc_busy))&&($past(o_fl_stb))
+			&&(!$past(i_fl_stall)))
+		assert(o_fl_addr == $past(o_fl_addr) + 1'b1);
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Cover properties
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset)))
+	begin
+		cover(crc_busy && crc_reqs == 0 && crc_acks == 2);
+		cover($past(crc_stop) && crc_busy && crc_acks == 2);
+		cover(M_AXIS_TVALID && M_AXIS_TREADY && M_AXIS_TLAST
+				&& !crc_busy && $past(M_AXIS_TVALID,2));
+		cover($past(crc_busy) && !crc_busy && o_wb_ack);
+		cover(!crc_busy && $past(crc_busy) && $past(crc_busy,4)
+			&& $past(crc_ack,2) && $past(crc_ack,3));
+	end
+	// }}}
+`endif
+// }}}
+endmodule
@@ -0,0 +1,146 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	flashpassthru.v
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	The bus return path shared by the front ends that sit between
+//		the bus and a flash controller: flashpgm, flashcrc, and
+//	flashcfgfifo.  Each such front end answers requests to its own
+//	registers itself, passes every other request through to the
+//	controller, and at times takes the controller over for its own use.
+//	This module keeps the acknowledgments of these in order.
+//
+//	- Requests passed through are counted until acknowledged.
+//	- A local request waits for all of those acknowledgments first,
+//	  and is then acknowledged on the next clock, with i_local_data.
+//	- While the front end is busy with the controller, nothing is passed
+//	  through--unless the front end lowers i_busy for a request it has
+//	  room for, such as flashpgm between status polls.  The front end
+//	  must then wait for its acknowledgment before using the controller
+//	  again.  Other requests stall, unless the front end accepts one
+//	  itself on the master's behalf (i_busy_accept), such as flashpgm's
+//	  read of a suspended flash.  Its acknowledgment (i_busy_ack) is then
+//	  returned along with the controller's data.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2018-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+`default_nettype	none
+// }}}
+module	flashpassthru #(
+		// {{{
+		parameter	DW = 32
+		// }}}
+	) (
+		// {{{
+		input	wire			i_clk, i_reset,
+		// The master's request, to either port
+		input	wire			i_wb_cyc, i_wb_stb,
+		// Requests answered by the front end itself
+		// {{{
+		input	wire			i_local, i_local_stall,
+		input	wire	[(DW-1):0]	i_local_data,
+		// }}}
+		// While the front end is using the controller
+		// {{{
+		input	wire			i_busy, i_busy_accept,
+						i_busy_ack,
+		// }}}
+		// Returns from the flash controller
+		// {{{
+		input	wire			i_fl_stall,
+		input	wire			i_fl_ack,
+		input	wire	[(DW-1):0]	i_fl_data,
+		// }}}
+		//
+		output	reg			o_wb_stall,
+		output	wire			o_wb_ack,
+		output	wire	[(DW-1):0]	o_wb_data,
+		//
+		output	reg	[3:0]		o_pending,
+		output	reg			o_local_ack
+		// }}}
+	);
+
+	// Local declarations
+	// {{{
+	wire	pt_accept, pt_ack;
+	// }}}
+
+	// o_wb_stall
+	// {{{
+	// Local requests wait for any passed through requests to be
+	// acknowledged first, so that the acknowledgments remain in order.
+	always @(*)
+	if (i_local)
+		o_wb_stall = (o_pending != 0)||(i_local_stall);
+	else if (i_busy)
+		o_wb_stall = !i_busy_accept;
+	else
+		o_wb_stall = i_fl_stall;
+	// }}}
+
+	assign	pt_accept = (!i_busy)&&(i_wb_stb)&&(!i_local)&&(!i_fl_stall);
+	// The front end never uses the controller itself while requests
+	// passed through remain outstanding
+	assign	pt_ack    = (i_fl_ack)&&(o_pending != 0);
+
+	// o_pending
+	// {{{
+	// Counts the requests passed through to the controller, and not yet
+	// acknowledged
+	initial	o_pending = 0;
+	always @(posedge i_clk)
+	if ((i_reset)||(!i_wb_cyc))
+		o_pending <= 0;
+	else case({ pt_accept, pt_ack })
+	2'b10: o_pending <= o_pending + 1;
+	2'b01: o_pending <= o_pending - 1;
+	default: begin end
+	endcase
+	// }}}
+
+	// o_local_ack
+	// {{{
+	initial	o_local_ack = 1'b0;
+	always @(posedge i_clk)
+	if ((i_reset)||(!i_wb_cyc))
+		o_local_ack <= 1'b0;
+	else
+		o_local_ack <= (i_local)&&(!o_wb_stall);
+	// }}}
+
+	assign	o_wb_ack  = (o_local_ack)
+				||((i_wb_cyc)&&((pt_ack)||(i_busy_ack)));
+	assign	o_wb_data = (o_local_ack) ? i_local_data : i_fl_data;
+endmodule
@@ -0,0 +1,631 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	flashpfetch.v
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	A read-ahead prefetch stage, designed to sit between a bus
+//		master (typically a CPU's instruction fetch) and the memory
+//	port of either the qflexpress or dualflexpress controllers.
+//
+//	Those controllers can keep a read going, with only 8 (or 16) clocks
+//	per word, for as long as each new request arrives for the next
+//	sequential address before the current word completes.  Any bubble in
+//	the master's request stream, however, closes the transaction and
+//	costs a new address cycle (12+8N clocks) on the next request.  This
+//	module hides those bubbles by continuing to request sequential words
+//	from the controller on its own, up to (1<<LGPF) words past the last
+//	word requested, and then holding the results for the master.
+//
+//	- A request for a word already in the buffer is acknowledged on the
+//	  next clock.
+//	- A request for a word that has been requested, but not yet returned,
+//	  waits for it.
+//	- A request for a word shortly ahead of the buffer's head drops the
+//	  words before it.
+//	- Any other request is a miss.  Should any speculative reads be
+//	  outstanding, the downstream cycle is dropped for two clocks to
+//	  abort them.  The controllers are built to finish the word in
+//	  progress and to then discard it silently.  The buffer is then
+//	  restarted at the requested address.
+//
+//	Configuration port requests, as well as any memory port writes, are
+//	passed straight through once the buffer has been flushed and any
+//	reads in flight have been aborted.  Since the flash may change under
+//	a configuration port request (program or erase), no prefetched data
+//	is ever kept across one.  Likewise, while the controller has been
+//	placed into its configuration mode, reads are passed through and
+//	nothing is prefetched.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2018-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+`default_nettype	none
+// }}}
+module	flashpfetch #(
+		// {{{
+		// AW
+		// {{{
+		// AW is the number of word address bits.  This needs to match
+		// the controller behind us, where it is given by LGFLASHSZ-2.
+		parameter	AW = 22,
+		// }}}
+		// LGPF
+		// {{{
+		// LGPF is the log, base two, of the number of words we may
+		// hold, counting both those in our buffer and those still in
+		// flight within the controller.  Hence, with LGPF=3, we'll
+		// read up to eight words past the last word requested.
+		parameter	LGPF = 3,
+		// }}}
+		// CFG_MODE
+		// {{{
+		// CFG_MODE is the bit of the configuration register which,
+		// when written, places the controller into (or takes it out
+		// of) configuration mode.  We snoop on it, so as not to issue
+		// speculative reads the controller cannot honor.
+		parameter [4:0]	CFG_MODE = 12,
+		// }}}
+		localparam	DW = 32,
+		localparam [LGPF:0]	PFSZ = (1<<LGPF)
+		// }}}
+	) (
+		// {{{
+		input	wire			i_clk, i_reset,
+		// Incoming bus requests
+		// {{{
+		input	wire			i_wb_cyc, i_wb_stb,
+						i_cfg_stb, i_wb_we,
+		input	wire	[(AW-1):0]	i_wb_addr,
+		input	wire	[(DW-1):0]	i_wb_data,
+		//
+		output	wire			o_wb_stall,
+		output	reg			o_wb_ack,
+		output	reg	[(DW-1):0]	o_wb_data,
+		// }}}
+		// Outgoing requests, to the flash controller
+		// {{{
+		output	reg			o_fl_cyc, o_fl_stb,
+						o_fl_cfg_stb, o_fl_we,
+		output	reg	[(AW-1):0]	o_fl_addr,
+		output	reg	[(DW-1):0]	o_fl_data,
+		//
+		input	wire			i_fl_stall,
+		input	wire			i_fl_ack,
+		input	wire	[(DW-1):0]	i_fl_data
+		// }}}
+		// }}}
+	);
+
+	// Signal declarations
+	// {{{
+	reg			cfg_mode, rd_pending, pt_req, pt_wait, pt_cfg,
+				pt_live;
+	reg	[(AW-1):0]	rd_addr;
+
+	// The prefetch buffer
+	//	pf_base  is the address of the word at the head of the buffer
+	//	pf_fill  counts all words claimed: those in the buffer, those
+	//		in flight, and any request presently on the bus
+	//	pf_avail counts the words that have actually been returned
+	//	pf_abort is non-zero while the downstream cycle line is held
+	//		low to abort any reads in flight.  Two clocks are
+	//		required, to clear the controller's ack pipeline when
+	//		RDDELAY > 0.
+	reg			pf_valid;
+	reg	[1:0]		pf_abort;
+	reg	[(AW-1):0]	pf_base;
+	reg	[LGPF:0]	pf_fill, pf_avail;
+	reg	[LGPF-1:0]	pf_rd, pf_wr;
+	reg	[(DW-1):0]	pf_mem	[0:(1<<LGPF)-1];
+
+	wire			rd_request, pt_request, lookup, head_hit,
+				in_window, pf_busy, pf_ack, pf_pop, pf_restart,
+				pf_issue, pt_ack;
+	wire	[(AW-1):0]	lookup_addr, lookup_offset, pf_next;
+	// }}}
+
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Request decoding
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// Memory reads are ours.  Everything else gets passed through
+	assign	rd_request = (i_wb_stb)&&(!o_wb_stall)&&(!i_wb_we)&&(!cfg_mode);
+	assign	pt_request = (!o_wb_stall)&&((i_cfg_stb)
+				||((i_wb_stb)&&((i_wb_we)||(cfg_mode))));
+
+	assign	lookup      = (rd_request)||((rd_pending)&&(i_wb_cyc));
+	assign	lookup_addr = (rd_pending) ? rd_addr : i_wb_addr;
+	assign	lookup_offset = lookup_addr - pf_base;
+	assign	pf_next     = pf_base + { {(AW-LGPF-1){1'b0}}, pf_fill };
+
+	// head_hit: The word we want is at the head of our buffer, and it's
+	// been returned.  We can acknowledge it on the next clock.
+	assign	head_hit  = (pf_valid)&&(pf_avail != 0)&&(lookup_addr == pf_base);
+
+	// in_window: The word we want has either been returned or requested,
+	// although there may be some number of words before it that need to
+	// be dropped first.
+	assign	in_window = (pf_valid)
+			&&(lookup_offset < { {(AW-LGPF-1){1'b0}}, pf_fill });
+
+	// pf_busy: Are any reads outstanding?  If so, we'll need to abort
+	// them before we can do anything else.
+	assign	pf_busy   = (pf_fill != pf_avail);
+
+	assign	pf_ack    = (o_fl_cyc)&&(i_fl_ack)&&(!pt_req);
+	assign	pf_pop    = (lookup)&&(in_window)&&(pf_avail != 0);
+	assign	pf_restart= (lookup)&&(!in_window)&&(pf_abort == 0);
+	assign	pf_issue  = (pf_valid)&&(!cfg_mode)&&(!pt_req)&&(!pt_request)
+				&&(!pf_restart)&&(!pf_abort[1])
+				&&((!o_fl_stb)||(!i_fl_stall))
+				&&(pf_fill < PFSZ);
+
+	assign	pt_ack    = (pt_req)&&(!pt_wait)&&(o_fl_cyc)&&(i_fl_ack);
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// The prefetch buffer itself
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// pf_valid, pf_base, pf_fill, pf_avail, pf_rd, pf_wr, pf_abort
+	// {{{
+	initial	pf_valid = 1'b0;
+	initial	pf_abort = 2'b00;
+	initial	pf_fill  = 0;
+	initial	pf_avail = 0;
+	initial	pf_rd    = 0;
+	initial	pf_wr    = 0;
+	always @(posedge i_clk)
+	if (i_reset)
+	begin
+		// {{{
+		pf_valid <= 1'b0;
+		pf_abort <= 2'b00;
+		pf_fill  <= 0;
+		pf_avail <= 0;
+		pf_rd    <= 0;
+		pf_wr    <= 0;
+		// }}}
+	end else if ((pt_request)||(pf_restart))
+	begin
+		// {{{
+		// Flush everything, and (on a miss) start over
+		pf_valid <= !pt_request;
+		pf_base  <= lookup_addr;
+		pf_abort <= (pf_busy) ? 2'b11 : 2'b00;
+		pf_fill  <= 0;
+		pf_avail <= 0;
+		pf_rd    <= 0;
+		pf_wr    <= 0;
+
+		// If nothing is outstanding, issue the new request at once
+		if (!pt_request && !pf_busy)
+			pf_fill <= 1;
+		// }}}
+	end else begin
+		// {{{
+		pf_abort <= pf_abort >> 1;
+
+		pf_fill  <= pf_fill  + (pf_issue ? 1:0) - (pf_pop ? 1:0);
+		pf_avail <= pf_avail + (pf_ack   ? 1:0) - (pf_pop ? 1:0);
+
+		if (pf_pop)
+		begin
+			pf_base <= pf_base + 1'b1;
+			pf_rd   <= pf_rd   + 1'b1;
+		end
+
+		if (pf_ack)
+			pf_wr <= pf_wr + 1'b1;
+		// }}}
+	end
+	// }}}
+
+	// pf_mem
+	// {{{
+	always @(posedge i_clk)
+	if (pf_ack)
+		pf_mem[pf_wr] <= i_fl_data;
+	// }}}
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Pass through requests, and snooping on the configuration mode
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// pt_req, pt_wait, pt_cfg, pt_live
+	// {{{
+	// pt_req is true from when we accept a request to be passed through
+	// until the controller acknowledges it.  pt_wait is true while the
+	// downstream cycle line is held low, so as to abort any reads that
+	// were in flight, and until the request is then placed on the bus.
+	// pt_live is true as long as the master hasn't abandoned its request.
+	initial	pt_req  = 1'b0;
+	initial	pt_wait = 1'b0;
+	initial	pt_live = 1'b0;
+	always @(posedge i_clk)
+	if (i_reset)
+	begin
+		pt_req  <= 1'b0;
+		pt_wait <= 1'b0;
+		pt_live <= 1'b0;
+	end else if (pt_request)
+	begin
+		pt_req  <= 1'b1;
+		pt_wait <= pf_busy;
+		pt_live <= 1'b1;
+	end else begin
+		if (!pf_abort[1])
+			pt_wait <= 1'b0;
+		if (pt_ack)
+			pt_req <= 1'b0;
+		if (!i_wb_cyc || pt_ack)
+			pt_live <= 1'b0;
+	end
+
+	always @(posedge i_clk)
+	if (pt_request)
+		pt_cfg <= i_cfg_stb;
+	// }}}
+
+	// cfg_mode
+	// {{{
+	initial	cfg_mode = 1'b0;
+	always @(posedge i_clk)
+	if (i_reset)
+		cfg_mode <= 1'b0;
+	else if ((pt_request)&&(i_cfg_stb)&&(i_wb_we))
+		cfg_mode <= i_wb_data[CFG_MODE];
+	// }}}
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Downstream bus control
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// o_fl_cyc, o_fl_stb, o_fl_cfg_stb
+	// {{{
+	initial	o_fl_cyc     = 1'b0;
+	initial	o_fl_stb     = 1'b0;
+	initial	o_fl_cfg_stb = 1'b0;
+	always @(posedge i_clk)
+	if (i_reset)
+	begin
+		// {{{
+		o_fl_cyc     <= 1'b0;
+		o_fl_stb     <= 1'b0;
+		o_fl_cfg_stb <= 1'b0;
+		// }}}
+	end else if ((pt_request)||(pf_restart))
+	begin
+		// {{{
+		if (pf_busy)
+		begin
+			// Abort any outstanding reads
+			o_fl_cyc     <= 1'b0;
+			o_fl_stb     <= 1'b0;
+			o_fl_cfg_stb <= 1'b0;
+		end else begin
+			o_fl_cyc     <= 1'b1;
+			o_fl_stb     <= (!pt_request)||(!i_cfg_stb);
+			o_fl_cfg_stb <= (pt_request)&&(i_cfg_stb);
+		end
+		// }}}
+	end else if (pt_wait)
+	begin
+		// {{{
+		if (!pf_abort[1])
+		begin
+			o_fl_cyc     <= 1'b1;
+			o_fl_stb     <= !pt_cfg;
+			o_fl_cfg_stb <=  pt_cfg;
+		end
+		// }}}
+	end else if (pt_req)
+	begin
+		// {{{
+		if (!i_fl_stall)
+		begin
+			o_fl_stb     <= 1'b0;
+			o_fl_cfg_stb <= 1'b0;
+		end
+
+		if (pt_ack)
+			o_fl_cyc <= 1'b0;
+		// }}}
+	end else begin
+		// {{{
+		o_fl_cfg_stb <= 1'b0;
+		if (pf_issue)
+		begin
+			o_fl_cyc <= 1'b1;
+			o_fl_stb <= 1'b1;
+		end else begin
+			if (!i_fl_stall)
+				o_fl_stb <= 1'b0;
+			if (!o_fl_stb && !pf_busy)
+				o_fl_cyc <= 1'b0;
+		end
+		// }}}
+	end
+	// }}}
+
+	// o_fl_we, o_fl_addr, o_fl_data
+	// {{{
+	initial	o_fl_we = 1'b0;
+	always @(posedge i_clk)
+	if (pt_request)
+	begin
+		o_fl_we   <= i_wb_we;
+		o_fl_addr <= i_wb_addr;
+		o_fl_data <= i_wb_data;
+	end else if (!pt_req)
+	begin
+		o_fl_we <= 1'b0;
+		if (pf_restart)
+			o_fl_addr <= lookup_addr;
+		else if (pf_issue)
+			o_fl_addr <= pf_next;
+	end
+	// }}}
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Upstream bus returns
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// rd_pending, rd_addr
+	// {{{
+	initial	rd_pending = 1'b0;
+	always @(posedge i_clk)
+	if ((i_reset)||(!i_wb_cyc))
+		rd_pending <= 1'b0;
+	else if (rd_request)
+		rd_pending <= !head_hit;
+	else if (head_hit)
+		rd_pending <= 1'b0;
+
+	always @(posedge i_clk)
+	if (rd_request)
+		rd_addr <= i_wb_addr;
+	// }}}
+
+	assign	o_wb_stall = (rd_pending)||(pt_req);
+
+	// o_wb_ack
+	// {{{
+	initial	o_wb_ack = 1'b0;
+	always @(posedge i_clk)
+	if ((i_reset)||(!i_wb_cyc))
+		o_wb_ack <= 1'b0;
+	else
+		o_wb_ack <= ((lookup)&&(head_hit))||((pt_ack)&&(pt_live));
+	// }}}
+
+	// o_wb_data
+	// {{{
+	always @(posedge i_clk)
+	if (pt_ack)
+		o_wb_data <= i_fl_data;
+	else
+		o_wb_data <= pf_mem[pf_rd];
+	// }}}
+	// }}}
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//
+// Formal properties
+// {{{
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+`ifdef	FORMAL
+	localparam	F_LGDEPTH = 4;
+	reg	f_past_valid;
+	wire	[F_LGDEPTH-1:0]	f_nreqs, f_nacks, f_outstanding;
+	reg	[F_LGDEPTH-1:0]	f_dnreqs;
+
+	initial	f_past_valid = 1'b0;
+	always @(posedge i_clk)
+		f_past_valid <= 1'b1;
+
+	always @(*)
+	if (!f_past_valid)
+		assume(i_reset);
+
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Upstream bus properties
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	always @(*)
+		assume(!i_wb_stb || !i_cfg_stb);
+
+	fwb_slave #(.AW(AW), .DW(DW),.F_LGDEPTH(F_LGDEPTH),
+			.F_MAX_STALL(0), .F_MAX_ACK_DELAY(0),
+			.F_OPT_RMW_BUS_OPTION(0),
+			.F_OPT_CLK2FFLOGIC(1'b0),
+			.F_OPT_DISCONTINUOUS(1))
+		f_wbm(i_clk, i_reset,
+			i_wb_cyc, (i_wb_stb)||(i_cfg_stb), i_wb_we, i_wb_addr,
+				i_wb_data, 4'hf,
+			o_wb_ack, o_wb_stall, o_wb_data, 1'b0,
+			f_nreqs, f_nacks, f_outstanding);
+
+	always @(*)
+	if (i_wb_cyc)
+		assert(f_outstanding == ((rd_pending || (pt_req && pt_live))
+				? 1:0) + (o_wb_ack ? 1:0));
+
+	always @(*)
+		assert(!rd_pending || !pt_req);
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Downstream bus properties
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// Count the requests the controller has accepted, but not yet
+	// acknowledged, since the cycle line was last raised.
+	initial	f_dnreqs = 0;
+	always @(posedge i_clk)
+	if ((i_reset)||(!o_fl_cyc))
+		f_dnreqs <= 0;
+	else case({ (o_fl_stb || o_fl_cfg_stb) && !i_fl_stall, i_fl_ack })
+	2'b10: f_dnreqs <= f_dnreqs + 1;
+	2'b01: f_dnreqs <= f_dnreqs - 1;
+	default: begin end
+	endcase
+
+	always @(*)
+	if (o_fl_cyc && f_dnreqs == 0)
+		assume(!i_fl_ack);
+
+	always @(*)
+	if (!o_fl_cyc)
+		assert(!o_fl_stb && !o_fl_cfg_stb);
+
+	always @(*)
+		assert(!o_fl_stb || !o_fl_cfg_stb);
+
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset))
+			&&($past(o_fl_stb || o_fl_cfg_stb))&&($past(i_fl_stall))
+			&&(o_fl_cyc))
+	begin
+		assert(o_fl_stb     == $past(o_fl_stb));
+		assert(o_fl_cfg_stb == $past(o_fl_cfg_stb));
+		assert(o_fl_addr    == $past(o_fl_addr));
+		assert(o_fl_we      == $past(o_fl_we));
+	end
+
+	always @(*)
+	if (o_fl_cyc && !pt_req)
+		assert(f_dnreqs + (o_fl_stb ? 1:0) == pf_fill - pf_avail);
+
+	always @(*)
+	if (o_fl_cyc && pt_req)
+		assert(f_dnreqs + ((o_fl_stb || o_fl_cfg_stb) ? 1:0) <= 1);
+
+	always @(*)
+	if (pt_wait)
+		assert(pt_req && !o_fl_cyc);
+
+	always @(*)
+	if (pf_abort != 0)
+		assert(!o_fl_cyc && pf_fill == 0);
+
+	always @(*)
+	if (pf_abort == 2'b10)
+		assert(0);
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Buffer properties
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	always @(*)
+	begin
+		assert(pf_avail <= pf_fill);
+		assert(pf_fill  <= PFSZ);
+		assert(pf_wr - pf_rd == pf_avail[LGPF-1:0]);
+		if (!pf_valid)
+			assert(pf_fill == 0);
+		if (pt_req)
+			assert(pf_fill == 0);
+	end
+
+	// Any data we return from the buffer must be the data returned for
+	// that address.  Pick an arbitrary address, and track it through.
+	(* anyconst *)	reg	[AW-1:0]	f_addr;
+	(* anyconst *)	reg	[DW-1:0]	f_data;
+
+	wire	[AW-1:0]	f_offset;
+	assign	f_offset = f_addr - pf_base;
+
+	always @(*)
+	if ((pf_valid)&&(f_offset < { {(AW-LGPF-1){1'b0}}, pf_avail }))
+		assert(pf_mem[pf_rd + f_offset[LGPF-1:0]] == f_data);
+
+	always @(*)
+	if (o_fl_cyc && i_fl_ack && !pt_req
+			&& pf_base + { {(AW-LGPF-1){1'b0}}, pf_avail } == f_addr)
+		assume(i_fl_data == f_data);
+
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset))&&(o_wb_ack)&&(!$past(pt_ack))
+			&&($past(lookup_addr) == f_addr))
+		assert(o_wb_data == f_data);
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Cover properties
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset)))
+	begin
+		cover(o_wb_ack && $past(o_wb_ack) && $past(o_wb_ack,2));
+		cover(o_wb_ack && $past(pf_abort != 0,2));
+		cover(pf_fill == PFSZ && pf_avail == PFSZ);
+	end
+	// }}}
+`endif
+// }}}
+endmodule
@@ -0,0 +1,1047 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	flashpgm.v
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	A hardware page program and erase engine, designed to sit
+//		between the bus and either the qflexpress or dualflexpress
+//	controllers.
+//
+//	Programming a page through the configuration port costs one bus
+//	write per byte, plus the write enable, page program and address
+//	framing around them, followed by the host polling the status register
+//	until the write in progress bit clears--some 270 bus transactions per
+//	page.  With this engine, the host instead writes the page's (up to)
+//	64 words into a page buffer, using ordinary memory writes to the
+//	addresses they are to be programmed to, and then writes a single
+//	start command.  The engine then takes the controller offline, issues
+//	the write enable, the page program (0x02, or the quad page program,
+//	0x32, if OPT_QPP is set), the address and the data, polls the status
+//	register until the write completes, and then places the controller
+//	back online, all through the controller's configuration port.
+//
+//	Erases work the same way.  Writing a sector address and erase size
+//	to the ERASE register issues the write enable and the erase, and then
+//	polls the status register, once every POLLINT clocks, until the erase
+//	is complete.  The bus is then free for other masters throughout the
+//	erase, rather than being tied up polling the flash.
+//
+//	With OPT_SUSPEND set, memory reads needn't wait for the page program
+//	or erase to complete either.  A read arriving while the engine waits
+//	between status register polls suspends the program or erase (0x75),
+//	waits SUSPLAT clocks for the flash to suspend, places the controller
+//	back online and passes the read through to it.  The engine then takes
+//	the controller back offline, resumes the program or erase (0x7A), and
+//	returns to polling.  A read therefore waits at most one status
+//	register read, the suspend latency, and the command sequences around
+//	the read itself.  As the next suspend can only follow the next status
+//	register poll, the flash is given at least POLLINT clocks between a
+//	resume and the next suspend.  POLLINT should therefore be no shorter
+//	than the flash's minimum resume to suspend time.  The flash must
+//	support both commands.
+//
+//	Only the engine's own programs and erases are suspended.  Those sent
+//	through the configuration port, around the engine, are unknown to it:
+//	it neither polls on them nor suspends them, and memory reads then
+//	must wait for software to finish with the flash, as without the
+//	engine.  Software wishing to keep executing from the flash should
+//	therefore erase and program through ERASE and PGMCTL alone, as the
+//	driver does when built with R_FLASHPGM.
+//
+//	- Memory port writes are captured by the page buffer, at the word
+//	  given by i_wb_addr[5:0].  The page to be programmed is taken from
+//	  the address of the last such write.  Words not written since the
+//	  buffer was last emptied are sent as 32'hffff_ffff, and so leave the
+//	  flash unchanged.  The buffer is emptied once the page has been
+//	  programmed.
+//	- Configuration port requests with i_wb_addr[4:3] == 2'b10 are
+//	  answered by the engine, rather than being passed to the controller.
+//	  (The README lists the configuration port address map shared by the
+//	  controllers and all of the front ends.)
+//
+//	5'h10	PGMCTL
+//		Read:	{ busy, done, 1'b0, chip, 2'h0,
+//				24'h(page address, in bytes) }
+//			The chip and page address are those of the last
+//			page buffer write.
+//		Write:	Bit 0 starts programming the buffered page.  Bit 1
+//			empties the buffer instead.  Any write clears the
+//			done bit, and with it the interrupt.
+//	5'h11	ERASE
+//		Read:	{ busy, done, 1'b0, chip, size, 24'h(erase address) }
+//		Write:	{ 3'h0, chip, size, 24'h(erase address) } starts an
+//			erase of the given size, containing the given address,
+//			within the given chip.
+//			The size is one of
+//			2'b00	 4kB subsector erase, 0x20
+//			2'b01	32kB block erase, 0x52
+//			2'b10	64kB sector erase, 0xd8
+//			2'b11	Bulk (whole chip) erase, 0xc7.  The address
+//				is then ignored.
+//			Any write also clears the done bit.
+//	5'h12	POLLINT
+//		The number of clocks to wait between status register reads,
+//		while waiting on a page program or erase.  Initially
+//		DEF_POLLINT.
+//	5'h13	SUSPLAT
+//		The number of clocks to wait following a suspend command,
+//		before reading from the flash.  Initially DEF_SUSPLAT.  Reads
+//		as zero, and may not be written, unless OPT_SUSPEND is set.
+//	5'h14-17 (Reserved, read as zero)
+//
+//	- All other requests are passed straight through to the controller.
+//	- While the engine is busy, the bus is stalled for everything other
+//	  than the engine's own registers, and any memory reads from other
+//	  devices (NCS).  o_int is raised once the page has been programmed,
+//	  or the erase completed, and remains high until either PGMCTL or
+//	  ERASE is next written.
+//
+//	The words in the buffer are sent to the flash in the same byte order
+//	the controller reads them back in.  OPT_ENDIANSWAP must therefore
+//	match the controller's, so that any word written will read back the
+//	same.
+//
+//	A qflexpress controller may drive several flash devices (NCS), which
+//	then follow one another in the bus address space.  NCS must then
+//	match the controller's.  A page is programmed into the device its
+//	buffer writes were addressed to, and an erase applies to the device
+//	given by ERASE's chip field.  That device is placed in bits [15:13]
+//	of every configuration word the engine issues, so that only it is
+//	programmed or erased, and only it is taken out of, and returned to,
+//	its execute in place mode.  Page and erase addresses are always
+//	within the device.  Between status register polls, the engine
+//	leaves the controller's configuration mode, and passes any memory
+//	reads from the other devices straight through to the controller.
+//	The CPU may then keep reading from, and executing out of, the other
+//	devices at nearly their full speed.
+//
+//	The controller must have its configuration port (OPT_CFG) enabled.
+//	When done, the engine returns the controller to its execute in place
+//	mode using the quad I/O read command, 0xeb, or the dual I/O read
+//	command, 0xbb, if OPT_DUAL is set for the dualflexpress controller.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2018-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+`default_nettype	none
+// }}}
+module	flashpgm #(
+		// {{{
+		// AW
+		// {{{
+		// AW is the number of word address bits.  This needs to match
+		// the controller behind us, where it is given by LGFLASHSZ-2,
+		// plus $clog2(NCS) for several devices.  Only three address
+		// bytes are ever sent, so each device may hold no more than
+		// 16MB.
+		parameter	AW = 22,
+		// }}}
+		// NCS
+		// {{{
+		// The number of flash devices attached to the controller: 1,
+		// 2, 4, or 8.  This needs to match the controller behind us.
+		// Bus addresses select a device by their top $clog2(NCS) bits.
+		parameter	NCS = 1,
+		localparam	LGNCS = (NCS > 1) ? $clog2(NCS) : 0,
+		localparam	CSW = (NCS > 1) ? LGNCS : 1,
+		// }}}
+		// OPT_QPP
+		// {{{
+		// If set, the page will be sent using the quad page program
+		// command, 0x32, four bits at a time.  This requires the
+		// qflexpress controller.  Otherwise the normal page program
+		// command, 0x02, is used, which any controller may send.
+		parameter [0:0]	OPT_QPP = 1'b0,
+		// }}}
+		// OPT_DUAL
+		// {{{
+		// Set this when placed in front of the dualflexpress
+		// controller, so that the controller is placed back online
+		// with the dual I/O read command.  OPT_QPP must then be clear.
+		parameter [0:0]	OPT_DUAL = 1'b0,
+		// }}}
+		// DEF_POLLINT
+		// {{{
+		// The initial value of the POLLINT register: the number of
+		// clocks between status register reads
+		parameter [23:0] DEF_POLLINT = 24'd256,
+		// }}}
+		// OPT_SUSPEND
+		// {{{
+		// If set, memory reads arriving during a page program or erase
+		// will suspend it, be served, and then resume it
+		parameter [0:0]	OPT_SUSPEND = 1'b0,
+		// }}}
+		// DEF_SUSPLAT
+		// {{{
+		// The initial value of the SUSPLAT register: the number of
+		// clocks from a suspend command until the flash may be read
+		parameter [23:0] DEF_SUSPLAT = 24'd2048,
+		// }}}
+		// OPT_ENDIANSWAP
+		// {{{
+		// This needs to match the controller behind us.  If set, the
+		// first byte of each word sent to the flash is taken from bits
+		// [7:0], otherwise from bits [31:24].
+		parameter [0:0]	OPT_ENDIANSWAP = 1'b1,
+		// }}}
+		localparam	DW = 32,
+		localparam	LGPGW = 6,
+		localparam [1:0]	PGM_ADDR = 2'b10
+		// }}}
+	) (
+		// {{{
+		input	wire			i_clk, i_reset,
+		// Incoming bus requests
+		// {{{
+		input	wire			i_wb_cyc, i_wb_stb,
+						i_cfg_stb, i_wb_we,
+		input	wire	[(AW-1):0]	i_wb_addr,
+		input	wire	[(DW-1):0]	i_wb_data,
+		//
+		output	wire			o_wb_stall,
+		output	wire			o_wb_ack,
+		output	wire	[(DW-1):0]	o_wb_data,
+		// }}}
+		// Outgoing requests, to the flash controller
+		// {{{
+		output	reg			o_fl_cyc, o_fl_stb,
+						o_fl_cfg_stb, o_fl_we,
+		output	reg	[(AW-1):0]	o_fl_addr,
+		output	reg	[(DW-1):0]	o_fl_data,
+		//
+		input	wire			i_fl_stall,
+		input	wire			i_fl_ack,
+		input	wire	[(DW-1):0]	i_fl_data,
+		// }}}
+		output	wire			o_int
+		// }}}
+	);
+
+	// Local declarations
+	// {{{
+	// Configuration port commands, as written to the controllers'
+	// configuration register
+	localparam [15:0]	F_USER  = 16'h1000,
+				F_QUAD  = 16'h1a00,	// QSPEED | WEDIR
+				F_DUAL  = 16'h1600,	// DSPEED | WEDIR
+				F_END   = 16'h1100,	// USER_CS_n
+				F_RESET = 16'h10ff,
+				F_PP    = 16'h1002,
+				F_QPP   = 16'h1032,
+				F_RDSR  = 16'h1005,
+				F_WREN  = 16'h1006,
+				F_SSE   = 16'h1020,
+				F_BLKE  = 16'h1052,
+				F_SE    = 16'h10d8,
+				F_BE    = 16'h10c7,
+				F_QIOR  = 16'h10eb,
+				F_DIOR  = 16'h10bb,
+				F_SUSP  = 16'h1075,
+				F_RESUME= 16'h107a;
+
+	// Engine states.  Each issues a fixed sequence of configuration
+	// port requests, counted by eng_count.
+	// The last three are only used by OPT_SUSPEND, to serve a read.
+	localparam [3:0]	ST_OFFLINE = 4'h0,	// Leave XIP mode
+				ST_WREN    = 4'h1,	// Write enable
+				ST_CMD     = 4'h2,	// Program/erase + address
+				ST_DATA    = 4'h3,	// 256 data bytes
+				ST_POLL    = 4'h4,	// Wait on WIP
+				ST_ONLINE  = 4'h5,	// Return to XIP mode
+				ST_SUSPEND = 4'h6,	// Suspend pgm/erase
+				ST_READ    = 4'h7,	// Pass one read through
+				ST_RESUME  = 4'h8;	// Resume pgm/erase
+
+	reg			eng_busy, eng_stb, eng_ackwait, eng_erase,
+				pgm_done;
+	reg	[1:0]		eng_wait;
+	reg	[23:0]		poll_int, poll_ctr, susp_lat;
+	reg			eng_susp, susp_rd, eng_wip;
+	wire			susp_start, susp_accept, susp_ack,
+				poll_wait, pt_pass;
+	reg	[23:0]		er_addr;
+	reg	[1:0]		er_size;
+	reg	[CSW-1:0]	er_chip;
+	wire	[CSW-1:0]	eng_chip, pg_chip, rd_chip;
+	wire	[23:0]		eng_addr;
+	wire	[15:0]		online_speed;
+	reg	[3:0]		eng_state;
+	reg	[7:0]		eng_count, eng_last;
+	reg	[15:0]		eng_word;
+	reg			eng_we;
+
+	reg	[DW-1:0]	pg_mem	[0:(1<<LGPGW)-1];
+	reg	[(1<<LGPGW)-1:0]	pg_valid;
+	reg	[AW-LGPGW-1:0]	pg_addr;
+	reg	[DW-1:0]	pg_rdata;
+	reg			pg_rvalid;
+	reg	[7:0]		pg_byte;
+	wire	[31:0]		pg_wide;
+	wire	[23:0]		pg_baddr;
+
+	wire	[3:0]		pt_pending;
+	wire			l_ack;
+	reg	[DW-1:0]	l_data;
+
+	wire			pgm_sel, local_request, buf_write, ctl_write,
+				erase_write, poll_write, susp_write,
+				pgm_start, erase_start,
+				eng_start, eng_ack, eng_done;
+	// }}}
+
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Request decoding
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// Memory writes, and the engine's registers, are ours.  Everything
+	// else gets passed through.
+	assign	pgm_sel       = (i_wb_addr[4:3] == PGM_ADDR);
+	assign	local_request = ((i_wb_stb)&&(i_wb_we))
+				||((i_cfg_stb)&&(pgm_sel));
+
+	assign	buf_write = (i_wb_stb)&&(i_wb_we)&&(!o_wb_stall);
+	assign	ctl_write = (i_cfg_stb)&&(pgm_sel)&&(i_wb_we)&&(!o_wb_stall)
+				&&(i_wb_addr[2:0] == 3'h0);
+	assign	erase_write = (i_cfg_stb)&&(pgm_sel)&&(i_wb_we)&&(!o_wb_stall)
+				&&(i_wb_addr[2:0] == 3'h1);
+	assign	poll_write  = (i_cfg_stb)&&(pgm_sel)&&(i_wb_we)&&(!o_wb_stall)
+				&&(i_wb_addr[2:0] == 3'h2);
+	assign	susp_write  = (OPT_SUSPEND)&&(i_cfg_stb)&&(pgm_sel)&&(i_wb_we)
+				&&(!o_wb_stall)&&(i_wb_addr[2:0] == 3'h3);
+	assign	pgm_start   = (ctl_write)&&(!eng_busy)&&(i_wb_data[0]);
+	assign	erase_start = (erase_write)&&(!eng_busy);
+	assign	eng_start   = (pgm_start)||(erase_start);
+
+	// poll_wait, pt_pass
+	// {{{
+	// While the engine waits to poll the status register again, the
+	// controller is out of its configuration mode.  Memory reads from the
+	// other devices may then be passed straight through to it.  The
+	// engine waits for their acknowledgments before going on.
+	assign	poll_wait = (eng_busy)&&(eng_state == ST_POLL)
+				&&(eng_count == 1)&&(poll_ctr != 0);
+	assign	pt_pass   = (NCS > 1)&&(poll_wait)
+				&&(i_wb_stb)&&(!i_wb_we)&&(rd_chip != eng_chip);
+	// }}}
+
+	// susp_start, susp_accept, susp_ack
+	// {{{
+	// A memory read from the device being programmed or erased, arriving
+	// while the engine waits to poll the status register again, starts a
+	// suspend.  Once the controller is back online, the read is passed
+	// through to it, and its acknowledgment returned.
+	assign	susp_start  = (OPT_SUSPEND)&&(poll_wait)
+				&&(i_wb_cyc)&&(i_wb_stb)&&(!i_wb_we)
+				&&(rd_chip == eng_chip)&&(pt_pending == 0);
+	assign	susp_accept = (OPT_SUSPEND)&&(eng_busy)&&(eng_state == ST_READ)
+				&&(eng_stb)&&(!i_fl_stall)
+				&&(i_wb_stb)&&(!i_wb_we);
+	assign	susp_ack    = (eng_ack)&&(eng_state == ST_READ)&&(susp_rd);
+
+	// susp_rd
+	// {{{
+	// Set while the read being served is outstanding
+	initial	susp_rd = 1'b0;
+	always @(posedge i_clk)
+	if ((i_reset)||(!i_wb_cyc)||(!OPT_SUSPEND))
+		susp_rd <= 1'b0;
+	else if (susp_accept)
+		susp_rd <= 1'b1;
+	else if (eng_ack)
+		susp_rd <= 1'b0;
+	// }}}
+	// }}}
+
+	// passthru
+	// {{{
+	// Passes all other requests through to the controller, stalling local
+	// requests until those have been acknowledged.  While the engine is
+	// busy, only the engine's registers are answered, along with any read
+	// served by suspending the engine, or passed through to another
+	// device.  Writes to the page buffer wait.
+	flashpassthru #(
+		// {{{
+		.DW(DW)
+		// }}}
+	) passthru(
+		// {{{
+		.i_clk(i_clk), .i_reset(i_reset),
+		.i_wb_cyc(i_wb_cyc), .i_wb_stb((i_wb_stb)||(i_cfg_stb)),
+		.i_local(local_request),
+			.i_local_stall((eng_busy)&&((!i_cfg_stb)||(susp_rd))),
+			.i_local_data(l_data),
+		.i_busy((eng_busy)&&(!pt_pass)), .i_busy_accept(susp_accept),
+			.i_busy_ack(susp_ack),
+		.i_fl_stall(i_fl_stall), .i_fl_ack(i_fl_ack),
+			.i_fl_data(i_fl_data),
+		.o_wb_stall(o_wb_stall), .o_wb_ack(o_wb_ack),
+			.o_wb_data(o_wb_data),
+		.o_pending(pt_pending), .o_local_ack(l_ack)
+		// }}}
+	);
+	// }}}
+
+	assign	eng_ack   = (eng_busy)&&(eng_ackwait)&&(i_fl_ack);
+	assign	eng_done  = (eng_ack)&&(eng_state == ST_ONLINE)
+				&&(eng_count == eng_last)&&(!eng_susp);
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// The page buffer
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	always @(posedge i_clk)
+	if (buf_write)
+		pg_mem[i_wb_addr[LGPGW-1:0]] <= i_wb_data;
+
+	// pg_addr
+	// {{{
+	always @(posedge i_clk)
+	if (buf_write)
+		pg_addr <= i_wb_addr[AW-1:LGPGW];
+
+	// The page's byte address within its device
+	assign	pg_wide  = { {(32-AW+LGNCS-2){1'b0}}, pg_addr[AW-LGNCS-LGPGW-1:0],
+				{(LGPGW+2){1'b0}} };
+	assign	pg_baddr = pg_wide[23:0];
+	// }}}
+
+	// pg_chip, rd_chip
+	// {{{
+	// The devices of the buffered page, and of any memory read
+	generate if (NCS > 1)
+	begin : GEN_CHIPSEL
+		assign	pg_chip = pg_addr[AW-LGPGW-1 -: LGNCS];
+		assign	rd_chip = i_wb_addr[AW-1 -: LGNCS];
+	end else begin : NO_CHIPSEL
+		assign	pg_chip = 1'b0;
+		assign	rd_chip = 1'b0;
+	end endgenerate
+	// }}}
+
+	// pg_valid
+	// {{{
+	initial	pg_valid = 0;
+	always @(posedge i_clk)
+	if (i_reset)
+		pg_valid <= 0;
+	else if ((ctl_write)&&(!eng_busy)&&(i_wb_data[1]))
+		pg_valid <= 0;
+	else if ((eng_done)&&(!eng_erase))
+		pg_valid <= 0;
+	else if (buf_write)
+		pg_valid[i_wb_addr[LGPGW-1:0]] <= 1'b1;
+	// }}}
+
+	// pg_rdata, pg_rvalid, pg_byte
+	// {{{
+	// The word holding the byte the engine is about to send.  eng_count
+	// settles a full two clocks before that byte is needed.
+	always @(posedge i_clk)
+	begin
+		pg_rdata  <= pg_mem[eng_count[7:2]];
+		pg_rvalid <= pg_valid[eng_count[7:2]];
+	end
+
+	always @(*)
+	if (!pg_rvalid)
+		pg_byte = 8'hff;
+	else if (OPT_ENDIANSWAP)
+		pg_byte = pg_rdata[ 8*eng_count[1:0] +: 8];
+	else
+		pg_byte = pg_rdata[24-8*eng_count[1:0] +: 8];
+	// }}}
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// The programming engine
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// er_addr, er_size, eng_erase
+	// {{{
+	always @(posedge i_clk)
+	if (erase_start)
+	begin
+		er_addr <= i_wb_data[23:0];
+		er_size <= i_wb_data[25:24];
+	end
+
+	initial	er_chip = 0;
+	always @(posedge i_clk)
+	if (i_reset)
+		er_chip <= 0;
+	else if ((erase_start)&&(NCS > 1))
+		er_chip <= i_wb_data[26 +: CSW];
+
+	always @(posedge i_clk)
+	if (eng_start)
+		eng_erase <= erase_start;
+
+	assign	eng_addr = (eng_erase) ? er_addr : pg_baddr;
+	// }}}
+
+	// eng_chip
+	// {{{
+	// The device being programmed or erased
+	assign	eng_chip = (eng_erase) ? er_chip : pg_chip;
+	// }}}
+
+	// poll_int
+	// {{{
+	initial	poll_int = DEF_POLLINT;
+	always @(posedge i_clk)
+	if (i_reset)
+		poll_int <= DEF_POLLINT;
+	else if (poll_write)
+		poll_int <= i_wb_data[23:0];
+	// }}}
+
+	// susp_lat
+	// {{{
+	initial	susp_lat = DEF_SUSPLAT;
+	always @(posedge i_clk)
+	if ((i_reset)||(!OPT_SUSPEND))
+		susp_lat <= (OPT_SUSPEND) ? DEF_SUSPLAT : 24'h0;
+	else if (susp_write)
+		susp_lat <= i_wb_data[23:0];
+	// }}}
+
+	assign	online_speed = (OPT_DUAL) ? F_DUAL : F_QUAD;
+
+	// eng_word, eng_we, eng_last
+	// {{{
+	// The configuration port request for each step of each state, and
+	// the count of the last step within the state
+	always @(*)
+	begin
+		eng_word = F_END;
+		eng_we   = 1'b1;
+		eng_last = 0;
+		case(eng_state)
+		ST_OFFLINE: begin
+			// {{{
+			eng_last = 3;
+			if ((eng_count == 1)||(eng_count == 2))
+				eng_word = F_RESET;
+			end
+			// }}}
+		ST_WREN: begin
+			// {{{
+			eng_last = 1;
+			if (eng_count == 0)
+				eng_word = F_WREN;
+			end
+			// }}}
+		ST_CMD: begin
+			// {{{
+			// A bulk erase takes no address
+			eng_last = ((eng_erase)&&(er_size == 2'b11)) ? 0 : 3;
+			case(eng_count[1:0])
+			2'b00: if (!eng_erase)
+					eng_word = (OPT_QPP) ? F_QPP : F_PP;
+				else case(er_size)
+				2'b00: eng_word = F_SSE;
+				2'b01: eng_word = F_BLKE;
+				2'b10: eng_word = F_SE;
+				2'b11: eng_word = F_BE;
+				endcase
+			2'b01: eng_word = F_USER | { 8'h0, eng_addr[23:16] };
+			2'b10: eng_word = F_USER | { 8'h0, eng_addr[15: 8] };
+			2'b11: eng_word = F_USER | { 8'h0, eng_addr[ 7: 0] };
+			endcase end
+			// }}}
+		ST_DATA: begin
+			// {{{
+			eng_last = 8'hff;
+			eng_word = ((OPT_QPP) ? F_QUAD : F_USER) | { 8'h0, pg_byte };
+			end
+			// }}}
+		ST_POLL: begin
+			// {{{
+			// END the page program or erase command, then read
+			// the status register until the write in progress bit
+			// clears.  Each read is ENDed, and configuration mode
+			// left, before waiting to read it again.
+			eng_last = 5;
+			case(eng_count[2:0])
+			3'h0: eng_word = F_END;
+			3'h1: eng_word = F_RDSR;
+			3'h2: eng_word = F_USER;
+			3'h3: begin eng_word = F_USER; eng_we = 1'b0; end
+			3'h4: eng_word = F_END;
+			default: eng_word = 16'h0;
+			endcase end
+			// }}}
+		ST_ONLINE: begin
+			// {{{
+			eng_last = 6;
+			case(eng_count[2:0])
+			3'h0: eng_word = (OPT_DUAL) ? F_DIOR : F_QIOR;
+			3'h4: eng_word = online_speed | 16'h0a0; // Mode byte
+			3'h5: eng_word = online_speed & ~16'h200;// Dummy byte
+			3'h6: eng_word = 16'h0;
+			default: eng_word = online_speed;	// Address
+			endcase end
+			// }}}
+		ST_SUSPEND: begin
+			// {{{
+			eng_last = 1;
+			if (eng_count == 0)
+				eng_word = F_SUSP;
+			end
+			// }}}
+		ST_READ: begin
+			// {{{
+			// One memory read, rather than a configuration request
+			eng_last = 0;
+			eng_we   = 1'b0;
+			end
+			// }}}
+		ST_RESUME: begin
+			// {{{
+			eng_last = 1;
+			if (eng_count == 0)
+				eng_word = F_RESUME;
+			end
+			// }}}
+		default: begin end
+		endcase
+
+		// Every request goes to the device being programmed or erased
+		eng_word[13 +: CSW] = eng_chip;
+	end
+	// }}}
+
+	// eng_busy, eng_state, eng_count, eng_wait, eng_stb, eng_ackwait
+	// {{{
+	// Each request is placed on the bus once eng_wait has counted down,
+	// and then held until the controller accepts it.  The engine then
+	// waits for its acknowledgment before moving on to the next.  While
+	// the flash is busy, poll_ctr adds POLLINT clocks before each new
+	// status register read.  It also adds SUSPLAT clocks following a
+	// suspend, before the controller is placed back online.
+	initial	poll_ctr    = 0;
+	initial	eng_busy    = 1'b0;
+	initial	eng_susp    = 1'b0;
+	initial	eng_stb     = 1'b0;
+	initial	eng_ackwait = 1'b0;
+	initial	eng_wait    = 2'b00;
+	always @(posedge i_clk)
+	if (i_reset)
+	begin
+		// {{{
+		eng_busy    <= 1'b0;
+		eng_stb     <= 1'b0;
+		eng_ackwait <= 1'b0;
+		eng_wait    <= 2'b00;
+		eng_state   <= ST_OFFLINE;
+		eng_count   <= 0;
+		poll_ctr    <= 0;
+		eng_susp    <= 1'b0;
+		// }}}
+	end else if (!eng_busy)
+	begin
+		// {{{
+		eng_stb     <= 1'b0;
+		eng_ackwait <= 1'b0;
+		eng_state   <= ST_OFFLINE;
+		eng_count   <= 0;
+		poll_ctr    <= 0;
+		eng_susp    <= 1'b0;
+		if (eng_start)
+		begin
+			eng_busy <= 1'b1;
+			// Give any acknowledgment, from a request abandoned
+			// by the master, time to clear first
+			eng_wait <= 2'b11;
+		end
+		// }}}
+	end else if (susp_start)
+	begin
+		// {{{
+		// Abandon the wait, and suspend the program or erase
+		poll_ctr  <= 0;
+		eng_wait  <= 2'b10;
+		eng_state <= ST_SUSPEND;
+		eng_count <= 0;
+		eng_susp  <= 1'b1;
+		// }}}
+	end else if (poll_ctr != 0)
+		poll_ctr <= poll_ctr - 1;
+	else if (pt_pending != 0)
+	begin
+		// Wait on any reads passed through to the other devices
+	end else if (eng_wait != 0)
+	begin
+		eng_wait <= eng_wait - 1;
+		eng_stb  <= (eng_wait == 2'b01);
+	end else if (eng_stb)
+	begin
+		if (!i_fl_stall)
+		begin
+			eng_stb     <= 1'b0;
+			eng_ackwait <= 1'b1;
+		end
+	end else if (eng_ack)
+	begin
+		// {{{
+		eng_ackwait <= 1'b0;
+		eng_wait    <= 2'b10;
+		eng_count   <= eng_count + 1;
+
+		if ((eng_state == ST_POLL)&&(eng_count == eng_last)&&(eng_wip))
+		begin
+			// Still busy, so read the status register again
+			eng_count <= 1;
+			poll_ctr  <= poll_int;
+		end else if ((eng_count == eng_last)&&(eng_susp))
+		begin
+			// {{{
+			// Serve a read while the program or erase is
+			// suspended, then go back to waiting on it
+			eng_count <= 0;
+			case(eng_state)
+			ST_SUSPEND: begin
+				eng_state <= ST_ONLINE;
+				poll_ctr  <= susp_lat;
+				end
+			ST_ONLINE:  eng_state <= ST_READ;
+			ST_READ:    eng_state <= ST_OFFLINE;
+			ST_OFFLINE: eng_state <= ST_RESUME;
+			default: begin
+				// ST_RESUME
+				eng_state <= ST_POLL;
+				eng_susp  <= 1'b0;
+				end
+			endcase
+			// }}}
+		end else if (eng_count == eng_last)
+		begin
+			eng_count <= 0;
+			eng_state <= eng_state + 1;
+			if ((eng_state == ST_CMD)&&(eng_erase))
+				// No data to send
+				eng_state <= ST_POLL;
+			if (eng_state == ST_ONLINE)
+			begin
+				eng_busy  <= 1'b0;
+				eng_wait  <= 2'b00;
+				eng_state <= ST_OFFLINE;
+			end
+		end
+		// }}}
+	end
+	// }}}
+
+	// eng_wip
+	// {{{
+	// The write in progress bit, from the last status register read
+	always @(posedge i_clk)
+	if ((eng_ack)&&(eng_state == ST_POLL)&&(eng_count == 3))
+		eng_wip <= i_fl_data[0];
+	// }}}
+
+	// pgm_done
+	// {{{
+	initial	pgm_done = 1'b0;
+	always @(posedge i_clk)
+	if (i_reset)
+		pgm_done <= 1'b0;
+	else if (eng_done)
+		pgm_done <= 1'b1;
+	else if ((ctl_write)||(erase_write))
+		pgm_done <= 1'b0;
+
+	assign	o_int = pgm_done;
+	// }}}
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Downstream bus control
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	always @(*)
+	if ((OPT_SUSPEND)&&(eng_busy)&&(eng_state == ST_READ))
+	begin
+		o_fl_cyc     = 1'b1;
+		o_fl_stb     = eng_stb;
+		o_fl_cfg_stb = 1'b0;
+		o_fl_we      = 1'b0;
+		o_fl_addr    = i_wb_addr;
+		o_fl_data    = 0;
+	end else if ((eng_busy)&&((pt_pass)||(pt_pending != 0)))
+	begin
+		// Reads from the other devices, between status polls
+		o_fl_cyc     = i_wb_cyc;
+		o_fl_stb     = pt_pass;
+		o_fl_cfg_stb = 1'b0;
+		o_fl_we      = 1'b0;
+		o_fl_addr    = i_wb_addr;
+		o_fl_data    = 0;
+	end else if (eng_busy)
+	begin
+		o_fl_cyc     = 1'b1;
+		o_fl_stb     = 1'b0;
+		o_fl_cfg_stb = eng_stb;
+		o_fl_we      = eng_we;
+		o_fl_addr    = 0;
+		o_fl_data    = { {(DW-16){1'b0}}, eng_word };
+	end else begin
+		o_fl_cyc     = i_wb_cyc;
+		o_fl_stb     = (i_wb_stb)&&(!i_wb_we);
+		o_fl_cfg_stb = (i_cfg_stb)&&(!pgm_sel);
+		o_fl_we      = i_wb_we;
+		o_fl_addr    = i_wb_addr;
+		o_fl_data    = i_wb_data;
+	end
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Upstream bus returns
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// l_data
+	// {{{
+	// The device, if any, is placed in bits [28:26]
+	always @(posedge i_clk)
+	case(i_wb_addr[2:0])
+	3'h0: begin
+		l_data <= { eng_busy, pgm_done, 6'h0, pg_baddr };
+		l_data[26 +: CSW] <= pg_chip;
+		end
+	3'h1: begin
+		l_data <= { eng_busy, pgm_done, 4'h0, er_size, er_addr };
+		l_data[26 +: CSW] <= er_chip;
+		end
+	3'h2:	 l_data <= { 8'h0, poll_int };
+	3'h3:	 l_data <= { 8'h0, susp_lat };
+	default: l_data <= 0;
+	endcase
+	// }}}
+	// }}}
+
+	// Make verilator happy
+	// {{{
+	// verilator lint_off UNUSED
+	wire	unused;
+	assign	unused = &{ 1'b0, pg_wide[31:24] };
+	// verilator lint_on  UNUSED
+	// }}}
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//
+// Formal properties
+// {{{
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+`ifdef	FORMAL
+	localparam	F_LGDEPTH = 4;
+	reg	f_past_valid;
+	wire	[F_LGDEPTH-1:0]	f_nreqs, f_nacks, f_outstanding;
+	reg	[F_LGDEPTH-1:0]	f_dnreqs;
+
+	initial	f_past_valid = 1'b0;
+	always @(posedge i_clk)
+		f_past_valid <= 1'b1;
+
+	always @(*)
+	if (!f_past_valid)
+		assume(i_reset);
+
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Upstream bus properties
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	always @(*)
+		assume(!i_wb_stb || !i_cfg_stb);
+
+	fwb_slave #(.AW(AW), .DW(DW),.F_LGDEPTH(F_LGDEPTH),
+			.F_MAX_STALL(0), .F_MAX_ACK_DELAY(0),
+			.F_OPT_RMW_BUS_OPTION(0),
+			.F_OPT_CLK2FFLOGIC(1'b0),
+			.F_OPT_DISCONTINUOUS(1))
+		f_wbm(i_clk, i_reset,
+			i_wb_cyc, (i_wb_stb)||(i_cfg_stb), i_wb_we, i_wb_addr,
+				i_wb_data, 4'hf,
+			o_wb_ack, o_wb_stall, o_wb_data, 1'b0,
+			f_nreqs, f_nacks, f_outstanding);
+
+	always @(*)
+	if (i_wb_cyc)
+		assert(f_outstanding == pt_pending + (l_ack ? 1:0)
+						+ (susp_rd ? 1:0));
+
+	always @(*)
+	if (susp_rd)
+		assert(!l_ack);
+
+	always @(*)
+	if (l_ack)
+		assert(pt_pending == 0);
+
+	// Reads are only passed through, while busy, to the other devices
+	// between status polls.  The engine then waits on them.
+	always @(*)
+	if ((eng_busy)&&(pt_pending != 0))
+	begin
+		assert(NCS > 1);
+		assert(eng_state == ST_POLL && eng_count == 1);
+		assert(!eng_stb && !eng_ackwait && !eng_susp);
+	end
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Downstream bus properties
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// Count the requests the controller has accepted, but not yet
+	// acknowledged, since the cycle line was last raised.
+	initial	f_dnreqs = 0;
+	always @(posedge i_clk)
+	if ((i_reset)||(!o_fl_cyc))
+		f_dnreqs <= 0;
+	else case({ (o_fl_stb || o_fl_cfg_stb) && !i_fl_stall, i_fl_ack })
+	2'b10: f_dnreqs <= f_dnreqs + 1;
+	2'b01: f_dnreqs <= f_dnreqs - 1;
+	default: begin end
+	endcase
+
+	always @(*)
+	if (!o_fl_cyc || f_dnreqs == 0)
+		assume(!i_fl_ack);
+
+	always @(*)
+		assert(!o_fl_stb || !o_fl_cfg_stb);
+
+	always @(*)
+	if (!o_fl_cyc)
+		assert(!o_fl_stb && !o_fl_cfg_stb);
+
+	always @(*)
+	if (o_fl_cyc)
+		assert(f_dnreqs == pt_pending
+				+ ((eng_busy && eng_ackwait) ? 1:0));
+
+	always @(*)
+	if (eng_busy)
+	begin
+		assert(!eng_stb || !eng_ackwait);
+		if ((eng_wait != 0)||(poll_ctr != 0))
+			assert(!eng_stb && !eng_ackwait);
+		if (poll_ctr != 0)
+			assert((eng_state == ST_POLL && eng_count == 1)
+				||(eng_susp && eng_state == ST_ONLINE
+					&& eng_count == 0));
+		if (eng_erase)
+			assert(eng_state != ST_DATA);
+		if (eng_susp)
+			assert((eng_state == ST_SUSPEND)
+				||(eng_state == ST_ONLINE)
+				||(eng_state == ST_READ)
+				||(eng_state == ST_OFFLINE)
+				||(eng_state == ST_RESUME));
+		else
+			assert(eng_state <= ST_ONLINE);
+		assert(eng_count <= eng_last);
+	end else begin
+		assert(!eng_stb && !eng_ackwait);
+		assert(eng_wait == 0 && poll_ctr == 0);
+		assert(eng_state == ST_OFFLINE && eng_count == 0);
+		assert(!eng_susp);
+	end
+
+	always @(*)
+	if (!OPT_SUSPEND)
+		assert(!eng_susp && !susp_rd);
+
+	always @(*)
+	if (susp_rd)
+		assert(eng_busy && eng_state == ST_READ && eng_ackwait);
+
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset))&&($past(eng_busy))
+			&&($past(o_fl_cfg_stb))&&($past(i_fl_stall)))
+	begin
+		assert(o_fl_cfg_stb);
+		assert(o_fl_we   == $past(o_fl_we));
+		assert(o_fl_data == $past(o_fl_data));
+	end
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Cover properties
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset)))
+	begin
+		cover(eng_busy && eng_state == ST_DATA && eng_count == 1);
+		cover(eng_busy && eng_erase && eng_state == ST_POLL
+				&& eng_count == 3 && poll_ctr == 0
+				&& $past(poll_ctr) == 1);
+		cover(o_wb_ack && l_ack && $past(o_wb_ack && !l_ack));
+		cover(eng_busy && o_wb_ack);
+		cover(eng_susp && o_wb_ack && !l_ack);
+		cover(eng_busy && o_wb_ack && !l_ack && !eng_susp);
+	end
+	// }}}
+`endif
+// }}}
+endmodule
@@ -0,0 +1,1739 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	oflexpress.v
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	To provide wishbone controlled read access (and read access
+//		*only*) to an Octal SPI flash, using a flash clock equal to the
+//	system clock, and nothing more.  This is a derivative of the Quad SPI
+//	flash controller, qflexpress.v, and shares its bus and configuration
+//	port models, its startup script mechanism, and its OPT_PIPE,
+//	OPT_CLKDIV, and RDDELAY options.  The data path, however, is eight
+//	bits wide, addresses are always four bytes, and reads may use the
+//	flash's octal DTR (double transfer rate) mode.
+//
+//	Octal flash devices (Macronix's OPI, for example) have no XIP mode.
+//	Every bus read therefore starts with its own command: two bytes, the
+//	command followed by its complement, then four bytes of address, then
+//	NDUMMY dummy clocks before the data.  In DTR mode, a byte crosses the
+//	interface on each edge of SCK, and so a read takes 5+NDUMMY clocks,
+//	and each further pipelined word only two.
+//
+//	Three modes/states of operation:
+//	1. Startup/maintenance, places the device in the octal mode
+//	2. Normal operations, takes 5+NDUMMY+2N clocks to read N words in DTR
+//		mode, 10+NDUMMY+4N otherwise
+//	3. Configuration--useful to allow an external controller issue erase
+//		or program commands (or other) without requiring us to
+//		clutter up the logic with a giant state machine
+//
+//	STARTUP
+//	 1. Waits for the flash to come on line
+//	 2. Resets the flash from any octal mode it might have been left in,
+//		sending a reset enable (0x66,0x99) and reset (0x99,0x66) eight
+//		bits at a time.  In SPI mode, these are ignored.
+//	 3. Writes configuration register two (0x72), address zero, to place
+//		the flash into DTR octal mode (0x02), or its single transfer
+//		rate octal mode (0x01) if DTR isn't in use
+//	 4. All done
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2018-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+`default_nettype	none
+// }}}
+module	oflexpress #(
+		// {{{
+		// LGFLASHSZ
+		// {{{
+		// LGFLASHSZ is the size of the flash memory.  It defines the
+		// number of bits in the address register and more.  This
+		// controller will support flash sizes up to 2^LGFLASHSZ,
+		// where LGFLASHSZ goes up to 32.  Addresses are always sent
+		// as four bytes.
+		parameter	LGFLASHSZ=26,
+		// }}}
+		// OPT_PIPE
+		// {{{
+		// OPT_PIPE makes it possible to string multiple requests
+		// together, with no intervening need to shutdown the OSPI
+		// connection and send a new command and address
+		parameter [0:0]	OPT_PIPE    = 1'b1,
+		// }}}
+		// OPT_CFG
+		// {{{
+		// OPT_CFG enables the configuration logic port, and hence the
+		// ability to erase and program the flash, as well as the
+		// ability to perform other commands such as read-manufacturer
+		// ID, adjust configuration registers, etc.
+		parameter [0:0]	OPT_CFG     = 1'b1,
+		// }}}
+		//
+		// OPT_STARTUP enables the startup logic
+		parameter [0:0]	OPT_STARTUP = 1'b1,
+		//
+		parameter	OPT_CLKDIV = 0,
+		//
+		// OPT_ENDIANSWAP
+		// {{{
+		// Normally, I place the first byte read from the flash, and
+		// the lowest flash address, into bits [7:0], and then shift
+		// it up--to where upon return it is found in bits [31:24].
+		// This is ideal for a big endian systems, not so much for
+		// little endian systems.  The endian swap allows the bus to
+		// swap the return values in order to support little endian
+		// systems.
+		parameter [0:0]	OPT_ENDIANSWAP = 1'b1,
+		// }}}
+		// OPT_ODDR
+		// {{{
+		// OPT_ODDR will be true any time the clock has no clock
+		// division
+		localparam [0:0]	OPT_ODDR = (OPT_CLKDIV == 0),
+		// }}}
+		// CKDV_BITS
+		// {{{
+		// CKDV_BITS is the number of bits necessary to represent a
+		// counter that can do the CLKDIV division
+		localparam 	CKDV_BITS = (OPT_CLKDIV == 0) ? 0
+					: ((OPT_CLKDIV <   2) ? 1
+					: ((OPT_CLKDIV <   4) ? 2
+					: ((OPT_CLKDIV <   8) ? 3
+					: ((OPT_CLKDIV <  16) ? 4
+					: ((OPT_CLKDIV <  32) ? 5
+					: ((OPT_CLKDIV <  64) ? 6
+					: ((OPT_CLKDIV < 128) ? 7
+					: ((OPT_CLKDIV < 256) ? 8 : 9)))))))),
+		// }}}
+		// RDDELAY
+		// {{{
+		// RDDELAY is the number of clock cycles from when o_ospi_dat
+		// is valid until i_ospi_dat is valid.  As with qflexpress, DDR
+		// registered I/O on a Xilinx device can be done with a
+		// RDDELAY=3, Intel/Altera devices with RDDELAY=2, and iCE40
+		// devices with RDDELAY=0.
+		parameter	RDDELAY = 0,
+		// }}}
+		// NDUMMY
+		// {{{
+		// NDUMMY is the number of "dummy" clock cycles between the
+		// last address byte and the first data byte.  There's no mode
+		// byte in octal mode, so this is the number of clocks found in
+		// the flash's data sheet.  Macronix parts power up with 20,
+		// enough for their fastest clock.  The bus read counter
+		// limits this to 48 or fewer.
+		parameter	NDUMMY = 20,
+		// }}}
+		// OPT_DTR
+		// {{{
+		// OPT_DTR places the flash into its DTR octal mode, where
+		// commands, addresses, and data all cross the interface on
+		// both edges of SCK--two bytes per clock.  DTR requires DDR
+		// I/O on the data pins, and so is only supported when
+		// OPT_CLKDIV == 0.  o_ospi_dat and i_ospi_dat are then each
+		// two bytes wide: [15:8] for the first half of each clock,
+		// [7:0] for the second.  Single rate (SPI) bits are sent in
+		// both halves, and read from [7:0].
+		//
+		// Otherwise, the flash is placed into its single transfer
+		// rate octal mode, and the data pins are one byte wide.
+		parameter [0:0]	OPT_DTR = 1'b1,
+		localparam [0:0]	OPT_DTRIO = OPT_DTR && OPT_ODDR,
+		localparam		OW = OPT_DTRIO ? 16 : 8,
+		// }}}
+		//
+		//
+		localparam [4:0]	CFG_MODE =	12,
+		localparam [4:0]	OSPEED_BIT = 	11,
+		localparam [4:0]	DIR_BIT	= 	 9,
+		localparam [4:0]	USER_CS_n = 	 8,
+		//
+		localparam [1:0]	NORMAL_SPI = 	2'b00,
+		localparam [1:0]	OCTAL_WRITE = 	2'b10,
+		localparam [1:0]	OCTAL_READ = 	2'b11,
+		// The read command, followed by its complement
+		localparam [15:0] OIO_READ_CMD = OPT_DTRIO ? 16'hee11 : 16'hec13,
+		//
+		localparam	AW=LGFLASHSZ-2,
+		localparam	DW=32,
+		// The data pipe holds the command, the address, and room for
+		// eight single bits in low speed configuration writes.
+		// Without ODDR support, one more byte goes out before SCK's
+		// first rising edge.
+		localparam	DPW = 64 + (OPT_ODDR ? 0:8),
+		localparam [5:0] RD_CLOCKS = OPT_DTRIO ? (5 + NDUMMY)
+					: (10 + NDUMMY + (OPT_ODDR ? 0:1)),
+		localparam [5:0] PIPE_CLOCKS = OPT_DTRIO ? 2 : 4
+`ifdef	FORMAL
+		, localparam	F_LGDEPTH=$clog2(3+RDDELAY)
+`endif
+		// }}}
+	) (
+		// {{{
+		input	wire			i_clk, i_reset,
+		//
+		input	wire			i_wb_cyc, i_wb_stb,
+						i_cfg_stb, i_wb_we,
+		input	wire	[(AW-1):0]	i_wb_addr,
+		input	wire	[(DW-1):0]	i_wb_data,
+		//
+		output	reg			o_wb_stall,
+		output	reg			o_wb_ack,
+		output	reg	[(DW-1):0]	o_wb_data,
+		//
+		output	reg		o_ospi_sck,
+		output	reg		o_ospi_cs_n,
+		output	reg	[1:0]	o_ospi_mod,
+		output	wire	[OW-1:0]	o_ospi_dat,
+		input	wire	[OW-1:0]	i_ospi_dat
+		// }}}
+	);
+
+	// Signal declarations
+	// {{{
+`ifdef	FORMAL
+	reg	f_past_valid;
+`endif
+
+	reg		dly_ack, read_sck, xtra_stall;
+	// clk_ctr must have enough bits for ...
+	//	6		command and address clocks, 3 in DTR mode
+	//	NDUMMY		dummy clocks
+	//	4		data clocks, 2 in DTR mode
+	//	(RDDELAY clocks not counted here)
+	reg	[5:0]	clk_ctr;
+
+	//
+	// User override logic
+	//
+	reg	cfg_mode, cfg_speed, cfg_dir, cfg_cs;
+	wire	cfg_write, cfg_hs_write, cfg_ls_write, cfg_hs_read,
+		user_request, bus_request, pipe_req, pipe_next,
+		cfg_noop, cfg_stb;
+	//
+	assign	bus_request  = (i_wb_stb)&&(!o_wb_stall)
+					&&(!i_wb_we)&&(!cfg_mode);
+	assign	cfg_stb      = (OPT_CFG)&&(i_cfg_stb)&&(!o_wb_stall);
+	assign	cfg_noop     = ((cfg_stb)&&((!i_wb_we)||(!i_wb_data[CFG_MODE])
+					||(i_wb_data[USER_CS_n])))
+				||((!OPT_CFG)&&(i_cfg_stb)&&(!o_wb_stall));
+	assign	user_request = (cfg_stb)&&(i_wb_we)&&(i_wb_data[CFG_MODE]);
+
+	assign	cfg_write    = (user_request)&&(!i_wb_data[USER_CS_n]);
+	assign	cfg_hs_write = (cfg_write)&&(i_wb_data[OSPEED_BIT])
+					&&(i_wb_data[DIR_BIT]);
+	assign	cfg_hs_read  = (cfg_write)&&(i_wb_data[OSPEED_BIT])
+					&&(!i_wb_data[DIR_BIT]);
+	assign	cfg_ls_write = (cfg_write)&&(!i_wb_data[OSPEED_BIT]);
+
+
+	reg		ckstb, ckpos, ckneg, ckpre;
+	reg		maintenance;
+	reg	[1:0]	m_mod;
+	reg		m_cs_n;
+	reg		m_clk;
+	reg	[OW-1:0]	m_dat;
+
+	reg	[DPW-1:0]	data_pipe;
+	reg	[31:0]		w_addr;
+	reg	pre_ack = 1'b0;
+	reg	actual_sck;
+
+	// dtr_mode: when DTR is enabled, everything at octal speed--bus
+	// reads and high speed configuration transfers alike--moves two
+	// bytes per clock.  Single rate transfers use sdr_odat and sdr_idat.
+	wire		dtr_mode;
+	wire	[7:0]	sdr_odat, sdr_idat;
+	wire	[15:0]	dtr_idat;
+
+	assign	dtr_mode = (OPT_DTRIO)&&(!maintenance)
+					&&((!cfg_mode)||(cfg_speed));
+	// }}}
+
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Clock division: ckstb, ckpos, ckneg, ckpre
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	generate if (OPT_ODDR)
+	begin // Flash clock == system clock speed
+		// {{{
+		always @(*)
+		begin
+			ckstb = 1'b1;
+			ckpos = 1'b1;
+			ckneg = 1'b1;
+			ckpre = 1'b1;
+		end
+		// }}}
+	end else if (OPT_CLKDIV == 1)
+	begin : CKSTB_ONE // Flash clock can be generated logically, == sysclk/2
+		// {{{
+		reg	clk_counter;
+
+		initial	clk_counter = 1'b1;
+		always @(posedge i_clk)
+		if (i_reset)
+			clk_counter <= 1'b1;
+		else if (clk_counter != 0)
+			clk_counter <= 1'b0;
+		else if (bus_request)
+			clk_counter <= (pipe_req);
+		else if ((maintenance)||(!o_ospi_cs_n && o_wb_stall))
+			clk_counter <= 1'b1;
+
+		always @(*)
+		begin
+			ckpre = (clk_counter == 1);
+			ckstb = (clk_counter == 0);
+			ckpos = (clk_counter == 1);
+			ckneg = (clk_counter == 0);
+		end
+		// }}}
+	end else begin : CKSTB_GEN
+		// {{{
+		reg	[CKDV_BITS-1:0]	clk_counter;
+
+		initial	clk_counter = OPT_CLKDIV;
+		always @(posedge i_clk)
+		if (i_reset)
+			clk_counter <= OPT_CLKDIV;
+		else if (clk_counter != 0)
+			clk_counter <= clk_counter - 1;
+		else if (bus_request)
+			clk_counter <= (pipe_req ? OPT_CLKDIV : 0);
+		else if ((maintenance)||(!o_ospi_cs_n && o_wb_stall))
+			clk_counter <= OPT_CLKDIV;
+
+		initial	ckpre = (OPT_CLKDIV == 1);
+		initial	ckstb = 1'b0;
+		initial	ckpos = (OPT_CLKDIV == 1);
+		always @(posedge i_clk)
+		if (i_reset)
+		begin
+			ckpre <= (OPT_CLKDIV == 1);
+			ckstb <= 1'b0;
+			ckpos <= (OPT_CLKDIV == 1);
+		end else // if (OPT_CLKDIV > 1)
+		begin
+			ckpre <= (clk_counter == 2);
+			ckstb <= (clk_counter == 1);
+			ckpos <= (clk_counter == (OPT_CLKDIV+1)/2+1);
+		end
+
+		always @(*)
+			ckneg = ckstb;
+`ifdef	FORMAL
+		always @(*)
+			assert(!ckpos || !ckneg);
+
+		always @(posedge i_clk)
+		if ((f_past_valid)&&(!$past(i_reset))&&($past(ckpre)))
+			assert(ckstb);
+`endif
+		// }}}
+	end endgenerate
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Maintenance / startup portion
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	generate if (OPT_STARTUP)
+	begin : GEN_STARTUP
+		// {{{
+		// Signal declarations
+		// {{{
+		localparam	M_WAITBIT=18;
+		localparam	M_LGADDR=5;
+`ifdef	FORMAL
+		// For formal, jump into the middle of the startup
+		localparam	M_FIRSTIDX=5'h0d;
+`else
+		localparam	M_FIRSTIDX=0;
+`endif
+		// The value written to configuration register two: DTR octal
+		// (DOPI), or single transfer rate octal (SOPI)
+		localparam [7:0]	M_CR2 = (OPT_DTRIO) ? 8'h02 : 8'h01;
+		reg	[M_WAITBIT:0]	m_this_word;
+		reg	[M_WAITBIT:0]	m_cmd_word	[0:(1<<M_LGADDR)-1];
+		reg	[M_LGADDR-1:0]	m_cmd_index;
+
+		reg	[9:0]		m_counter;
+		reg			m_midcount;
+		reg	[3:0]		m_bitcount;
+		reg	[15:0]		m_byte;
+		// }}}
+
+		// Command ISA description:
+		// {{{
+		// The script follows that of qflexpress, save that each word
+		// now carries sixteen bits of data.  These commands are
+		// specific to Macronix's octal (OPI) flash devices.
+		//
+		// The format of the data words is ...
+		//	1'bit (MSB) to indicate this is a counter word.
+		//		Counter words count a number of idle cycles, as
+		//		given by the bottom ten bits, in which the port
+		//		is unused (CSN is high)
+		//
+		//	2'bit mode.  This is either ...
+		//	    NORMAL_SPI, for a normal SPI interaction, sending
+		//			the bottom eight bits out one at a
+		//			time on o_ospi_dat[0]
+		//	or  OCTAL_WRITE, all eight pins are outputs, and both
+		//			bytes are sent--in one clock in DTR
+		//			mode, or two otherwise.  Octal
+		//			commands always come in such pairs.
+		//
+		//	16'bit data	As described above
+		// }}}
+		integer k;
+		initial
+		begin
+		// {{{
+		for(k=0; k<(1<<M_LGADDR); k=k+1)
+			m_cmd_word[k] = -1;
+		// cmd_word= m_ctr_flag, m_mod[1:0], m_data[15:0]
+		//
+		// Start off idle, giving the flash time to come on line.
+		// Words 5'h00-5'h07 are all idles of 1023 clocks each.
+		//
+		// Since we don't know what mode the flash started in, we'll
+		// start by resetting it from any octal mode it might have
+		// been left in.  This is a reset enable, followed by a reset,
+		// each sent eight bits at a time.  A flash in SPI mode will
+		// see only one or two bits of each, and so ignore them.
+		m_cmd_word[5'h08] = { 1'b0, OCTAL_WRITE, 16'h6699 };
+		// Idle
+		m_cmd_word[5'h09] = { 1'b1, 8'h0, 10'h3f };
+		m_cmd_word[5'h0a] = { 1'b0, OCTAL_WRITE, 16'h9966 };
+		//
+		// Idle, while the reset completes
+		m_cmd_word[5'h0b] = { 1'b1, 8'h0, 10'h3ff };
+		m_cmd_word[5'h0c] = { 1'b1, 8'h0, 10'h3ff };
+		m_cmd_word[5'h0d] = { 1'b1, 8'h0, 10'h3ff };
+		//
+		// Write configuration register two
+		//
+		// The write enable must come first: 06
+		m_cmd_word[5'h0e] = { 1'b0, NORMAL_SPI, 8'h0, 8'h06 };
+		//
+		// Idle
+		m_cmd_word[5'h0f] = { 1'b1, 8'h0, 10'h3f };
+		//
+		// WRCR2, address zero, the octal mode
+		m_cmd_word[5'h10] = { 1'b0, NORMAL_SPI, 8'h0, 8'h72 };
+		m_cmd_word[5'h11] = { 1'b0, NORMAL_SPI, 8'h0, 8'h00 };
+		m_cmd_word[5'h12] = { 1'b0, NORMAL_SPI, 8'h0, 8'h00 };
+		m_cmd_word[5'h13] = { 1'b0, NORMAL_SPI, 8'h0, 8'h00 };
+		m_cmd_word[5'h14] = { 1'b0, NORMAL_SPI, 8'h0, 8'h00 };
+		m_cmd_word[5'h15] = { 1'b0, NORMAL_SPI, 8'h0, M_CR2 };
+		//
+		// Idle -- The flash is now in its octal mode, and there's no
+		// XIP mode to enter.  Every read will send its own command.
+		// The last two idles are *REQUIRED* and not optional.
+		m_cmd_word[5'h16] = { 1'b1, 8'h0, 10'h3ff };
+		m_cmd_word[5'h1e] = -1;
+		m_cmd_word[5'h1f] = -1;
+		// Then we are in business!
+		// }}}
+		end
+
+		reg	m_final;
+
+		wire	m_ce, new_word;
+		assign	m_ce = (!m_midcount)&&(ckstb);
+		assign	new_word = (m_ce && m_bitcount == 0);
+
+		// m_cmd_index, maintenance (on/off)
+		// {{{
+		initial	maintenance = 1'b1;
+		initial	m_cmd_index = M_FIRSTIDX;
+		always @(posedge i_clk)
+		if (i_reset)
+		begin
+			m_cmd_index <= M_FIRSTIDX;
+			maintenance <= 1'b1;
+		end else if (new_word)
+		begin
+			maintenance <= (maintenance)&&(!m_final);
+			if (!(&m_cmd_index))
+				m_cmd_index <= m_cmd_index + 1'b1;
+		end
+		// }}}
+
+		// m_this_word -- current command
+		// {{{
+		initial	m_this_word = -1;
+		always @(posedge i_clk)
+		if (new_word)
+			m_this_word <= m_cmd_word[m_cmd_index];
+		// }}}
+
+		// m_final
+		// {{{
+		initial	m_final = 1'b0;
+		always @(posedge i_clk)
+		if (i_reset)
+			m_final <= 1'b0;
+		else if (new_word)
+			m_final <= (m_final || (&m_cmd_index));
+		// }}}
+
+		// m_midcount .. are we in the middle of a counter/pause?
+		// {{{
+		initial	m_midcount = 1;
+		initial	m_counter   = -1;
+		always @(posedge i_clk)
+		if (i_reset)
+		begin
+			// {{{
+			m_midcount <= 1'b1;
+`ifdef	FORMAL
+			m_counter <= 3;
+`else
+			m_counter <= -1;
+`endif
+			// }}}
+		end else if (new_word)
+		begin
+			// {{{
+			m_midcount <= m_this_word[M_WAITBIT]
+					&& (|m_this_word[9:0]);
+			if (m_this_word[M_WAITBIT])
+			begin
+				m_counter <= m_this_word[9:0];
+`ifdef	FORMAL
+				if (m_this_word[9:0] > 3)
+					m_counter <= 3;
+`endif
+			end
+			// }}}
+		end else begin
+			// {{{
+			m_midcount <= (m_counter > 1);
+			if (m_counter > 0)
+				m_counter <= m_counter - 1'b1;
+			// }}}
+		end
+		// }}}
+
+		// m_cs_n, m_mod, m_bitcount
+		// {{{
+		initial	m_cs_n      = 1'b1;
+		initial	m_mod       = NORMAL_SPI;
+		always @(posedge i_clk)
+		if (i_reset)
+		begin
+			m_cs_n <= 1'b1;
+			m_mod  <= NORMAL_SPI;
+			m_bitcount <= 0;
+		end else if (ckstb)
+		begin
+			if (m_bitcount != 0)
+				m_bitcount <= m_bitcount - 1;
+			else if ((m_ce)&&(m_final))
+			begin
+				m_cs_n <= 1'b1;
+				m_mod  <= NORMAL_SPI;
+				m_bitcount <= 0;
+			end else if ((m_midcount)||(m_this_word[M_WAITBIT]))
+			begin
+				m_cs_n <= 1'b1;
+				m_mod  <= NORMAL_SPI;
+				m_bitcount <= 0;
+			end else begin
+				m_cs_n <= 1'b0;
+				m_mod  <= m_this_word[M_WAITBIT-1:M_WAITBIT-2];
+				if (!m_this_word[M_WAITBIT-1])
+					// Eight clocks, one per bit
+					m_bitcount <= (!OPT_ODDR && m_cs_n) ? 4'h8 : 4'h7;
+				else if (OPT_DTRIO)
+					// Both bytes in one clock
+					m_bitcount <= 4'h0;
+				else
+					// One byte per clock
+					m_bitcount <= (!OPT_ODDR && m_cs_n) ? 4'h2 : 4'h1;
+			end
+		end
+		// }}}
+
+		// m_dat, m_byte
+		// {{{
+		if (OPT_DTRIO)
+		begin : M_DTR_DATA
+			// {{{
+			// Octal words go out in a single clock, one byte on
+			// each edge.  SPI bits are sent on both halves.
+			always @(posedge i_clk)
+			if (m_ce)
+			begin
+				if (m_bitcount == 0)
+				begin
+					if (m_this_word[M_WAITBIT-1])
+					begin
+						m_dat  <= m_this_word[15:0];
+						m_byte <= 16'h0;
+					end else begin
+						m_dat  <= {(2){ 7'h0, m_this_word[7] }};
+						m_byte <= { m_this_word[6:0], 9'h0 };
+					end
+				end else begin
+					m_dat  <= {(2){ 7'h0, m_byte[15] }};
+					m_byte <= { m_byte[14:0], 1'b0 };
+				end
+			end
+			// }}}
+		end else begin : M_SDR_DATA
+			// {{{
+			always @(posedge i_clk)
+			if (m_ce)
+			begin
+				if (m_bitcount == 0)
+				begin
+					// {{{
+					if (!OPT_ODDR && m_cs_n)
+					begin
+						// Before SCK's first rising
+						// edge, keep the whole word
+						if (m_this_word[M_WAITBIT-1])
+						begin
+							m_dat  <= m_this_word[15:8];
+							m_byte <= m_this_word[15:0];
+						end else begin
+							m_dat  <= { 7'h0, m_this_word[7] };
+							m_byte <= { m_this_word[7:0], 8'h0 };
+						end
+					end else if (m_this_word[M_WAITBIT-1])
+					begin
+						m_dat  <= m_this_word[15:8];
+						m_byte <= { m_this_word[7:0], 8'h0 };
+					end else begin
+						// Slow speed
+						m_dat  <= { 7'h0, m_this_word[7] };
+						m_byte <= { m_this_word[6:0], 9'h0 };
+					end
+					// }}}
+				end else if (m_mod[1])
+				begin
+					m_dat  <= m_byte[15:8];
+					m_byte <= { m_byte[7:0], 8'h0 };
+				end else begin
+					m_dat  <= { 7'h0, m_byte[15] };
+					m_byte <= { m_byte[14:0], 1'b0 };
+				end
+			end
+			// }}}
+		end
+		// }}}
+
+		// m_clk
+		// {{{
+		if (OPT_ODDR)
+		begin
+			always @(*)
+				m_clk = !m_cs_n;
+		end else begin
+			// {{{
+			always @(posedge i_clk)
+			if (i_reset)
+				m_clk <= 1'b1;
+			else if (m_cs_n)
+				m_clk <= 1'b1;
+			else if ((!m_clk)&&(ckpos))
+				m_clk <= 1'b1;
+			else if (m_midcount)
+				m_clk <= 1'b1;
+			else if (new_word && m_this_word[M_WAITBIT])
+				m_clk <= 1'b1;
+			else if (ckneg)
+				m_clk <= 1'b0;
+			// }}}
+		end
+		// }}}
+
+`ifdef	FORMAL
+		// {{{
+		(* anyconst *) reg [M_LGADDR:0]	f_const_addr;
+
+		always @(*)
+		begin
+			assert((m_cmd_word[f_const_addr][M_WAITBIT])
+				||(m_cmd_word[f_const_addr][M_WAITBIT-1:M_WAITBIT-2] != 2'b01));
+			if (m_cmd_word[f_const_addr][M_WAITBIT])
+				assert(m_cmd_word[f_const_addr][9:0] > 0);
+		end
+		always @(*)
+		begin
+			if (m_cmd_index != f_const_addr)
+				assume((m_cmd_word[m_cmd_index][M_WAITBIT])||(m_cmd_word[m_cmd_index][M_WAITBIT-1:M_WAITBIT-2] != 2'b01));
+			if (m_cmd_word[m_cmd_index][M_WAITBIT])
+				assume(m_cmd_word[m_cmd_index][9:0]>0);
+		end
+
+		always @(*)
+		begin
+			assert((m_this_word[M_WAITBIT])
+				||(m_this_word[M_WAITBIT-1:M_WAITBIT-2] != 2'b01));
+			if (m_this_word[M_WAITBIT])
+				assert(m_this_word[9:0] > 0);
+		end
+
+		// Setting the last two command words to IDLE with maximum
+		// counts is required by our implementation
+		always @(*)
+			assert(m_cmd_word[5'h1e] == -1);
+		always @(*)
+			assert(m_cmd_word[5'h1f] == -1);
+
+		wire	[M_LGADDR-1:0]	last_index;
+		assign	last_index = m_cmd_index - 1;
+
+		always @(posedge i_clk)
+		if ((f_past_valid)&&(m_cmd_index != M_FIRSTIDX))
+			assert(m_this_word == m_cmd_word[last_index]);
+
+		always @(posedge i_clk)
+			assert(m_midcount == (m_counter != 0));
+
+		always @(*)
+		if (OPT_DTRIO && !m_cs_n && m_mod[1])
+			assert(m_bitcount == 0);
+
+		always @(posedge i_clk)
+		begin
+			cover(!maintenance);
+			cover(m_cmd_index == 5'h0e);
+			cover(m_cmd_index == 5'h10);
+			cover(m_cmd_index == 5'h16);
+			cover(m_cmd_index == 5'h1f);
+		end
+		// }}}
+`endif
+		// }}}
+	end else begin : NO_STARTUP_OPT
+		// {{{
+		always @(*)
+		begin
+			maintenance = 0;
+			m_mod       = 2'b00;
+			m_cs_n      = 1'b1;
+			m_clk       = 1'b0;
+			m_dat       = 0;
+		end
+
+		// verilator lint_off UNUSED
+		wire	unused_maintenance;
+		assign	unused_maintenance = &{ 1'b0, maintenance,
+					m_mod, m_cs_n, m_clk, m_dat };
+		// verilator lint_on  UNUSED
+		// }}}
+	end endgenerate
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Data / access portion
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// w_addr: the four byte address of a bus read
+	// {{{
+	always @(*)
+	begin
+		w_addr = 0;
+		w_addr[LGFLASHSZ-1:0] = { i_wb_addr, 2'b00 };
+	end
+	// }}}
+
+	// data_pipe
+	// {{{
+	initial	data_pipe = 0;
+	always @(posedge i_clk)
+	begin
+		if (!o_wb_stall)
+		begin
+			// Set the high bits to zero initially
+			data_pipe <= 0;
+
+			if (!i_cfg_stb)
+				// Command, its complement, and address
+				data_pipe[63:0] <= { OIO_READ_CMD, w_addr, 16'h0 };
+			else if (i_wb_data[OSPEED_BIT])
+			begin
+				// High speed configuration I/O.  In DTR mode,
+				// a second byte follows in the same clock
+				data_pipe[56 +: 8] <= i_wb_data[7:0];
+				if (OPT_DTRIO)
+					data_pipe[48 +: 8] <= i_wb_data[23:16];
+			end else begin
+				// Low speed configuration I/O, one bit per byte
+				data_pipe[56] <= i_wb_data[7];
+				data_pipe[48] <= i_wb_data[6];
+				data_pipe[40] <= i_wb_data[5];
+				data_pipe[32] <= i_wb_data[4];
+				data_pipe[24] <= i_wb_data[3];
+				data_pipe[16] <= i_wb_data[2];
+				data_pipe[ 8] <= i_wb_data[1];
+				data_pipe[ 0] <= i_wb_data[0];
+			end
+		end else if ((ckstb)&&(dtr_mode))
+			data_pipe <= { data_pipe[DPW-17:0], 16'h0 };
+		else if (ckstb)
+			data_pipe <= { data_pipe[DPW-9:0], 8'h0 };
+
+		if (maintenance)
+			data_pipe[DPW-1 -: OW] <= m_dat;
+	end
+	// }}}
+
+	assign	sdr_odat = data_pipe[DPW-1 -: 8];
+
+	// o_ospi_dat, sdr_idat
+	// {{{
+	generate if (OPT_DTRIO)
+	begin : GEN_DTR_DATA
+		assign	o_ospi_dat = (dtr_mode || maintenance)
+				? data_pipe[DPW-1 -: 16]
+				: { sdr_odat, sdr_odat };
+		assign	sdr_idat = i_ospi_dat[7:0];
+		assign	dtr_idat = i_ospi_dat;
+	end else begin : GEN_SDR_DATA
+		assign	o_ospi_dat = sdr_odat;
+		assign	sdr_idat = i_ospi_dat;
+		assign	dtr_idat = 16'h0;
+	end endgenerate
+	// }}}
+
+	// pre_ack
+	// {{{
+	// Since we can't abort any transaction once started, without
+	// risking leaving the flash in an unknown state, we'll keep track of
+	// whether this operation should be ack'd upon completion
+	always @(posedge i_clk)
+	if ((i_reset)||(!i_wb_cyc))
+		pre_ack <= 1'b0;
+	else if ((bus_request)||(cfg_write))
+		pre_ack <= 1'b1;
+	// }}}
+
+	// pipe_req
+	// {{{
+	generate if (OPT_PIPE)
+	begin : OPT_PIPE_BLOCK
+		// {{{
+		reg	r_pipe_req;
+		wire	w_pipe_condition;
+
+		reg	[(AW-1):0]	next_addr;
+		always  @(posedge i_clk)
+		if (!o_wb_stall)
+			next_addr <= i_wb_addr + 1'b1;
+
+		assign	w_pipe_condition = (i_wb_stb)&&(!i_wb_we)&&(pre_ack)
+				&&(!maintenance)
+				&&(!cfg_mode)
+				&&(!o_ospi_cs_n)
+				&&((OPT_DTRIO) ? (clk_ctr != 0)
+					: (|clk_ctr[1:0]))
+				&&(next_addr == i_wb_addr);
+
+		initial	r_pipe_req = 1'b0;
+		always @(posedge i_clk)
+		if ((clk_ctr == 1)&&(ckstb))
+			r_pipe_req <= 1'b0;
+		else
+			r_pipe_req <= w_pipe_condition;
+
+		assign	pipe_req = r_pipe_req;
+
+		// In DTR mode, a word takes only two clocks.  Following a
+		// piped request, r_pipe_req won't be valid again until the
+		// last clock of the word--too late to drop the stall line.
+		// Since a stalled request can't change, the combinatorial
+		// condition can be used instead.
+		assign	pipe_next = (OPT_DTRIO) ? w_pipe_condition : r_pipe_req;
+		// }}}
+	end else begin
+		assign	pipe_req  = 1'b0;
+		assign	pipe_next = 1'b0;
+	end endgenerate
+	// }}}
+
+	// clk_ctr
+	// {{{
+	initial	clk_ctr = 0;
+	always @(posedge i_clk)
+	if ((i_reset)||(maintenance))
+		clk_ctr <= 0;
+	else if ((bus_request)&&(!pipe_req))
+		// Notice that this is only for
+		// regular bus reads, and so the check for
+		// !pipe_req
+		clk_ctr <= RD_CLOCKS;
+	else if (bus_request) // && pipe_req
+		// Otherwise, if this is a piped read, we'll
+		// reset the counter back to four--or two clocks
+		// if the data comes two bytes at a time.
+		clk_ctr <= PIPE_CLOCKS;
+	else if (cfg_ls_write)
+		clk_ctr <= 6'd8 + ((OPT_ODDR) ? 0:1);
+	else if (cfg_write)
+		clk_ctr <= 6'd1 + ((OPT_ODDR) ? 0:1);
+	else if ((ckstb)&&(|clk_ctr))
+		clk_ctr <= clk_ctr - 1'b1;
+	// }}}
+
+	// o_ospi_sck
+	// {{{
+	initial	o_ospi_sck = (!OPT_ODDR);
+	always @(posedge i_clk)
+	if (i_reset)
+		o_ospi_sck <= (!OPT_ODDR);
+	else if (maintenance)
+		o_ospi_sck <= m_clk;
+	else if ((!OPT_ODDR)&&(bus_request)&&(pipe_req))
+		o_ospi_sck <= 1'b0;
+	else if ((bus_request)||(cfg_write))
+		o_ospi_sck <= 1'b1;
+	else if (OPT_ODDR)
+	begin
+		// {{{
+		if ((cfg_mode)&&(clk_ctr <= 1))
+			// Config mode has no pipe instructions
+			o_ospi_sck <= 1'b0;
+		else if (clk_ctr > 6'd1)
+			o_ospi_sck <= 1'b1;
+		else
+			o_ospi_sck <= 1'b0;
+		// }}}
+	end else if (((ckpos)&&(!o_ospi_sck))||(o_ospi_cs_n))
+	begin
+		o_ospi_sck <= 1'b1;
+	end else if ((ckneg)&&(o_ospi_sck))
+	begin
+		// {{{
+		if ((cfg_mode)&&(clk_ctr <= 1))
+			// Config mode has no pipe instructions
+			o_ospi_sck <= 1'b1;
+		else if (clk_ctr > 6'd1)
+			o_ospi_sck <= 1'b0;
+		else
+			o_ospi_sck <= 1'b1;
+		// }}}
+	end
+	// }}}
+
+	// o_ospi_cs_n
+	// {{{
+	initial	o_ospi_cs_n = 1'b1;
+	always @(posedge i_clk)
+	if (i_reset)
+		o_ospi_cs_n <= 1'b1;
+	else if (maintenance)
+		o_ospi_cs_n <= m_cs_n;
+	else if ((cfg_stb)&&(i_wb_we))
+		o_ospi_cs_n <= (!i_wb_data[CFG_MODE])||(i_wb_data[USER_CS_n]);
+	else if ((OPT_CFG)&&(cfg_cs))
+		o_ospi_cs_n <= 1'b0;
+	else if ((bus_request)||(cfg_write))
+		o_ospi_cs_n <= 1'b0;
+	else if (ckstb)
+		o_ospi_cs_n <= (clk_ctr <= 1);
+	// }}}
+
+	// o_ospi_mod
+	// {{{
+	// Control the mode of the external pins
+	// 	NORMAL_SPI:  i_miso is an input, o_mosi is an output
+	// 	OCTAL_READ:  all eight pins are inputs
+	// 	OCTAL_WRITE: all eight pins are outputs
+	//
+	// Unlike a quad XIP read, there's no mode byte to send following
+	// the address, so the pins are turned around as soon as the
+	// address has been sent.
+	initial	o_ospi_mod =  NORMAL_SPI;
+	always @(posedge i_clk)
+	if (i_reset)
+		o_ospi_mod <= NORMAL_SPI;
+	else if (maintenance)
+		o_ospi_mod <= m_mod;
+	else if ((bus_request)&&(!pipe_req))
+		o_ospi_mod <= OCTAL_WRITE;
+	else if ((bus_request)||(cfg_hs_read))
+		o_ospi_mod <= OCTAL_READ;
+	else if (cfg_hs_write)
+		o_ospi_mod <= OCTAL_WRITE;
+	else if ((cfg_ls_write)||((cfg_mode)&&(!cfg_speed)))
+		o_ospi_mod <= NORMAL_SPI;
+	else if ((ckstb)&&(clk_ctr <= NDUMMY + PIPE_CLOCKS + 1)
+				&&((!cfg_mode)||(!cfg_dir)))
+		o_ospi_mod <= OCTAL_READ;
+	// }}}
+
+	// o_wb_stall
+	// {{{
+	initial	o_wb_stall = 1'b1;
+	always @(posedge i_clk)
+	if (i_reset)
+		o_wb_stall <= 1'b1;
+	else if (maintenance)
+		o_wb_stall <= 1'b1;
+	else if ((RDDELAY > 0)&&((i_cfg_stb)||(i_wb_stb))&&(!o_wb_stall))
+		o_wb_stall <= 1'b1;
+	else if ((RDDELAY == 0)&&((cfg_write)||(bus_request)))
+		o_wb_stall <= 1'b1;
+	else if (ckstb || clk_ctr == 0)
+	begin
+		// {{{
+		if (ckpre && (i_wb_stb)&&(pipe_next)&&(clk_ctr == 6'd2))
+			o_wb_stall <= 1'b0;
+		else if ((clk_ctr > 1)||(xtra_stall))
+			o_wb_stall <= 1'b1;
+		else
+			o_wb_stall <= 1'b0;
+		// }}}
+	end else if (ckpre && (i_wb_stb)&&(pipe_next)&&(clk_ctr == 6'd1))
+		o_wb_stall <= 1'b0;
+	// }}}
+
+	// dly_ack
+	// {{{
+	initial	dly_ack = 1'b0;
+	always @(posedge i_clk)
+	if (i_reset)
+		dly_ack <= 1'b0;
+	else if ((ckstb)&&(clk_ctr == 1))
+		dly_ack <= (i_wb_cyc)&&(pre_ack);
+	else if ((i_wb_stb)&&(!o_wb_stall)&&(!bus_request))
+		dly_ack <= 1'b1;
+	else if (cfg_noop)
+		dly_ack <= 1'b1;
+	else
+		dly_ack <= 1'b0;
+	// }}}
+
+	// actual_sck
+	// {{{
+	generate if (OPT_ODDR)
+	begin : SCK_ACTUAL
+		// {{{
+		always @(*)
+			actual_sck = o_ospi_sck;
+		// }}}
+	end else if (OPT_CLKDIV == 1)
+	begin : SCK_ONE
+		// {{{
+		initial	actual_sck = 1'b0;
+		always @(posedge i_clk)
+		if (i_reset)
+			actual_sck <= 1'b0;
+		else
+			actual_sck <= (!o_ospi_sck)&&(clk_ctr > 0);
+		// }}}
+	end else begin : SCK_ANY
+		// {{{
+		initial	actual_sck = 1'b0;
+		always @(posedge i_clk)
+		if (i_reset)
+			actual_sck <= 1'b0;
+		else
+			actual_sck <= (o_ospi_sck)&&(ckpre)&&(clk_ctr > 0);
+		// }}}
+	end endgenerate
+	// }}}
+
+
+	// read_sck, o_wb_ack, and xtra_stall
+	// {{{
+`ifdef	FORMAL
+	reg	[F_LGDEPTH-1:0]	f_extra;
+`endif
+
+	generate if (RDDELAY == 0)
+	begin : RDDELAY_NONE
+		// {{{
+		always @(*)
+		begin
+			read_sck = actual_sck;
+			o_wb_ack = dly_ack;
+			xtra_stall = 1'b0;
+		end
+
+`ifdef	FORMAL
+		always @(*)
+			f_extra = 0;
+`endif
+		// }}}
+	end else
+	begin : RDDELAY_NONZERO
+		// {{{
+		reg	[RDDELAY-1:0]	sck_pipe, ack_pipe, stall_pipe;
+		reg	not_done;
+
+		// sck_pipe, ack_pipe, and stall_pipe
+		// {{{
+		initial	sck_pipe = 0;
+		initial	ack_pipe = 0;
+		initial	stall_pipe = -1;
+		if (RDDELAY > 1)
+		begin
+			// {{{
+			always @(posedge i_clk)
+			if (i_reset)
+				sck_pipe <= 0;
+			else
+				sck_pipe <= { sck_pipe[RDDELAY-2:0], actual_sck };
+
+			always @(posedge i_clk)
+			if (i_reset || !i_wb_cyc)
+				ack_pipe <= 0;
+			else
+				ack_pipe <= { ack_pipe[RDDELAY-2:0], dly_ack };
+
+			always @(posedge i_clk)
+			if (i_reset)
+				stall_pipe <= -1;
+			else
+				stall_pipe <= { stall_pipe[RDDELAY-2:0], not_done };
+			// }}}
+		end else // if (RDDELAY > 0)
+		begin
+			// {{{
+			always @(posedge i_clk)
+			if (i_reset)
+				sck_pipe <= 0;
+			else
+				sck_pipe <= actual_sck;
+
+			always @(posedge i_clk)
+			if (i_reset || !i_wb_cyc)
+				ack_pipe <= 0;
+			else
+				ack_pipe <= dly_ack;
+
+			always @(posedge i_clk)
+			if (i_reset)
+				stall_pipe <= -1;
+			else
+				stall_pipe <= not_done;
+			// }}}
+		end
+		// }}}
+
+		// not_done
+		// {{{
+		always @(*)
+		begin
+			not_done = (i_wb_stb || i_cfg_stb) && !o_wb_stall;
+			if (clk_ctr > 1)
+				not_done = 1'b1;
+			if ((clk_ctr == 1)&&(!ckstb))
+				not_done = 1'b1;
+		end
+		// }}}
+
+		always @(*)
+			o_wb_ack = ack_pipe[RDDELAY-1];
+
+		always @(*)
+			read_sck = sck_pipe[RDDELAY-1];
+
+		always @(*)
+			xtra_stall = |stall_pipe;
+
+`ifdef	FORMAL
+		// {{{
+		integer	k;
+		always @(*)
+		if (!i_wb_cyc)
+			f_extra = 0;
+		else begin
+			f_extra = 0;
+			for(k=0; k<RDDELAY; k=k+1)
+				f_extra = f_extra + (ack_pipe[k] ? 1 : 0);
+		end
+		// }}}
+`endif // FORMAL
+		// }}}
+	end endgenerate
+	// }}}
+
+	// o_wb_data
+	// {{{
+	// In configuration mode, a high speed read returns its byte in
+	// [7:0].  In DTR mode, the byte from the second half of the clock
+	// is returned in [23:16].
+	always @(posedge i_clk)
+	begin
+		if ((read_sck)&&(dtr_mode))
+		begin
+			// {{{
+			// Two bytes, one from each half of the clock
+			if (cfg_mode)
+			begin
+				o_wb_data[ 7: 0] <= dtr_idat[15:8];
+				o_wb_data[23:16] <= dtr_idat[ 7:0];
+			end else if (OPT_ENDIANSWAP)
+				o_wb_data <= { dtr_idat[7:0], dtr_idat[15:8],
+							o_wb_data[31:16] };
+			else
+				o_wb_data <= { o_wb_data[15:0], dtr_idat };
+			// }}}
+		end else if (read_sck)
+		begin
+			// {{{
+			if (cfg_mode)
+			begin
+				// No endian-swapping in config mode
+				if (!o_ospi_mod[1])
+					o_wb_data[7:0]<= { o_wb_data[6:0], sdr_idat[1] };
+				else
+					o_wb_data[7:0]<= sdr_idat;
+			end else if (OPT_ENDIANSWAP)
+				o_wb_data <= { sdr_idat, o_wb_data[31:8] };
+			else
+				o_wb_data <= { o_wb_data[23:0], sdr_idat };
+			// }}}
+		end // read_sck
+
+		if ((OPT_CFG)&&(cfg_mode))
+			o_wb_data[15:8] <= { 3'b0, cfg_mode, cfg_speed, 1'b0,
+				cfg_dir, cfg_cs };
+	end
+	// }}}
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Configuration / user overrride access port
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// cfg_mode
+	// {{{
+	initial	cfg_mode = 1'b0;
+	always @(posedge i_clk)
+	if ((i_reset)||(!OPT_CFG))
+		cfg_mode <= 1'b0;
+	else if ((i_cfg_stb)&&(!o_wb_stall)&&(i_wb_we))
+		cfg_mode <= i_wb_data[CFG_MODE];
+	// }}}
+
+	// cfg_cs
+	// {{{
+	initial	cfg_cs = 1'b0;
+	always @(posedge i_clk)
+	if ((i_reset)||(!OPT_CFG))
+		cfg_cs <= 1'b0;
+	else if ((i_cfg_stb)&&(!o_wb_stall)&&(i_wb_we))
+		cfg_cs    <= (!i_wb_data[USER_CS_n])&&(i_wb_data[CFG_MODE]);
+	// }}}
+
+	// cfg_speed, cfg_dir
+	// {{{
+	initial	cfg_speed = 1'b0;
+	initial	cfg_dir   = 1'b0;
+	always @(posedge i_clk)
+	if (!OPT_CFG)
+	begin
+		cfg_speed <= 1'b0;
+		cfg_dir   <= 1'b0;
+	end else if ((i_cfg_stb)&&(!o_wb_stall)&&(i_wb_we))
+	begin
+		cfg_speed <= i_wb_data[OSPEED_BIT];
+		cfg_dir   <= i_wb_data[DIR_BIT];
+	end
+	// }}}
+	// }}}
+
+	// Make Verilator happy
+	// {{{
+	// verilator lint_off UNUSED
+	wire	unused;
+	assign	unused = &{ 1'b0, i_wb_data[31:24], i_wb_data[23:16],
+				i_wb_data[15:13], i_wb_data[10] };
+	// verilator lint_on  UNUSED
+	// }}}
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//
+// Formal properties
+// {{{
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+`ifdef	FORMAL
+	// Signal declarations
+	// {{{
+	localparam	F_MEMDONE   = RD_CLOCKS;
+	localparam	F_MEMACK    = F_MEMDONE + RDDELAY;
+	localparam	F_PIPEDONE  = PIPE_CLOCKS;
+	// Clocks of command and address, including the extra byte sent
+	// before SCK's first rising edge when !OPT_ODDR
+	localparam	F_CMDDONE   = (OPT_DTRIO ? 3 : 6) + (OPT_ODDR ? 0:1);
+	localparam	F_MAXCTR    = (F_MEMDONE > 9) ? F_MEMDONE : 9;
+	localparam	F_ACKCOUNT  = (F_MEMDONE+1+RDDELAY)
+				*(OPT_ODDR ? 1 : (OPT_CLKDIV+1));
+
+	wire	[(F_LGDEPTH-1):0]	f_nreqs, f_nacks,
+					f_outstanding;
+	reg	[31:0]		fv_addr;
+	reg	[F_MEMACK:0]	f_memread;
+	// }}}
+//
+//
+// Generic setup
+//
+//
+`ifdef	OFLEXPRESS
+`define	ASSUME	assume
+`else
+`define	ASSUME	assert
+`endif
+
+	// Keep track of a flag telling us whether or not $past()
+	// will return valid results
+	initial	f_past_valid = 1'b0;
+	always @(posedge i_clk)
+		f_past_valid = 1'b1;
+
+	always @(*)
+	if (!f_past_valid)
+       		`ASSUME(i_reset);
+
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Assumptions about our inputs
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	always @(*)
+		`ASSUME((!i_wb_stb)||(!i_cfg_stb));
+
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset))
+			&&($past(i_wb_stb))&&($past(o_wb_stall)))
+		`ASSUME(i_wb_stb);
+
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset))
+			&&($past(i_cfg_stb))&&($past(o_wb_stall)))
+		`ASSUME(i_cfg_stb);
+
+	fwb_slave #(.AW(AW), .DW(DW),.F_LGDEPTH(F_LGDEPTH),
+			.F_MAX_STALL((OPT_CLKDIV<3) ? (F_ACKCOUNT+1):0),
+			.F_MAX_ACK_DELAY((OPT_CLKDIV<3) ? F_ACKCOUNT : 0),
+			.F_OPT_RMW_BUS_OPTION(0),
+			.F_OPT_CLK2FFLOGIC(1'b0),
+			.F_OPT_DISCONTINUOUS(1))
+		f_wbm(i_clk, i_reset,
+			i_wb_cyc, (i_wb_stb)||(i_cfg_stb), i_wb_we, i_wb_addr,
+				i_wb_data, 4'hf,
+			o_wb_ack, o_wb_stall, o_wb_data, 1'b0,
+			f_nreqs, f_nacks, f_outstanding);
+
+	always @(*)
+		assert(f_outstanding <= 2 + f_extra);
+
+	always @(posedge i_clk)
+	if ((f_past_valid)&&((!$past(i_wb_stb))||($past(o_wb_stall))))
+		assert(f_outstanding <= 1 + f_extra);
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Assumptions about i_ospi_dat
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	// 1. On output, i_ospi_dat equals the input
+	// 2. Otherwise when implementing multi-cycle clocks, i_ospi_dat only
+	//	changes on a negative edge
+	// 3. With DTR, single rate transfers return the same byte in both
+	//	halves of the clock
+	//
+	(* anyseq *) reg [OW-1:0] dly_idat;
+	always @(posedge i_clk)
+	if (o_ospi_mod == NORMAL_SPI)
+	begin
+		if ((!OPT_ODDR)&&((o_ospi_sck)||(!$past(o_ospi_sck))))
+			assume($stable(dly_idat[1]));
+	end else if (o_ospi_mod == OCTAL_WRITE)
+		assume(dly_idat == o_ospi_dat);
+	else if ((!OPT_ODDR)&&((o_ospi_sck)||(!$past(o_ospi_sck))))
+		assume($stable(dly_idat));
+
+	generate if (OPT_DTRIO)
+	begin : F_DTR_IDAT
+		always @(posedge i_clk)
+		if (!dtr_mode)
+			assume(dly_idat[15:8] == dly_idat[7:0]);
+
+		always @(*)
+		if (!dtr_mode && !maintenance)
+			assert(o_ospi_dat[15:8] == o_ospi_dat[7:0]);
+	end endgenerate
+
+	generate if (RDDELAY > 0)
+	begin
+		always @(posedge i_clk)
+			assume(i_ospi_dat == $past(dly_idat,RDDELAY));
+	end else begin
+		always @(posedge i_clk)
+			assume(i_ospi_dat == dly_idat);
+	end endgenerate
+
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Maintenance mode assertions
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	always @(*)
+	if (maintenance)
+	begin
+		assume((!i_wb_stb)&&(!i_cfg_stb));
+
+		assert(f_outstanding == 0);
+
+		assert(o_wb_stall);
+		//
+		assert(clk_ctr == 0);
+		assert(cfg_mode == 1'b0);
+		assert(!o_wb_ack);
+	end
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Acknowledgments
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	always @(posedge i_clk)
+	if (dly_ack)
+		assert(clk_ctr[(OPT_DTRIO ? 0:1):0] == 0);
+
+	// Zero cycle requests
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset))&&(($past(cfg_noop))
+			||($past(i_wb_stb && i_wb_we && !o_wb_stall))))
+		assert((dly_ack)&&((!i_wb_cyc)
+			||(f_outstanding == 1 + f_extra)));
+
+	always @(posedge i_clk)
+	if ((f_outstanding > 0)&&(clk_ctr > 0))
+		assert(pre_ack);
+
+	always @(posedge i_clk)
+	if ((i_wb_cyc)&&(dly_ack))
+		assert(f_outstanding >= 1 + f_extra);
+
+	always @(*)
+	if ((i_wb_cyc)&&(pre_ack)&&(!o_ospi_cs_n))
+		assert((f_outstanding >= 1 + f_extra)||((OPT_CFG)&&(cfg_mode)));
+
+	always @(*)
+	if ((cfg_mode)&&(!dly_ack)&&(clk_ctr == 0))
+		assert(f_outstanding == f_extra);
+
+	always @(*)
+	if (cfg_mode)
+		assert(f_outstanding <= 1 + f_extra);
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Idle channel
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	//
+	always @(*)
+	if (!maintenance)
+	begin
+		if (o_ospi_cs_n)
+		begin
+			assert(clk_ctr == 0);
+			assert(o_ospi_sck  == !OPT_ODDR);
+		end else if (clk_ctr == 0)
+			assert(o_ospi_sck == !OPT_ODDR);
+	end
+
+	always @(*)
+		assert(o_ospi_mod != 2'b01);
+
+	always @(*)
+	if (clk_ctr > 6'd9)
+	begin
+		assert(!cfg_mode);
+		assert(!cfg_cs);
+	end
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Read requests
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset))&&($past(bus_request)))
+	begin
+		assert(!o_ospi_cs_n);
+		if ((OPT_ODDR)||(!$past(pipe_req)))
+			assert(o_ospi_sck == 1'b1);
+		else
+			assert(o_ospi_sck == 1'b0);
+		//
+		if (!$past(o_ospi_cs_n))
+		begin
+			assert(clk_ctr == F_PIPEDONE);
+			assert(o_ospi_mod == OCTAL_READ);
+		end else begin
+			assert(clk_ctr == F_MEMDONE);
+			assert(o_ospi_mod == OCTAL_WRITE);
+		end
+	end
+
+	always @(*)
+		assert(clk_ctr <= F_MAXCTR);
+
+	always @(*)
+	if ((OPT_ODDR)&&(!o_ospi_cs_n))
+		assert((o_ospi_sck)||(actual_sck)||(cfg_mode)||(maintenance));
+
+	always @(*)
+	if (!maintenance)
+	begin
+		if (cfg_mode)
+		begin
+			if (!cfg_cs)
+				assert(o_ospi_cs_n);
+			else if (!cfg_speed)
+				assert(o_ospi_mod == NORMAL_SPI);
+			else if ((cfg_dir)&&(clk_ctr > 0))
+				assert(o_ospi_mod == OCTAL_WRITE);
+		end else if (clk_ctr > NDUMMY + F_PIPEDONE)
+			assert(o_ospi_mod == OCTAL_WRITE);
+		else if (clk_ctr > 0)
+			assert(o_ospi_mod == OCTAL_READ);
+	end
+
+	always @(posedge i_clk)
+	if (((!OPT_PIPE)&&(clk_ctr != 0))||(clk_ctr > 6'd1))
+		assert(o_wb_stall);
+
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(OPT_CLKDIV>0)&&($past(o_ospi_cs_n)))
+		assert(o_ospi_sck);
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// User mode (setup only)
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	always @(*)
+	if ((maintenance)||(!OPT_CFG))
+		assert(!cfg_mode);
+	always @(*)
+	if ((OPT_CFG)&&(cfg_mode))
+		assert(o_ospi_cs_n == !cfg_cs);
+	else
+		assert(!cfg_cs);
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Memory reads
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	always @(posedge i_clk)
+	if (bus_request)
+		fv_addr <= w_addr;
+
+	initial	f_memread = 0;
+	always @(posedge i_clk)
+	if (i_reset)
+		f_memread <= 0;
+	else begin
+		if (ckstb)
+			f_memread <= { f_memread[F_MEMACK-1:0], 1'b0 };
+		else if ((!OPT_ODDR)&&(RDDELAY > 0))
+			f_memread[F_MEMACK:F_MEMDONE]
+				<= { f_memread[F_MEMACK-1:F_MEMDONE], 1'b0 };
+		else if (!OPT_ODDR)
+			f_memread[F_MEMACK] <= 1'b0;
+		if ((bus_request)&&(o_ospi_cs_n))
+			f_memread[0] <= 1'b1;
+	end
+
+	always @(posedge i_clk)
+	if ((OPT_ODDR)&&(|f_memread[F_MEMDONE-1:0]))
+		assert(o_ospi_sck);
+
+	always @(*)
+	if (|f_memread[F_CMDDONE-1:0])
+		assert(o_ospi_mod == OCTAL_WRITE);
+	else if (|f_memread[F_MEMDONE-1:F_CMDDONE])
+		assert(o_ospi_mod == OCTAL_READ);
+
+	always @(*)
+	if (|f_memread[F_MEMDONE-1:0])
+		assert(!o_ospi_cs_n && !cfg_mode);
+
+	// The command, its complement, and the address
+	generate if (OPT_DTRIO)
+	begin : F_DTR_ADDR
+		always @(*)
+		begin
+			if (f_memread[0])
+				assert(o_ospi_dat == OIO_READ_CMD);
+			if (f_memread[1])
+				assert(o_ospi_dat == fv_addr[31:16]);
+			if (f_memread[2])
+				assert(o_ospi_dat == fv_addr[15: 0]);
+		end
+	end else begin : F_SDR_ADDR
+		localparam	FO = (OPT_ODDR ? 0:1);
+
+		always @(*)
+		begin
+			if (f_memread[FO])
+				assert(o_ospi_dat == OIO_READ_CMD[15:8]);
+			if (f_memread[FO+1])
+				assert(o_ospi_dat == OIO_READ_CMD[ 7:0]);
+			if (f_memread[FO+2])
+				assert(o_ospi_dat == fv_addr[31:24]);
+			if (f_memread[FO+3])
+				assert(o_ospi_dat == fv_addr[23:16]);
+			if (f_memread[FO+4])
+				assert(o_ospi_dat == fv_addr[15: 8]);
+			if (f_memread[FO+5])
+				assert(o_ospi_dat == fv_addr[ 7: 0]);
+		end
+	end endgenerate
+
+	// The data returned
+	always @(posedge i_clk)
+	if ((OPT_DTRIO)&&(f_memread[F_MEMACK]))
+	begin
+		if (OPT_ENDIANSWAP)
+		begin
+			assert(o_wb_data[ 7: 0] == $past(dtr_idat[15:8],2));
+			assert(o_wb_data[15: 8] == $past(dtr_idat[ 7:0],2));
+			assert(o_wb_data[23:16] == $past(dtr_idat[15:8],1));
+			assert(o_wb_data[31:24] == $past(dtr_idat[ 7:0],1));
+		end else begin
+			assert(o_wb_data[31:16] == $past(dtr_idat,2));
+			assert(o_wb_data[15: 0] == $past(dtr_idat,1));
+		end
+	end else if ((OPT_ODDR)&&(f_memread[F_MEMACK]))
+	begin
+		if (OPT_ENDIANSWAP)
+		begin
+			assert(o_wb_data[ 7: 0] == $past(i_ospi_dat,4));
+			assert(o_wb_data[15: 8] == $past(i_ospi_dat,3));
+			assert(o_wb_data[23:16] == $past(i_ospi_dat,2));
+			assert(o_wb_data[31:24] == $past(i_ospi_dat,1));
+		end else begin
+			assert(o_wb_data[31:24] == $past(i_ospi_dat,4));
+			assert(o_wb_data[23:16] == $past(i_ospi_dat,3));
+			assert(o_wb_data[15: 8] == $past(i_ospi_dat,2));
+			assert(o_wb_data[ 7: 0] == $past(i_ospi_dat,1));
+		end
+	end else if ((OPT_ODDR)&&(|f_memread))
+	begin
+		if (!OPT_PIPE)
+			assert(o_wb_stall);
+		else if (!f_memread[F_MEMDONE-1])
+			assert(o_wb_stall);
+		assert(!o_wb_ack);
+	end
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Cover Properties
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	generate if (!OPT_STARTUP)
+	begin
+		// As with qflexpress, the startup sequence takes too many
+		// clocks for these to be reached if OPT_STARTUP is set
+		always @(posedge i_clk)
+			cover(o_wb_ack && f_memread[F_MEMACK]);
+
+		always @(posedge i_clk)
+			// Cover a piped transaction
+			cover((o_wb_ack)&&(!cfg_mode)&&(!o_ospi_cs_n));
+
+		if (OPT_CFG)
+		begin
+			always @(posedge i_clk)
+			begin
+				cover((o_wb_ack)&&(cfg_mode)&&(cfg_speed));
+				cover((o_wb_ack)&&(cfg_mode)&&(cfg_speed)
+						&&(!cfg_dir));
+				cover((o_wb_ack)&&(cfg_mode)&&(!cfg_speed));
+			end
+		end
+	end else begin
+
+		always @(posedge i_clk)
+			cover(!maintenance);
+
+	end endgenerate
+	// }}}
+`endif
+// }}}
+endmodule
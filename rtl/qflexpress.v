@@ -26,6 +26,12 @@
 //		QSPI mode.
 //	 3. Explicitly places and leaves the flash into QSPI mode
 //		0xEB 3(0x00) 0xa0 6(0x00)
+//	    or, if OPT_DTR is set, into its DTR (double transfer rate) QSPI
+//	    mode
+//		0xED 3(0x00) 0xaa ...
+//	    If OPT_QPI is set, the flash is first placed into QPI (4-4-4)
+//	    mode with a 0x38, and the read command is then sent four bits at
+//	    a time.
 //	 4. All done
 //
 // Creator:	Dan Gisselquist, Ph.D.
@@ -73,6 +79,38 @@ module	qflexpress #(
 		// where LGFLASHSZ goes up to 32.
 		parameter	LGFLASHSZ=24,
 		// }}}
+		// DW
+		// {{{
+		// DW is the width of the bus, and may be 32, 64, or 128 bits.
+		// Each bus word is read from the flash as DW/4 nibbles (DW/8
+		// bytes with OPT_DTR) of one continuous quad read, so that a
+		// wider bus pays for its request and acknowledgment only once
+		// every eight or sixteen bytes.  Pipelined reads continue from
+		// one wide word to the next as before.  The configuration port
+		// and its registers remain in the low 32 bits of the bus.
+		parameter	DW=32,
+		// }}}
+		// NCS
+		// {{{
+		// NCS is the number of flash devices attached, each with its
+		// own chip select, and may be 1, 2, 4, or 8.  All devices share
+		// SCK and the data pins, and each holds 2^LGFLASHSZ bytes.
+		// Bus addresses select a device by their top $clog2(NCS) bits,
+		// so that the devices appear one after another.  Pipelined
+		// reads never continue from one device to the next.  The
+		// configuration port selects its device by bits [15:13] of
+		// every configuration mode write, and reports it back in the
+		// same bits while in configuration mode.  The startup script
+		// (OPT_STARTUP) is sent to all devices at once.
+		//
+		// Since each device holds its own XIP mode, software may leave
+		// configuration mode between status polls while erasing or
+		// programming one device, and the CPU may go on reading (and
+		// executing from) the others at full speed in the meantime.
+		parameter	NCS=1,
+		localparam	LGNCS = (NCS > 1) ? $clog2(NCS) : 0,
+		localparam	CSW = (NCS > 1) ? LGNCS : 1,
+		// }}}
 		// OPT_PIPE
 		// {{{
 		// OPT_PIPE makes it possible to string multiple requests
@@ -107,11 +145,15 @@ module	qflexpress #(
 		// {{{
 		// Normally, I place the first byte read from the flash, and
 		// the lowest flash address, into bits [7:0], and then shift
-		// it up--to where upon return it is found in bits [31:24].
-		// This is ideal for a big endian systems, not so much for
-		// little endian systems.  The endian swap allows the bus to
-		// swap the return values in order to support little endian
-		// systems.
+		// it up--to where upon return it is found in the top byte of
+		// the bus word, bits [DW-1:DW-8].  This is ideal for a big
+		// endian systems, not so much for little endian systems.  The
+		// endian swap reverses the order of every byte in the bus
+		// word, so that the first byte read is returned in bits [7:0]
+		// instead.  On a wide bus, the first 32-bit word read is then
+		// found in the most significant bits normally, or in the least
+		// significant bits with the swap.  Configuration port reads
+		// are never swapped.
 		parameter [0:0]	OPT_ENDIANSWAP = 1'b1,
 		// }}}
 		// OPT_ODDR
@@ -142,6 +184,10 @@ module	qflexpress #(
 		// can be done with a RDDELAY=3
 		// On Intel/Altera devices, RDDELAY=2 works
 		// I'm using RDDELAY=0 for my iCE40 devices
+		//
+		// With OPT_SPEEDREG, RDDELAY is instead the largest delay that
+		// may be selected at run time.  sw/flashcal.cpp can then find
+		// the best delay for a given board by trying them all.
 		parameter	RDDELAY = 0,
 		// }}}
 		// NDUMMY
@@ -154,14 +200,205 @@ module	qflexpress #(
 		// you choose this value.
 		parameter	NDUMMY = 6,
 		// }}}
+		// OPT_DTR
+		// {{{
+		// OPT_DTR switches reads to the flash's DTR Quad I/O read,
+		// 0xED, where the address, mode byte, and data all cross the
+		// interface on both edges of SCK--two nibbles per clock.  A
+		// read of a word then takes half as many clocks, once past
+		// the dummy cycles.  In this mode, NDUMMY counts SCK cycles
+		// following the address, including the one clock of the mode
+		// byte, as the flash's data sheet does.  Commands, and
+		// anything else sent through the configuration port, remain
+		// single rate.
+		//
+		// DTR requires DDR I/O on the data pins, and so is only
+		// supported when OPT_CLKDIV == 0.  o_qspi_dat and i_qspi_dat
+		// are then each two nibbles wide: [7:4] for the first half of
+		// each clock, [3:0] for the second.  Single rate nibbles are
+		// sent in both halves, and read from [3:0].
+		parameter [0:0]	OPT_DTR = 1'b0,
+		localparam [0:0]	OPT_DTRIO = OPT_DTR && OPT_ODDR,
+		localparam		QW = OPT_DTRIO ? 8 : 4,
+		// }}}
+		// OPT_QPI
+		// {{{
+		// If set, the startup script places the flash into QPI mode
+		// (0x38), where every command--not just the quad reads--is
+		// sent four bits at a time.  Bus reads are unaffected, since
+		// they never send an opcode, but the initial read command,
+		// any read command sent to return to XIP mode after using the
+		// configuration port, and all configuration port traffic then
+		// take a quarter of the clocks.  The configuration port
+		// itself is unchanged: software must set the QSPEED bit (and
+		// WEDIR) for every byte, including the opcode.  The script
+		// first exits any QPI mode the flash might have been left in,
+		// sending 0xFF four bits at a time.
+		//
+		// Not all flash devices support QPI, and those that do
+		// differ on which command exits it and on how many dummy
+		// cycles a QPI read requires.  Check NDUMMY.
+		parameter [0:0]	OPT_QPI = 1'b0,
+		// }}}
 		// OPT_STARTUP_FILE
 		// {{{
 		// For dealing with multiple flash devices, the
 		// OPT_STARTUP_FILE allows a hex file to be provided containing
 		// the necessary script to place the design into the proper
-		// initial configuration.
+		// initial configuration.  If not given, the built-in script
+		// below is used.  The flashscript utility in sw/ will assemble
+		// these files.
 		parameter	OPT_STARTUP_FILE="",
 		// }}}
+		// LGWRAP
+		// {{{
+		// LGWRAP is the log, base two, of the length (in DW-bit bus
+		// words) of the flash's wrapped burst, or zero if wrapped
+		// bursts are not used.  Once the flash has been placed into
+		// its wrapped burst mode (Winbond's "Set burst with wrap",
+		// 0x77, with a wrap length of (DW/8)<<LGWRAP bytes), a read
+		// continues from the end of each aligned block of (1<<LGWRAP)
+		// bus words back to its beginning, rather than on to the next
+		// block.  With LGWRAP set, OPT_PIPE will then continue a read
+		// with the next bus word *within* the block, so that a master
+		// may read an entire line, critical word first, in a single
+		// transaction.  Since the wrap mode is set by a flash command,
+		// it is up to the software to set the flash's wrap length to
+		// match.
+		parameter	LGWRAP = 0,
+		// }}}
+		// SKIPAHEAD
+		// {{{
+		// With OPT_PIPE, a read only continues the last one if it is of
+		// the very next address.  SKIPAHEAD widens this window: a read
+		// of up to SKIPAHEAD words past the next address also continues
+		// the last read, clocking the flash through the words in
+		// between and discarding them.  Skipping a word costs NDATA
+		// clocks (eight at single rate, four with OPT_DTR), whereas
+		// starting over costs the address, mode, and dummy clocks
+		// (roughly 6+NDUMMY), plus the clocks CS_n must spend high.
+		// Short forward branches of a CPU fetching instructions from
+		// the flash can then be followed without a new address.  Zero,
+		// the default, disables this window.  It is also disabled when
+		// reads wrap (LGWRAP).
+		parameter	SKIPAHEAD = 0,
+		localparam [0:0]	OPT_SKIP = (OPT_PIPE)&&(SKIPAHEAD > 0)
+						&&(LGWRAP == 0),
+		localparam	LGSKIP = (OPT_SKIP) ? $clog2(SKIPAHEAD+1) : 1,
+		// }}}
+		// OPT_SPEEDREG
+		// {{{
+		// OPT_SPEEDREG adds a speed register to the configuration
+		// port, found where i_wb_addr[4:0] == SPEED_ADDR (5'h01), so
+		// that software can adjust the clock divider, the number of
+		// dummy cycles, and the read delay once the flash has been
+		// configured to run faster.  OPT_CLKDIV, NDUMMY, and RDDELAY
+		// then only set the values following a reset--the startup
+		// script always runs at OPT_CLKDIV--and OPT_CLKDIV and RDDELAY
+		// become the largest values allowed.  The register's fields
+		// are
+		//
+		//	[31:24]	The clock divider, 1--OPT_CLKDIV
+		//	[23:20]	The read delay, 0--RDDELAY
+		//	[4:0]	The dummy cycles, NDUMMY_MIN--NDUMMY_MAX
+		//
+		// Values written outside of these ranges are clipped.  While
+		// in configuration mode, bits [16:8] read back the
+		// configuration status, as with any other configuration port
+		// read.  A write stalls the bus until any read in progress has
+		// completed, and its acknowledgment has left the read delay
+		// pipeline.  The new values then take effect before the write
+		// is itself acknowledged.
+		//
+		// An ODDR clock (OPT_CLKDIV == 0) can't be divided, so only
+		// the dummy cycles and read delay may then be adjusted.  This
+		// option requires OPT_CFG.
+		parameter [0:0]	OPT_SPEEDREG = 1'b0,
+		localparam [0:0]	OPT_SPEED = OPT_SPEEDREG && OPT_CFG,
+		localparam [4:0]	SPEED_ADDR = 5'h01,
+		localparam		NDUMMY_MIN = (OPT_DTRIO) ? 1 : 2,
+		localparam		NDUMMY_MAX = (OPT_DTRIO)
+					? (24 - (OPT_ADDR32 ? 1:0))
+					: (17 - (OPT_ADDR32 ? 2:0)
+						- (OPT_ODDR ? 0:1)),
+		// }}}
+		// OPT_PERF
+		// {{{
+		// OPT_PERF adds a set of performance counters to the
+		// configuration port, found where i_wb_addr[4:0] is between
+		// PERF_ADDR (5'h08) and 5'h0d.  Each counts from the last time
+		// the counters were cleared, wrapping at 32-bits.
+		//
+		//	5'h08	Clock cycles
+		//	5'h09	Memory reads
+		//	5'h0a	Memory reads continuing the last one (OPT_PIPE)
+		//	5'h0b	Memory reads requiring a new address
+		//	5'h0c	Clock cycles where a request was stalled
+		//	5'h0d	Clock cycles spent in configuration mode
+		//
+		// Reads return a snapshot of the counters, so that they may
+		// be read one at a time without changing in between.  Writing
+		// a one to bit 0 of PERF_ADDR takes a new snapshot, and a one
+		// to bit 1 clears the counters.  Writing both does both, so
+		// that the snapshot holds the counts since the last clear.  As
+		// with the speed register, reads while in configuration mode
+		// return the configuration status in bits [16:8].  This option
+		// requires OPT_CFG.
+		parameter [0:0]	OPT_PERF = 1'b0,
+		localparam [0:0]	OPT_PERFCTR = OPT_PERF && OPT_CFG,
+		localparam [4:0]	PERF_ADDR = 5'h08,
+		// }}}
+		// OPT_REMAP
+		// {{{
+		// OPT_REMAP passes the bus address through a remapping, in
+		// units of 64kB sectors, before it is sent to the flash.  This
+		// allows a boot loader to switch between two images held in
+		// the flash, without copying either one or relinking.  The
+		// remapping is set by registers in the configuration port:
+		//
+		//	5'h02	OFFSET: Bits [LGFLASHSZ-1:16] are added to every
+		//		bus address, wrapping at the end of the flash.
+		//		Bits [15:0] are ignored.
+		//	5'h04-5'h07	REMAP windows, each
+		//		{ enable, 15'h(bus sector), 1'b0,
+		//				15'h(flash sector) }
+		//		An enabled window maps its one bus sector to the
+		//		given flash sector, in place of the OFFSET.
+		//
+		// All are cleared on reset, so the mapping starts out as it
+		// would be without this option.  Pipelined reads only continue
+		// across a sector boundary if the two sectors are also
+		// adjacent in the flash.  As with the speed register, reads
+		// while in configuration mode return the configuration status
+		// in bits [16:8].  The mapping adds an adder and NREMAP
+		// comparators to the address path.  This option requires
+		// OPT_CFG, and a flash of between 128kB and 2GB.
+		parameter [0:0]	OPT_REMAP = 1'b0,
+		localparam [0:0]	OPT_REMAPREG = OPT_REMAP && OPT_CFG
+					&& (LGFLASHSZ+LGNCS > 16)
+					&& (LGFLASHSZ+LGNCS < 32),
+		localparam [4:0]	OFFSET_ADDR = 5'h02,
+		localparam [4:0]	REMAP_ADDR = 5'h04,
+		localparam		NREMAP = 4,
+		// }}}
+		// OPT_EARLYACK
+		// {{{
+		// OPT_EARLYACK uses i_wb_sel to acknowledge a memory read as
+		// soon as the last selected byte has arrived from the flash,
+		// rather than waiting for the whole bus word.  A single rate
+		// load of the first byte of a word then returns five clocks
+		// earlier: two for each byte it no longer waits for, less one
+		// to move it into its lane.  The flash continues reading the
+		// rest of the word regardless, so that a following read of
+		// the next address may still continue the same burst
+		// (OPT_PIPE).  A read with no lanes selected reads the whole
+		// word.
+		//
+		// Without this option, i_wb_sel is ignored and every read
+		// returns a full bus word.  It may then be tied high, or
+		// left unconnected.
+		parameter [0:0]	OPT_EARLYACK = 1'b0,
+		// }}}
 		//
 		//
 		localparam [4:0]	CFG_MODE =	12,
@@ -169,6 +406,7 @@ module	qflexpress #(
 		localparam [4:0]	DSPEED_BIT = 	10, // Not supported
 		localparam [4:0]	DIR_BIT	= 	 9,
 		localparam [4:0]	USER_CS_n = 	 8,
+		localparam [4:0]	CHIP_BIT = 	13,
 		//
 		localparam [1:0]	NORMAL_SPI = 	2'b00,
 		localparam [1:0]	QUAD_WRITE = 	2'b10,
@@ -176,8 +414,19 @@ module	qflexpress #(
 		// localparam [7:0] DIO_READ_CMD = 8'hbb,
 		localparam [7:0] QIO_READ_CMD = OPT_ADDR32 ? 8'hec : 8'heb,
 		//
-		localparam	AW=LGFLASHSZ-2,
-		localparam	DW=32,
+		localparam	LGDW=$clog2(DW/8),
+		localparam	AW=LGFLASHSZ-LGDW+LGNCS,
+		// NDATA: The number of clocks (ckstb's) per bus word
+		localparam	NDATA = (OPT_DTRIO) ? (DW/8) : (DW/4),
+		// CTRW: The width of clk_ctr, wide enough for the longest
+		// read, or for a continued read that skips SKIPAHEAD words
+		localparam	CTRW_READ = (DW > 32) ? 6 : 5,
+		localparam	CTRW_SKIP = $clog2(NDATA*(SKIPAHEAD+1)+1),
+		localparam	CTRW = (CTRW_SKIP > CTRW_READ) ? CTRW_SKIP
+						: CTRW_READ,
+		localparam [AW-1:0]	WRAP_MASK = (LGWRAP == 0)
+						? ((1<<(AW-LGNCS))-1)
+						: ((1<<LGWRAP)-1)
 `ifdef	FORMAL
 		, localparam	F_LGDEPTH=$clog2(3+RDDELAY+(OPT_ADDR32 ? 2:0))
 `endif
@@ -196,10 +445,15 @@ module	qflexpress #(
 		output	reg	[(DW-1):0]	o_wb_data,
 		//
 		output	reg		o_qspi_sck,
-		output	reg		o_qspi_cs_n,
+		output	wire	[NCS-1:0]	o_qspi_cs_n,
 		output	reg	[1:0]	o_qspi_mod,
-		output	wire	[3:0]	o_qspi_dat,
-		input	wire	[3:0]	i_qspi_dat
+		output	wire	[QW-1:0]	o_qspi_dat,
+		input	wire	[QW-1:0]	i_qspi_dat,
+		//
+		// The bus byte selects, placed last so that they may be left
+		// off of any positional port list.  Only used with
+		// OPT_EARLYACK, and ignored otherwise.
+		input	wire	[(DW/8-1):0]	i_wb_sel
 		//
 		// Debugging port (if used)
 		// , output	wire		o_dbg_trigger,
@@ -217,9 +471,50 @@ module	qflexpress #(
 	// clk_ctr must have enough bits for ...
 	//	8		address clocks, 4-bits each
 	//	NDUMMY		dummy clocks, including two mode bytes
-	//	8		data clocks
+	//	NDATA		data clocks, 8 for a 32-bit bus
 	//	(RDDELAY clocks not counted here)
-	reg	[4:0]	clk_ctr;
+	reg	[CTRW-1:0]	clk_ctr;
+
+	//
+	// Speed register (OPT_SPEEDREG)
+	//
+	reg	[7:0]	r_clkdiv;
+	reg	[4:0]	r_ndummy;
+	reg	[3:0]	r_rddelay;
+	reg		speed_pending, rd_idle;
+	wire		speed_sel, speed_stb, speed_write, speed_apply;
+
+	//
+	// Performance counters (OPT_PERF)
+	//
+	wire		perf_sel, perf_stb, perf_write;
+	wire	[31:0]	perf_data;
+
+	//
+	// Address remapping (OPT_REMAP)
+	//
+	wire		remap_sel, remap_stb, remap_write;
+	wire	[31:0]	remap_data;
+	wire	[AW-1:0]	flash_addr;
+
+	//
+	// Chip selects (NCS)
+	//
+	// qspi_cs_n is low whenever any one device is selected, and cs_chip
+	// holds the number of that device
+	reg			qspi_cs_n;
+	wire	[CSW-1:0]	cs_chip;
+
+	//
+	// Early acknowledgments (OPT_EARLYACK)
+	//
+	// sel_skip is the number of bytes of the current word following the
+	// last one selected.  dly_skip and fix_skip follow the read pipeline,
+	// nonzero when the last selected byte has just been read.
+	wire	[LGDW-1:0]	sel_skip;
+	wire	[CTRW-1:0]	skip_clocks;
+	reg	[LGDW-1:0]	dly_skip, fix_skip;
+	reg			early_ack;
 
 	//
 	// User override logic
@@ -227,13 +522,36 @@ module	qflexpress #(
 	reg	cfg_mode, cfg_speed, cfg_dir, cfg_cs;
 	wire	cfg_write, cfg_hs_write, cfg_ls_write, cfg_hs_read,
 		user_request, bus_request, pipe_req, cfg_noop, cfg_stb;
+	// pipe_skip: The number of words a continued read skips (SKIPAHEAD)
+	wire	[LGSKIP-1:0]	pipe_skip;
+	wire			skip_next;
 	//
 	assign	bus_request  = (i_wb_stb)&&(!o_wb_stall)
 					&&(!i_wb_we)&&(!cfg_mode);
-	assign	cfg_stb      = (OPT_CFG)&&(i_cfg_stb)&&(!o_wb_stall);
+	assign	speed_sel    = (OPT_SPEED)&&(i_wb_addr[4:0] == SPEED_ADDR);
+	assign	speed_stb    = (OPT_SPEED)&&(i_cfg_stb)&&(!o_wb_stall)
+					&&(speed_sel);
+	assign	speed_write  = (speed_stb)&&(i_wb_we);
+	assign	perf_sel     = (OPT_PERFCTR)
+				&&(i_wb_addr[4:3] == PERF_ADDR[4:3])
+				&&(i_wb_addr[2:1] != 2'b11);
+	assign	perf_stb     = (OPT_PERFCTR)&&(i_cfg_stb)&&(!o_wb_stall)
+					&&(perf_sel);
+	assign	perf_write   = (perf_stb)&&(i_wb_we)
+					&&(i_wb_addr[2:0] == PERF_ADDR[2:0]);
+	assign	remap_sel    = (OPT_REMAPREG)
+				&&((i_wb_addr[4:0] == OFFSET_ADDR)
+				||(i_wb_addr[4:2] == REMAP_ADDR[4:2]));
+	assign	remap_stb    = (OPT_REMAPREG)&&(i_cfg_stb)&&(!o_wb_stall)
+					&&(remap_sel);
+	assign	remap_write  = (remap_stb)&&(i_wb_we);
+	assign	cfg_stb      = (OPT_CFG)&&(i_cfg_stb)&&(!o_wb_stall)
+					&&(!speed_sel)&&(!perf_sel)&&(!remap_sel);
 	assign	cfg_noop     = ((cfg_stb)&&((!i_wb_we)||(!i_wb_data[CFG_MODE])
 					||(i_wb_data[USER_CS_n])))
-				||((!OPT_CFG)&&(i_cfg_stb)&&(!o_wb_stall));
+				||((!OPT_CFG)&&(i_cfg_stb)&&(!o_wb_stall))
+				||((speed_stb)&&(!i_wb_we))||(perf_stb)
+				||(remap_stb);
 	assign	user_request = (cfg_stb)&&(i_wb_we)&&(i_wb_data[CFG_MODE]);
 
 	assign	cfg_write    = (user_request)&&(!i_wb_data[USER_CS_n]);
@@ -255,6 +573,15 @@ module	qflexpress #(
 	reg	pre_ack = 1'b0;
 	reg	actual_sck;
 
+	// dtr_mode: bus reads, when DTR is enabled, move two nibbles per
+	// clock.  Everything else moves one nibble at a time, in sdr_odat and
+	// sdr_idat.
+	wire		dtr_mode;
+	wire	[3:0]	sdr_odat, sdr_idat;
+	wire	[7:0]	dtr_idat;
+
+	assign	dtr_mode = (OPT_DTRIO)&&(!maintenance)&&(!cfg_mode);
+
 	// }}}
 
 	////////////////////////////////////////////////////////////////////////
@@ -289,7 +616,7 @@ module	qflexpress #(
 			clk_counter <= 1'b0;
 		else if (bus_request)
 			clk_counter <= (pipe_req);
-		else if ((maintenance)||(!o_qspi_cs_n && o_wb_stall))
+		else if ((maintenance)||(!qspi_cs_n && o_wb_stall))
 			clk_counter <= 1'b1;
 
 		always @(*)
@@ -302,7 +629,10 @@ module	qflexpress #(
 		// }}}
 	end else begin : CKSTB_GEN
 		// {{{
+		// The divider is r_clkdiv, which only differs from OPT_CLKDIV
+		// when the speed register (OPT_SPEEDREG) has been written
 		reg	[CKDV_BITS-1:0]	clk_counter;
+		reg			gen_pre, gen_stb, gen_pos;
 
 		initial	clk_counter = OPT_CLKDIV;
 		always @(posedge i_clk)
@@ -311,28 +641,41 @@ module	qflexpress #(
 		else if (clk_counter != 0)
 			clk_counter <= clk_counter - 1;
 		else if (bus_request)
-			clk_counter <= (pipe_req ? OPT_CLKDIV : 0);
-		else if ((maintenance)||(!o_qspi_cs_n && o_wb_stall))
-			clk_counter <= OPT_CLKDIV;
+			clk_counter <= (pipe_req ? r_clkdiv[CKDV_BITS-1:0] : 0);
+		else if ((maintenance)||(!qspi_cs_n && o_wb_stall))
+			clk_counter <= r_clkdiv[CKDV_BITS-1:0];
 
-		initial	ckpre = (OPT_CLKDIV == 1);
-		initial	ckstb = 1'b0;
-		initial	ckpos = (OPT_CLKDIV == 1);
+		initial	gen_pre = 1'b0;
+		initial	gen_stb = 1'b0;
+		initial	gen_pos = 1'b0;
 		always @(posedge i_clk)
 		if (i_reset)
 		begin
-			ckpre <= (OPT_CLKDIV == 1);
-			ckstb <= 1'b0;
-			ckpos <= (OPT_CLKDIV == 1);
-		end else // if (OPT_CLKDIV > 1)
+			gen_pre <= 1'b0;
+			gen_stb <= 1'b0;
+			gen_pos <= 1'b0;
+		end else // if (r_clkdiv > 1)
 		begin
-			ckpre <= (clk_counter == 2);
-			ckstb <= (clk_counter == 1);
-			ckpos <= (clk_counter == (OPT_CLKDIV+1)/2+1);
+			gen_pre <= (clk_counter == 2);
+			gen_stb <= (clk_counter == 1);
+			gen_pos <= (clk_counter == (r_clkdiv+1)/2+1);
 		end
 
+		// A divider of one, selected at run time, can't use the
+		// registered strobes above, and so it uses those of CKSTB_ONE
 		always @(*)
-			ckneg = ckstb;
+		if ((OPT_SPEED)&&(r_clkdiv == 1))
+		begin
+			ckpre = (clk_counter == 1);
+			ckstb = (clk_counter == 0);
+			ckpos = (clk_counter == 1);
+			ckneg = (clk_counter == 0);
+		end else begin
+			ckpre = gen_pre;
+			ckstb = gen_stb;
+			ckpos = gen_pos;
+			ckneg = gen_stb;
+		end
 `ifdef	FORMAL
 		always @(*)
 			assert(!ckpos || !ckneg);
@@ -365,6 +708,9 @@ module	qflexpress #(
 `else
 		localparam	M_FIRSTIDX=0;
 `endif
+		// The mode the read command is sent in
+		localparam [1:0]	M_CMDMOD = (OPT_QPI) ? QUAD_WRITE
+							: NORMAL_SPI;
 		reg	[M_WAITBIT:0]	m_this_word;
 		reg	[M_WAITBIT:0]	m_cmd_word	[0:(1<<M_LGADDR)-1];
 		reg	[M_LGADDR-1:0]	m_cmd_index;
@@ -404,87 +750,172 @@ module	qflexpress #(
 		//			mode, or 4-bits at a time in QUAD_WRITE
 		//			mode.  Ignored otherwis
 		// }}}
-		integer k;
-		initial
-		// if (OPT_STARTUP_FILE)
-		//	$readmemh(OPT_STARTUP_FILE, m_cmd_word); else
-		begin
-		// {{{
-		for(k=0; k<(1<<M_LGADDR); k=k+1)
-			m_cmd_word[k] = -1;
-		// cmd_word= m_ctr_flag, m_mod[1:0],
-		//			m_cs_n, m_clk, m_data[3:0]
-		// Start off idle
-		//	This is really redundant since all of our commands are
-		//	idle's.
-		m_cmd_word[5'h07] = -1;
-		//
-		// Since we don't know what mode we started in, whether the
-		// device was left in XIP mode or some other mode, we'll start
-		// by exiting any mode we might have been in.
-		//
-		// The key to doing this is to issue a non-command, that can
-		// also be interpreted as an XIP address with an incorrect
-		// mode bit.  That will get us out of any XIP mode, and back
-		// into a SPI mode we might use.  The command is issued in
-		// NORMAL_SPI mode, however, since we don't know if the device
-		// is initially in XIP or not.
-		//
-		// Exit any QSPI mode we might've been in
-		m_cmd_word[5'h08] = { 1'b0, NORMAL_SPI, 8'hff }; // Addr 1
-		m_cmd_word[5'h09] = { 1'b0, NORMAL_SPI, 8'hff }; // Addr 2
-		m_cmd_word[5'h0a] = { 1'b0, NORMAL_SPI, 8'hff }; // Addr 2
-		// Idle
-		m_cmd_word[5'h0b] = { 1'b1, 10'h3f };
-		//
-		// Write configuration register
-		//
-		// The write enable must come first: 06
-		m_cmd_word[5'h0c] = { 1'b0, NORMAL_SPI, 8'h06 };
-		//
-		// Idle
-		m_cmd_word[5'h0d] = { 1'b1, 10'h3ff };
-		//
-		// Write configuration register, follows a write-register
-		m_cmd_word[5'h0e] = { 1'b0, NORMAL_SPI, 8'h01 };	// WRR
-		m_cmd_word[5'h0f] = { 1'b0, NORMAL_SPI, 8'h00 };	// status register
-		m_cmd_word[5'h10] = { 1'b0, NORMAL_SPI, 8'h02 };	// Config register
-		//
-		// Idle
-		m_cmd_word[5'h11] = { 1'b1, 10'h3ff };
-		m_cmd_word[5'h12] = { 1'b1, 10'h3ff };
-		//
-		//
-		// WRDI: write disable: 04
-		m_cmd_word[5'h13] = { 1'b0, NORMAL_SPI, 8'h04 };
-		//
-		// Idle
-		m_cmd_word[5'h14] = { 1'b1, 10'h3ff };
-		//
-		// Enter into QSPI mode, 0xeb, 0,0,0
-		// 0xeb
-		m_cmd_word[5'h15] = { 1'b0, NORMAL_SPI, 8'heb };
-		// Addr #1
-		m_cmd_word[5'h16] = { 1'b0, QUAD_WRITE, 8'h00 };
-		// Addr #2
-		m_cmd_word[5'h17] = { 1'b0, QUAD_WRITE, 8'h00 };
-		// Addr #3
-		m_cmd_word[5'h18] = { 1'b0, QUAD_WRITE, 8'h00 };
-		// Mode byte
-		m_cmd_word[5'h19] = { 1'b0, QUAD_WRITE, 8'ha0 };
-		// Dummy clocks, x6 for this flash
-		m_cmd_word[5'h1a] = { 1'b0, QUAD_WRITE, 8'h00 };
-		m_cmd_word[5'h1b] = { 1'b0, QUAD_WRITE, 8'h00 };
-		m_cmd_word[5'h1c] = { 1'b0, QUAD_WRITE, 8'h00 };
-		// Now read a byte for form
-		m_cmd_word[5'h1d] = { 1'b0, QUAD_READ, 8'h00 };
-		//
-		// Idle -- These last two idles are *REQUIRED* and not optional
-		// (although they might be able to be trimmed back a bit...)
-		m_cmd_word[5'h1e] = -1;
-		m_cmd_word[5'h1f] = -1;
-		// Then we are in business!
-		// }}}
+		if (OPT_STARTUP_FILE != 0)
+		begin : LOAD_STARTUP_FILE
+			// {{{
+			// A script loaded from a file replaces the one below.
+			// It must hold all 32 words, in the format above, and
+			// the last two must be maximum length idles.  The
+			// flashscript utility, found in sw/, will assemble one
+			// for you.
+			initial	$readmemh(OPT_STARTUP_FILE, m_cmd_word);
+			// }}}
+		end else begin : DEFAULT_STARTUP
+			integer k;
+			initial begin
+				// {{{
+				for(k=0; k<(1<<M_LGADDR); k=k+1)
+					m_cmd_word[k] = -1;
+				// cmd_word= m_ctr_flag, m_mod[1:0],
+				//			m_cs_n, m_clk, m_data[3:0]
+				// Start off idle
+				//	This is really redundant since all of our commands are
+				//	idle's.
+				m_cmd_word[5'h07] = -1;
+				//
+				// Since we don't know what mode we started in, whether the
+				// device was left in XIP mode or some other mode, we'll start
+				// by exiting any mode we might have been in.
+				//
+				// The key to doing this is to issue a non-command, that can
+				// also be interpreted as an XIP address with an incorrect
+				// mode bit.  That will get us out of any XIP mode, and back
+				// into a SPI mode we might use.  The command is issued in
+				// NORMAL_SPI mode, however, since we don't know if the device
+				// is initially in XIP or not.
+				//
+				// Exit any QSPI mode we might've been in
+				m_cmd_word[5'h08] = { 1'b0, NORMAL_SPI, 8'hff }; // Addr 1
+				m_cmd_word[5'h09] = { 1'b0, NORMAL_SPI, 8'hff }; // Addr 2
+				m_cmd_word[5'h0a] = { 1'b0, NORMAL_SPI, 8'hff }; // Addr 2
+				// Idle
+				m_cmd_word[5'h0b] = { 1'b1, 10'h3f };
+				//
+				// Write configuration register
+				//
+				// The write enable must come first: 06
+				m_cmd_word[5'h0c] = { 1'b0, NORMAL_SPI, 8'h06 };
+				//
+				// Idle
+				m_cmd_word[5'h0d] = { 1'b1, 10'h3ff };
+				//
+				// Write configuration register, follows a write-register
+				m_cmd_word[5'h0e] = { 1'b0, NORMAL_SPI, 8'h01 };	// WRR
+				m_cmd_word[5'h0f] = { 1'b0, NORMAL_SPI, 8'h00 };	// status register
+				m_cmd_word[5'h10] = { 1'b0, NORMAL_SPI, 8'h02 };	// Config register
+				//
+				// Idle
+				m_cmd_word[5'h11] = { 1'b1, 10'h3ff };
+				m_cmd_word[5'h12] = { 1'b1, 10'h3ff };
+				//
+				//
+				// WRDI: write disable: 04
+				m_cmd_word[5'h13] = { 1'b0, NORMAL_SPI, 8'h04 };
+				//
+				// Idle
+				m_cmd_word[5'h14] = { 1'b1, 10'h3ff };
+				//
+				if (OPT_QPI)
+				begin
+					// {{{
+					// Replace the above with a QPI script.  It is three
+					// words longer, and so it starts three words early,
+					// at 5'h05, cutting into the initial idle.
+					//
+					// Exit any XIP mode we might have been in, whether
+					// in QPI or not.  Eight clocks, four bits at a time,
+					// cover the address and an invalid mode byte.  In
+					// (non-XIP) SPI mode, the 0xff command is ignored.
+					m_cmd_word[5'h05] = { 1'b0, QUAD_WRITE, 8'hff };
+					m_cmd_word[5'h06] = { 1'b0, QUAD_WRITE, 8'hff };
+					m_cmd_word[5'h07] = { 1'b0, QUAD_WRITE, 8'hff };
+					m_cmd_word[5'h08] = { 1'b0, QUAD_WRITE, 8'hff };
+					// Idle
+					m_cmd_word[5'h09] = { 1'b1, 10'h3f };
+					//
+					// Exit QPI mode, 0xff four bits at a time.  A device
+					// in SPI mode sees only two bits of it, and ignores
+					// them.
+					m_cmd_word[5'h0a] = { 1'b0, QUAD_WRITE, 8'hff };
+					// Idle
+					m_cmd_word[5'h0b] = { 1'b1, 10'h3f };
+					//
+					// Write enable, then write the status and
+					// configuration registers to set the QUAD bit, as
+					// below.  The WRDI is left out, since the WEL bit
+					// is cleared once the write completes.
+					m_cmd_word[5'h0c] = { 1'b0, NORMAL_SPI, 8'h06 };
+					// Idle
+					m_cmd_word[5'h0d] = { 1'b1, 10'h3ff };
+					m_cmd_word[5'h0e] = { 1'b0, NORMAL_SPI, 8'h01 };	// WRR
+					m_cmd_word[5'h0f] = { 1'b0, NORMAL_SPI, 8'h00 };	// status register
+					m_cmd_word[5'h10] = { 1'b0, NORMAL_SPI, 8'h02 };	// Config register
+					// Idle
+					m_cmd_word[5'h11] = { 1'b1, 10'h3ff };
+					m_cmd_word[5'h12] = { 1'b1, 10'h3ff };
+					//
+					// Enter QPI mode: 0x38
+					m_cmd_word[5'h13] = { 1'b0, NORMAL_SPI, 8'h38 };
+					// Idle
+					m_cmd_word[5'h14] = { 1'b1, 10'h3f };
+					// }}}
+				end
+				//
+				if (OPT_DTRIO)
+				begin
+					// {{{
+					// Enter into DTR QSPI mode, 0xed, 0,0,0
+					//
+					// Everything after the command goes out on both clock
+					// edges, whereas this script sends its nibbles at one
+					// per clock.  Each nibble is therefore seen twice, so
+					// one QUAD_WRITE byte carries four nibbles of address.
+					// The zero address then takes the first three nibbles
+					// of 0x00,0x0a, leaving the 0xa to become a 0xaa mode
+					// byte--one the flash still takes as staying in XIP.
+					m_cmd_word[5'h15] = { 1'b0, M_CMDMOD, 8'hed };
+					// Addr #1, #2, and half of #3
+					m_cmd_word[5'h16] = { 1'b0, QUAD_WRITE, 8'h00 };
+					// The rest of addr #3, then the mode byte
+					m_cmd_word[5'h17] = { 1'b0, QUAD_WRITE, 8'h0a };
+					// Dummy clocks
+					m_cmd_word[5'h18] = { 1'b0, QUAD_WRITE, 8'h00 };
+					m_cmd_word[5'h19] = { 1'b0, QUAD_READ,  8'h00 };
+					m_cmd_word[5'h1a] = { 1'b0, QUAD_READ,  8'h00 };
+					m_cmd_word[5'h1b] = { 1'b0, QUAD_READ,  8'h00 };
+					m_cmd_word[5'h1c] = { 1'b0, QUAD_READ,  8'h00 };
+					// Now read a byte for form
+					m_cmd_word[5'h1d] = { 1'b0, QUAD_READ, 8'h00 };
+					// }}}
+				end else begin
+					// {{{
+					// Enter into QSPI mode, 0xeb, 0,0,0
+					// 0xeb
+					m_cmd_word[5'h15] = { 1'b0, M_CMDMOD, 8'heb };
+					// Addr #1
+					m_cmd_word[5'h16] = { 1'b0, QUAD_WRITE, 8'h00 };
+					// Addr #2
+					m_cmd_word[5'h17] = { 1'b0, QUAD_WRITE, 8'h00 };
+					// Addr #3
+					m_cmd_word[5'h18] = { 1'b0, QUAD_WRITE, 8'h00 };
+					// Mode byte
+					m_cmd_word[5'h19] = { 1'b0, QUAD_WRITE, 8'ha0 };
+					// Dummy clocks, x6 for this flash
+					m_cmd_word[5'h1a] = { 1'b0, QUAD_WRITE, 8'h00 };
+					m_cmd_word[5'h1b] = { 1'b0, QUAD_WRITE, 8'h00 };
+					m_cmd_word[5'h1c] = { 1'b0, QUAD_WRITE, 8'h00 };
+					// Now read a byte for form
+					m_cmd_word[5'h1d] = { 1'b0, QUAD_READ, 8'h00 };
+					// }}}
+				end
+				//
+				// Idle -- These last two idles are *REQUIRED* and not optional
+				// (although they might be able to be trimmed back a bit...)
+				m_cmd_word[5'h1e] = -1;
+				m_cmd_word[5'h1f] = -1;
+				// Then we are in business!
+				// }}}
+			end
 		end
 
 		reg	m_final;
@@ -796,7 +1227,7 @@ module	qflexpress #(
 			assert(m_mod == f_last_word[9:8]);
 			assert(m_midcount == 1'b0);
 
-		end else if (maintenance && o_qspi_cs_n)
+		end else if (maintenance && qspi_cs_n)
 		begin
 			assert(f_last_word[M_WAITBIT]);
 			assert(m_counter <= f_last_word[M_WAITBIT-1:0]);
@@ -877,7 +1308,8 @@ module	qflexpress #(
 			data_pipe <= 0;
 
 			data_pipe[8+LGFLASHSZ-1:0] <= {
-					i_wb_addr, 2'b00, 4'ha, 4'h0 };
+				flash_addr[AW-LGNCS-1:0], {(LGDW){1'b0}},
+				4'ha, 4'h0 };
 
 			if (i_cfg_stb)
 				// High speed configuration I/O
@@ -898,7 +1330,9 @@ module	qflexpress #(
 				data_pipe[ 4+(OPT_ADDR32 ? 8:0)]<= i_wb_data[1];
 				data_pipe[ 0+(OPT_ADDR32 ? 8:0)]<= i_wb_data[0];
 			end
-		end else if (ckstb)
+		end else if ((ckstb)&&(dtr_mode))
+			data_pipe <= { data_pipe[(24+(OPT_ADDR32 ? 8:0)+4*(OPT_ODDR ? 0:1))-1:0], 8'h0 };
+		else if (ckstb)
 			data_pipe <= { data_pipe[(32+(OPT_ADDR32 ? 8:0)+4*((OPT_ODDR ? 0:1)-1))-1:0], 4'h0 };
 
 		if (maintenance)
@@ -906,7 +1340,23 @@ module	qflexpress #(
 	end
 	// }}}
 
-	assign	o_qspi_dat = data_pipe[28+(OPT_ADDR32 ? 8:0)+4*(OPT_ODDR ? 0:1) +: 4];
+	assign	sdr_odat = data_pipe[28+(OPT_ADDR32 ? 8:0)+4*(OPT_ODDR ? 0:1) +: 4];
+
+	// o_qspi_dat, sdr_idat
+	// {{{
+	generate if (OPT_DTRIO)
+	begin : GEN_DTR_DATA
+		assign	o_qspi_dat = (dtr_mode)
+				? data_pipe[24+(OPT_ADDR32 ? 8:0) +: 8]
+				: { sdr_odat, sdr_odat };
+		assign	sdr_idat = i_qspi_dat[3:0];
+		assign	dtr_idat = i_qspi_dat;
+	end else begin : GEN_SDR_DATA
+		assign	o_qspi_dat = sdr_odat;
+		assign	sdr_idat = i_qspi_dat;
+		assign	dtr_idat = 8'h0;
+	end endgenerate
+	// }}}
 
 	// pre_ack
 	// {{{
@@ -917,7 +1367,7 @@ module	qflexpress #(
 	always @(posedge i_clk)
 	if ((i_reset)||(!i_wb_cyc))
 		pre_ack <= 1'b0;
-	else if ((bus_request)||(cfg_write))
+	else if ((bus_request)||(cfg_write)||(speed_write))
 		pre_ack <= 1'b1;
 	// }}}
 
@@ -927,19 +1377,32 @@ module	qflexpress #(
 	begin : OPT_PIPE_BLOCK
 		// {{{
 		reg	r_pipe_req;
-		wire	w_pipe_condition;
+		wire	w_pipe_condition, w_skip_window;
+		reg	[LGSKIP-1:0]	r_pipe_skip;
 
+		// The next address, wrapping within the burst if LGWRAP is
+		// set, or otherwise within the current device (NCS).  This is
+		// kept in the flash's address space, following any remapping
+		// (OPT_REMAP).
 		reg	[(AW-1):0]	next_addr;
 		always  @(posedge i_clk)
 		if (!o_wb_stall)
-			next_addr <= i_wb_addr + 1'b1;
+			next_addr <= (flash_addr & ~WRAP_MASK)
+					| ((flash_addr + 1'b1) & WRAP_MASK);
+
+		// The skip ahead window (SKIPAHEAD): a read within SKIPAHEAD
+		// words past the next address may also continue this one
+		wire	[(AW-1):0]	w_gap;
+
+		assign	w_gap = flash_addr - next_addr;
+		assign	w_skip_window = (OPT_SKIP)&&(w_gap <= SKIPAHEAD);
 
 		assign	w_pipe_condition = (i_wb_stb)&&(!i_wb_we)&&(pre_ack)
 				&&(!maintenance)
 				&&(!cfg_mode)
-				&&(!o_qspi_cs_n)
-				&&(|clk_ctr[2:0])
-				&&(next_addr == i_wb_addr);
+				&&(!qspi_cs_n)
+				&&(|clk_ctr[(OPT_DTRIO ? 1:2):0])
+				&&((next_addr == flash_addr)||(w_skip_window));
 
 		initial	r_pipe_req = 1'b0;
 		always @(posedge i_clk)
@@ -948,10 +1411,25 @@ module	qflexpress #(
 		else
 			r_pipe_req <= w_pipe_condition;
 
-		assign	pipe_req = r_pipe_req;
+		// r_pipe_skip
+		// {{{
+		initial	r_pipe_skip = 0;
+		always @(posedge i_clk)
+		if ((OPT_SKIP)&&(w_pipe_condition)&&(w_skip_window))
+			r_pipe_skip <= w_gap[LGSKIP-1:0];
+		else
+			r_pipe_skip <= 0;
+		// }}}
+
+		assign	pipe_req  = r_pipe_req;
+		assign	pipe_skip = r_pipe_skip;
+		assign	skip_next = (w_pipe_condition)&&(w_skip_window)
+					&&(next_addr != flash_addr);
 		// }}}
 	end else begin
-		assign	pipe_req = 1'b0;
+		assign	pipe_req  = 1'b0;
+		assign	pipe_skip = 0;
+		assign	skip_next = 1'b0;
 	end endgenerate
 	// }}}
 
@@ -965,11 +1443,18 @@ module	qflexpress #(
 		// Notice that this is only for
 		// regular bus reads, and so the check for
 		// !pipe_req
-		clk_ctr <= 5'd14 + NDUMMY + (OPT_ADDR32 ? 2:0)+(OPT_ODDR ? 0:1);
+		clk_ctr <= (OPT_DTRIO) ? (3 + NDATA + r_ndummy
+						+ (OPT_ADDR32 ? 1:0))
+			: (6 + NDATA + r_ndummy + (OPT_ADDR32 ? 2:0)
+						+ (OPT_ODDR ? 0:1));
 	else if (bus_request) // && pipe_req
 		// Otherwise, if this is a piped read, we'll
-		// reset the counter back to eight.
-		clk_ctr <= 5'd8;
+		// reset the counter back to eight--or four clocks
+		// if the data comes two nibbles at a time, or more
+		// for a wider bus--plus as many again for every word
+		// skipped (SKIPAHEAD).  Only the last word read remains
+		// in o_wb_data.
+		clk_ctr <= NDATA + NDATA * pipe_skip;
 	else if (cfg_ls_write)
 		clk_ctr <= 5'd8 + ((OPT_ODDR) ? 0:1);
 	else if (cfg_write)
@@ -996,12 +1481,12 @@ module	qflexpress #(
 		if ((cfg_mode)&&(clk_ctr <= 1))
 			// Config mode has no pipe instructions
 			o_qspi_sck <= 1'b0;
-		else if (clk_ctr[4:0] > 5'd1)
+		else if (clk_ctr > 1)
 			o_qspi_sck <= 1'b1;
 		else
 			o_qspi_sck <= 1'b0;
 		// }}}
-	end else if (((ckpos)&&(!o_qspi_sck))||(o_qspi_cs_n))
+	end else if (((ckpos)&&(!o_qspi_sck))||(qspi_cs_n))
 	begin
 		o_qspi_sck <= 1'b1;
 	end else if ((ckneg)&&(o_qspi_sck))
@@ -1010,7 +1495,7 @@ module	qflexpress #(
 		if ((cfg_mode)&&(clk_ctr <= 1))
 			// Config mode has no pipe instructions
 			o_qspi_sck <= 1'b1;
-		else if (clk_ctr[4:0] > 5'd1)
+		else if (clk_ctr > 1)
 			o_qspi_sck <= 1'b0;
 		else
 			o_qspi_sck <= 1'b1;
@@ -1018,22 +1503,100 @@ module	qflexpress #(
 	end
 	// }}}
 
-	// o_qspi_cs_n
+	// qspi_cs_n
 	// {{{
-	initial	o_qspi_cs_n = 1'b1;
+	initial	qspi_cs_n = 1'b1;
 	always @(posedge i_clk)
 	if (i_reset)
-		o_qspi_cs_n <= 1'b1;
+		qspi_cs_n <= 1'b1;
 	else if (maintenance)
-		o_qspi_cs_n <= m_cs_n;
+		qspi_cs_n <= m_cs_n;
 	else if ((cfg_stb)&&(i_wb_we))
-		o_qspi_cs_n <= (!i_wb_data[CFG_MODE])||(i_wb_data[USER_CS_n]);
+		qspi_cs_n <= (!i_wb_data[CFG_MODE])||(i_wb_data[USER_CS_n]);
 	else if ((OPT_CFG)&&(cfg_cs))
-		o_qspi_cs_n <= 1'b0;
+		qspi_cs_n <= 1'b0;
 	else if ((bus_request)||(cfg_write))
-		o_qspi_cs_n <= 1'b0;
+		qspi_cs_n <= 1'b0;
 	else if (ckstb)
-		o_qspi_cs_n <= (clk_ctr <= 1);
+		qspi_cs_n <= (clk_ctr <= 1);
+	// }}}
+
+	// o_qspi_cs_n, cs_chip
+	// {{{
+	generate if (NCS > 1)
+	begin : GEN_CHIPSEL
+		// {{{
+		localparam [NCS-1:0]	CS_ONE = 1;
+		wire	[LGNCS-1:0]	w_bus_chip, w_cfg_chip;
+		reg	[LGNCS-1:0]	r_chip;
+		reg	[NCS-1:0]	r_cs_n;
+
+		assign	w_bus_chip = flash_addr[AW-1 -: LGNCS];
+		assign	w_cfg_chip = i_wb_data[CHIP_BIT +: LGNCS];
+
+		// r_chip
+		// {{{
+		// Memory reads select their device from the address, and
+		// configuration mode writes from bits [15:13].  A pipelined
+		// read always stays within the same device.
+		initial	r_chip = 0;
+		always @(posedge i_clk)
+		if ((i_reset)||(maintenance))
+			r_chip <= 0;
+		else if (user_request)
+			r_chip <= w_cfg_chip;
+		else if (bus_request)
+			r_chip <= w_bus_chip;
+		// }}}
+
+		// r_cs_n
+		// {{{
+		// This follows qspi_cs_n above, step for step, lowering only
+		// the chip select of the selected device--or all of them
+		// during the startup sequence
+		initial	r_cs_n = -1;
+		always @(posedge i_clk)
+		if (i_reset)
+			r_cs_n <= -1;
+		else if (maintenance)
+			r_cs_n <= {(NCS){m_cs_n}};
+		else if ((cfg_stb)&&(i_wb_we))
+			r_cs_n <= ((!i_wb_data[CFG_MODE])
+					||(i_wb_data[USER_CS_n]))
+				? {(NCS){1'b1}} : ~(CS_ONE << w_cfg_chip);
+		else if ((OPT_CFG)&&(cfg_cs))
+			r_cs_n <= ~(CS_ONE << r_chip);
+		else if (bus_request)
+			r_cs_n <= ~(CS_ONE << w_bus_chip);
+		else if (ckstb)
+			r_cs_n <= (clk_ctr <= 1) ? {(NCS){1'b1}}
+				: ~(CS_ONE << r_chip);
+		// }}}
+
+		assign	o_qspi_cs_n = r_cs_n;
+		assign	cs_chip     = r_chip;
+
+`ifdef	FORMAL
+		always @(*)
+		if (maintenance)
+			assert(r_cs_n == {(NCS){qspi_cs_n}});
+		else if (qspi_cs_n)
+			assert(&r_cs_n);
+		else
+			assert((r_cs_n == ~(CS_ONE << r_chip))
+				||(r_cs_n == 0));
+
+		always @(*)
+		if ((OPT_CFG)&&(cfg_mode)&&(!cfg_cs))
+			assert(&r_cs_n);
+`endif
+		// }}}
+	end else begin : NO_CHIPSEL
+		// {{{
+		assign	o_qspi_cs_n = qspi_cs_n;
+		assign	cs_chip     = 1'b0;
+		// }}}
+	end endgenerate
 	// }}}
 
 	// o_qspi_mod
@@ -1056,7 +1619,8 @@ module	qflexpress #(
 		o_qspi_mod <= QUAD_WRITE;
 	else if ((cfg_ls_write)||((cfg_mode)&&(!cfg_speed)))
 		o_qspi_mod <= NORMAL_SPI;
-	else if ((ckstb)&&(clk_ctr <= 5'd9)&&((!cfg_mode)||(!cfg_dir)))
+	else if ((ckstb)&&(clk_ctr <= NDATA + 1)
+				&&((!cfg_mode)||(!cfg_dir)))
 		o_qspi_mod <= QUAD_READ;
 	// }}}
 
@@ -1068,6 +1632,8 @@ module	qflexpress #(
 		o_wb_stall <= 1'b1;
 	else if (maintenance)
 		o_wb_stall <= 1'b1;
+	else if ((speed_write)||((speed_pending)&&(!speed_apply)))
+		o_wb_stall <= 1'b1;
 	else if ((RDDELAY > 0)&&((i_cfg_stb)||(i_wb_stb))&&(!o_wb_stall))
 		o_wb_stall <= 1'b1;
 	else if ((RDDELAY == 0)&&((cfg_write)||(bus_request)))
@@ -1093,6 +1659,10 @@ module	qflexpress #(
 	if (i_reset)
 		dly_ack <= 1'b0;
 	else if ((ckstb)&&(clk_ctr == 1))
+		// Reads acknowledged early (OPT_EARLYACK) aren't
+		// acknowledged again here
+		dly_ack <= (i_wb_cyc)&&(pre_ack)&&(sel_skip == 0);
+	else if (speed_apply)
 		dly_ack <= (i_wb_cyc)&&(pre_ack);
 	else if ((i_wb_stb)&&(!o_wb_stall)&&(!bus_request))
 		dly_ack <= 1'b1;
@@ -1102,6 +1672,21 @@ module	qflexpress #(
 		dly_ack <= 1'b0;
 	// }}}
 
+	// dly_skip
+	// {{{
+	// Set, for one clock, on the clock that reads the last selected byte
+	// of a word--a word not otherwise acknowledged until its end
+	initial	dly_skip = 0;
+	always @(posedge i_clk)
+	if ((i_reset)||(!i_wb_cyc))
+		dly_skip <= 0;
+	else if ((ckstb)&&(sel_skip != 0)&&(clk_ctr == skip_clocks + 1)
+			&&(pre_ack)&&(!cfg_mode))
+		dly_skip <= sel_skip;
+	else
+		dly_skip <= 0;
+	// }}}
+
 	// actual_sck
 	// {{{
 	generate if (OPT_ODDR)
@@ -1126,6 +1711,8 @@ module	qflexpress #(
 		always @(posedge i_clk)
 		if (i_reset)
 			actual_sck <= 1'b0;
+		else if ((OPT_SPEED)&&(r_clkdiv == 1))
+			actual_sck <= (!o_qspi_sck)&&(clk_ctr > 0);
 		else
 			actual_sck <= (o_qspi_sck)&&(ckpre)&&(clk_ctr > 0);
 		// }}}
@@ -1145,8 +1732,10 @@ module	qflexpress #(
 		always @(*)
 		begin
 			read_sck = actual_sck;
-			o_wb_ack = dly_ack;
+			o_wb_ack = dly_ack || early_ack;
+			fix_skip = dly_skip;
 			xtra_stall = 1'b0;
+			rd_idle  = 1'b1;
 		end
 
 `ifdef	FORMAL
@@ -1158,6 +1747,7 @@ module	qflexpress #(
 	begin : RDDELAY_NONZERO
 		// {{{
 		reg	[RDDELAY-1:0]	sck_pipe, ack_pipe, stall_pipe;
+		reg	[RDDELAY*LGDW-1:0]	skip_pipe;
 		reg	not_done;
 
 		// sck_pipe, ack_pipe, and stall_pipe
@@ -1165,6 +1755,7 @@ module	qflexpress #(
 		initial	sck_pipe = 0;
 		initial	ack_pipe = 0;
 		initial	stall_pipe = -1;
+		initial	skip_pipe = 0;
 		if (RDDELAY > 1)
 		begin
 			// {{{
@@ -1180,6 +1771,13 @@ module	qflexpress #(
 			else
 				ack_pipe <= { ack_pipe[RDDELAY-2:0], dly_ack };
 
+			always @(posedge i_clk)
+			if (i_reset || !i_wb_cyc)
+				skip_pipe <= 0;
+			else
+				skip_pipe <= { skip_pipe[(RDDELAY-1)*LGDW-1:0],
+							dly_skip };
+
 			always @(posedge i_clk)
 			if (i_reset)
 				stall_pipe <= -1;
@@ -1201,6 +1799,12 @@ module	qflexpress #(
 			else
 				ack_pipe <= dly_ack;
 
+			always @(posedge i_clk)
+			if (i_reset || !i_wb_cyc)
+				skip_pipe <= 0;
+			else
+				skip_pipe <= dly_skip;
+
 			always @(posedge i_clk)
 			if (i_reset)
 				stall_pipe <= -1;
@@ -1219,29 +1823,58 @@ module	qflexpress #(
 				not_done = 1'b1;
 			if ((clk_ctr == 1)&&(!ckstb))
 				not_done = 1'b1;
+			if (speed_pending)
+				not_done = 1'b1;
 		end
 		// }}}
 
+		// o_wb_ack, read_sck, xtra_stall
+		// {{{
+		// The delay is r_rddelay, which is RDDELAY unless it has been
+		// changed through the speed register (OPT_SPEEDREG)
 		always @(*)
-			o_wb_ack = ack_pipe[RDDELAY-1];
+		if (r_rddelay == 0)
+		begin
+			o_wb_ack = dly_ack || early_ack;
+			read_sck = actual_sck;
+			fix_skip = dly_skip;
+		end else begin
+			o_wb_ack = ack_pipe[r_rddelay-1] || early_ack;
+			read_sck = sck_pipe[r_rddelay-1];
+			fix_skip = skip_pipe[(r_rddelay-1)*LGDW +: LGDW];
+		end
 
 		always @(*)
-			read_sck = sck_pipe[RDDELAY-1];
+			xtra_stall = |(stall_pipe
+					& ({(RDDELAY){1'b1}} >> (RDDELAY-r_rddelay)));
 
+		// The speed register may only be changed once nothing remains
+		// in these pipelines
 		always @(*)
-			xtra_stall = |stall_pipe;
+			rd_idle = (sck_pipe == 0)&&(ack_pipe == 0)
+					&&(skip_pipe == 0);
+		// }}}
 
 `ifdef	FORMAL
 		// {{{
 		integer	k;
+		// Acknowledgments still in the read delay pipeline, whether
+		// at the end of a word (ack_pipe) or early (skip_pipe)
 		always @(*)
 		if (!i_wb_cyc)
 			f_extra = 0;
 		else begin
 			f_extra = 0;
 			for(k=0; k<RDDELAY; k=k+1)
-				f_extra = f_extra + (ack_pipe[k] ? 1 : 0);
+			if (k < r_rddelay)
+				f_extra = f_extra + (ack_pipe[k] ? 1 : 0)
+					+ ((skip_pipe[k*LGDW +: LGDW] != 0) ? 1:0);
 		end
+
+		// Without OPT_EARLYACK, nothing is ever acknowledged early
+		always @(*)
+		if (!OPT_EARLYACK)
+			assert(skip_pipe == 0);
 		// }}}
 `endif // FORMAL
 		// }}}
@@ -1250,45 +1883,88 @@ module	qflexpress #(
 
 	// o_wb_data
 	// {{{
+	integer	bk;
+
 	always @(posedge i_clk)
 	begin
-		if (read_sck)
+		if ((read_sck)&&(dtr_mode))
+		begin
+			// Two nibbles, one from each half of the clock
+			if (OPT_ENDIANSWAP)
+				o_wb_data <= { dtr_idat, o_wb_data[DW-1:8] };
+			else
+				o_wb_data <= { o_wb_data[DW-9:0], dtr_idat };
+		end else if (read_sck)
 		begin
 			if (OPT_ENDIANSWAP)
 			begin
 				// {{{
+				// Each byte shifts in at the top, and then moves
+				// down one byte at a time, so that the first byte
+				// read ends up in the LSBs
 				if (!o_qspi_mod[1])
 				begin
-					o_wb_data <= { o_wb_data[30:24], i_qspi_dat[1],
-						o_wb_data[22:16], o_wb_data[31],
-						o_wb_data[14:8], o_wb_data[23],
-						o_wb_data[6:0], o_wb_data[15] };
+					for(bk=0; bk<DW/8-1; bk=bk+1)
+						o_wb_data[bk*8 +: 8] <= {
+							o_wb_data[bk*8 +: 7],
+							o_wb_data[bk*8+15] };
+					o_wb_data[DW-8 +: 8] <= {
+						o_wb_data[DW-8 +: 7], sdr_idat[1] };
 				end else begin
-					o_wb_data <= { o_wb_data[27:24], i_qspi_dat,
-						o_wb_data[19:16], o_wb_data[31:28],
-						o_wb_data[11:8], o_wb_data[23:20],
-						o_wb_data[3:0], o_wb_data[15:12]};
+					for(bk=0; bk<DW/8-1; bk=bk+1)
+						o_wb_data[bk*8 +: 8] <= {
+							o_wb_data[bk*8 +: 4],
+							o_wb_data[bk*8+12 +: 4] };
+					o_wb_data[DW-8 +: 8] <= {
+						o_wb_data[DW-8 +: 4], sdr_idat };
 				end
 
 				if (cfg_mode)
 				begin
 					// No endian-swapping in config mode
 					if (!o_qspi_mod[1])
-					o_wb_data[7:0]<= { o_wb_data[6:0], i_qspi_dat[1] };
+					o_wb_data[7:0]<= { o_wb_data[6:0], sdr_idat[1] };
 					else
-					o_wb_data[7:0]<= { o_wb_data[3:0], i_qspi_dat };
+					o_wb_data[7:0]<= { o_wb_data[3:0], sdr_idat };
 				end
 				// }}}
 			end else if (!o_qspi_mod[1])
 				// No endian-swapping
-				o_wb_data <= { o_wb_data[30:0], i_qspi_dat[1] };
+				o_wb_data <= { o_wb_data[DW-2:0], sdr_idat[1] };
 			else
-				o_wb_data <= { o_wb_data[27:0], i_qspi_dat };
+				o_wb_data <= { o_wb_data[DW-5:0], sdr_idat };
 		end // read_sck
 
+		// An early acknowledgment (OPT_EARLYACK).  The bytes read so
+		// far move into their lanes, replacing whatever was read on
+		// this clock--the start of a byte that wasn't selected.
+		if (fix_skip != 0)
+		begin
+			if (OPT_ENDIANSWAP)
+				o_wb_data <= o_wb_data >> (8*fix_skip);
+			else
+				o_wb_data <= o_wb_data << (8*fix_skip);
+		end
+
+		// Register reads clear any bits above the first 32
+		if (((speed_stb)||(perf_stb)||(remap_stb))&&(!i_wb_we))
+			o_wb_data <= 0;
+
+		if ((speed_stb)&&(!i_wb_we))
+			o_wb_data[31:0] <= { r_clkdiv, r_rddelay, 15'h0, r_ndummy };
+
+		if ((perf_stb)&&(!i_wb_we))
+			o_wb_data[31:0] <= perf_data;
+
+		if ((remap_stb)&&(!i_wb_we))
+			o_wb_data[31:0] <= remap_data;
+
 		if ((OPT_CFG)&&(cfg_mode))
 			o_wb_data[16:8] <= { 4'b0, cfg_mode, cfg_speed, 1'b0,
 				cfg_dir, cfg_cs };
+
+		if ((OPT_CFG)&&(cfg_mode)&&(NCS > 1))
+			o_wb_data[CHIP_BIT +: CSW] <= cs_chip;
 	end
 	// }}}
 	// }}}
@@ -1306,7 +1982,7 @@ module	qflexpress #(
 	always @(posedge i_clk)
 	if ((i_reset)||(!OPT_CFG))
 		cfg_mode <= 1'b0;
-	else if ((i_cfg_stb)&&(!o_wb_stall)&&(i_wb_we))
+	else if ((cfg_stb)&&(i_wb_we))
 		cfg_mode <= i_wb_data[CFG_MODE];
 	// }}}
 
@@ -1316,7 +1992,7 @@ module	qflexpress #(
 	always @(posedge i_clk)
 	if ((i_reset)||(!OPT_CFG))
 		cfg_cs <= 1'b0;
-	else if ((i_cfg_stb)&&(!o_wb_stall)&&(i_wb_we))
+	else if ((cfg_stb)&&(i_wb_we))
 		cfg_cs    <= (!i_wb_data[USER_CS_n])&&(i_wb_data[CFG_MODE]);
 	// }}}
 
@@ -1329,12 +2005,407 @@ module	qflexpress #(
 	begin
 		cfg_speed <= 1'b0;
 		cfg_dir   <= 1'b0;
-	end else if ((i_cfg_stb)&&(!o_wb_stall)&&(i_wb_we))
+	end else if ((cfg_stb)&&(i_wb_we))
 	begin
 		cfg_speed <= i_wb_data[QSPEED_BIT];
 		cfg_dir   <= i_wb_data[DIR_BIT];
 	end
 	// }}}
+
+	// r_clkdiv, r_ndummy, r_rddelay: the speed register
+	// {{{
+	generate if (OPT_SPEED)
+	begin : GEN_SPEEDREG
+		// {{{
+		reg	[7:0]	new_clkdiv;
+		reg	[4:0]	new_ndummy;
+		reg	[3:0]	new_rddelay;
+
+		// speed_pending
+		// {{{
+		// Set from the time a new speed is written until it can be
+		// applied: when the flash is idle, and the read delay
+		// pipeline is empty
+		initial	speed_pending = 1'b0;
+		always @(posedge i_clk)
+		if (i_reset)
+			speed_pending <= 1'b0;
+		else if (speed_write)
+			speed_pending <= 1'b1;
+		else if (speed_apply)
+			speed_pending <= 1'b0;
+
+		assign	speed_apply = (speed_pending)&&(!maintenance)
+					&&(clk_ctr == 0)&&(!dly_ack)&&(rd_idle);
+		// }}}
+
+		// new_*: The values written, clipped into range
+		// {{{
+		always @(posedge i_clk)
+		if (speed_write)
+		begin
+			if (OPT_ODDR)
+				new_clkdiv <= 0;
+			else if (i_wb_data[31:24] == 0)
+				new_clkdiv <= 1;
+			else if (i_wb_data[31:24] > OPT_CLKDIV)
+				new_clkdiv <= OPT_CLKDIV;
+			else
+				new_clkdiv <= i_wb_data[31:24];
+
+			if (i_wb_data[23:20] > RDDELAY)
+				new_rddelay <= RDDELAY;
+			else
+				new_rddelay <= i_wb_data[23:20];
+
+			if (i_wb_data[4:0] < NDUMMY_MIN)
+				new_ndummy <= NDUMMY_MIN;
+			else if (i_wb_data[4:0] > NDUMMY_MAX)
+				new_ndummy <= NDUMMY_MAX;
+			else
+				new_ndummy <= i_wb_data[4:0];
+		end
+		// }}}
+
+		// r_clkdiv, r_ndummy, r_rddelay
+		// {{{
+		initial	r_clkdiv  = OPT_CLKDIV;
+		initial	r_ndummy  = NDUMMY;
+		initial	r_rddelay = RDDELAY;
+		always @(posedge i_clk)
+		if (i_reset)
+		begin
+			r_clkdiv  <= OPT_CLKDIV;
+			r_ndummy  <= NDUMMY;
+			r_rddelay <= RDDELAY;
+		end else if (speed_apply)
+		begin
+			r_clkdiv  <= new_clkdiv;
+			r_ndummy  <= new_ndummy;
+			r_rddelay <= new_rddelay;
+		end
+		// }}}
+`ifdef	FORMAL
+`ifdef	F_FREETIMING
+		// {{{
+		// Any value may be written, but only values within range are
+		// ever applied, and those within range are kept as written
+		always @(posedge i_clk)
+		if ((f_past_valid)&&($past(speed_write)))
+		begin
+			if (OPT_ODDR)
+				assert(new_clkdiv == 0);
+			else begin
+				assert(new_clkdiv >= 1);
+				assert(new_clkdiv <= OPT_CLKDIV);
+				if (($past(i_wb_data[31:24]) >= 1)
+					&&($past(i_wb_data[31:24]) <= OPT_CLKDIV))
+					assert(new_clkdiv == $past(i_wb_data[31:24]));
+			end
+
+			assert(new_rddelay <= RDDELAY);
+			if ($past(i_wb_data[23:20]) <= RDDELAY)
+				assert(new_rddelay == $past(i_wb_data[23:20]));
+
+			assert(new_ndummy >= NDUMMY_MIN);
+			assert(new_ndummy <= NDUMMY_MAX);
+			if (($past(i_wb_data[4:0]) >= NDUMMY_MIN)
+				&&($past(i_wb_data[4:0]) <= NDUMMY_MAX))
+				assert(new_ndummy == $past(i_wb_data[4:0]));
+		end
+
+		// The speed only ever changes between reads, once the read
+		// delay pipeline has emptied
+		always @(posedge i_clk)
+		if ((f_past_valid)&&(!$past(i_reset))&&(($changed(r_clkdiv))
+			||($changed(r_ndummy))||($changed(r_rddelay))))
+		begin
+			assert($past(speed_apply));
+			assert($past(clk_ctr) == 0);
+			assert($past(rd_idle));
+		end
+
+		always @(*)
+		if (speed_pending)
+			assert(!maintenance);
+		// }}}
+`else
+		always @(*)
+		if (speed_pending)
+		begin
+			assert(new_clkdiv  == OPT_CLKDIV);
+			assert(new_ndummy  == NDUMMY);
+			assert(new_rddelay == RDDELAY);
+			assert(!maintenance);
+		end
+`endif
+`endif
+		// }}}
+	end else begin : NO_SPEEDREG
+		// {{{
+		always @(*)
+		begin
+			speed_pending = 1'b0;
+			r_clkdiv  = OPT_CLKDIV;
+			r_ndummy  = NDUMMY;
+			r_rddelay = RDDELAY;
+		end
+
+		assign	speed_apply = 1'b0;
+
+		// verilator lint_off UNUSED
+		wire	unused_speed;
+		assign	unused_speed = &{ 1'b0, rd_idle };
+		// verilator lint_on  UNUSED
+		// }}}
+	end endgenerate
+	// }}}
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Performance counters (OPT_PERF)
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	generate if (OPT_PERFCTR)
+	begin : GEN_PERF
+		// {{{
+		// The counters are, in order from PERF_ADDR: clocks, memory
+		// reads, pipelined reads, new address reads, stalled clocks,
+		// and configuration mode clocks
+		localparam	NPERF = 6;
+		wire	[NPERF-1:0]	perf_evt;
+		reg	[32*NPERF-1:0]	perf_count, perf_snap;
+		reg	[31:0]		r_perf_data;
+		integer			pk;
+
+		assign	perf_evt = { cfg_mode,
+			(i_wb_cyc)&&((i_wb_stb)||(i_cfg_stb))&&(o_wb_stall),
+			(bus_request)&&(!pipe_req), (bus_request)&&(pipe_req),
+			bus_request, 1'b1 };
+
+		// perf_count
+		// {{{
+		initial	perf_count = 0;
+		always @(posedge i_clk)
+		if ((i_reset)||((perf_write)&&(i_wb_data[1])))
+			perf_count <= 0;
+		else for(pk=0; pk<NPERF; pk=pk+1)
+			perf_count[32*pk +: 32] <= perf_count[32*pk +: 32]
+						+ { 31'h0, perf_evt[pk] };
+		// }}}
+
+		// perf_snap
+		// {{{
+		initial	perf_snap = 0;
+		always @(posedge i_clk)
+		if (i_reset)
+			perf_snap <= 0;
+		else if ((perf_write)&&(i_wb_data[0]))
+			perf_snap <= perf_count;
+		// }}}
+
+		// perf_data
+		// {{{
+		always @(*)
+		case(i_wb_addr[2:0])
+		3'h0:	 r_perf_data = perf_snap[ 31:  0];
+		3'h1:	 r_perf_data = perf_snap[ 63: 32];
+		3'h2:	 r_perf_data = perf_snap[ 95: 64];
+		3'h3:	 r_perf_data = perf_snap[127: 96];
+		3'h4:	 r_perf_data = perf_snap[159:128];
+		3'h5:	 r_perf_data = perf_snap[191:160];
+		default: r_perf_data = 0;
+		endcase
+
+		assign	perf_data = r_perf_data;
+		// }}}
+`ifdef	FORMAL
+		// Every memory read is either pipelined, or not
+		always @(*)
+		begin
+			assert(perf_count[63:32] == perf_count[95:64]
+						+ perf_count[127:96]);
+			assert(perf_snap[63:32] == perf_snap[95:64]
+						+ perf_snap[127:96]);
+		end
+`endif
+		// }}}
+	end else begin : NO_PERF
+		// {{{
+		assign	perf_data = 0;
+
+		// verilator lint_off UNUSED
+		wire	unused_perf;
+		assign	unused_perf = &{ 1'b0, perf_write };
+		// verilator lint_on  UNUSED
+		// }}}
+	end endgenerate
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Address remapping (OPT_REMAP)
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	generate if (OPT_REMAPREG)
+	begin : GEN_REMAP
+		// {{{
+		// SW: the number of sector address bits
+		localparam	SW = LGFLASHSZ+LGNCS-16;
+		integer			ik;
+		reg	[SW-1:0]	r_offset, w_sector;
+		reg	[NREMAP-1:0]	r_remap_en;
+		reg	[NREMAP*SW-1:0]	r_remap_from, r_remap_to;
+		reg	[31:0]		r_remap_data;
+
+		// r_offset
+		// {{{
+		initial	r_offset = 0;
+		always @(posedge i_clk)
+		if (i_reset)
+			r_offset <= 0;
+		else if ((remap_write)&&(i_wb_addr[4:0] == OFFSET_ADDR))
+			r_offset <= i_wb_data[16 +: SW];
+		// }}}
+
+		// r_remap_en, r_remap_from, r_remap_to
+		// {{{
+		initial	r_remap_en = 0;
+		always @(posedge i_clk)
+		if (i_reset)
+			r_remap_en <= 0;
+		else if ((remap_write)&&(i_wb_addr[4:2] == REMAP_ADDR[4:2]))
+			r_remap_en[i_wb_addr[1:0]] <= i_wb_data[31];
+
+		always @(posedge i_clk)
+		if ((remap_write)&&(i_wb_addr[4:2] == REMAP_ADDR[4:2]))
+		begin
+			r_remap_from[i_wb_addr[1:0]*SW +: SW]<= i_wb_data[16 +: SW];
+			r_remap_to[  i_wb_addr[1:0]*SW +: SW]<= i_wb_data[ 0 +: SW];
+		end
+		// }}}
+
+		// w_sector, flash_addr
+		// {{{
+		// The bus sector plus the offset, unless a window matches
+		always @(*)
+		begin
+			w_sector = i_wb_addr[AW-1:16-LGDW] + r_offset;
+			for(ik=0; ik<NREMAP; ik=ik+1)
+			if ((r_remap_en[ik])&&(r_remap_from[ik*SW +: SW]
+						== i_wb_addr[AW-1:16-LGDW]))
+				w_sector = r_remap_to[ik*SW +: SW];
+		end
+
+		assign	flash_addr = { w_sector, i_wb_addr[15-LGDW:0] };
+		// }}}
+
+		// remap_data
+		// {{{
+		always @(*)
+		begin
+			r_remap_data = 0;
+			if (i_wb_addr[2])
+			begin
+				r_remap_data[31] = r_remap_en[i_wb_addr[1:0]];
+				r_remap_data[16 +: SW] = r_remap_from[
+							i_wb_addr[1:0]*SW +: SW];
+				r_remap_data[ 0 +: SW] = r_remap_to[
+							i_wb_addr[1:0]*SW +: SW];
+			end else
+				r_remap_data[16 +: SW] = r_offset;
+		end
+
+		assign	remap_data = r_remap_data;
+		// }}}
+		// }}}
+	end else begin : NO_REMAP
+		// {{{
+		assign	flash_addr = i_wb_addr;
+		assign	remap_data = 0;
+
+		// verilator lint_off UNUSED
+		wire	unused_remap;
+		assign	unused_remap = &{ 1'b0, remap_write };
+		// verilator lint_on  UNUSED
+		// }}}
+	end endgenerate
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Early acknowledgments (OPT_EARLYACK)
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	generate if (OPT_EARLYACK)
+	begin : GEN_EARLYACK
+		// {{{
+		integer			sk;
+		reg	[LGDW-1:0]	w_skip, r_skip;
+
+		// w_skip
+		// {{{
+		// Bytes arrive from the flash starting with the lane in the
+		// MSBs, or in the LSBs with OPT_ENDIANSWAP.  Count the lanes
+		// that will arrive after the last one selected.
+		always @(*)
+		begin
+			w_skip = 0;
+			for(sk=0; sk<DW/8; sk=sk+1)
+			if (OPT_ENDIANSWAP)
+			begin
+				if (i_wb_sel[sk])
+					w_skip = DW/8-1-sk;
+			end else if (i_wb_sel[DW/8-1-sk])
+				w_skip = DW/8-1-sk;
+		end
+		// }}}
+
+		// r_skip
+		// {{{
+		initial	r_skip = 0;
+		always @(posedge i_clk)
+		if (i_reset)
+			r_skip <= 0;
+		else if (bus_request)
+			r_skip <= w_skip;
+		else if (cfg_write)
+			r_skip <= 0;
+		// }}}
+
+		// early_ack
+		// {{{
+		initial	early_ack = 1'b0;
+		always @(posedge i_clk)
+		if ((i_reset)||(!i_wb_cyc))
+			early_ack <= 1'b0;
+		else
+			early_ack <= (fix_skip != 0);
+		// }}}
+
+		assign	sel_skip = r_skip;
+		// }}}
+	end else begin : NO_EARLYACK
+		// {{{
+		assign	sel_skip = 0;
+
+		always @(*)
+			early_ack = 1'b0;
+
+		// verilator lint_off UNUSED
+		wire	unused_sel;
+		assign	unused_sel = &{ 1'b0, i_wb_sel };
+		// verilator lint_on  UNUSED
+		// }}}
+	end endgenerate
+
+	// Two clocks per byte, or one if the data arrives two nibbles at a time
+	assign	skip_clocks = (OPT_DTRIO) ? { {(CTRW-LGDW){1'b0}}, sel_skip }
+			: { {(CTRW-LGDW-1){1'b0}}, sel_skip, 1'b0 };
 	// }}}
 	////////////////////////////////////////////////////////////////////////
 	//
@@ -1354,7 +2425,7 @@ module	qflexpress #(
 	assign	o_dbg_trigger = (!cfg_mode)&&(r_last_cfg);
 	assign	o_debug = { o_dbg_trigger,
 			i_wb_cyc, i_cfg_stb, i_wb_stb, o_wb_ack, o_wb_stall,//6
-			o_qspi_cs_n, o_qspi_sck, o_qspi_dat, o_qspi_mod,// 8
+			qspi_cs_n, o_qspi_sck, o_qspi_dat, o_qspi_mod,// 8
 			i_qspi_dat, cfg_mode, cfg_cs, cfg_speed, cfg_dir,// 8
 			actual_sck, i_wb_we,
 			(((i_wb_stb)||(i_cfg_stb))
@@ -1367,7 +2438,7 @@ module	qflexpress #(
 	// {{{
 	// verilator lint_off UNUSED
 	wire	unused;
-	assign	unused = &{ 1'b0, i_wb_data[31:12] };
+	assign	unused = &{ 1'b0, i_wb_data[DW-1:12], skip_next };
 	// verilator lint_on  UNUSED
 	// }}}
 ////////////////////////////////////////////////////////////////////////////////
@@ -1382,16 +2453,24 @@ module	qflexpress #(
 `ifdef	FORMAL
 	// Signal declarations
 	// {{{
-	localparam	F_MEMDONE   = NDUMMY+6+8+(OPT_ADDR32 ? 2:0)+(OPT_ODDR ? 0:1);
+	localparam	F_MEMDONE   = (OPT_DTRIO) ? (NDUMMY+3+NDATA+(OPT_ADDR32 ? 1:0))
+				: (NDUMMY+6+NDATA+(OPT_ADDR32 ? 2:0)+(OPT_ODDR ? 0:1));
 	localparam	F_MEMACK    = F_MEMDONE + RDDELAY;
-	localparam	F_PIPEDONE  = 8;
+	localparam	F_PIPEDONE  = NDATA;
 	localparam	F_PIPEACK   = F_PIPEDONE + RDDELAY;
 	localparam	F_CFGLSDONE = 8+(OPT_ODDR ? 0:1);
 	localparam	F_CFGLSACK  = F_CFGLSDONE + RDDELAY;
 	localparam	F_CFGHSDONE = 2+(OPT_ODDR ? 0:1);
 	localparam	F_CFGHSACK  = RDDELAY+F_CFGHSDONE;
-	localparam	F_ACKCOUNT = (15+NDUMMY+RDDELAY)
+	localparam	F_ACKCOUNT = (7+(DW/4)+NDUMMY+RDDELAY)
 				*(OPT_ODDR ? 1 : (OPT_CLKDIV+1));
+	// F_FREETIMING: Check reads against the speed in use, rather than
+	// against a fixed sequence.  The bus is then held to no fixed delay.
+`ifdef	F_FREETIMING
+	localparam [0:0]	F_OPT_FREETIMING = 1'b1;
+`else
+	localparam [0:0]	F_OPT_FREETIMING = 1'b0;
+`endif
 	genvar	k;
 
 	wire	[(F_LGDEPTH-1):0]	f_nreqs, f_nacks,
@@ -1400,7 +2479,8 @@ module	qflexpress #(
 	reg	[(OPT_ADDR32 ? 29:21):0]	fv_addr;
 	reg	[31:0]	fv_data;
 	reg	[F_MEMACK:0] f_memread;
-	reg	[32:0]	f_past_data;
+	reg	[DW:0]	f_past_data;
+	wire	[DW-1:0]	f_swap_data;
 	reg	[F_PIPEACK:0]	f_piperead;
 	reg	[F_CFGHSACK:0]	f_cfghsread;
 	reg	[F_CFGHSACK:0]	f_cfghswrite;
@@ -1438,6 +2518,57 @@ module	qflexpress #(
 	always @(*)
 		`ASSUME((!i_wb_stb)||(!i_cfg_stb));
 
+`ifndef	F_FREETIMING
+	// The properties below follow every read and configuration port
+	// transfer through a fixed sequence of clocks.  They assume every
+	// read is of a full bus word.  An early acknowledgment (OPT_EARLYACK)
+	// is instead checked under F_FREETIMING, where i_wb_sel may vary.
+	always @(*)
+	if (i_wb_stb)
+		`ASSUME(&i_wb_sel);
+
+	// Likewise, every continued read is of the next address.  Reads
+	// skipping ahead (SKIPAHEAD) are instead checked under F_FREETIMING.
+	always @(*)
+	if (i_wb_stb)
+		`ASSUME(!skip_next);
+
+	always @(*)
+		assert(pipe_skip == 0);
+
+	always @(*)
+	begin
+		assert(sel_skip == 0);
+		assert(dly_skip == 0);
+		assert(fix_skip == 0);
+		assert(!early_ack);
+	end
+
+	// The fixed sequence is written in terms of OPT_CLKDIV, NDUMMY, and
+	// RDDELAY.  The speed register (OPT_SPEEDREG) is therefore only ever
+	// rewritten with these same values here.
+	always @(*)
+	if ((OPT_SPEED)&&(i_cfg_stb)&&(i_wb_we)&&(speed_sel))
+	begin
+		`ASSUME(i_wb_data[31:24] == OPT_CLKDIV);
+		`ASSUME(i_wb_data[23:20] == RDDELAY);
+		`ASSUME(i_wb_data[4:0]   == NDUMMY);
+	end
+
+	always @(*)
+	begin
+		assert(r_clkdiv  == OPT_CLKDIV);
+		assert(r_ndummy  == NDUMMY);
+		assert(r_rddelay == RDDELAY);
+	end
+`else
+	// F_FREETIMING replaces the fixed sequence with the properties under
+	// "Free timing" below: the speed register may be written with any
+	// value, and every read is then checked against the speed in use.
+	// Without the fixed sequence, these are only checked as far as a
+	// bounded model check reaches.
+`endif
+
 	always @(posedge i_clk)
 	if ((f_past_valid)&&(!$past(i_reset))
 			&&($past(i_wb_stb))&&($past(o_wb_stall)))
@@ -1449,16 +2580,18 @@ module	qflexpress #(
 		`ASSUME(i_cfg_stb);
 
 	fwb_slave #(.AW(AW), .DW(DW),.F_LGDEPTH(F_LGDEPTH),
-			.F_MAX_STALL(((OPT_CLKDIV<3) ? (F_ACKCOUNT+1):0)
-				+(OPT_ADDR32 ? 2:0)),
-			.F_MAX_ACK_DELAY(((OPT_CLKDIV<3) ? F_ACKCOUNT : 0)
-				+(OPT_ADDR32 ? 2:0)),
+			.F_MAX_STALL((F_OPT_FREETIMING) ? 0
+				: (((OPT_CLKDIV<3) ? (F_ACKCOUNT+1):0)
+				+(OPT_ADDR32 ? 2:0))),
+			.F_MAX_ACK_DELAY((F_OPT_FREETIMING) ? 0
+				: (((OPT_CLKDIV<3) ? F_ACKCOUNT : 0)
+				+(OPT_ADDR32 ? 2:0))),
 			.F_OPT_RMW_BUS_OPTION(0),
 			.F_OPT_CLK2FFLOGIC(1'b0),
 			.F_OPT_DISCONTINUOUS(1))
 		f_wbm(i_clk, i_reset,
 			i_wb_cyc, (i_wb_stb)||(i_cfg_stb), i_wb_we, i_wb_addr,
-				i_wb_data, 4'hf,
+				i_wb_data, i_wb_sel,
 			o_wb_ack, o_wb_stall, o_wb_data, 1'b0,
 			f_nreqs, f_nacks, f_outstanding);
 
@@ -1468,6 +2601,10 @@ module	qflexpress #(
 	always @(posedge i_clk)
 	if ((f_past_valid)&&(!$past(i_wb_stb))||($past(o_wb_stall)))
 		assert(f_outstanding <= 1 + f_extra);
+
+	always @(*)
+	if (speed_pending)
+		assert(o_wb_stall);
 	// }}}
 	////////////////////////////////////////////////////////////////////////
 	//
@@ -1479,7 +2616,10 @@ module	qflexpress #(
 	// 2. Otherwise when implementing multi-cycle clocks, i_qspi_dat only
 	//	changes on a negative edge
 	//
-	(* anyseq *) reg [3:0] dly_idat;
+	// 3. With DTR, single rate transfers return the same nibble in both
+	//	halves of the clock
+	//
+	(* anyseq *) reg [QW-1:0] dly_idat;
 	always @(posedge i_clk)
 	if (o_qspi_mod == NORMAL_SPI)
 	begin
@@ -1492,6 +2632,17 @@ module	qflexpress #(
 	else if ((!OPT_ODDR)&&((o_qspi_sck)||(!$past(o_qspi_sck))))
 		assume($stable(dly_idat));
 
+	generate if (OPT_DTRIO)
+	begin : F_DTR_IDAT
+		always @(posedge i_clk)
+		if (!dtr_mode)
+			assume(dly_idat[7:4] == dly_idat[3:0]);
+
+		always @(*)
+		if (!dtr_mode)
+			assert(o_qspi_dat[7:4] == o_qspi_dat[3:0]);
+	end endgenerate
+
 	generate if (RDDELAY > 0)
 	begin
 		always @(posedge i_clk)
@@ -1536,7 +2687,7 @@ module	qflexpress #(
 	//
 	always @(posedge i_clk)
 	if (dly_ack)
-		assert(clk_ctr[2:0] == 0);
+		assert(clk_ctr[(OPT_DTRIO ? 1:2):0] == 0);
 
 	// Zero cycle requests
 	always @(posedge i_clk)
@@ -1554,16 +2705,25 @@ module	qflexpress #(
 		assert(f_outstanding >= 1 + f_extra);
 
 	always @(posedge i_clk)
-	if ((f_past_valid)&&(clk_ctr == 0)&&(!dly_ack)
+	if ((f_past_valid)&&(clk_ctr == 0)&&(!dly_ack)&&(!early_ack)
+			&&(!speed_pending)
 			&&((!$past(i_wb_stb|i_cfg_stb))||($past(o_wb_stall))))
 		assert(f_outstanding == f_extra);
 
+	// A speed register write remains outstanding until it is applied
 	always @(*)
-	if ((i_wb_cyc)&&(pre_ack)&&(!o_qspi_cs_n))
-		assert((f_outstanding >= 1 + f_extra)||((OPT_CFG)&&(cfg_mode)));
+	if ((speed_pending)&&(i_wb_cyc)&&(pre_ack))
+		assert(f_outstanding >= 1 + f_extra);
 
+	// A read acknowledged early (OPT_EARLYACK) keeps reading to the end
+	// of its word, with nothing left outstanding
 	always @(*)
-	if ((cfg_mode)&&(!dly_ack)&&(clk_ctr == 0))
+	if ((i_wb_cyc)&&(pre_ack)&&(!qspi_cs_n))
+		assert((f_outstanding >= 1 + f_extra)||((OPT_CFG)&&(cfg_mode))
+			||(sel_skip != 0));
+
+	always @(*)
+	if ((cfg_mode)&&(!dly_ack)&&(clk_ctr == 0)&&(!speed_pending))
 		assert(f_outstanding == f_extra);
 
 	always @(*)
@@ -1581,7 +2741,7 @@ module	qflexpress #(
 	always @(*)
 	if (!maintenance)
 	begin
-		if (o_qspi_cs_n)
+		if (qspi_cs_n)
 		begin
 			assert(clk_ctr == 0);
 			assert(o_qspi_sck  == !OPT_ODDR);
@@ -1601,10 +2761,11 @@ module	qflexpress #(
 
 
 	always @(posedge i_clk)
-	if ((OPT_CLKDIV==1)&&(!o_qspi_cs_n)&&(!$past(o_qspi_cs_n))
-			&&(!$past(o_qspi_cs_n,2))&&(!cfg_mode))
+	if ((OPT_CLKDIV==1)&&(!qspi_cs_n)&&(!$past(qspi_cs_n))
+			&&(!$past(qspi_cs_n,2))&&(!cfg_mode))
 		assert(o_qspi_sck != $past(o_qspi_sck));
 	// }}}
+`ifndef	F_FREETIMING
 	////////////////////////////////////////////////////////////////////////
 	//
 	// Read requests
@@ -1615,28 +2776,27 @@ module	qflexpress #(
 	always @(posedge i_clk)
 	if ((f_past_valid)&&(!$past(i_reset))&&($past(bus_request)))
 	begin
-		assert(!o_qspi_cs_n);
+		assert(!qspi_cs_n);
 		if ((OPT_ODDR)||(!$past(pipe_req)))
 			assert(o_qspi_sck == 1'b1);
 		else
 			assert(o_qspi_sck == 1'b0);
 		//
-		if (!$past(o_qspi_cs_n))
+		if (!$past(qspi_cs_n))
 		begin
-			assert(clk_ctr == 5'd8);
+			assert(clk_ctr == F_PIPEDONE);
 			assert(o_qspi_mod == QUAD_READ);
 		end else begin
-			assert(clk_ctr == 5'd14 + NDUMMY
-				+ (OPT_ADDR32 ? 2:0) + (OPT_ODDR ? 0:1));
+			assert(clk_ctr == F_MEMDONE);
 			assert(o_qspi_mod == QUAD_WRITE);
 		end
 	end
 
 	always @(*)
-		assert(clk_ctr <= 5'd18 + NDUMMY + (OPT_ODDR ? 0:1));
+		assert(clk_ctr <= 10 + (DW/4) + NDUMMY + (OPT_ODDR ? 0:1));
 
 	always @(*)
-	if ((OPT_ODDR)&&(!o_qspi_cs_n))
+	if ((OPT_ODDR)&&(!qspi_cs_n))
 		assert((o_qspi_sck)||(actual_sck)||(cfg_mode)||(maintenance));
 
 	always @(*)
@@ -1649,12 +2809,12 @@ module	qflexpress #(
 		if (cfg_mode)
 		begin
 			if (!cfg_cs)
-				assert(o_qspi_cs_n);
+				assert(qspi_cs_n);
 			else if (!cfg_speed)
 				assert(o_qspi_mod == NORMAL_SPI);
 			else if ((cfg_dir)&&(clk_ctr > 0))
 				assert(o_qspi_mod == QUAD_WRITE);
-		end else if (clk_ctr > 5'd8)
+		end else if (clk_ctr > F_PIPEDONE)
 			assert(o_qspi_mod == QUAD_WRITE);
 		else if (clk_ctr > 0)
 			assert(o_qspi_mod == QUAD_READ);
@@ -1665,7 +2825,7 @@ module	qflexpress #(
 		assert(o_wb_stall);
 
 	always @(posedge i_clk)
-	if ((OPT_CLKDIV>0)&&($past(o_qspi_cs_n)))
+	if ((OPT_CLKDIV>0)&&($past(qspi_cs_n)))
 		assert(o_qspi_sck);
 	// }}}
 	////////////////////////////////////////////////////////////////////////
@@ -1680,7 +2840,7 @@ module	qflexpress #(
 		assert(!cfg_mode);
 	always @(*)
 	if ((OPT_CFG)&&(cfg_mode))
-		assert(o_qspi_cs_n == !cfg_cs);
+		assert(qspi_cs_n == !cfg_cs);
 	else
 		assert(!cfg_cs);
 
@@ -1693,13 +2853,14 @@ module	qflexpress #(
 	begin
 		// Make sure all of the bits are set
 		fv_addr <= 0;
-		// Now set as many bits as we have address bits
-		fv_addr[AW-1:0] <= i_wb_addr;
+		// Now set as many bits as we have address bits, counting
+		// in 32-bit words
+		fv_addr[LGFLASHSZ-3:0] <= flash_addr[AW-LGNCS-1:0] << (LGDW-2);
 	end
 
 	always @(posedge i_clk)
 	if ((i_wb_stb || i_cfg_stb) && !o_wb_stall && i_wb_we)
-		fv_data <= i_wb_data;
+		fv_data <= i_wb_data[31:0];
 	// }}}
 	////////////////////////////////////////////////////////////////////////
 	//
@@ -1721,7 +2882,7 @@ module	qflexpress #(
 				f_memread <= { f_memread[F_MEMACK-1:0],1'b0};
 			else if (!OPT_ODDR)
 				f_memread[F_MEMACK] <= 1'b0;
-			if ((bus_request)&&(o_qspi_cs_n))
+			if ((bus_request)&&(qspi_cs_n))
 				f_memread[0] <= 1'b1;
 		end
 	end else begin
@@ -1735,7 +2896,7 @@ module	qflexpress #(
 			else if (!OPT_ODDR)
 				f_memread[F_MEMACK:F_MEMDONE]
 					<= { f_memread[F_MEMACK-1:F_MEMDONE],1'b0};
-			if ((bus_request)&&(o_qspi_cs_n))
+			if ((bus_request)&&(qspi_cs_n))
 				f_memread[0] <= 1'b1;
 		end
 	end endgenerate
@@ -1744,14 +2905,26 @@ module	qflexpress #(
 	if ((OPT_ODDR)&&(|f_memread[F_MEMDONE-1:0]))
 		assert(o_qspi_sck);
 
-	always @(posedge i_clk)
-	if (|f_memread[6+(OPT_ADDR32 ? 2:0)+(OPT_ODDR ? 0:1):0])
-		assert(o_qspi_mod == QUAD_WRITE);
-	else if (|f_memread[(OPT_ODDR ? 0:1)+(OPT_ADDR32 ? 2:0) +7 +: NDUMMY])
-	// begin assert(1); end
-	begin end
-	else if (|f_memread)
-		assert(o_qspi_mod == QUAD_READ);
+	generate if (OPT_DTRIO)
+	begin : F_DTR_MODE
+		// Address and mode take 4 clocks, 5 with 32-bit addresses
+		always @(posedge i_clk)
+		if (|f_memread[3+(OPT_ADDR32 ? 1:0):0])
+			assert(o_qspi_mod == QUAD_WRITE);
+		else if (|f_memread[4+(OPT_ADDR32 ? 1:0) +: NDUMMY])
+		begin end
+		else if (|f_memread)
+			assert(o_qspi_mod == QUAD_READ);
+	end else begin : F_SDR_MODE
+		always @(posedge i_clk)
+		if (|f_memread[6+(OPT_ADDR32 ? 2:0)+(OPT_ODDR ? 0:1):0])
+			assert(o_qspi_mod == QUAD_WRITE);
+		else if (|f_memread[(OPT_ODDR ? 0:1)+(OPT_ADDR32 ? 2:0) +7 +: NDUMMY])
+		// begin assert(1); end
+		begin end
+		else if (|f_memread)
+			assert(o_qspi_mod == QUAD_READ);
+	end endgenerate
 
 	generate if (RDDELAY > 0)
 	begin
@@ -1759,74 +2932,106 @@ module	qflexpress #(
 		if ($past(ckpos,RDDELAY))
 		begin
 			if ($past(o_qspi_mod,RDDELAY) == NORMAL_SPI)
-				f_past_data <= { f_past_data[31:0], i_qspi_dat[1] };
+				f_past_data <= { f_past_data[DW-1:0], i_qspi_dat[1] };
 			else if ($past(o_qspi_mod,RDDELAY) == QUAD_READ)
-				f_past_data <= { f_past_data[28:0], i_qspi_dat[3:0] };
+				f_past_data <= { f_past_data[DW-4:0], i_qspi_dat[3:0] };
 		end
 	end else begin
 		always @(posedge i_clk)
 		if (ckpos)
 		begin
 			if (o_qspi_mod == NORMAL_SPI)
-				f_past_data <= { f_past_data[31:0], i_qspi_dat[1] };
+				f_past_data <= { f_past_data[DW-1:0], i_qspi_dat[1] };
 			else if (o_qspi_mod == QUAD_READ)
-				f_past_data <= { f_past_data[28:0], i_qspi_dat[3:0] };
+				f_past_data <= { f_past_data[DW-4:0], i_qspi_dat[3:0] };
+		end
+	end endgenerate
+
+	// f_swap_data: f_past_data, with the first byte read in the LSBs
+	generate for(k=0; k<DW/8; k=k+1)
+	begin : F_SWAP_DATA
+		assign	f_swap_data[k*8 +: 8] = f_past_data[DW-8-k*8 +: 8];
+	end endgenerate
+
+	// F_DATA: Check every beat of the data returned, one byte per clock
+	// for DTR, else one nibble per clock
+	generate for(k=0; k<NDATA; k=k+1)
+	begin : F_DATA
+		always @(posedge i_clk)
+		if ((OPT_DTRIO)&&((f_memread[F_MEMACK])||(f_piperead[F_PIPEACK])))
+		begin
+			if (OPT_ENDIANSWAP)
+				assert(o_wb_data[k*8 +: 8]
+					== $past(dtr_idat, NDATA-k));
+			else
+				assert(o_wb_data[DW-8-k*8 +: 8]
+					== $past(dtr_idat, NDATA-k));
+		end else if ((OPT_ODDR)
+			&&((f_memread[F_MEMACK])||(f_piperead[F_PIPEACK])))
+		begin
+			if (OPT_ENDIANSWAP)
+				assert(o_wb_data[(k/2)*8 + ((k&1) ? 0:4) +: 4]
+					== $past(i_qspi_dat, NDATA-k));
+			else
+				assert(o_wb_data[DW-4-k*4 +: 4]
+					== $past(i_qspi_dat, NDATA-k));
 		end
 	end endgenerate
 
 
-	always @(posedge i_clk)
-	if (|f_memread[(OPT_ODDR ? 0:1) +: 7 + (OPT_ADDR32 ? 2:0)])
-	begin
-		if (OPT_ADDR32)
+	generate if (OPT_DTRIO)
+	begin : F_DTR_ADDR
+		always @(posedge i_clk)
+		if (|f_memread[0 +: 4 + (OPT_ADDR32 ? 1:0)])
 		begin
 			// Eight extra bits of address
-			if (f_memread[(OPT_ODDR ? 0:1)])
-				assert(o_qspi_dat== fv_addr[29:26]);
-			if (f_memread[1 + (OPT_ODDR ? 0:1)])
-				assert(o_qspi_dat== fv_addr[25:22]);
-		end
-		// 6 nibbles of address, one nibble of mode
-		if (f_memread[(OPT_ODDR ? 0:1)+(OPT_ADDR32 ? 2:0)])
-			assert(o_qspi_dat== fv_addr[21:18]);
-		if (f_memread[1+(OPT_ODDR ? 0:1)+(OPT_ADDR32 ? 2:0)])
-			assert(o_qspi_dat== fv_addr[17:14]);
-		if (f_memread[2+(OPT_ODDR ? 0:1)+(OPT_ADDR32 ? 2:0)])
-			assert(o_qspi_dat== fv_addr[13:10]);
-		if (f_memread[3+(OPT_ODDR ? 0:1)+(OPT_ADDR32 ? 2:0)])
-			assert(o_qspi_dat== fv_addr[ 9: 6]);
-		if (f_memread[4+(OPT_ODDR ? 0:1)+(OPT_ADDR32 ? 2:0)])
-			assert(o_qspi_dat== fv_addr[ 5: 2]);
-		if (f_memread[5+(OPT_ODDR ? 0:1)+(OPT_ADDR32 ? 2:0)])
-			assert(o_qspi_dat=={ fv_addr[1:0],2'b00 });
-		if (f_memread[6+(OPT_ODDR ? 0:1)+(OPT_ADDR32 ? 2:0)])
-			assert(o_qspi_dat == 4'ha);
-	end
+			if ((OPT_ADDR32)&&(f_memread[0]))
+				assert(o_qspi_dat== fv_addr[29:22]);
+			// 3 clocks of address, one clock of mode
+			if (f_memread[(OPT_ADDR32 ? 1:0)])
+				assert(o_qspi_dat== fv_addr[21:14]);
+			if (f_memread[1+(OPT_ADDR32 ? 1:0)])
+				assert(o_qspi_dat== fv_addr[13: 6]);
+			if (f_memread[2+(OPT_ADDR32 ? 1:0)])
+				assert(o_qspi_dat=={ fv_addr[5:0],2'b00 });
+			if (f_memread[3+(OPT_ADDR32 ? 1:0)])
+				assert(o_qspi_dat == 8'ha0);
+		end
+	end else begin : F_SDR_ADDR
+		always @(posedge i_clk)
+		if (|f_memread[(OPT_ODDR ? 0:1) +: 7 + (OPT_ADDR32 ? 2:0)])
+		begin
+			if (OPT_ADDR32)
+			begin
+				// Eight extra bits of address
+				if (f_memread[(OPT_ODDR ? 0:1)])
+					assert(o_qspi_dat== fv_addr[29:26]);
+				if (f_memread[1 + (OPT_ODDR ? 0:1)])
+					assert(o_qspi_dat== fv_addr[25:22]);
+			end
+			// 6 nibbles of address, one nibble of mode
+			if (f_memread[(OPT_ODDR ? 0:1)+(OPT_ADDR32 ? 2:0)])
+				assert(o_qspi_dat== fv_addr[21:18]);
+			if (f_memread[1+(OPT_ODDR ? 0:1)+(OPT_ADDR32 ? 2:0)])
+				assert(o_qspi_dat== fv_addr[17:14]);
+			if (f_memread[2+(OPT_ODDR ? 0:1)+(OPT_ADDR32 ? 2:0)])
+				assert(o_qspi_dat== fv_addr[13:10]);
+			if (f_memread[3+(OPT_ODDR ? 0:1)+(OPT_ADDR32 ? 2:0)])
+				assert(o_qspi_dat== fv_addr[ 9: 6]);
+			if (f_memread[4+(OPT_ODDR ? 0:1)+(OPT_ADDR32 ? 2:0)])
+				assert(o_qspi_dat== fv_addr[ 5: 2]);
+			if (f_memread[5+(OPT_ODDR ? 0:1)+(OPT_ADDR32 ? 2:0)])
+				assert(o_qspi_dat=={ fv_addr[1:0],2'b00 });
+			if (f_memread[6+(OPT_ODDR ? 0:1)+(OPT_ADDR32 ? 2:0)])
+				assert(o_qspi_dat == 4'ha);
+		end
+	end endgenerate
 
 	always @(posedge i_clk)
-	if (OPT_ODDR)
+	if ((OPT_DTRIO)||(OPT_ODDR))
 	begin
-		if (f_memread[F_MEMACK] && OPT_ENDIANSWAP)
-		begin
-			assert(o_wb_data[ 7: 4] == $past(i_qspi_dat,8));
-			assert(o_wb_data[ 3: 0] == $past(i_qspi_dat,7));
-			assert(o_wb_data[15:12] == $past(i_qspi_dat,6));
-			assert(o_wb_data[11: 8] == $past(i_qspi_dat,5));
-			assert(o_wb_data[23:20] == $past(i_qspi_dat,4));
-			assert(o_wb_data[19:16] == $past(i_qspi_dat,3));
-			assert(o_wb_data[31:28] == $past(i_qspi_dat,2));
-			assert(o_wb_data[27:24] == $past(i_qspi_dat,1));
-		end else if (f_memread[F_MEMACK])
-		begin
-			assert(o_wb_data[31:28] == $past(i_qspi_dat,8));
-			assert(o_wb_data[27:24] == $past(i_qspi_dat,7));
-			assert(o_wb_data[23:20] == $past(i_qspi_dat,6));
-			assert(o_wb_data[19:16] == $past(i_qspi_dat,5));
-			assert(o_wb_data[15:12] == $past(i_qspi_dat,4));
-			assert(o_wb_data[11: 8] == $past(i_qspi_dat,3));
-			assert(o_wb_data[ 7: 4] == $past(i_qspi_dat,2));
-			assert(o_wb_data[ 3: 0] == $past(i_qspi_dat,1));
-		end else if (|f_memread)
+		// The data itself is checked above, within F_DATA
+		if ((|f_memread)&&(!f_memread[F_MEMACK]))
 		begin
 			if (!OPT_PIPE)
 				assert(o_wb_stall);
@@ -1835,13 +3040,9 @@ module	qflexpress #(
 			assert(!o_wb_ack);
 		end
 	end else if (f_memread[F_MEMACK] && OPT_ENDIANSWAP)
-		assert((!o_wb_ack)||(
-			   o_wb_data[ 7: 0] == f_past_data[31:24]
-			&& o_wb_data[15: 8] == f_past_data[23:16]
-			&& o_wb_data[23:16] == f_past_data[15: 8]
-			&& o_wb_data[31:24] == f_past_data[ 7: 0]));
+		assert((!o_wb_ack)||(o_wb_data == f_swap_data));
 	else if (f_memread[F_MEMACK]) // 25
-		assert((!o_wb_ack)||(o_wb_data == f_past_data[31:0]));
+		assert((!o_wb_ack)||(o_wb_data == f_past_data[DW-1:0]));
 	else if (|f_memread)
 	begin
 		if ((!OPT_PIPE)||(!ckstb))
@@ -1872,7 +3073,7 @@ module	qflexpress #(
 			f_piperead <= 0;
 		else if (ckstb) begin
 			f_piperead <= { f_piperead[F_PIPEACK-1:0],1'b0};
-			f_piperead[0] <= (bus_request)&&(!o_qspi_cs_n);
+			f_piperead[0] <= (bus_request)&&(!qspi_cs_n);
 		end else if (!OPT_ODDR)
 			f_piperead[F_PIPEACK] <= 1'b0;
 
@@ -1884,46 +3085,24 @@ module	qflexpress #(
 			f_piperead <= 0;
 		else if (ckstb) begin
 			f_piperead <= { f_piperead[F_PIPEACK-1:0],1'b0};
-			f_piperead[0] <= (bus_request)&&(!o_qspi_cs_n);
+			f_piperead[0] <= (bus_request)&&(!qspi_cs_n);
 		end else if (!OPT_ODDR)
 			f_piperead[F_PIPEACK:F_PIPEDONE] <= { f_piperead[F_PIPEACK-1:F_PIPEDONE], 1'b0 };
 
 	end endgenerate
 
 	always @(posedge  i_clk)
-	if (OPT_ODDR)
+	if ((OPT_DTRIO)||(OPT_ODDR))
 	begin
-		if (f_piperead[F_PIPEACK] && OPT_ENDIANSWAP)
-		begin
-			assert(o_wb_data[ 7: 4] == $past(i_qspi_dat,8));
-			assert(o_wb_data[ 3: 0] == $past(i_qspi_dat,7));
-			assert(o_wb_data[15:12] == $past(i_qspi_dat,6));
-			assert(o_wb_data[11: 8] == $past(i_qspi_dat,5));
-			assert(o_wb_data[23:20] == $past(i_qspi_dat,4));
-			assert(o_wb_data[19:16] == $past(i_qspi_dat,3));
-			assert(o_wb_data[31:28] == $past(i_qspi_dat,2));
-			assert(o_wb_data[27:24] == $past(i_qspi_dat,1));
-		end else if (f_piperead[F_PIPEACK])
-		begin
-			assert(o_wb_data[31:28] == $past(i_qspi_dat,8));
-			assert(o_wb_data[27:24] == $past(i_qspi_dat,7));
-			assert(o_wb_data[23:20] == $past(i_qspi_dat,6));
-			assert(o_wb_data[19:16] == $past(i_qspi_dat,5));
-			assert(o_wb_data[15:12] == $past(i_qspi_dat,4));
-			assert(o_wb_data[11: 8] == $past(i_qspi_dat,3));
-			assert(o_wb_data[ 7: 4] == $past(i_qspi_dat,2));
-			assert(o_wb_data[ 3: 0] == $past(i_qspi_dat));
-		end else if ((|f_piperead)&&(!f_piperead[RDDELAY]))
+		// The data itself is checked above, within F_DATA
+		if ((|f_piperead)&&(!f_piperead[F_PIPEACK])
+				&&(!f_piperead[RDDELAY]))
 			assert(!o_wb_ack);
 	end else if (f_piperead[F_PIPEACK] && OPT_ENDIANSWAP)
 	begin
-		assert((!o_wb_ack)||(
-			   o_wb_data[ 7: 0] == f_past_data[31:24]
-			&& o_wb_data[15: 8] == f_past_data[23:16]
-			&& o_wb_data[23:16] == f_past_data[15: 8]
-			&& o_wb_data[31:24] == f_past_data[ 7: 0]));
+		assert((!o_wb_ack)||(o_wb_data == f_swap_data));
 	end else if (f_piperead[F_PIPEACK]) // 25
-		assert((!o_wb_ack)||(o_wb_data == f_past_data[31:0]));
+		assert((!o_wb_ack)||(o_wb_data == f_past_data[DW-1:0]));
 	else if (|f_piperead)
 	begin
 		if ((!OPT_PIPE)||(!ckstb))
@@ -2032,7 +3211,7 @@ module	qflexpress #(
 	always @(posedge i_clk)
 	if (|f_cfglswrite)
 	begin
-		assert(!o_qspi_cs_n);
+		assert(!qspi_cs_n);
 		assert(o_qspi_mod == NORMAL_SPI);
 	end
 
@@ -2108,15 +3287,15 @@ module	qflexpress #(
 
 	always @(posedge i_clk)
 	if ((OPT_ODDR) && (f_cfghswrite[0]))
-		assert(o_qspi_dat == $past(i_wb_data[7:4]));
+		assert(sdr_odat == $past(i_wb_data[7:4]));
 	else if ((!OPT_ODDR) && (f_cfghswrite[1]))
-		assert(o_qspi_dat == fv_data[7:4]);
+		assert(sdr_odat == fv_data[7:4]);
 
 	always @(posedge i_clk)
 	if ((OPT_ODDR)&&f_cfghswrite[1])
-		assert(o_qspi_dat == $past(i_wb_data[3:0],2));
+		assert(sdr_odat == $past(i_wb_data[3:0],2));
 	else if ((!OPT_ODDR) && (f_cfghswrite[2]))
-		assert(o_qspi_dat == fv_data[3:0]);
+		assert(sdr_odat == fv_data[3:0]);
 
 	always @(posedge i_clk)
 	if (OPT_ODDR)
@@ -2139,7 +3318,7 @@ module	qflexpress #(
 	always @(posedge i_clk)
 	if (|f_cfghswrite)
 	begin
-		assert(!o_qspi_cs_n);
+		assert(!qspi_cs_n);
 		assert(o_qspi_mod == QUAD_WRITE);
 	end
 
@@ -2197,14 +3376,14 @@ module	qflexpress #(
 		assert(o_qspi_sck == !OPT_ODDR);
 
 	always @(*)
-	if ((!maintenance)&&(o_qspi_cs_n))
+	if ((!maintenance)&&(qspi_cs_n))
 		assert(!actual_sck);
 
 	always @(posedge i_clk)
 	if (|f_cfghsread[F_CFGHSDONE-1:F_CFGHSDONE-2])
 	begin
 		assert(!dly_ack);
-		assert(!o_qspi_cs_n);
+		assert(!qspi_cs_n);
 		assert(o_qspi_mod == QUAD_READ);
 		assert(o_wb_stall);
 	end
@@ -2319,7 +3498,7 @@ module	qflexpress #(
 	end
 
 	always @(*)
-	if (!maintenance && !o_qspi_cs_n && !cfg_mode)
+	if (!maintenance && !qspi_cs_n && !cfg_mode)
 	begin
 		assert((|f_memread[F_MEMDONE:0])
 			||(|f_piperead[F_PIPEDONE:0]));
@@ -2343,6 +3522,141 @@ module	qflexpress #(
 			|| f_cfghsread[F_CFGHSACK]);
 	end
 	// }}}
+`else
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Free timing
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// Every new address is followed by r_ndummy dummy clocks
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset))&&($past(bus_request))
+			&&(!$past(pipe_req)))
+	begin
+		assert(!qspi_cs_n);
+		assert(o_qspi_mod == QUAD_WRITE);
+		assert(clk_ctr == F_MEMDONE - NDUMMY + $past(r_ndummy));
+	end
+
+	// The speed in use always remains within its limits
+	always @(*)
+	begin
+		assert(r_clkdiv  <= OPT_CLKDIV);
+		assert(r_rddelay <= RDDELAY);
+		if (!OPT_ODDR)
+			assert(r_clkdiv >= 1);
+	end
+
+	// F_EARLY: An early acknowledgment (OPT_EARLYACK), skipping the last
+	// s bytes of the word, returns the NB beats read before them--one
+	// byte per clock for DTR, else one nibble per clock--in the same
+	// lanes F_DATA would have found them in.  The lanes are moved one
+	// clock after the last beat is read, and acknowledged on the next.
+	genvar	s;
+	generate if ((OPT_EARLYACK)&&((OPT_DTRIO)||(OPT_ODDR)))
+	begin : F_EARLY
+		for(s=1; s<DW/8; s=s+1)
+		begin : F_EARLY_SKIP
+			localparam	NB = NDATA - s * (NDATA / (DW/8));
+
+			for(k=0; k<NB; k=k+1)
+			begin : F_EARLY_LANE
+				always @(posedge i_clk)
+				if ((f_past_valid)&&(early_ack)
+						&&($past(fix_skip) == s))
+				begin
+					if ((OPT_DTRIO)&&(OPT_ENDIANSWAP))
+						assert(o_wb_data[k*8 +: 8]
+						== $past(dtr_idat, NB-k+1));
+					else if (OPT_DTRIO)
+						assert(o_wb_data[DW-8-k*8 +: 8]
+						== $past(dtr_idat, NB-k+1));
+					else if (OPT_ENDIANSWAP)
+						assert(o_wb_data[(k/2)*8
+							+ ((k&1) ? 0:4) +: 4]
+						== $past(i_qspi_dat, NB-k+1));
+					else
+						assert(o_wb_data[DW-4-k*4 +: 4]
+						== $past(i_qspi_dat, NB-k+1));
+				end
+			end
+		end
+	end endgenerate
+
+	// F_FULL: Without a fixed sequence to follow, check the data of every
+	// full word read, new or continued, against the last NDATA beats read
+	// before its acknowledgment--just as F_DATA does
+	generate if ((RDDELAY == 0)&&((OPT_DTRIO)||(OPT_ODDR)))
+	for(k=0; k<NDATA; k=k+1)
+	begin : F_FULL
+		always @(posedge i_clk)
+		if ((f_past_valid)&&(!$past(i_reset))&&(o_wb_ack)&&(!early_ack)
+				&&($past(ckstb))&&($past(clk_ctr) == 1)
+				&&(!$past(cfg_mode))
+				&&($past(o_qspi_mod) == QUAD_READ))
+		begin
+			if ((OPT_DTRIO)&&(OPT_ENDIANSWAP))
+				assert(o_wb_data[k*8 +: 8]
+					== $past(dtr_idat, NDATA-k));
+			else if (OPT_DTRIO)
+				assert(o_wb_data[DW-8-k*8 +: 8]
+					== $past(dtr_idat, NDATA-k));
+			else if (OPT_ENDIANSWAP)
+				assert(o_wb_data[(k/2)*8 + ((k&1) ? 0:4) +: 4]
+					== $past(i_qspi_dat, NDATA-k));
+			else
+				assert(o_wb_data[DW-4-k*4 +: 4]
+					== $past(i_qspi_dat, NDATA-k));
+		end
+	end endgenerate
+
+	// F_SKIP: A read continued past the next address (SKIPAHEAD) first
+	// clocks through, and discards, every word in between.  Count those
+	// words from the last address requested, rather than trusting the
+	// controller's own count.  As with the flash itself, the count wraps
+	// from the end of each device (NCS) back to its start.  F_FULL then
+	// checks that the word returned is the last one read.
+	generate if (OPT_SKIP)
+	begin : F_SKIP
+		reg	[AW-1:0]	f_last_addr;
+		wire	[AW-1:0]	f_skip_gap;
+
+		always @(posedge i_clk)
+		if (bus_request)
+			f_last_addr <= flash_addr;
+
+		assign	f_skip_gap = (flash_addr - f_last_addr - 1'b1)
+						& WRAP_MASK;
+
+		always @(posedge i_clk)
+		if ((f_past_valid)&&(!$past(i_reset))
+				&&($past(bus_request))&&($past(pipe_req)))
+		begin
+			assert($past(flash_addr & ~WRAP_MASK)
+					== $past(f_last_addr & ~WRAP_MASK));
+			assert($past(f_skip_gap) <= SKIPAHEAD);
+			assert($past(pipe_skip) == $past(f_skip_gap));
+			assert(clk_ctr == NDATA * (1 + $past(f_skip_gap)));
+		end
+
+		always @(posedge i_clk)
+		if ((f_past_valid)&&(!$past(i_reset))&&(!$past(i_wb_stb)))
+			assert(pipe_skip == 0);
+	end endgenerate
+
+	// An early acknowledgment never coincides with any other
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset))&&(early_ack))
+	begin
+		if (r_rddelay == 0)
+			assert(!dly_ack);
+		assert(!cfg_mode);
+	end
+	// }}}
+`endif
 	////////////////////////////////////////////////////////////////////////
 	//
 	// Cover Properties
@@ -2412,10 +3726,10 @@ module	qflexpress #(
 		always @(posedge i_clk)
 			cover((o_wb_ack)&&(!cfg_mode));
 		always @(posedge i_clk)
-			cover((o_wb_ack)&&(!cfg_mode)&&(!$past(o_qspi_cs_n)));
+			cover((o_wb_ack)&&(!cfg_mode)&&(!$past(qspi_cs_n)));
 		always @(posedge i_clk)
 			// Cover a piped transaction
-			cover((o_wb_ack)&&(!cfg_mode)&&(!o_qspi_cs_n));	//!
+			cover((o_wb_ack)&&(!cfg_mode)&&(!qspi_cs_n));	//!
 		always @(posedge i_clk)
 			cover((o_wb_ack)&&(cfg_mode)&&(cfg_speed));
 		always @(posedge i_clk)
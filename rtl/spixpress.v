@@ -6,7 +6,9 @@
 //
 // Purpose:	This module is intended to be a low logic flash controller.
 // 		It uses the 8'h03 read command from the flash, and so it
-// 	cannot be used with a clock speed any greater than 50MHz.
+// 	cannot be used with a clock speed any greater than 50MHz--unless
+//	OPT_FASTREAD is set, in which case it uses the 8'h0b fast read command
+//	instead.
 //
 //	Although this controller has no erase or program capability, it
 //	includes a control port.  When using the control port, you should be
@@ -84,6 +86,16 @@
 // }}}
 module	spixpress #(
 		// {{{
+		// LGFLASHSZ
+		// {{{
+		// LGFLASHSZ is the log, base two, of the size of the flash in
+		// bytes.  Anything greater than 24 requires four byte
+		// addresses, and so the four byte read commands, 8'h13 or
+		// (with OPT_FASTREAD) 8'h0c.  LGFLASHSZ may go up to 32.
+		parameter	LGFLASHSZ = 24,
+		localparam [0:0]	OPT_ADDR32 = (LGFLASHSZ > 24),
+		localparam		AW = LGFLASHSZ-2,
+		// }}}
 		// OPT_PIPE
 		// {{{
 		// OPT_PIPE allows successive, sequential, transactions to
@@ -93,8 +105,27 @@ module	spixpress #(
 		// Random access performance:	65+64(N-1)
 		// Performance when piped:	65+32(N-1)
 		//
+		// OPT_FASTREAD, below, and four byte addresses each add
+		// eight clocks to every new address.
 		parameter [0:0]	OPT_PIPE = 1'b1,
 		// }}}
+		// OPT_FASTREAD
+		// {{{
+		// OPT_FASTREAD reads the flash using the fast read command,
+		// 8'h0b (8'h0c with four byte addresses), followed by eight
+		// dummy clocks, rather than the 8'h03 read command.  The
+		// normal read command is limited to 50MHz or so, whereas the
+		// fast read allows SCK to run at the full system clock rate.
+		parameter [0:0]	OPT_FASTREAD = 1'b0,
+		localparam	NDUMMY   = (OPT_FASTREAD) ? 8 : 0,
+		localparam	ADDRBITS = (OPT_ADDR32) ? 32 : 24,
+		localparam [7:0]	READ_CMD = (OPT_ADDR32)
+					? ((OPT_FASTREAD) ? 8'h0c : 8'h13)
+					: ((OPT_FASTREAD) ? 8'h0b : 8'h03),
+		// The clocks from a new read request to its acknowledgment:
+		// the command, address, dummy cycles, and 32 data bits
+		localparam [6:0]	READ_DELAY = 7'd41 + ADDRBITS + NDUMMY,
+		// }}}
 		// OPT_CFG
 		// {{{
 		// OPT_CFG creates a configuration register that can be accessed
@@ -104,7 +135,25 @@ module	spixpress #(
 		// flash.  Since the access is arbitrary, other flash features
 		// are supported as well such as programming or reading the
 		// one-time-programmable memory or more.
-		parameter [0:0]	OPT_CFG  = 1'b1
+		parameter [0:0]	OPT_CFG  = 1'b1,
+		// }}}
+		// OPT_PERF
+		// {{{
+		// OPT_PERF adds a set of performance counters to the
+		// configuration port, found where i_wb_addr[4:0] is between
+		// PERF_ADDR (5'h08) and 5'h0d.  These are, in order, the
+		// clock cycles, memory reads, pipelined memory reads, memory
+		// reads requiring a new address, clock cycles where a request
+		// was stalled, and clock cycles spent in the configuration
+		// (user) mode.  Reads, outside of the configuration mode,
+		// return a snapshot of the counters.  Writing a one to bit 0
+		// of PERF_ADDR takes a new snapshot, and a one to bit 1
+		// clears the counters.  Any other configuration port address
+		// reaches the control port described above.  This option
+		// requires OPT_CFG.
+		parameter [0:0]	OPT_PERF = 1'b0,
+		localparam [0:0]	OPT_PERFCTR = OPT_PERF && OPT_CFG,
+		localparam [4:0]	PERF_ADDR = 5'h08
 		// }}}
 		// }}}
 	) (
@@ -112,7 +161,7 @@ module	spixpress #(
 		input	wire		i_clk, i_reset,
 		//
 		input	wire		i_wb_cyc, i_wb_stb, i_cfg_stb, i_wb_we,
-		input	wire	[21:0]	i_wb_addr,
+		input	wire	[AW-1:0]	i_wb_addr,
 		input	wire	[31:0]	i_wb_data,
 		output	reg		o_wb_stall, o_wb_ack,
 		output	reg	[31:0]	o_wb_data,
@@ -125,13 +174,16 @@ module	spixpress #(
 	// Signal declarations
 	// {{{
 	reg		cfg_user_mode;
-	reg	[32:0]	wdata_pipe;
+	reg	[ADDRBITS+8:0]	wdata_pipe;
 	reg	[6:0]	ack_delay;
 	reg		actual_sck;
 
-	wire	[21:0]	next_addr;
+	wire	[AW-1:0]	next_addr;
 
 	wire	bus_request, next_request, user_request;
+
+	wire		perf_sel, perf_stb, perf_write;
+	wire	[31:0]	perf_data;
 	// }}}
 
 	assign	bus_request  = (i_wb_stb)&&(!o_wb_stall)
@@ -140,7 +192,14 @@ module	spixpress #(
 					&&(!cfg_user_mode)
 					&&(i_wb_addr == next_addr);
 	assign	user_request = (OPT_CFG)&&(i_cfg_stb)&&(!o_wb_stall)
-					&&(i_wb_we)&&(!i_wb_data[8]);
+					&&(i_wb_we)&&(!i_wb_data[8])&&(!perf_sel);
+
+	assign	perf_sel   = (OPT_PERFCTR)&&(i_wb_addr[4:3] == PERF_ADDR[4:3])
+					&&(i_wb_addr[2:1] != 2'b11);
+	assign	perf_stb   = (OPT_PERFCTR)&&(i_cfg_stb)&&(!o_wb_stall)
+					&&(perf_sel);
+	assign	perf_write = (perf_stb)&&(i_wb_we)
+					&&(i_wb_addr[2:0] == PERF_ADDR[2:0]);
 
 
 	// ack_delay (State control)
@@ -153,7 +212,7 @@ module	spixpress #(
 	if ((i_reset)||(!i_wb_cyc))
 		ack_delay <= 0;
 	else if (bus_request)
-		ack_delay <= ((o_spi_cs_n)||(!OPT_PIPE)) ? 7'd65 : 7'd32;
+		ack_delay <= ((o_spi_cs_n)||(!OPT_PIPE)) ? READ_DELAY : 7'd32;
 	else if (user_request)
 		ack_delay <= 7'd9;
 	else if (ack_delay != 0)
@@ -167,7 +226,9 @@ module	spixpress #(
 	// wdata_pipe is a long shift register, containing values that need
 	// to be sent to the SPI port for our current transaction.  The
 	// basic transaction requires sending a 8'h03 (read) command, followed
-	// by a 24-bit address.
+	// by a 24-bit address.  READ_CMD and ADDRBITS generalize this to the
+	// fast and four byte address reads.  The dummy clocks of a fast
+	// read then send the zeros shifted in behind the address.
 	//
 	// For purposes of logic minimization, setting wdata_pipe has been
 	// broken up into two sections, but it basically follows a couple
@@ -193,31 +254,34 @@ module	spixpress #(
 	initial	wdata_pipe = 0;
 	always @(posedge i_clk)
 	if (!o_wb_stall)
+	begin
 		// On any read request, this sets the address to be read.
 		//
 		// On a configuration write request, or if the bus is idle,
 		// these bits are don't cares so we can optimize them a bit
-		wdata_pipe[23:0] <= { i_wb_addr[21:0], 2'b00 };
-	else
+		wdata_pipe[ADDRBITS-1:0] <= 0;
+		wdata_pipe[LGFLASHSZ-1:0] <= { i_wb_addr, 2'b00 };
+	end else
 		// While in operation, just shift left one bit at a time
-		wdata_pipe[23:0] <= { wdata_pipe[22:0], 1'b0 };
+		wdata_pipe[ADDRBITS-1:0] <= { wdata_pipe[ADDRBITS-2:0], 1'b0 };
 
 	always @(posedge i_clk)
 	if (((!OPT_CFG)||(i_wb_stb))&&(!o_wb_stall)) // (bus_request)
 		// Request to read from the flash
-		wdata_pipe[32:24] <= { 1'b0, 8'h03 };
+		wdata_pipe[ADDRBITS+8:ADDRBITS] <= { 1'b0, READ_CMD };
 	else if ((OPT_CFG)&&(!o_wb_stall)) // (user_request)
 		// Request to send special data to the flash
-		wdata_pipe[32:24] <= { 1'b0, i_wb_data[7:0] };
+		wdata_pipe[ADDRBITS+8:ADDRBITS] <= { 1'b0, i_wb_data[7:0] };
 	else
 		// Otherwise just shift the register left
-		wdata_pipe[32:24] <= { wdata_pipe[31:23] };
+		wdata_pipe[ADDRBITS+8:ADDRBITS]
+				<= { wdata_pipe[ADDRBITS+7:ADDRBITS-1] };
 	// }}}
 
 	// The outgoing bit to the flash is simply given by the top bit of
 	// this wdata_pipe shift register.
 	always @(*)
-		o_spi_mosi = wdata_pipe[32];
+		o_spi_mosi = wdata_pipe[ADDRBITS+8];
 
 	// o_wb_ack, WB-ACK
 	// {{{
@@ -254,7 +318,8 @@ module	spixpress #(
 	always @(posedge i_clk)
 	if (i_reset)
 		cfg_user_mode <= 0;
-	else if ((OPT_CFG)&&(i_cfg_stb)&&(!o_wb_stall)&&(i_wb_we))
+	else if ((OPT_CFG)&&(i_cfg_stb)&&(!o_wb_stall)&&(i_wb_we)
+			&&(!perf_sel))
 		cfg_user_mode <= !i_wb_data[8];
 	// }}}
 
@@ -286,6 +351,10 @@ module	spixpress #(
 				o_wb_data <= { o_wb_data[30:0], i_spi_miso };
 		end
 
+		if ((perf_stb)&&(!i_wb_we))
+			// Reads of the performance counters are immediate
+			o_wb_data <= perf_data;
+
 		if (cfg_user_mode)
 			o_wb_data[31:8] <= { 19'h0, 1'b1, 4'h0 };
 	end
@@ -308,7 +377,8 @@ module	spixpress #(
 		// On any bus read request, select the device to initiate a
 		// transaction.
 		o_spi_cs_n <= 1'b0;
-	else if ((OPT_CFG)&&(i_cfg_stb)&&(!o_wb_stall)&&(i_wb_we))
+	else if ((OPT_CFG)&&(i_cfg_stb)&&(!o_wb_stall)&&(i_wb_we)
+			&&(!perf_sel))
 		// Similarly, on any write to the configuration port, begin
 		// an 8-bit transfer.
 		o_spi_cs_n <= i_wb_data[8];
@@ -372,7 +442,7 @@ module	spixpress #(
 	// {{{
 	generate if (OPT_PIPE)
 	begin
-		reg	[21:0]	r_next_addr;
+		reg	[AW-1:0]	r_next_addr;
 		always @(posedge i_clk)
 		if (!o_wb_stall)
 			r_next_addr <= i_wb_addr + 1'b1;
@@ -386,6 +456,74 @@ module	spixpress #(
 	end endgenerate
 	// }}}
 
+	// Performance counters (OPT_PERF)
+	// {{{
+	generate if (OPT_PERFCTR)
+	begin : GEN_PERF
+		// {{{
+		localparam	NPERF = 6;
+		wire	[NPERF-1:0]	perf_evt;
+		reg	[32*NPERF-1:0]	perf_count, perf_snap;
+		reg	[31:0]		r_perf_data;
+		integer			pk;
+
+		// A read is pipelined if it arrives while the device remains
+		// selected from the last one
+		assign	perf_evt = { cfg_user_mode,
+			(i_wb_cyc)&&((i_wb_stb)||(i_cfg_stb))&&(o_wb_stall),
+			(bus_request)&&((o_spi_cs_n)||(!OPT_PIPE)),
+			(bus_request)&&(!o_spi_cs_n)&&(OPT_PIPE),
+			bus_request, 1'b1 };
+
+		initial	perf_count = 0;
+		always @(posedge i_clk)
+		if ((i_reset)||((perf_write)&&(i_wb_data[1])))
+			perf_count <= 0;
+		else for(pk=0; pk<NPERF; pk=pk+1)
+			perf_count[32*pk +: 32] <= perf_count[32*pk +: 32]
+						+ { 31'h0, perf_evt[pk] };
+
+		initial	perf_snap = 0;
+		always @(posedge i_clk)
+		if (i_reset)
+			perf_snap <= 0;
+		else if ((perf_write)&&(i_wb_data[0]))
+			perf_snap <= perf_count;
+
+		always @(*)
+		case(i_wb_addr[2:0])
+		3'h0:	 r_perf_data = perf_snap[ 31:  0];
+		3'h1:	 r_perf_data = perf_snap[ 63: 32];
+		3'h2:	 r_perf_data = perf_snap[ 95: 64];
+		3'h3:	 r_perf_data = perf_snap[127: 96];
+		3'h4:	 r_perf_data = perf_snap[159:128];
+		3'h5:	 r_perf_data = perf_snap[191:160];
+		default: r_perf_data = 0;
+		endcase
+
+		assign	perf_data = r_perf_data;
+`ifdef	FORMAL
+		always @(*)
+		begin
+			assert(perf_count[63:32] == perf_count[95:64]
+						+ perf_count[127:96]);
+			assert(perf_snap[63:32] == perf_snap[95:64]
+						+ perf_snap[127:96]);
+		end
+`endif
+		// }}}
+	end else begin : NO_PERF
+
+		assign	perf_data = 0;
+
+		// verilator lint_off UNUSED
+		wire	unused_perf;
+		assign	unused_perf = perf_write;
+		// verilator lint_on  UNUSED
+
+	end endgenerate
+	// }}}
+
 	// Make Verilator happy
 	// {{{
 	// verilator lint_off UNUSED
@@ -438,7 +576,8 @@ module	spixpress #(
 	localparam	F_LGDEPTH = 7;
 	wire	[F_LGDEPTH-1:0]	f_nreqs, f_nacks, f_outstanding;
 
-	fwb_slave #( .AW(22), .F_MAX_STALL(7'd66), .F_MAX_ACK_DELAY(7'd66),
+	fwb_slave #( .AW(AW), .F_MAX_STALL(READ_DELAY+1),
+			.F_MAX_ACK_DELAY(READ_DELAY+1),
 			.F_LGDEPTH(F_LGDEPTH),
 			.F_MAX_REQUESTS((OPT_PIPE) ? 0 : 1'b1),
 			.F_OPT_MINCLOCK_DELAY(1'b1)
@@ -513,7 +652,7 @@ module	spixpress #(
 		assert(o_wb_stall);
 
 	always @(*)
-		assert(ack_delay <= 7'd65);
+		assert(ack_delay <= READ_DELAY);
 
 	always @(*)
 	if (cfg_user_mode)
@@ -570,11 +709,11 @@ module	spixpress #(
 `endif
 `ifdef	VERIFIC
 	// {{{
-	reg	[21:0]	f_last_addr, f_next_addr;
+	reg	[AW-1:0]	f_last_addr, f_next_addr;
 
 	always @(posedge i_clk)
 	if (bus_request)
-		f_last_addr <= i_wb_addr[21:0];
+		f_last_addr <= i_wb_addr;
 
 	always @(*)
 		f_next_addr <= f_last_addr + 1'b1;
@@ -592,51 +731,50 @@ module	spixpress #(
 		|-> (OPT_PIPE)&&(i_wb_addr == f_next_addr)
 		);
 
+	// The address bits, as they are sent to the flash
+	reg	[ADDRBITS-1:0]	f_addr_bits;
+	always @(*)
+	begin
+		f_addr_bits = 0;
+		f_addr_bits[LGFLASHSZ-1:0] = { f_last_addr, 2'b00 };
+	end
+
 	sequence READ_COMMAND;
-		// Send command 8'h03
+		// Send READ_CMD, nominally 8'h03
 		(f_last_addr == $past(i_wb_addr))
 				&&(!o_spi_cs_n)&&(o_spi_sck)&&(!o_spi_mosi)
 				&&(!actual_sck)
 		##1 ( ((f_last_addr == $past(f_last_addr))
 			&&(!o_spi_cs_n)&&(o_spi_sck)&&(actual_sck)) throughout
-				(!o_spi_mosi)&&(ack_delay==7'd64)&&(actual_sck)
-				##1 (!o_spi_mosi)&&(ack_delay==7'd63)
-				##1 (!o_spi_mosi)&&(ack_delay==7'd62)
-				##1 (!o_spi_mosi)&&(ack_delay==7'd61)
-				##1 (!o_spi_mosi)&&(ack_delay==7'd60)
-				##1 (!o_spi_mosi)&&(ack_delay==7'd59)
-				##1 ( o_spi_mosi)&&(ack_delay==7'd58)
-				##1 ( o_spi_mosi)&&(ack_delay==7'd57));
+				(o_spi_mosi == READ_CMD[7])
+					&&(ack_delay==READ_DELAY-1)&&(actual_sck)
+				##1 (o_spi_mosi == READ_CMD[6])
+					&&(ack_delay==READ_DELAY-2)
+				##1 (o_spi_mosi == READ_CMD[5])
+					&&(ack_delay==READ_DELAY-3)
+				##1 (o_spi_mosi == READ_CMD[4])
+					&&(ack_delay==READ_DELAY-4)
+				##1 (o_spi_mosi == READ_CMD[3])
+					&&(ack_delay==READ_DELAY-5)
+				##1 (o_spi_mosi == READ_CMD[2])
+					&&(ack_delay==READ_DELAY-6)
+				##1 (o_spi_mosi == READ_CMD[1])
+					&&(ack_delay==READ_DELAY-7)
+				##1 (o_spi_mosi == READ_CMD[0])
+					&&(ack_delay==READ_DELAY-8));
 	endsequence
 
 	sequence	SEND_ADDRESS;
+		// ADDRBITS address bits, MSB first, ending with ack_delay
+		// at 33+NDUMMY
 		(((f_last_addr == $past(f_last_addr))&&(!o_spi_cs_n)&&(o_spi_sck)
 			&&(actual_sck))
 		throughout
-			(o_spi_mosi == f_last_addr[21])&&(ack_delay==7'd56)
-			##1 (o_spi_mosi == f_last_addr[20])&&(ack_delay==7'd55)
-			##1 (o_spi_mosi == f_last_addr[19])&&(ack_delay==7'd54)
-			##1 (o_spi_mosi == f_last_addr[18])&&(ack_delay==7'd53)
-			##1 (o_spi_mosi == f_last_addr[17])&&(ack_delay==7'd52)
-			##1 (o_spi_mosi == f_last_addr[16])&&(ack_delay==7'd51)
-			##1 (o_spi_mosi == f_last_addr[15])&&(ack_delay==7'd50)
-			##1 (o_spi_mosi == f_last_addr[14])&&(ack_delay==7'd49)
-			##1 (o_spi_mosi == f_last_addr[13])&&(ack_delay==7'd48)
-			##1 (o_spi_mosi == f_last_addr[12])&&(ack_delay==7'd47)
-			##1 (o_spi_mosi == f_last_addr[11])&&(ack_delay==7'd46)
-			##1 (o_spi_mosi == f_last_addr[10])&&(ack_delay==7'd45)
-			##1 (o_spi_mosi == f_last_addr[ 9])&&(ack_delay==7'd44)
-			##1 (o_spi_mosi == f_last_addr[ 8])&&(ack_delay==7'd43)
-			##1 (o_spi_mosi == f_last_addr[ 7])&&(ack_delay==7'd42)
-			##1 (o_spi_mosi == f_last_addr[ 6])&&(ack_delay==7'd41)
-			##1 (o_spi_mosi == f_last_addr[ 5])&&(ack_delay==7'd40)
-			##1 (o_spi_mosi == f_last_addr[ 4])&&(ack_delay==7'd39)
-			##1 (o_spi_mosi == f_last_addr[ 3])&&(ack_delay==7'd38)
-			##1 (o_spi_mosi == f_last_addr[ 2])&&(ack_delay==7'd37)
-			##1 (o_spi_mosi == f_last_addr[ 1])&&(ack_delay==7'd36)
-			##1 (o_spi_mosi == f_last_addr[ 0])&&(ack_delay==7'd35)
-			##1 (o_spi_mosi == 1'b0)&&(ack_delay==7'd34)
-			##1 (o_spi_mosi == 1'b0)&&(ack_delay==7'd33));
+			((ack_delay <= READ_DELAY-9)
+				&&(ack_delay >= 7'd33 + NDUMMY)
+				&&(o_spi_mosi
+					== f_addr_bits[ack_delay-7'd33-NDUMMY]))
+			[*ADDRBITS]);
 	endsequence
 
 	sequence	READ_DATA;
@@ -661,11 +799,12 @@ module	spixpress #(
 		disable iff ((i_reset)||(!i_wb_cyc))
 		(i_wb_stb)&&(!o_wb_stall)&&(!i_wb_we)&&(o_spi_cs_n)
 			&&(!cfg_user_mode)
-		// Send command 8'h03
+		// Send the read command
 		|=> READ_COMMAND
 		##1 ((f_last_addr == $past(f_last_addr)) throughout
 				SEND_ADDRESS)
-		##1 READ_DATA);
+		// Followed by any dummy clocks
+		##(1+NDUMMY) READ_DATA);
 
 
 	//////////////
@@ -705,7 +844,8 @@ module	spixpress #(
 		// Now for configuration writes
 		assert property (@(posedge i_clk)
 			disable iff ((i_reset)||(!i_wb_cyc))
-			((i_cfg_stb)&&(!o_wb_stall)&&(i_wb_we)&&(i_wb_data[8]))
+			((i_cfg_stb)&&(!o_wb_stall)&&(i_wb_we)&&(i_wb_data[8])
+				&&(!perf_sel))
 			|=> ((!cfg_user_mode)&&(o_spi_cs_n)&&(!o_spi_sck))
 				&&(o_wb_ack)&&(!o_wb_stall));
 
@@ -716,7 +856,8 @@ module	spixpress #(
 
 		assert property (@(posedge i_clk)
 			disable iff ((i_reset)||(!i_wb_cyc))
-			((i_cfg_stb)&&(!o_wb_stall)&&(i_wb_we)&&(!i_wb_data[8]))
+			((i_cfg_stb)&&(!o_wb_stall)&&(i_wb_we)&&(!i_wb_data[8])
+				&&(!perf_sel))
 			|=> (((cfg_user_mode)&&(!o_spi_cs_n)&&(o_spi_sck)
 				&&(o_wb_stall)) throughout
 				(!o_spi_mosi)&&(ack_delay==7'd9)
@@ -745,7 +886,8 @@ module	spixpress #(
 		// charge the o_wb_data buffer
 		assert property (@(posedge i_clk)
 			disable iff ((i_reset)||(!i_wb_cyc))
-			((i_cfg_stb)&&(!o_wb_stall)&&(i_wb_we)&&(!i_wb_data[8]))
+			((i_cfg_stb)&&(!o_wb_stall)&&(i_wb_we)&&(!i_wb_data[8])
+				&&(!perf_sel))
 			##2 DATA_BYTE(f_data[7:0])
 			|=> (o_wb_ack)&&(o_wb_data == { 24'h10,
 				$past(i_spi_miso,8), $past(i_spi_miso,7),
@@ -760,6 +902,7 @@ module	spixpress #(
 		assert property (@(posedge i_clk)
 			disable iff (i_reset)
 			($past(!o_spi_sck))&&(!o_spi_sck)&&(cfg_user_mode)
+				&&(!perf_stb)
 			|=> $stable(o_wb_data)&&(o_wb_data[31:8]==5'h10));
 
 	end endgenerate
@@ -0,0 +1,1635 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename:	sqflexpress.v
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	To provide wishbone controlled read access (and read access
+//		*only*) to a pair of Quad SPI flash devices, striped together
+//	so that each moves half of every byte.  The two devices share SCK and
+//	CSn, while each has its own four data pins: the first device, chip
+//	zero, is found on o_qspi_dat[3:0] and i_qspi_dat[3:0], the second,
+//	chip one, on [7:4].  This is a derivative of the Quad SPI flash
+//	controller, qflexpress.v, and shares its bus and configuration port
+//	models, its startup script, its XIP read protocol, and its OPT_PIPE,
+//	OPT_CLKDIV, and RDDELAY options.
+//
+//	Striping
+//	Chip one holds the upper nibble of every byte, chip zero the lower.
+//	A byte at (bus) address A is therefore split between the two devices,
+//	with its nibbles found at address A/2 within each.  Reading a byte
+//	takes one SCK rather than two, and a 32-bit word only four.  Commands,
+//	addresses, and mode bytes are sent to both devices at once.
+//
+//	Three modes/states of operation:
+//	1. Startup/maintenance, places both devices in the Quad XIP mode
+//	2. Normal operations, takes 10+NDUMMY+4N clocks to read N words
+//	3. Configuration--useful to allow an external controller issue erase
+//		or program commands (or other) without requiring us to
+//		clutter up the logic with a giant state machine
+//
+//	CONFIGURATION
+//	The configuration port works as it does for qflexpress, save that
+//	each transfer now carries a byte for each device: i_wb_data[7:0] for
+//	chip zero and i_wb_data[23:16] for chip one.  Commands and addresses
+//	must be placed in both.  Data to be programmed is split by nibble,
+//	so that each device receives its half of two bytes.  Reads, whether
+//	at single or quad speed, return chip zero's byte in o_wb_data[7:0]
+//	and chip one's in [23:16].  A status register read, then, will show
+//	a write in progress on either device.
+//
+//	STARTUP
+//	 1. Waits for the flash to come on line
+//	 2. Sends a signal to remove both devices from any QSPI read mode
+//	 3. Writes the configuration register to set the quad enable bit,
+//		and then places and leaves both devices in QSPI XIP mode
+//		0xEB 3(0x00) 0xa0 6(0x00)
+//	 4. All done
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2018-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+//
+`default_nettype	none
+// }}}
+module	sqflexpress #(
+		// {{{
+		// LGFLASHSZ
+		// {{{
+		// LGFLASHSZ is the size of the flash memory--both devices
+		// together.  Each device holds half of this, and is sent a
+		// 24-bit address, so LGFLASHSZ may go up to 25.
+		parameter	LGFLASHSZ=25,
+		// }}}
+		// OPT_PIPE
+		// {{{
+		// OPT_PIPE makes it possible to string multiple requests
+		// together, with no intervening need to shutdown the QSPI
+		// connection and send a new address
+		parameter [0:0]	OPT_PIPE    = 1'b1,
+		// }}}
+		// OPT_CFG
+		// {{{
+		// OPT_CFG enables the configuration logic port, and hence the
+		// ability to erase and program the flash, as well as the
+		// ability to perform other commands such as read-manufacturer
+		// ID, adjust configuration registers, etc.
+		parameter [0:0]	OPT_CFG     = 1'b1,
+		// }}}
+		//
+		// OPT_STARTUP enables the startup logic
+		parameter [0:0]	OPT_STARTUP = 1'b1,
+		//
+		parameter	OPT_CLKDIV = 0,
+		//
+		// OPT_ENDIANSWAP
+		// {{{
+		// As with qflexpress, the endian swap allows the bus to swap
+		// the return values in order to support little endian
+		// systems.
+		parameter [0:0]	OPT_ENDIANSWAP = 1'b1,
+		// }}}
+		// OPT_ODDR
+		// {{{
+		// OPT_ODDR will be true any time the clock has no clock
+		// division
+		localparam [0:0]	OPT_ODDR = (OPT_CLKDIV == 0),
+		// }}}
+		// CKDV_BITS
+		// {{{
+		// CKDV_BITS is the number of bits necessary to represent a
+		// counter that can do the CLKDIV division
+		localparam 	CKDV_BITS = (OPT_CLKDIV == 0) ? 0
+					: ((OPT_CLKDIV <   2) ? 1
+					: ((OPT_CLKDIV <   4) ? 2
+					: ((OPT_CLKDIV <   8) ? 3
+					: ((OPT_CLKDIV <  16) ? 4
+					: ((OPT_CLKDIV <  32) ? 5
+					: ((OPT_CLKDIV <  64) ? 6
+					: ((OPT_CLKDIV < 128) ? 7
+					: ((OPT_CLKDIV < 256) ? 8 : 9)))))))),
+		// }}}
+		// RDDELAY
+		// {{{
+		// RDDELAY is the number of clock cycles from when o_qspi_dat
+		// is valid until i_qspi_dat is valid.  As with qflexpress, DDR
+		// registered I/O on a Xilinx device can be done with a
+		// RDDELAY=3, Intel/Altera devices with RDDELAY=2, and iCE40
+		// devices with RDDELAY=0.  Both devices must share the same
+		// delay.
+		parameter	RDDELAY = 0,
+		// }}}
+		// NDUMMY
+		// {{{
+		// NDUMMY is the number of "dummy" clock cycles between the
+		// 24-bits of the Quad I/O address and the first data bits,
+		// including the two clocks of the mode byte, 0xa0--just as
+		// with qflexpress.  The bus read counter limits this to 20
+		// or fewer.
+		parameter	NDUMMY = 6,
+		// }}}
+		//
+		//
+		localparam [4:0]	CFG_MODE =	12,
+		localparam [4:0]	QSPEED_BIT = 	11,
+		localparam [4:0]	DSPEED_BIT = 	10, // Not supported
+		localparam [4:0]	DIR_BIT	= 	 9,
+		localparam [4:0]	USER_CS_n = 	 8,
+		//
+		localparam [1:0]	NORMAL_SPI = 	2'b00,
+		localparam [1:0]	QUAD_WRITE = 	2'b10,
+		localparam [1:0]	QUAD_READ = 	2'b11,
+		//
+		localparam	AW=LGFLASHSZ-2,
+		localparam	DW=32,
+		// The data pipe holds the address and mode byte, one nibble
+		// for each device per clock, with room for eight single bits
+		// in low speed configuration writes.  Without ODDR support,
+		// one more byte goes out before SCK's first rising edge.
+		localparam	DPW = 64 + (OPT_ODDR ? 0:8),
+		localparam [5:0] RD_CLOCKS = 10 + NDUMMY + (OPT_ODDR ? 0:1),
+		localparam [5:0] PIPE_CLOCKS = 4
+`ifdef	FORMAL
+		, localparam	F_LGDEPTH=$clog2(3+RDDELAY)
+`endif
+		// }}}
+	) (
+		// {{{
+		input	wire			i_clk, i_reset,
+		//
+		input	wire			i_wb_cyc, i_wb_stb,
+						i_cfg_stb, i_wb_we,
+		input	wire	[(AW-1):0]	i_wb_addr,
+		input	wire	[(DW-1):0]	i_wb_data,
+		//
+		output	reg			o_wb_stall,
+		output	reg			o_wb_ack,
+		output	reg	[(DW-1):0]	o_wb_data,
+		//
+		output	reg		o_qspi_sck,
+		output	reg		o_qspi_cs_n,
+		output	reg	[1:0]	o_qspi_mod,
+		output	wire	[7:0]	o_qspi_dat,
+		input	wire	[7:0]	i_qspi_dat
+		// }}}
+	);
+
+	// Signal declarations
+	// {{{
+`ifdef	FORMAL
+	reg	f_past_valid;
+`endif
+
+	reg		dly_ack, read_sck, xtra_stall;
+	// clk_ctr must have enough bits for ...
+	//	6		address clocks, 4-bits per device each
+	//	NDUMMY		dummy clocks, including the mode byte
+	//	4		data clocks
+	//	(RDDELAY clocks not counted here)
+	reg	[5:0]	clk_ctr;
+
+	//
+	// User override logic
+	//
+	reg	cfg_mode, cfg_speed, cfg_dir, cfg_cs;
+	wire	cfg_write, cfg_hs_write, cfg_ls_write, cfg_hs_read,
+		user_request, bus_request, pipe_req, cfg_noop, cfg_stb;
+	//
+	assign	bus_request  = (i_wb_stb)&&(!o_wb_stall)
+					&&(!i_wb_we)&&(!cfg_mode);
+	assign	cfg_stb      = (OPT_CFG)&&(i_cfg_stb)&&(!o_wb_stall);
+	assign	cfg_noop     = ((cfg_stb)&&((!i_wb_we)||(!i_wb_data[CFG_MODE])
+					||(i_wb_data[USER_CS_n])))
+				||((!OPT_CFG)&&(i_cfg_stb)&&(!o_wb_stall));
+	assign	user_request = (cfg_stb)&&(i_wb_we)&&(i_wb_data[CFG_MODE]);
+
+	assign	cfg_write    = (user_request)&&(!i_wb_data[USER_CS_n]);
+	assign	cfg_hs_write = (cfg_write)&&(i_wb_data[QSPEED_BIT])
+					&&(i_wb_data[DIR_BIT]);
+	assign	cfg_hs_read  = (cfg_write)&&(i_wb_data[QSPEED_BIT])
+					&&(!i_wb_data[DIR_BIT]);
+	assign	cfg_ls_write = (cfg_write)&&(!i_wb_data[QSPEED_BIT]);
+
+
+	reg		ckstb, ckpos, ckneg, ckpre;
+	reg		maintenance;
+	reg	[1:0]	m_mod;
+	reg		m_cs_n;
+	reg		m_clk;
+	reg	[7:0]	m_dat;
+
+	reg	[DPW-1:0]	data_pipe;
+	reg	[23:0]		w_addr;
+	reg	[63:0]		w_xipcmd;
+	reg	pre_ack = 1'b0;
+	reg	actual_sck;
+
+	wire	[7:0]	sdr_odat, sdr_idat;
+	// }}}
+
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Clock division: ckstb, ckpos, ckneg, ckpre
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	generate if (OPT_ODDR)
+	begin // Flash clock == system clock speed
+		// {{{
+		always @(*)
+		begin
+			ckstb = 1'b1;
+			ckpos = 1'b1;
+			ckneg = 1'b1;
+			ckpre = 1'b1;
+		end
+		// }}}
+	end else if (OPT_CLKDIV == 1)
+	begin : CKSTB_ONE // Flash clock can be generated logically, == sysclk/2
+		// {{{
+		reg	clk_counter;
+
+		initial	clk_counter = 1'b1;
+		always @(posedge i_clk)
+		if (i_reset)
+			clk_counter <= 1'b1;
+		else if (clk_counter != 0)
+			clk_counter <= 1'b0;
+		else if (bus_request)
+			clk_counter <= (pipe_req);
+		else if ((maintenance)||(!o_qspi_cs_n && o_wb_stall))
+			clk_counter <= 1'b1;
+
+		always @(*)
+		begin
+			ckpre = (clk_counter == 1);
+			ckstb = (clk_counter == 0);
+			ckpos = (clk_counter == 1);
+			ckneg = (clk_counter == 0);
+		end
+		// }}}
+	end else begin : CKSTB_GEN
+		// {{{
+		reg	[CKDV_BITS-1:0]	clk_counter;
+
+		initial	clk_counter = OPT_CLKDIV;
+		always @(posedge i_clk)
+		if (i_reset)
+			clk_counter <= OPT_CLKDIV;
+		else if (clk_counter != 0)
+			clk_counter <= clk_counter - 1;
+		else if (bus_request)
+			clk_counter <= (pipe_req ? OPT_CLKDIV : 0);
+		else if ((maintenance)||(!o_qspi_cs_n && o_wb_stall))
+			clk_counter <= OPT_CLKDIV;
+
+		initial	ckpre = (OPT_CLKDIV == 1);
+		initial	ckstb = 1'b0;
+		initial	ckpos = (OPT_CLKDIV == 1);
+		always @(posedge i_clk)
+		if (i_reset)
+		begin
+			ckpre <= (OPT_CLKDIV == 1);
+			ckstb <= 1'b0;
+			ckpos <= (OPT_CLKDIV == 1);
+		end else // if (OPT_CLKDIV > 1)
+		begin
+			ckpre <= (clk_counter == 2);
+			ckstb <= (clk_counter == 1);
+			ckpos <= (clk_counter == (OPT_CLKDIV+1)/2+1);
+		end
+
+		always @(*)
+			ckneg = ckstb;
+`ifdef	FORMAL
+		always @(*)
+			assert(!ckpos || !ckneg);
+
+		always @(posedge i_clk)
+		if ((f_past_valid)&&(!$past(i_reset))&&($past(ckpre)))
+			assert(ckstb);
+`endif
+		// }}}
+	end endgenerate
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Maintenance / startup portion
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	generate if (OPT_STARTUP)
+	begin : GEN_STARTUP
+		// {{{
+		// Signal declarations
+		// {{{
+		localparam	M_WAITBIT=10;
+		localparam	M_LGADDR=5;
+`ifdef	FORMAL
+		// For formal, jump into the middle of the startup
+		localparam	M_FIRSTIDX=9;
+`else
+		localparam	M_FIRSTIDX=0;
+`endif
+		reg	[M_WAITBIT:0]	m_this_word;
+		reg	[M_WAITBIT:0]	m_cmd_word	[0:(1<<M_LGADDR)-1];
+		reg	[M_LGADDR-1:0]	m_cmd_index;
+
+		reg	[M_WAITBIT-1:0]	m_counter;
+		reg			m_midcount;
+		reg	[3:0]		m_bitcount;
+		reg	[7:0]		m_byte;
+		// }}}
+
+		// Command ISA description:
+		// {{{
+		// The script is that of qflexpress, and its words have the
+		// same format.  Each is sent to both devices at once.
+		//
+		//	1'bit (MSB) to indicate this is a counter word.
+		//		Counter words count a number of idle cycles,
+		//		in which the port is unused (CSN is high)
+		//
+		//	2'bit mode.  This is either ...
+		//	    NORMAL_SPI, for a normal SPI interaction, sending
+		//			each bit on both devices' MOSI
+		//	    QUAD_READ, all pins set as inputs.  In this
+		//			startup, the input values will be
+		//			ignored.
+		//	or  QUAD_WRITE, all pins are outputs, sending each
+		//			nibble to both devices
+		//
+		//	8'bit data	To be sent 1-bit at a time in NORMAL_SPI
+		//			mode, or 4-bits at a time in QUAD_WRITE
+		//			mode.  Ignored otherwise
+		// }}}
+		integer k;
+		initial
+		begin
+		// {{{
+		for(k=0; k<(1<<M_LGADDR); k=k+1)
+			m_cmd_word[k] = -1;
+		// Start off idle
+		m_cmd_word[5'h07] = -1;
+		//
+		// Exit any QSPI mode we might've been in
+		m_cmd_word[5'h08] = { 1'b0, NORMAL_SPI, 8'hff }; // Addr 1
+		m_cmd_word[5'h09] = { 1'b0, NORMAL_SPI, 8'hff }; // Addr 2
+		m_cmd_word[5'h0a] = { 1'b0, NORMAL_SPI, 8'hff }; // Addr 2
+		// Idle
+		m_cmd_word[5'h0b] = { 1'b1, 10'h3f };
+		//
+		// Write configuration register
+		//
+		// The write enable must come first: 06
+		m_cmd_word[5'h0c] = { 1'b0, NORMAL_SPI, 8'h06 };
+		//
+		// Idle
+		m_cmd_word[5'h0d] = { 1'b1, 10'h3ff };
+		//
+		// Write configuration register, follows a write-register
+		m_cmd_word[5'h0e] = { 1'b0, NORMAL_SPI, 8'h01 };	// WRR
+		m_cmd_word[5'h0f] = { 1'b0, NORMAL_SPI, 8'h00 };	// status register
+		m_cmd_word[5'h10] = { 1'b0, NORMAL_SPI, 8'h02 };	// Config register
+		//
+		// Idle
+		m_cmd_word[5'h11] = { 1'b1, 10'h3ff };
+		m_cmd_word[5'h12] = { 1'b1, 10'h3ff };
+		//
+		//
+		// WRDI: write disable: 04
+		m_cmd_word[5'h13] = { 1'b0, NORMAL_SPI, 8'h04 };
+		//
+		// Idle
+		m_cmd_word[5'h14] = { 1'b1, 10'h3ff };
+		//
+		// Enter into QSPI mode, 0xeb, 0,0,0
+		// 0xeb
+		m_cmd_word[5'h15] = { 1'b0, NORMAL_SPI, 8'heb };
+		// Addr #1
+		m_cmd_word[5'h16] = { 1'b0, QUAD_WRITE, 8'h00 };
+		// Addr #2
+		m_cmd_word[5'h17] = { 1'b0, QUAD_WRITE, 8'h00 };
+		// Addr #3
+		m_cmd_word[5'h18] = { 1'b0, QUAD_WRITE, 8'h00 };
+		// Mode byte
+		m_cmd_word[5'h19] = { 1'b0, QUAD_WRITE, 8'ha0 };
+		// Dummy clocks, x6 for this flash
+		m_cmd_word[5'h1a] = { 1'b0, QUAD_WRITE, 8'h00 };
+		m_cmd_word[5'h1b] = { 1'b0, QUAD_WRITE, 8'h00 };
+		m_cmd_word[5'h1c] = { 1'b0, QUAD_WRITE, 8'h00 };
+		// Now read a byte for form
+		m_cmd_word[5'h1d] = { 1'b0, QUAD_READ, 8'h00 };
+		//
+		// Idle -- These last two idles are *REQUIRED* and not optional
+		m_cmd_word[5'h1e] = -1;
+		m_cmd_word[5'h1f] = -1;
+		// Then we are in business!
+		// }}}
+		end
+
+		reg	m_final;
+
+		wire	m_ce, new_word;
+		assign	m_ce = (!m_midcount)&&(ckstb);
+		assign	new_word = (m_ce && m_bitcount == 0);
+
+		// m_cmd_index, maintenance (on/off)
+		// {{{
+		initial	maintenance = 1'b1;
+		initial	m_cmd_index = M_FIRSTIDX;
+		always @(posedge i_clk)
+		if (i_reset)
+		begin
+			m_cmd_index <= M_FIRSTIDX;
+			maintenance <= 1'b1;
+		end else if (new_word)
+		begin
+			maintenance <= (maintenance)&&(!m_final);
+			if (!(&m_cmd_index))
+				m_cmd_index <= m_cmd_index + 1'b1;
+		end
+		// }}}
+
+		// m_this_word -- current command
+		// {{{
+		initial	m_this_word = -1;
+		always @(posedge i_clk)
+		if (new_word)
+			m_this_word <= m_cmd_word[m_cmd_index];
+		// }}}
+
+		// m_final
+		// {{{
+		initial	m_final = 1'b0;
+		always @(posedge i_clk)
+		if (i_reset)
+			m_final <= 1'b0;
+		else if (new_word)
+			m_final <= (m_final || (&m_cmd_index));
+		// }}}
+
+		// m_midcount .. are we in the middle of a counter/pause?
+		// {{{
+		initial	m_midcount = 1;
+		initial	m_counter   = -1;
+		always @(posedge i_clk)
+		if (i_reset)
+		begin
+			// {{{
+			m_midcount <= 1'b1;
+`ifdef	FORMAL
+			m_counter <= 3;
+`else
+			m_counter <= -1;
+`endif
+			// }}}
+		end else if (new_word)
+		begin
+			// {{{
+			m_midcount <= m_this_word[M_WAITBIT]
+					&& (|m_this_word[M_WAITBIT-1:0]);
+			if (m_this_word[M_WAITBIT])
+			begin
+				m_counter <= m_this_word[M_WAITBIT-1:0];
+`ifdef	FORMAL
+				if (m_this_word[M_WAITBIT-1:0] > 3)
+					m_counter <= 3;
+`endif
+			end
+			// }}}
+		end else begin
+			// {{{
+			m_midcount <= (m_counter > 1);
+			if (m_counter > 0)
+				m_counter <= m_counter - 1'b1;
+			// }}}
+		end
+		// }}}
+
+		// m_cs_n, m_mod, m_bitcount
+		// {{{
+		initial	m_cs_n      = 1'b1;
+		initial	m_mod       = NORMAL_SPI;
+		always @(posedge i_clk)
+		if (i_reset)
+		begin
+			m_cs_n <= 1'b1;
+			m_mod  <= NORMAL_SPI;
+			m_bitcount <= 0;
+		end else if (ckstb)
+		begin
+			if (m_bitcount != 0)
+				m_bitcount <= m_bitcount - 1;
+			else if ((m_ce)&&(m_final))
+			begin
+				m_cs_n <= 1'b1;
+				m_mod  <= NORMAL_SPI;
+				m_bitcount <= 0;
+			end else if ((m_midcount)||(m_this_word[M_WAITBIT]))
+			begin
+				m_cs_n <= 1'b1;
+				m_mod  <= NORMAL_SPI;
+				m_bitcount <= 0;
+			end else begin
+				m_cs_n <= 1'b0;
+				m_mod  <= m_this_word[M_WAITBIT-1:M_WAITBIT-2];
+				m_bitcount <= (!OPT_ODDR && m_cs_n) ? 4'h2 : 4'h1;
+				if (!m_this_word[M_WAITBIT-1])
+					m_bitcount <= (!OPT_ODDR && m_cs_n) ? 4'h8 : 4'h7;
+			end
+		end
+		// }}}
+
+		// m_dat, m_byte
+		// {{{
+		// Both devices are sent the same bits: on bit zero of each
+		// nibble at single speed, or the whole nibble at quad speed
+		always @(posedge i_clk)
+		if (m_ce)
+		begin
+			if (m_bitcount == 0)
+			begin
+				// {{{
+				if (!OPT_ODDR && m_cs_n)
+				begin
+					// Before SCK's first rising edge, keep
+					// the whole word
+					if (m_this_word[M_WAITBIT-1])
+						m_dat <= {(2){ m_this_word[7:4] }};
+					else
+						m_dat <= {(2){ 3'b0, m_this_word[7] }};
+					m_byte <= m_this_word[7:0];
+				end else if (m_this_word[M_WAITBIT-1])
+				begin
+					m_dat  <= {(2){ m_this_word[7:4] }};
+					m_byte <= { m_this_word[3:0], 4'h0 };
+				end else begin
+					// Slow speed
+					m_dat  <= {(2){ 3'b0, m_this_word[7] }};
+					m_byte <= { m_this_word[6:0], 1'b0 };
+				end
+				// }}}
+			end else if (m_mod[1])
+			begin
+				m_dat  <= {(2){ m_byte[7:4] }};
+				m_byte <= { m_byte[3:0], 4'h0 };
+			end else begin
+				m_dat  <= {(2){ 3'b0, m_byte[7] }};
+				m_byte <= { m_byte[6:0], 1'b0 };
+			end
+		end
+		// }}}
+
+		// m_clk
+		// {{{
+		if (OPT_ODDR)
+		begin
+			always @(*)
+				m_clk = !m_cs_n;
+		end else begin
+			// {{{
+			always @(posedge i_clk)
+			if (i_reset)
+				m_clk <= 1'b1;
+			else if (m_cs_n)
+				m_clk <= 1'b1;
+			else if ((!m_clk)&&(ckpos))
+				m_clk <= 1'b1;
+			else if (m_midcount)
+				m_clk <= 1'b1;
+			else if (new_word && m_this_word[M_WAITBIT])
+				m_clk <= 1'b1;
+			else if (ckneg)
+				m_clk <= 1'b0;
+			// }}}
+		end
+		// }}}
+
+`ifdef	FORMAL
+		// {{{
+		(* anyconst *) reg [M_LGADDR:0]	f_const_addr;
+
+		always @(*)
+		begin
+			assert((m_cmd_word[f_const_addr][M_WAITBIT])
+				||(m_cmd_word[f_const_addr][M_WAITBIT-1:M_WAITBIT-2] != 2'b01));
+			if (m_cmd_word[f_const_addr][M_WAITBIT])
+				assert(m_cmd_word[f_const_addr][M_WAITBIT-3:0] > 0);
+		end
+		always @(*)
+		begin
+			if (m_cmd_index != f_const_addr)
+				assume((m_cmd_word[m_cmd_index][M_WAITBIT])||(m_cmd_word[m_cmd_index][9:8] != 2'b01));
+			if (m_cmd_word[m_cmd_index][M_WAITBIT])
+				assume(m_cmd_word[m_cmd_index][M_WAITBIT-3:0]>0);
+		end
+
+		always @(*)
+		begin
+			assert((m_this_word[M_WAITBIT])
+				||(m_this_word[M_WAITBIT-1:M_WAITBIT-2] != 2'b01));
+			if (m_this_word[M_WAITBIT])
+				assert(m_this_word[M_WAITBIT-3:0] > 0);
+		end
+
+		// Setting the last two command words to IDLE with maximum
+		// counts is required by our implementation
+		always @(*)
+			assert(m_cmd_word[5'h1e] == 11'h7ff);
+		always @(*)
+			assert(m_cmd_word[5'h1f] == 11'h7ff);
+
+		wire	[M_LGADDR-1:0]	last_index;
+		assign	last_index = m_cmd_index - 1;
+
+		always @(posedge i_clk)
+		if ((f_past_valid)&&(m_cmd_index != M_FIRSTIDX))
+			assert(m_this_word == m_cmd_word[last_index]);
+
+		always @(posedge i_clk)
+			assert(m_midcount == (m_counter != 0));
+
+		// Both devices always see the same startup script
+		always @(*)
+			assert(m_dat[7:4] == m_dat[3:0]);
+
+		always @(posedge i_clk)
+		begin
+			cover(!maintenance);
+			cover(m_cmd_index == 5'h0c);
+			cover(m_cmd_index == 5'h10);
+			cover(m_cmd_index == 5'h15);
+			cover(m_cmd_index == 5'h1d);
+			cover(m_cmd_index == 5'h1f);
+		end
+		// }}}
+`endif
+		// }}}
+	end else begin : NO_STARTUP_OPT
+		// {{{
+		always @(*)
+		begin
+			maintenance = 0;
+			m_mod       = 2'b00;
+			m_cs_n      = 1'b1;
+			m_clk       = 1'b0;
+			m_dat       = 8'h0;
+		end
+
+		// verilator lint_off UNUSED
+		wire	unused_maintenance;
+		assign	unused_maintenance = &{ 1'b0, maintenance,
+					m_mod, m_cs_n, m_clk, m_dat };
+		// verilator lint_on  UNUSED
+		// }}}
+	end endgenerate
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Data / access portion
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// w_addr, w_xipcmd
+	// {{{
+	// Each device holds half of every word, so the address sent to both is
+	// half of the bus byte address.  The address and the 0xa0 mode byte
+	// are then sent to both devices, one nibble each per clock.
+	always @(*)
+	begin
+		w_addr = 0;
+		w_addr[LGFLASHSZ-2:0] = { i_wb_addr, 1'b0 };
+
+		w_xipcmd = { {(2){ w_addr[23:20] }}, {(2){ w_addr[19:16] }},
+				{(2){ w_addr[15:12] }}, {(2){ w_addr[11: 8] }},
+				{(2){ w_addr[ 7: 4] }}, {(2){ w_addr[ 3: 0] }},
+				8'haa, 8'h00 };
+	end
+	// }}}
+
+	// data_pipe
+	// {{{
+	integer	ik;
+	initial	data_pipe = 0;
+	always @(posedge i_clk)
+	begin
+		if (!o_wb_stall)
+		begin
+			// Set the high bits to zero initially
+			data_pipe <= 0;
+
+			if (!i_cfg_stb)
+				data_pipe[63:0] <= w_xipcmd;
+			else if (i_wb_data[QSPEED_BIT])
+			begin
+				// High speed configuration I/O, a byte to each
+				// device over two clocks
+				data_pipe[56 +: 8] <= { i_wb_data[23:20],
+							i_wb_data[7:4] };
+				data_pipe[48 +: 8] <= { i_wb_data[19:16],
+							i_wb_data[3:0] };
+			end else begin
+				// Low speed configuration I/O, one bit to each
+				// device per clock
+				for(ik=0; ik<8; ik=ik+1)
+				begin
+					data_pipe[8*ik]   <= i_wb_data[ik];
+					data_pipe[8*ik+4] <= i_wb_data[16+ik];
+				end
+			end
+		end else if (ckstb)
+			data_pipe <= { data_pipe[DPW-9:0], 8'h0 };
+
+		if (maintenance)
+			data_pipe[DPW-1 -: 8] <= m_dat;
+	end
+	// }}}
+
+	assign	sdr_odat   = data_pipe[DPW-1 -: 8];
+	assign	o_qspi_dat = sdr_odat;
+	assign	sdr_idat   = i_qspi_dat;
+
+	// pre_ack
+	// {{{
+	// Since we can't abort any transaction once started, without
+	// risking losing XIP mode or any other mode we might be in, we'll
+	// keep track of whether this operation should be ack'd upon
+	// completion
+	always @(posedge i_clk)
+	if ((i_reset)||(!i_wb_cyc))
+		pre_ack <= 1'b0;
+	else if ((bus_request)||(cfg_write))
+		pre_ack <= 1'b1;
+	// }}}
+
+	// pipe_req
+	// {{{
+	generate if (OPT_PIPE)
+	begin : OPT_PIPE_BLOCK
+		// {{{
+		reg	r_pipe_req;
+		wire	w_pipe_condition;
+
+		reg	[(AW-1):0]	next_addr;
+		always  @(posedge i_clk)
+		if (!o_wb_stall)
+			next_addr <= i_wb_addr + 1'b1;
+
+		assign	w_pipe_condition = (i_wb_stb)&&(!i_wb_we)&&(pre_ack)
+				&&(!maintenance)
+				&&(!cfg_mode)
+				&&(!o_qspi_cs_n)
+				&&(|clk_ctr[1:0])
+				&&(next_addr == i_wb_addr);
+
+		initial	r_pipe_req = 1'b0;
+		always @(posedge i_clk)
+		if ((clk_ctr == 1)&&(ckstb))
+			r_pipe_req <= 1'b0;
+		else
+			r_pipe_req <= w_pipe_condition;
+
+		assign	pipe_req = r_pipe_req;
+		// }}}
+	end else begin
+		assign	pipe_req = 1'b0;
+	end endgenerate
+	// }}}
+
+	// clk_ctr
+	// {{{
+	initial	clk_ctr = 0;
+	always @(posedge i_clk)
+	if ((i_reset)||(maintenance))
+		clk_ctr <= 0;
+	else if ((bus_request)&&(!pipe_req))
+		// Notice that this is only for
+		// regular bus reads, and so the check for
+		// !pipe_req
+		clk_ctr <= RD_CLOCKS;
+	else if (bus_request) // && pipe_req
+		// Otherwise, if this is a piped read, we'll
+		// reset the counter back to four--a byte per clock
+		clk_ctr <= PIPE_CLOCKS;
+	else if (cfg_ls_write)
+		clk_ctr <= 6'd8 + ((OPT_ODDR) ? 0:1);
+	else if (cfg_write)
+		clk_ctr <= 6'd2 + ((OPT_ODDR) ? 0:1);
+	else if ((ckstb)&&(|clk_ctr))
+		clk_ctr <= clk_ctr - 1'b1;
+	// }}}
+
+	// o_qspi_sck
+	// {{{
+	initial	o_qspi_sck = (!OPT_ODDR);
+	always @(posedge i_clk)
+	if (i_reset)
+		o_qspi_sck <= (!OPT_ODDR);
+	else if (maintenance)
+		o_qspi_sck <= m_clk;
+	else if ((!OPT_ODDR)&&(bus_request)&&(pipe_req))
+		o_qspi_sck <= 1'b0;
+	else if ((bus_request)||(cfg_write))
+		o_qspi_sck <= 1'b1;
+	else if (OPT_ODDR)
+	begin
+		// {{{
+		if ((cfg_mode)&&(clk_ctr <= 1))
+			// Config mode has no pipe instructions
+			o_qspi_sck <= 1'b0;
+		else if (clk_ctr > 6'd1)
+			o_qspi_sck <= 1'b1;
+		else
+			o_qspi_sck <= 1'b0;
+		// }}}
+	end else if (((ckpos)&&(!o_qspi_sck))||(o_qspi_cs_n))
+	begin
+		o_qspi_sck <= 1'b1;
+	end else if ((ckneg)&&(o_qspi_sck))
+	begin
+		// {{{
+		if ((cfg_mode)&&(clk_ctr <= 1))
+			// Config mode has no pipe instructions
+			o_qspi_sck <= 1'b1;
+		else if (clk_ctr > 6'd1)
+			o_qspi_sck <= 1'b0;
+		else
+			o_qspi_sck <= 1'b1;
+		// }}}
+	end
+	// }}}
+
+	// o_qspi_cs_n
+	// {{{
+	initial	o_qspi_cs_n = 1'b1;
+	always @(posedge i_clk)
+	if (i_reset)
+		o_qspi_cs_n <= 1'b1;
+	else if (maintenance)
+		o_qspi_cs_n <= m_cs_n;
+	else if ((cfg_stb)&&(i_wb_we))
+		o_qspi_cs_n <= (!i_wb_data[CFG_MODE])||(i_wb_data[USER_CS_n]);
+	else if ((OPT_CFG)&&(cfg_cs))
+		o_qspi_cs_n <= 1'b0;
+	else if ((bus_request)||(cfg_write))
+		o_qspi_cs_n <= 1'b0;
+	else if (ckstb)
+		o_qspi_cs_n <= (clk_ctr <= 1);
+	// }}}
+
+	// o_qspi_mod
+	// {{{
+	// Control the mode of the external pins, for both devices
+	// 	NORMAL_SPI: i_miso is an input,  o_mosi is an output
+	// 	QUAD_READ:  i_miso is an input,  o_mosi is an input
+	// 	QUAD_WRITE: i_miso is an output, o_mosi is an output
+	initial	o_qspi_mod =  NORMAL_SPI;
+	always @(posedge i_clk)
+	if (i_reset)
+		o_qspi_mod <= NORMAL_SPI;
+	else if (maintenance)
+		o_qspi_mod <= m_mod;
+	else if ((bus_request)&&(!pipe_req))
+		o_qspi_mod <= QUAD_WRITE;
+	else if ((bus_request)||(cfg_hs_read))
+		o_qspi_mod <= QUAD_READ;
+	else if (cfg_hs_write)
+		o_qspi_mod <= QUAD_WRITE;
+	else if ((cfg_ls_write)||((cfg_mode)&&(!cfg_speed)))
+		o_qspi_mod <= NORMAL_SPI;
+	else if ((ckstb)&&(clk_ctr <= PIPE_CLOCKS + 1)
+				&&((!cfg_mode)||(!cfg_dir)))
+		o_qspi_mod <= QUAD_READ;
+	// }}}
+
+	// o_wb_stall
+	// {{{
+	initial	o_wb_stall = 1'b1;
+	always @(posedge i_clk)
+	if (i_reset)
+		o_wb_stall <= 1'b1;
+	else if (maintenance)
+		o_wb_stall <= 1'b1;
+	else if ((RDDELAY > 0)&&((i_cfg_stb)||(i_wb_stb))&&(!o_wb_stall))
+		o_wb_stall <= 1'b1;
+	else if ((RDDELAY == 0)&&((cfg_write)||(bus_request)))
+		o_wb_stall <= 1'b1;
+	else if (ckstb || clk_ctr == 0)
+	begin
+		// {{{
+		if (ckpre && (i_wb_stb)&&(pipe_req)&&(clk_ctr == 6'd2))
+			o_wb_stall <= 1'b0;
+		else if ((clk_ctr > 1)||(xtra_stall))
+			o_wb_stall <= 1'b1;
+		else
+			o_wb_stall <= 1'b0;
+		// }}}
+	end else if (ckpre && (i_wb_stb)&&(pipe_req)&&(clk_ctr == 6'd1))
+		o_wb_stall <= 1'b0;
+	// }}}
+
+	// dly_ack
+	// {{{
+	initial	dly_ack = 1'b0;
+	always @(posedge i_clk)
+	if (i_reset)
+		dly_ack <= 1'b0;
+	else if ((ckstb)&&(clk_ctr == 1))
+		dly_ack <= (i_wb_cyc)&&(pre_ack);
+	else if ((i_wb_stb)&&(!o_wb_stall)&&(!bus_request))
+		dly_ack <= 1'b1;
+	else if (cfg_noop)
+		dly_ack <= 1'b1;
+	else
+		dly_ack <= 1'b0;
+	// }}}
+
+	// actual_sck
+	// {{{
+	generate if (OPT_ODDR)
+	begin : SCK_ACTUAL
+		// {{{
+		always @(*)
+			actual_sck = o_qspi_sck;
+		// }}}
+	end else if (OPT_CLKDIV == 1)
+	begin : SCK_ONE
+		// {{{
+		initial	actual_sck = 1'b0;
+		always @(posedge i_clk)
+		if (i_reset)
+			actual_sck <= 1'b0;
+		else
+			actual_sck <= (!o_qspi_sck)&&(clk_ctr > 0);
+		// }}}
+	end else begin : SCK_ANY
+		// {{{
+		initial	actual_sck = 1'b0;
+		always @(posedge i_clk)
+		if (i_reset)
+			actual_sck <= 1'b0;
+		else
+			actual_sck <= (o_qspi_sck)&&(ckpre)&&(clk_ctr > 0);
+		// }}}
+	end endgenerate
+	// }}}
+
+
+	// read_sck, o_wb_ack, and xtra_stall
+	// {{{
+`ifdef	FORMAL
+	reg	[F_LGDEPTH-1:0]	f_extra;
+`endif
+
+	generate if (RDDELAY == 0)
+	begin : RDDELAY_NONE
+		// {{{
+		always @(*)
+		begin
+			read_sck = actual_sck;
+			o_wb_ack = dly_ack;
+			xtra_stall = 1'b0;
+		end
+
+`ifdef	FORMAL
+		always @(*)
+			f_extra = 0;
+`endif
+		// }}}
+	end else
+	begin : RDDELAY_NONZERO
+		// {{{
+		reg	[RDDELAY-1:0]	sck_pipe, ack_pipe, stall_pipe;
+		reg	not_done;
+
+		// sck_pipe, ack_pipe, and stall_pipe
+		// {{{
+		initial	sck_pipe = 0;
+		initial	ack_pipe = 0;
+		initial	stall_pipe = -1;
+		if (RDDELAY > 1)
+		begin
+			// {{{
+			always @(posedge i_clk)
+			if (i_reset)
+				sck_pipe <= 0;
+			else
+				sck_pipe <= { sck_pipe[RDDELAY-2:0], actual_sck };
+
+			always @(posedge i_clk)
+			if (i_reset || !i_wb_cyc)
+				ack_pipe <= 0;
+			else
+				ack_pipe <= { ack_pipe[RDDELAY-2:0], dly_ack };
+
+			always @(posedge i_clk)
+			if (i_reset)
+				stall_pipe <= -1;
+			else
+				stall_pipe <= { stall_pipe[RDDELAY-2:0], not_done };
+			// }}}
+		end else // if (RDDELAY > 0)
+		begin
+			// {{{
+			always @(posedge i_clk)
+			if (i_reset)
+				sck_pipe <= 0;
+			else
+				sck_pipe <= actual_sck;
+
+			always @(posedge i_clk)
+			if (i_reset || !i_wb_cyc)
+				ack_pipe <= 0;
+			else
+				ack_pipe <= dly_ack;
+
+			always @(posedge i_clk)
+			if (i_reset)
+				stall_pipe <= -1;
+			else
+				stall_pipe <= not_done;
+			// }}}
+		end
+		// }}}
+
+		// not_done
+		// {{{
+		always @(*)
+		begin
+			not_done = (i_wb_stb || i_cfg_stb) && !o_wb_stall;
+			if (clk_ctr > 1)
+				not_done = 1'b1;
+			if ((clk_ctr == 1)&&(!ckstb))
+				not_done = 1'b1;
+		end
+		// }}}
+
+		always @(*)
+			o_wb_ack = ack_pipe[RDDELAY-1];
+
+		always @(*)
+			read_sck = sck_pipe[RDDELAY-1];
+
+		always @(*)
+			xtra_stall = |stall_pipe;
+
+`ifdef	FORMAL
+		// {{{
+		integer	k;
+		always @(*)
+		if (!i_wb_cyc)
+			f_extra = 0;
+		else begin
+			f_extra = 0;
+			for(k=0; k<RDDELAY; k=k+1)
+				f_extra = f_extra + (ack_pipe[k] ? 1 : 0);
+		end
+		// }}}
+`endif // FORMAL
+		// }}}
+	end endgenerate
+	// }}}
+
+	// o_wb_data
+	// {{{
+	// A bus read gets a byte per clock, the upper nibble of each from chip
+	// one.  In configuration mode, each device's byte is kept apart: chip
+	// zero's in [7:0], chip one's in [23:16].
+	always @(posedge i_clk)
+	begin
+		if (read_sck)
+		begin
+			// {{{
+			if (cfg_mode)
+			begin
+				// No endian-swapping in config mode
+				if (!o_qspi_mod[1])
+				begin
+					o_wb_data[ 7: 0] <= { o_wb_data[ 6: 0],
+								sdr_idat[1] };
+					o_wb_data[23:16] <= { o_wb_data[22:16],
+								sdr_idat[5] };
+				end else begin
+					o_wb_data[ 7: 0] <= { o_wb_data[ 3: 0],
+								sdr_idat[3:0] };
+					o_wb_data[23:16] <= { o_wb_data[19:16],
+								sdr_idat[7:4] };
+				end
+			end else if (OPT_ENDIANSWAP)
+				o_wb_data <= { sdr_idat, o_wb_data[31:8] };
+			else
+				o_wb_data <= { o_wb_data[23:0], sdr_idat };
+			// }}}
+		end // read_sck
+
+		if ((OPT_CFG)&&(cfg_mode))
+			o_wb_data[15:8] <= { 3'b0, cfg_mode, cfg_speed, 1'b0,
+				cfg_dir, cfg_cs };
+	end
+	// }}}
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Configuration / user overrride access port
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	// cfg_mode
+	// {{{
+	initial	cfg_mode = 1'b0;
+	always @(posedge i_clk)
+	if ((i_reset)||(!OPT_CFG))
+		cfg_mode <= 1'b0;
+	else if ((i_cfg_stb)&&(!o_wb_stall)&&(i_wb_we))
+		cfg_mode <= i_wb_data[CFG_MODE];
+	// }}}
+
+	// cfg_cs
+	// {{{
+	initial	cfg_cs = 1'b0;
+	always @(posedge i_clk)
+	if ((i_reset)||(!OPT_CFG))
+		cfg_cs <= 1'b0;
+	else if ((i_cfg_stb)&&(!o_wb_stall)&&(i_wb_we))
+		cfg_cs    <= (!i_wb_data[USER_CS_n])&&(i_wb_data[CFG_MODE]);
+	// }}}
+
+	// cfg_speed, cfg_dir
+	// {{{
+	initial	cfg_speed = 1'b0;
+	initial	cfg_dir   = 1'b0;
+	always @(posedge i_clk)
+	if (!OPT_CFG)
+	begin
+		cfg_speed <= 1'b0;
+		cfg_dir   <= 1'b0;
+	end else if ((i_cfg_stb)&&(!o_wb_stall)&&(i_wb_we))
+	begin
+		cfg_speed <= i_wb_data[QSPEED_BIT];
+		cfg_dir   <= i_wb_data[DIR_BIT];
+	end
+	// }}}
+	// }}}
+
+	// Make Verilator happy
+	// {{{
+	// verilator lint_off UNUSED
+	wire	unused;
+	assign	unused = &{ 1'b0, i_wb_data[31:24], i_wb_data[15:13],
+				i_wb_data[DSPEED_BIT] };
+	// verilator lint_on  UNUSED
+	// }}}
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+//
+// Formal properties
+// {{{
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////////////
+`ifdef	FORMAL
+	// Signal declarations
+	// {{{
+	localparam	F_MEMDONE   = RD_CLOCKS;
+	localparam	F_MEMACK    = F_MEMDONE + RDDELAY;
+	localparam	F_PIPEDONE  = PIPE_CLOCKS;
+	// Clocks during which the pins are driven: the address, the mode
+	// byte, and all but the last of the dummy clocks
+	localparam	F_CMDDONE   = RD_CLOCKS - PIPE_CLOCKS;
+	localparam	FO          = (OPT_ODDR ? 0:1);
+	localparam	F_MAXCTR    = (F_MEMDONE > 9) ? F_MEMDONE : 9;
+	localparam	F_ACKCOUNT  = (F_MEMDONE+1+RDDELAY)
+				*(OPT_ODDR ? 1 : (OPT_CLKDIV+1));
+
+	wire	[(F_LGDEPTH-1):0]	f_nreqs, f_nacks,
+					f_outstanding;
+	reg	[31:0]		fv_xipcmd;
+	reg	[F_MEMACK:0]	f_memread;
+	// }}}
+//
+//
+// Generic setup
+//
+//
+`ifdef	SQFLEXPRESS
+`define	ASSUME	assume
+`else
+`define	ASSUME	assert
+`endif
+
+	// Keep track of a flag telling us whether or not $past()
+	// will return valid results
+	initial	f_past_valid = 1'b0;
+	always @(posedge i_clk)
+		f_past_valid = 1'b1;
+
+	always @(*)
+	if (!f_past_valid)
+       		`ASSUME(i_reset);
+
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Assumptions about our inputs
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	always @(*)
+		`ASSUME((!i_wb_stb)||(!i_cfg_stb));
+
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset))
+			&&($past(i_wb_stb))&&($past(o_wb_stall)))
+		`ASSUME(i_wb_stb);
+
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset))
+			&&($past(i_cfg_stb))&&($past(o_wb_stall)))
+		`ASSUME(i_cfg_stb);
+
+	fwb_slave #(.AW(AW), .DW(DW),.F_LGDEPTH(F_LGDEPTH),
+			.F_MAX_STALL((OPT_CLKDIV<3) ? (F_ACKCOUNT+1):0),
+			.F_MAX_ACK_DELAY((OPT_CLKDIV<3) ? F_ACKCOUNT : 0),
+			.F_OPT_RMW_BUS_OPTION(0),
+			.F_OPT_CLK2FFLOGIC(1'b0),
+			.F_OPT_DISCONTINUOUS(1))
+		f_wbm(i_clk, i_reset,
+			i_wb_cyc, (i_wb_stb)||(i_cfg_stb), i_wb_we, i_wb_addr,
+				i_wb_data, 4'hf,
+			o_wb_ack, o_wb_stall, o_wb_data, 1'b0,
+			f_nreqs, f_nacks, f_outstanding);
+
+	always @(*)
+		assert(f_outstanding <= 2 + f_extra);
+
+	always @(posedge i_clk)
+	if ((f_past_valid)&&((!$past(i_wb_stb))||($past(o_wb_stall))))
+		assert(f_outstanding <= 1 + f_extra);
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Assumptions about i_qspi_dat
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	// 1. On output, i_qspi_dat equals the input
+	// 2. Otherwise when implementing multi-cycle clocks, i_qspi_dat only
+	//	changes on a negative edge
+	//
+	(* anyseq *) reg [7:0] dly_idat;
+	always @(posedge i_clk)
+	if (o_qspi_mod == NORMAL_SPI)
+	begin
+		if ((!OPT_ODDR)&&((o_qspi_sck)||(!$past(o_qspi_sck))))
+		begin
+			assume($stable(dly_idat[1]));
+			assume($stable(dly_idat[5]));
+		end
+	end else if (o_qspi_mod == QUAD_WRITE)
+		assume(dly_idat == o_qspi_dat);
+	else if ((!OPT_ODDR)&&((o_qspi_sck)||(!$past(o_qspi_sck))))
+		assume($stable(dly_idat));
+
+	generate if (RDDELAY > 0)
+	begin
+		always @(posedge i_clk)
+			assume(i_qspi_dat == $past(dly_idat,RDDELAY));
+	end else begin
+		always @(posedge i_clk)
+			assume(i_qspi_dat == dly_idat);
+	end endgenerate
+
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Maintenance mode assertions
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+
+	always @(*)
+	if (maintenance)
+	begin
+		assume((!i_wb_stb)&&(!i_cfg_stb));
+
+		assert(f_outstanding == 0);
+
+		assert(o_wb_stall);
+		//
+		assert(clk_ctr == 0);
+		assert(cfg_mode == 1'b0);
+		assert(!o_wb_ack);
+	end
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Acknowledgments
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	always @(posedge i_clk)
+	if (dly_ack)
+		assert(clk_ctr[1:0] == 0);
+
+	// Zero cycle requests
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset))&&(($past(cfg_noop))
+			||($past(i_wb_stb && i_wb_we && !o_wb_stall))))
+		assert((dly_ack)&&((!i_wb_cyc)
+			||(f_outstanding == 1 + f_extra)));
+
+	always @(posedge i_clk)
+	if ((f_outstanding > 0)&&(clk_ctr > 0))
+		assert(pre_ack);
+
+	always @(posedge i_clk)
+	if ((i_wb_cyc)&&(dly_ack))
+		assert(f_outstanding >= 1 + f_extra);
+
+	always @(*)
+	if ((i_wb_cyc)&&(pre_ack)&&(!o_qspi_cs_n))
+		assert((f_outstanding >= 1 + f_extra)||((OPT_CFG)&&(cfg_mode)));
+
+	always @(*)
+	if ((cfg_mode)&&(!dly_ack)&&(clk_ctr == 0))
+		assert(f_outstanding == f_extra);
+
+	always @(*)
+	if (cfg_mode)
+		assert(f_outstanding <= 1 + f_extra);
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Idle channel
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	//
+	always @(*)
+	if (!maintenance)
+	begin
+		if (o_qspi_cs_n)
+		begin
+			assert(clk_ctr == 0);
+			assert(o_qspi_sck  == !OPT_ODDR);
+		end else if (clk_ctr == 0)
+			assert(o_qspi_sck == !OPT_ODDR);
+	end
+
+	always @(*)
+		assert(o_qspi_mod != 2'b01);
+
+	always @(*)
+	if (clk_ctr > 6'd9)
+	begin
+		assert(!cfg_mode);
+		assert(!cfg_cs);
+	end
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Read requests
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(!$past(i_reset))&&($past(bus_request)))
+	begin
+		assert(!o_qspi_cs_n);
+		if ((OPT_ODDR)||(!$past(pipe_req)))
+			assert(o_qspi_sck == 1'b1);
+		else
+			assert(o_qspi_sck == 1'b0);
+		//
+		if (!$past(o_qspi_cs_n))
+		begin
+			assert(clk_ctr == F_PIPEDONE);
+			assert(o_qspi_mod == QUAD_READ);
+		end else begin
+			assert(clk_ctr == F_MEMDONE);
+			assert(o_qspi_mod == QUAD_WRITE);
+		end
+	end
+
+	always @(*)
+		assert(clk_ctr <= F_MAXCTR);
+
+	always @(*)
+	if ((OPT_ODDR)&&(!o_qspi_cs_n))
+		assert((o_qspi_sck)||(actual_sck)||(cfg_mode)||(maintenance));
+
+	always @(*)
+	if (!maintenance)
+	begin
+		if (cfg_mode)
+		begin
+			if (!cfg_cs)
+				assert(o_qspi_cs_n);
+			else if (!cfg_speed)
+				assert(o_qspi_mod == NORMAL_SPI);
+			else if ((cfg_dir)&&(clk_ctr > 0))
+				assert(o_qspi_mod == QUAD_WRITE);
+		end else if (clk_ctr > F_PIPEDONE)
+			assert(o_qspi_mod == QUAD_WRITE);
+		else if (clk_ctr > 0)
+			assert(o_qspi_mod == QUAD_READ);
+	end
+
+	always @(posedge i_clk)
+	if (((!OPT_PIPE)&&(clk_ctr != 0))||(clk_ctr > 6'd1))
+		assert(o_wb_stall);
+
+	always @(posedge i_clk)
+	if ((f_past_valid)&&(OPT_CLKDIV>0)&&($past(o_qspi_cs_n)))
+		assert(o_qspi_sck);
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// User mode (setup only)
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	always @(*)
+	if ((maintenance)||(!OPT_CFG))
+		assert(!cfg_mode);
+	always @(*)
+	if ((OPT_CFG)&&(cfg_mode))
+		assert(o_qspi_cs_n == !cfg_cs);
+	else
+		assert(!cfg_cs);
+
+	// Single speed writes place the same bit position of each device's
+	// byte on bit zero of its nibble
+	always @(*)
+	if ((cfg_mode)&&(!cfg_speed)&&(clk_ctr > 0))
+		assert({ sdr_odat[7:5], sdr_odat[3:1] } == 0);
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Memory reads
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	always @(posedge i_clk)
+	if (bus_request)
+		fv_xipcmd <= { w_addr, 8'ha0 };
+
+	initial	f_memread = 0;
+	always @(posedge i_clk)
+	if (i_reset)
+		f_memread <= 0;
+	else begin
+		if (ckstb)
+			f_memread <= { f_memread[F_MEMACK-1:0], 1'b0 };
+		else if ((!OPT_ODDR)&&(RDDELAY > 0))
+			f_memread[F_MEMACK:F_MEMDONE]
+				<= { f_memread[F_MEMACK-1:F_MEMDONE], 1'b0 };
+		else if (!OPT_ODDR)
+			f_memread[F_MEMACK] <= 1'b0;
+		if ((bus_request)&&(o_qspi_cs_n))
+			f_memread[0] <= 1'b1;
+	end
+
+	always @(posedge i_clk)
+	if ((OPT_ODDR)&&(|f_memread[F_MEMDONE-1:0]))
+		assert(o_qspi_sck);
+
+	always @(*)
+	if (|f_memread[F_CMDDONE-1:0])
+		assert(o_qspi_mod == QUAD_WRITE);
+	else if (|f_memread[F_MEMDONE-1:F_CMDDONE])
+		assert(o_qspi_mod == QUAD_READ);
+
+	always @(*)
+	if (|f_memread[F_MEMDONE-1:0])
+		assert(!o_qspi_cs_n && !cfg_mode);
+
+	// The address and mode byte, sent to both devices
+	always @(*)
+	begin
+		if (f_memread[FO])
+			assert(o_qspi_dat == {(2){ fv_xipcmd[31:28] }});
+		if (f_memread[FO+1])
+			assert(o_qspi_dat == {(2){ fv_xipcmd[27:24] }});
+		if (f_memread[FO+2])
+			assert(o_qspi_dat == {(2){ fv_xipcmd[23:20] }});
+		if (f_memread[FO+3])
+			assert(o_qspi_dat == {(2){ fv_xipcmd[19:16] }});
+		if (f_memread[FO+4])
+			assert(o_qspi_dat == {(2){ fv_xipcmd[15:12] }});
+		if (f_memread[FO+5])
+			assert(o_qspi_dat == {(2){ fv_xipcmd[11: 8] }});
+		if (f_memread[FO+6])
+			assert(o_qspi_dat == {(2){ fv_xipcmd[ 7: 4] }});
+		if (f_memread[FO+7])
+			assert(o_qspi_dat == {(2){ fv_xipcmd[ 3: 0] }});
+	end
+
+	// The data returned
+	always @(posedge i_clk)
+	if ((OPT_ODDR)&&(f_memread[F_MEMACK]))
+	begin
+		if (OPT_ENDIANSWAP)
+		begin
+			assert(o_wb_data[ 7: 0] == $past(i_qspi_dat,4));
+			assert(o_wb_data[15: 8] == $past(i_qspi_dat,3));
+			assert(o_wb_data[23:16] == $past(i_qspi_dat,2));
+			assert(o_wb_data[31:24] == $past(i_qspi_dat,1));
+		end else begin
+			assert(o_wb_data[31:24] == $past(i_qspi_dat,4));
+			assert(o_wb_data[23:16] == $past(i_qspi_dat,3));
+			assert(o_wb_data[15: 8] == $past(i_qspi_dat,2));
+			assert(o_wb_data[ 7: 0] == $past(i_qspi_dat,1));
+		end
+	end else if ((OPT_ODDR)&&(|f_memread))
+	begin
+		if (!OPT_PIPE)
+			assert(o_wb_stall);
+		else if (!f_memread[F_MEMDONE-1])
+			assert(o_wb_stall);
+		assert(!o_wb_ack);
+	end
+	// }}}
+	////////////////////////////////////////////////////////////////////////
+	//
+	// Cover Properties
+	// {{{
+	////////////////////////////////////////////////////////////////////////
+	//
+	//
+	generate if (!OPT_STARTUP)
+	begin
+		// As with qflexpress, the startup sequence takes too many
+		// clocks for these to be reached if OPT_STARTUP is set
+		always @(posedge i_clk)
+			cover(o_wb_ack && f_memread[F_MEMACK]);
+
+		always @(posedge i_clk)
+			// Cover a piped transaction
+			cover((o_wb_ack)&&(!cfg_mode)&&(!o_qspi_cs_n));
+
+		if (OPT_CFG)
+		begin
+			always @(posedge i_clk)
+			begin
+				cover((o_wb_ack)&&(cfg_mode)&&(cfg_speed));
+				cover((o_wb_ack)&&(cfg_mode)&&(cfg_speed)
+						&&(!cfg_dir));
+				cover((o_wb_ack)&&(cfg_mode)&&(!cfg_speed));
+			end
+		end
+	end else begin
+
+		always @(posedge i_clk)
+			cover(!maintenance);
+
+	end endgenerate
+	// }}}
+`endif
+// }}}
+endmodule
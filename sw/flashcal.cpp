@@ -0,0 +1,165 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	flashcal.cpp
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	Read delay calibration.  Given a controller built with a speed
+//		register (OPT_SPEEDREG), this sweeps the read delay at a
+//	given clock divider, reading a known region of the flash at each delay,
+//	and then leaves the controller at the center of the passing window.
+//	The window itself is printed, so that a board's margin can be seen.
+//
+//	Usage: flashcal [-v] [-d <clkdiv>] [-a <addr>] [-n <len>] [<image>]
+//
+//	-d <clkdiv>	The clock divider to calibrate, 1 by default
+//	-a <addr>	The bus address of the region to read, FLASHBASE
+//			by default
+//	-n <len>	The number of bytes to read, 4kB by default
+//	<image>		A binary image of the flash, starting at FLASHBASE,
+//			holding the expected contents of the region.  If not
+//			given, the region is first read at the current speed.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2015-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <assert.h>
+
+#include "port.h"
+#include "design.h"
+#include "regdefs.h"
+#include "ttybus.h"
+#include "flashdrvr.h"
+
+FPGA	*m_fpga;
+
+void	usage(void) {
+	printf("USAGE: flashcal [-v] [-d <clkdiv>] [-a <addr>] [-n <len>] [<image>]\n"
+"\n"
+"\tSweeps the flash controller's read delay at the given clock divider,\n"
+"\tand leaves it at the center of the window of delays that read\n"
+"\t<len> bytes at <addr> correctly.\n");
+}
+
+int main(int argc, char **argv) {
+#if	!defined(FLASH_ACCESS) || !defined(R_FLASHSPEED)
+	fprintf(stderr, "This design has no flash speed register to calibrate\n");
+	exit(EXIT_FAILURE);
+#else
+	unsigned	clkdiv = 1, addr = FLASHBASE, len = 4096, window;
+	const char	*fname = NULL;
+	char		*data = NULL;
+	bool		verbose = false;
+	int		opt;
+	FLASHDRVR	*flash;
+
+	while((opt = getopt(argc, argv, "hva:d:n:")) != -1) {
+		switch(opt) {
+		case 'a': addr   = strtoul(optarg, NULL, 0); break;
+		case 'd': clkdiv = strtoul(optarg, NULL, 0); break;
+		case 'n': len    = strtoul(optarg, NULL, 0); break;
+		case 'v': verbose = true; break;
+		case 'h': usage(); exit(EXIT_SUCCESS);
+		default:
+			usage(); exit(EXIT_FAILURE);
+		}
+	}
+
+	if (optind < argc)
+		fname = argv[optind];
+
+	len &= -4;
+	if ((len == 0)||(addr < FLASHBASE)
+			||(addr + len > FLASHBASE + FLASHLEN)) {
+		fprintf(stderr, "ERR: Region 0x%08x--0x%08x isn't within the flash\n",
+			addr, addr+len-1);
+		exit(EXIT_FAILURE);
+	}
+
+	// Read the expected contents from the image, if given
+	// {{{
+	if (fname) {
+		FILE	*fp;
+
+		data = new char[len];
+		fp = fopen(fname, "rb");
+		if (NULL == fp) {
+			fprintf(stderr, "ERR: Cannot open %s\n", fname);
+			exit(EXIT_FAILURE);
+		} else if ((0 != fseek(fp, addr - FLASHBASE, SEEK_SET))
+				||(len != fread(data, 1, len, fp))) {
+			fprintf(stderr, "ERR: %s doesn't cover 0x%08x--0x%08x\n",
+				fname, addr, addr+len-1);
+			exit(EXIT_FAILURE);
+		} fclose(fp);
+	}
+	// }}}
+
+	FPGAOPEN(m_fpga);
+	flash = new FLASHDRVR(m_fpga);
+
+	window = flash->calibrate(addr, len, data, clkdiv);
+
+	// Report the window
+	// {{{
+	printf("CLKDIV = %d\n", clkdiv);
+	printf("RDDELAY:");
+	for(unsigned dly=0; dly<16; dly++)
+		printf(" %2d", dly);
+	printf("\n        ");
+	for(unsigned dly=0; dly<16; dly++)
+		printf(" %s", (window & (1<<dly)) ? "OK" : " -");
+	printf("\n");
+
+	if (window != 0) {
+		unsigned	speed = m_fpga->readio(R_FLASHSPEED);
+
+		printf("RDDELAY set to %d\n", (speed >> 20) & 0x0f);
+		if (verbose)
+			printf("SPEED = 0x%08x\n", speed);
+	}
+	// }}}
+
+	delete	flash;
+	delete	m_fpga;
+	if (data)
+		delete[] data;
+
+	return (window != 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+#endif
+}
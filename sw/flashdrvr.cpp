@@ -73,19 +73,75 @@
 #define	CFG_WEDIR	(1<<9)
 #define	CFG_USER_CS_n	(1<<8)
 
-static const unsigned	F_RESET = (CFG_USERMODE|0x0ff),
-			F_EMPTY = (CFG_USERMODE|0x000),
-			F_WRR   = (CFG_USERMODE|0x001),
-			F_PP    = (CFG_USERMODE|0x002),
-			F_QPP   = (CFG_USERMODE|0x032),
-			F_READ  = (CFG_USERMODE|0x003),
-			F_WRDI  = (CFG_USERMODE|0x004),
-			F_RDSR1 = (CFG_USERMODE|0x005),
-			F_WREN  = (CFG_USERMODE|0x006),
-			F_MFRID = (CFG_USERMODE|0x09f),
-			F_SE    = (CFG_USERMODE|0x0d8),
+// CFG_WRMODE, CFG_RDMODE
+//
+// A controller built with OPT_QPI leaves the flash in QPI (4-4-4) mode.  Every
+// byte--opcode, address, and data--must then be sent, or read, four bits at a
+// time.
+#ifdef	FLASH_QPI
+#ifndef	QSPI_FLASH
+#error "QPI mode requires a QSPI flash controller"
+#endif
+#define	CFG_WRMODE	(CFG_USERMODE|CFG_QSPEED|CFG_WEDIR)
+#define	CFG_RDMODE	(CFG_USERMODE|CFG_QSPEED)
+#else
+#define	CFG_WRMODE	CFG_USERMODE
+#define	CFG_RDMODE	CFG_USERMODE
+#endif
+
+// CFG_BOTH, FLASH_STRIPES
+//
+// A striped controller (sqflexpress) drives two quad SPI flash devices side
+// by side, each holding one nibble of every byte.  Every configuration word
+// then carries a byte for each device: chip zero's in bits [7:0], chip one's
+// in [23:16].  Commands and addresses must be sent to both, while each
+// device byte programmed holds half of each of two bytes.  A device address
+// is therefore half the flash address, and SECTORSZB and PGLENB, as given
+// by regdefs.h, should be twice those of one device.
+#ifdef	FLASH_STRIPED
+#ifndef	QSPI_FLASH
+#error "A striped flash requires a QSPI flash controller"
+#endif
+#ifdef	R_FLASHPGM
+#error "The flashpgm engine can't program a striped flash"
+#endif
+#define	CFG_BOTH(V)	((V) | (((V) & 0x0ff) << 16))
+#define	FLASH_STRIPES	2
+#else
+#define	CFG_BOTH(V)	(V)
+#define	FLASH_STRIPES	1
+#endif
+
+static const unsigned	F_RESET = CFG_BOTH(CFG_WRMODE|0x0ff),
+			F_EMPTY = (CFG_RDMODE|0x000),
+			F_WRR   = CFG_BOTH(CFG_WRMODE|0x001),
+			F_PP    = CFG_BOTH(CFG_WRMODE|0x002),
+			F_QPP   = CFG_BOTH(CFG_WRMODE|0x032),
+			F_READ  = CFG_BOTH(CFG_WRMODE|0x003),
+			F_WRDI  = CFG_BOTH(CFG_WRMODE|0x004),
+			F_RDSR1 = CFG_BOTH(CFG_WRMODE|0x005),
+			F_WREN  = CFG_BOTH(CFG_WRMODE|0x006),
+			F_MFRID = CFG_BOTH(CFG_WRMODE|0x09f),
+			F_SE    = CFG_BOTH(CFG_WRMODE|0x0d8),
 			F_END   = (CFG_USERMODE|CFG_USER_CS_n);
 
+// pgm_byte
+// {{{
+// The data of the i'th byte to be programmed into the flash, from the page
+// at data.  A striped pair takes half of each of two bytes: chip zero their
+// lower nibbles, and chip one their upper.
+static	unsigned	pgm_byte(const char *data, const unsigned i) {
+#ifdef	FLASH_STRIPED
+	unsigned	b0 = data[2*i] & 0x0ff, b1 = data[2*i+1] & 0x0ff;
+
+	return (((b0 & 0x0f) << 4) | (b1 & 0x0f))
+		| (((b0 & 0xf0) | (b1 >> 4)) << 16);
+#else
+	return data[i] & 0x0ff;
+#endif
+}
+// }}}
+
 
 const	bool	HIGH_SPEED = false;
 
@@ -112,14 +168,14 @@ unsigned FLASHDRVR::flashid(void) {
 // printf("Getting ID\n");
 	take_offline();
 
-	m_fpga->writeio(R_FLASHCFG, CFG_USERMODE | 0x9f);
-	m_fpga->writeio(R_FLASHCFG, CFG_USERMODE | 0x00);
+	m_fpga->writeio(R_FLASHCFG, F_MFRID);
+	m_fpga->writeio(R_FLASHCFG, CFG_RDMODE | 0x00);
 	r = m_fpga->readio(R_FLASHCFG) & 0x0ff;
-	m_fpga->writeio(R_FLASHCFG, CFG_USERMODE | 0x00);
+	m_fpga->writeio(R_FLASHCFG, CFG_RDMODE | 0x00);
 	r = (r<<8) | (m_fpga->readio(R_FLASHCFG) & 0x0ff);
-	m_fpga->writeio(R_FLASHCFG, CFG_USERMODE | 0x00);
+	m_fpga->writeio(R_FLASHCFG, CFG_RDMODE | 0x00);
 	r = (r<<8) | (m_fpga->readio(R_FLASHCFG) & 0x0ff);
-	m_fpga->writeio(R_FLASHCFG, CFG_USERMODE | 0x00);
+	m_fpga->writeio(R_FLASHCFG, CFG_RDMODE | 0x00);
 	r = (r<<8) | (m_fpga->readio(R_FLASHCFG) & 0x0ff);
 	m_id = r;
 	place_online();
@@ -178,7 +234,7 @@ void	FLASHDRVR::restore_quadio(void) {
 
 void	FLASHDRVR::restore_quadio(DEVBUS *fpga) {
 #ifdef	QSPI_FLASH
-	static	const	uint32_t	QUAD_IO_READ     = CFG_USERMODE|0xeb;
+	static	const	uint32_t	QUAD_IO_READ = CFG_BOTH(CFG_WRMODE|0xeb);
 
 	fpga->writeio(R_FLASHCFG, F_END);
 	/*
@@ -197,13 +253,26 @@ void	FLASHDRVR::restore_quadio(DEVBUS *fpga) {
 	}
 	*/
 
+#ifdef	FLASH_DTR
+	// A controller built with OPT_DTR reads using the DTR quad I/O
+	// command.  The configuration port only runs at single rate, so the
+	// flash sees each nibble twice: 0x00, 0x0a become a zero address
+	// followed by a mode byte of 0xaa.
+	static	const	uint32_t	DTR_IO_READ  = CFG_BOTH(CFG_WRMODE|0xed);
+
+	fpga->writeio(R_FLASHCFG, DTR_IO_READ);
+	fpga->writeio(R_FLASHCFG, CFG_USERMODE | CFG_QSPEED | CFG_WEDIR);
+	fpga->writeio(R_FLASHCFG, CFG_BOTH(CFG_USERMODE | CFG_QSPEED | CFG_WEDIR | 0x0a));
+	fpga->writeio(R_FLASHCFG, CFG_USERMODE | CFG_QSPEED | CFG_WEDIR);
+#else
 	fpga->writeio(R_FLASHCFG, QUAD_IO_READ);
 	// 3 address bytes
 	fpga->writeio(R_FLASHCFG, CFG_USERMODE | CFG_QSPEED | CFG_WEDIR);
 	fpga->writeio(R_FLASHCFG, CFG_USERMODE | CFG_QSPEED | CFG_WEDIR);
 	fpga->writeio(R_FLASHCFG, CFG_USERMODE | CFG_QSPEED | CFG_WEDIR);
 	// Mode byte
-	fpga->writeio(R_FLASHCFG, CFG_USERMODE | CFG_QSPEED | CFG_WEDIR | 0xa0);
+	fpga->writeio(R_FLASHCFG, CFG_BOTH(CFG_USERMODE | CFG_QSPEED | CFG_WEDIR | 0xa0));
+#endif
 	// Read NDUMMY clocks worth
 #ifdef	FLASH_NDUMMY
 	for(int k=0; k<(FLASH_NDUMMY-2)/2; k++)
@@ -219,7 +288,8 @@ void	FLASHDRVR::restore_quadio(DEVBUS *fpga) {
 
 void	FLASHDRVR::flwait(void) {
 #ifdef	FLASH_ACCESS
-	const	int	WIP = 1;	// Write in progress bit
+	// The write in progress bit, of either device if striped
+	const	unsigned	WIP = CFG_BOTH(1);
 	DEVBUS::BUSW	sr;
 
 	m_fpga->writeio(R_FLASHCFG, F_END);
@@ -232,10 +302,70 @@ void	FLASHDRVR::flwait(void) {
 #endif
 }
 
+#ifdef	R_FLASHCFGQ
+#define	CFGQ_BUSY	0x80000000
+#endif
+
+#ifdef	R_FLASHPGM
+#define	PGM_BUSY	0x80000000
+#define	PGM_START	0x01
+#define	ERASE_64K	0x02000000
+#define	PGM_CHIP(C)	(((C)&7)<<26)
+#endif
+
+#ifdef	R_FLASHCRC
+#define	CRC_BUSY	0x80000000
+#define	CRC_BLANKCHK	0x80000000
+#define	BLANK		0x80000000
+
+// blank_check
+// {{{
+// Ask the flashcrc engine whether len bytes of the flash, starting at
+// addr, are blank.  The engine only checks whole words, so every word
+// these bytes touch is checked.  Returns true if they are all blank.
+// Otherwise, dirty is set to the address of the first word that isn't.
+bool	FLASHDRVR::blank_check(const unsigned addr, const unsigned len,
+		unsigned &dirty) {
+	unsigned	flashaddr = addr & 0x0ffffff, r,
+			nw = ((addr & 3) + len + 3) >> 2;
+
+	dirty = 0;
+	if (len == 0)
+		return true;
+
+	m_fpga->writeio(R_FLASHCRCADDR, flashaddr);
+	m_fpga->writeio(R_FLASHCRCLEN, CRC_BLANKCHK | nw);
+	while(m_fpga->readio(R_FLASHCRCLEN) & CRC_BUSY)
+		;
+	r = m_fpga->readio(R_FLASHBLANK);
+	if (r & BLANK)
+		return true;
+	dirty = (addr & ~0x0ffffff) | (r & 0x0ffffff);
+	return false;
+}
+// }}}
+#endif
+
 bool	FLASHDRVR::erase_sector(const unsigned sector, const bool verify_erase) {
 #ifdef	FLASH_ACCESS
 	unsigned	flashaddr = sector & 0x0ffffff;
 
+#ifdef	R_FLASHPGM
+	printf("Erasing sector: %06x\n", flashaddr);
+
+	// Let the flashpgm engine erase the sector, given its device (if
+	// the controller drives several) and its address within that device.
+	// The engine takes the flash offline, and back online, itself.
+	m_fpga->writeio(R_FLASHERASE, PGM_CHIP((sector - R_FLASH) >> 24)
+			| ERASE_64K | flashaddr);
+
+	// Wait for the erase to complete, and then clear the done flag
+	while(m_fpga->readio(R_FLASHERASE) & PGM_BUSY)
+		;
+	m_fpga->writeio(R_FLASHPGM, 0);
+#else
+	unsigned	devaddr = flashaddr / FLASH_STRIPES;
+
 	take_offline();
 
 	// Write enable
@@ -243,15 +373,13 @@ bool	FLASHDRVR::erase_sector(const unsigned sector, const bool verify_erase) {
 	m_fpga->writeio(R_FLASHCFG, F_WREN);
 	m_fpga->writeio(R_FLASHCFG, F_END);
 
-	DEVBUS::BUSW	page[SZPAGEW];
-
 	// printf("EREG before   : %08x\n", m_fpga->readio(R_QSPI_EREG));
 	printf("Erasing sector: %06x\n", flashaddr);
 
 	m_fpga->writeio(R_FLASHCFG, F_SE);
-	m_fpga->writeio(R_FLASHCFG, CFG_USERMODE | ((flashaddr>>16)&0x0ff));
-	m_fpga->writeio(R_FLASHCFG, CFG_USERMODE | ((flashaddr>> 8)&0x0ff));
-	m_fpga->writeio(R_FLASHCFG, CFG_USERMODE | ((flashaddr    )&0x0ff));
+	m_fpga->writeio(R_FLASHCFG, CFG_BOTH(CFG_WRMODE | ((devaddr>>16)&0x0ff)));
+	m_fpga->writeio(R_FLASHCFG, CFG_BOTH(CFG_WRMODE | ((devaddr>> 8)&0x0ff)));
+	m_fpga->writeio(R_FLASHCFG, CFG_BOTH(CFG_WRMODE | ((devaddr    )&0x0ff)));
 	m_fpga->writeio(R_FLASHCFG, F_END);
 
 	// Wait for the erase to complete
@@ -259,11 +387,23 @@ bool	FLASHDRVR::erase_sector(const unsigned sector, const bool verify_erase) {
 
 	// Turn quad-mode read back on, so we can read next
 	place_online();
+#endif
 
 	// Now, let's verify that we erased the sector properly
 	if (verify_erase) {
 		if (m_debug)
 			printf("Verifying the erase\n");
+#ifdef	R_FLASHCRC
+		unsigned	dirty;
+
+		if (!blank_check(R_FLASH+flashaddr, SECTORSZB, dirty)) {
+			if (m_debug)
+				printf("FLASH[%07x] is not blank\n", dirty);
+			return false;
+		}
+#else
+		DEVBUS::BUSW	page[SZPAGEW];
+
 		for(int i=0; i<NPAGES; i++) {
 			// printf("READI[%08x + %04x]\n", R_FLASH+flashaddr+i*SZPAGEB, SZPAGEW);
 			m_fpga->readi(R_FLASH+flashaddr+i*SZPAGEB, SZPAGEW, page);
@@ -278,6 +418,7 @@ bool	FLASHDRVR::erase_sector(const unsigned sector, const bool verify_erase) {
 					return false;
 				}
 		}
+#endif
 		if (m_debug)
 			printf("Erase verified\n");
 	}
@@ -292,13 +433,21 @@ bool	FLASHDRVR::page_program(const unsigned addr, const unsigned len,
 		const char *data, const bool verify_write) {
 #ifdef	FLASH_ACCESS
 	DEVBUS::BUSW	buf[SZPAGEW], bswapd[SZPAGEW];
-	unsigned	flashaddr = addr & 0x0ffffff;
 
+#ifndef	R_FLASHPGM
+	unsigned	flashaddr = (addr & 0x0ffffff) / FLASH_STRIPES;
+
+	// flashpgm takes the flash offline, and back online, itself
 	take_offline();
+#endif
 
 	assert(len > 0);
 	assert(len <= PGLENB);
 	assert(PAGEOF(addr)==PAGEOF(addr+len-1));
+#ifdef	FLASH_STRIPED
+	// Every device byte holds a nibble from two bytes
+	assert(((addr | len) & 1) == 0);
+#endif
 
 	if (len <= 0)
 		return true;
@@ -313,7 +462,46 @@ bool	FLASHDRVR::page_program(const unsigned addr, const unsigned len,
 	}
 
 	if (!empty_page) {
-#ifndef	EQSPIFLASH
+#if	defined(R_FLASHPGM)
+		// Write the page into the flashpgm engine's buffer, at its
+		// own address, and let the engine program it.  Any other bytes
+		// sharing the first and last words are sent as 0xff, and so
+		// leave the flash unchanged.
+		DEVBUS::BUSW	pgmbuf[SZPAGEW+1];
+		unsigned char	pgbytes[PGLENB+8];
+		unsigned	base = addr & -4,
+				nw = (addr + len - base + 3) >> 2;
+
+		memset(pgbytes, 0xff, nw << 2);
+		memcpy(&pgbytes[addr - base], data, len);
+		for(unsigned k=0; k<nw; k++)
+			pgmbuf[k] = buildword(&pgbytes[k<<2]);
+
+		m_fpga->writei(base, nw, pgmbuf);
+		m_fpga->writeio(R_FLASHPGM, PGM_START);
+#elif	defined(R_FLASHCFGQ)&&!defined(EQSPIFLASH)&&!defined(FLASH_STRIPED)
+		// Queue the whole page program command--write enable, command,
+		// address, and data--in the configuration port FIFO, with one
+		// bus burst, and then wait for the FIFO to drain.  (The FIFO's
+		// words have no room for a striped pair's second byte.)
+		DEVBUS::BUSW	cfgbuf[PGLENB+8];
+		unsigned	n = 0;
+
+		cfgbuf[n++] = F_END;
+		cfgbuf[n++] = F_WREN;
+		cfgbuf[n++] = F_END;
+		cfgbuf[n++] = F_PP;
+		cfgbuf[n++] = CFG_WRMODE|((flashaddr>>16)&0x0ff);
+		cfgbuf[n++] = CFG_WRMODE|((flashaddr>> 8)&0x0ff);
+		cfgbuf[n++] = CFG_WRMODE|((flashaddr    )&0x0ff);
+		for(unsigned i=0; i<len; i++)
+			cfgbuf[n++] = CFG_WRMODE | CFG_WEDIR | (data[i] & 0x0ff);
+		cfgbuf[n++] = F_END;
+
+		m_fpga->writez(R_FLASHCFGQ, n, cfgbuf);
+		while(m_fpga->readio(R_FLASHCFGQ) & CFGQ_BUSY)
+			;
+#elif	!defined(EQSPIFLASH)
 		// Write enable
 		m_fpga->writeio(R_FLASHCFG, F_END);
 		m_fpga->writeio(R_FLASHCFG, F_WREN);
@@ -330,14 +518,14 @@ bool	FLASHDRVR::page_program(const unsigned addr, const unsigned len,
 		// if (F_QPP) {} else
 		m_fpga->writeio(R_FLASHCFG, F_PP);
 		// The address
-		m_fpga->writeio(R_FLASHCFG, CFG_USERMODE|((flashaddr>>16)&0x0ff));
-		m_fpga->writeio(R_FLASHCFG, CFG_USERMODE|((flashaddr>> 8)&0x0ff));
-		m_fpga->writeio(R_FLASHCFG, CFG_USERMODE|((flashaddr    )&0x0ff));
+		m_fpga->writeio(R_FLASHCFG, CFG_BOTH(CFG_WRMODE|((flashaddr>>16)&0x0ff)));
+		m_fpga->writeio(R_FLASHCFG, CFG_BOTH(CFG_WRMODE|((flashaddr>> 8)&0x0ff)));
+		m_fpga->writeio(R_FLASHCFG, CFG_BOTH(CFG_WRMODE|((flashaddr    )&0x0ff)));
 
 		// Write the page data itself
-		for(unsigned i=0; i<len; i++)
+		for(unsigned i=0; i<len/FLASH_STRIPES; i++)
 			m_fpga->writeio(R_FLASHCFG, 
-				CFG_USERMODE | CFG_WEDIR | (data[i] & 0x0ff));
+				CFG_WRMODE | CFG_WEDIR | pgm_byte(data, i));
 		m_fpga->writeio(R_FLASHCFG, F_END);
 #else
 		// Write the page
@@ -363,10 +551,20 @@ bool	FLASHDRVR::page_program(const unsigned addr, const unsigned len,
 		else
 			printf("\n");
 
+#ifdef	R_FLASHPGM
+		// Wait on the engine, rather than polling the flash, and then
+		// clear its done flag
+		while(m_fpga->readio(R_FLASHPGM) & PGM_BUSY)
+			;
+		m_fpga->writeio(R_FLASHPGM, 0);
+#else
 		flwait();
+#endif
 	}
 
+#ifndef	R_FLASHPGM
 	place_online();
+#endif
 	if (verify_write) {
 
 		// printf("Attempting to verify page\n");
@@ -422,6 +620,181 @@ void	FLASHDRVR::set_config(void) {
 #endif
 }
 
+// crc32
+// {{{
+// The (zlib) CRC32 of a buffer, matching that calculated by the flashcrc
+// verification engine
+static	unsigned	crc32(const unsigned len, const char *data) {
+	unsigned	crc = 0xffffffff;
+
+	for(unsigned k=0; k<len; k++) {
+		crc ^= data[k] & 0x0ff;
+		for(int i=0; i<8; i++)
+			crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320 : 0);
+	}
+
+	return ~crc;
+}
+// }}}
+
+// verify_readback
+// {{{
+// Verifies len bytes of the flash, starting at addr, against data by reading
+// back every bus word they touch.  Neither addr nor len need be word aligned.
+bool	FLASHDRVR::verify_readback(const unsigned addr, const unsigned len,
+		const char *data) {
+	unsigned	base = addr & -4, nw = (addr + len - base + 3) >> 2;
+	char		*rbuf = new char[nw << 2];
+	bool		r;
+
+	m_fpga->readi(base, nw, (uint32_t *)rbuf);
+	byteswapbuf(nw, (uint32_t *)rbuf);
+	r = (0 == memcmp(&rbuf[addr - base], data, len));
+	delete[] rbuf;
+
+	if (!r)
+		printf("VERIFY FAILS: 0x%08x - 0x%08x\n", addr, addr+len-1);
+	return r;
+}
+// }}}
+
+// verify_crc
+// {{{
+// Verifies len bytes of the flash, starting at addr, against data.  Given
+// a flashcrc verification engine, this is done with one command and a
+// comparison of the CRC it returns.  The engine only works on whole words,
+// so any bytes before the first whole word, or after the last, are read
+// back instead.  Without the engine, the flash is read back.
+bool	FLASHDRVR::verify_crc(const unsigned addr, const unsigned len,
+		const char *data) {
+#ifndef	FLASH_ACCESS
+	return false;
+#elif	defined(R_FLASHCRC)
+	unsigned	head = (-addr) & 3, tail, wlen, waddr, flashaddr, crc;
+	const char	*wdata;
+
+	if (head > len)
+		head = len;
+	tail  = (len - head) & 3;
+	waddr = addr + head;
+	wlen  = len - head - tail;
+	wdata = &data[head];
+
+	if ((head > 0)&&(!verify_readback(addr, head, data)))
+		return false;
+	if ((tail > 0)&&(!verify_readback(addr+len-tail, tail,
+			&data[len-tail])))
+		return false;
+	if (wlen == 0)
+		return true;
+
+	flashaddr = waddr & 0x0ffffff;
+	m_fpga->writeio(R_FLASHCRCADDR, flashaddr);
+	m_fpga->writeio(R_FLASHCRCLEN, wlen >> 2);
+	while(m_fpga->readio(R_FLASHCRCLEN) & CRC_BUSY)
+		;
+	crc = m_fpga->readio(R_FLASHCRC);
+
+	if (crc != crc32(wlen, wdata)) {
+		printf("CRC VERIFY FAILS: 0x%08x - 0x%08x, CRC %08x != %08x (Goal)\n",
+			waddr, waddr+wlen-1, crc, crc32(wlen, wdata));
+		return false;
+	} if (m_debug)
+		printf("CRC verified: 0x%08x - 0x%08x\n", addr, addr+len-1);
+	return true;
+#else
+	if (len == 0)
+		return true;
+	return verify_readback(addr, len, data);
+#endif
+}
+// }}}
+
+#ifdef	R_FLASHSPEED
+#define	SPEED_MASK		0xfff0001f
+#define	SPEED_CLKDIV(V)		(((V)&0x0ff)<<24)
+#define	SPEED_RDDELAY(V)	(((V)&0x0f)<<20)
+#define	SPEED_GETDELAY(V)	(((V)>>20)&0x0f)
+#endif
+
+// calibrate
+// {{{
+// Searches for the read delay, given a clock divider of clkdiv, that best
+// centers the controller's sampling within the flash's data valid window.
+// len bytes, starting at addr, are read at every delay the controller will
+// accept and compared against data.  Should data be NULL, these bytes are
+// first read at the current speed setting, which is then assumed to work.
+//
+// The controller is left at the center of the longest run of passing delays.
+// Returns the window found--a bit mask with bit d set if delay d passed--or
+// zero if no delay passed, in which case the speed is left unchanged.
+unsigned	FLASHDRVR::calibrate(const unsigned addr, const unsigned len,
+		const char *data, const unsigned clkdiv) {
+#if	!defined(FLASH_ACCESS) || !defined(R_FLASHSPEED)
+	return 0;
+#else
+	unsigned	speed, maxdly, window = 0, best = 0, bestlen = 0;
+	char		*rbuf = new char[len], *ref = new char[len];
+
+	assert((len & 3) == 0);
+
+	speed = m_fpga->readio(R_FLASHSPEED) & SPEED_MASK;
+
+	// Out of range delays are clipped, so the largest is found by asking
+	// for one that's too large
+	m_fpga->writeio(R_FLASHSPEED, speed | SPEED_RDDELAY(0x0f));
+	maxdly = SPEED_GETDELAY(m_fpga->readio(R_FLASHSPEED));
+
+	// Comparisons are made as read from the bus, before any byte swapping
+	if (data == NULL) {
+		m_fpga->writeio(R_FLASHSPEED, speed);
+		m_fpga->readi(addr, len>>2, (uint32_t *)ref);
+	} else {
+		memcpy(ref, data, len);
+		byteswapbuf(len>>2, (uint32_t *)ref);
+	}
+
+	for(unsigned dly=0; dly<=maxdly; dly++) {
+		m_fpga->writeio(R_FLASHSPEED, (speed & 0x0000ffff)
+				| SPEED_CLKDIV(clkdiv) | SPEED_RDDELAY(dly));
+		m_fpga->readi(addr, len>>2, (uint32_t *)rbuf);
+		if (0 == memcmp(rbuf, ref, len))
+			window |= (1<<dly);
+	}
+
+	// Pick the center of the longest run of passing delays
+	for(unsigned lo=0; lo<=maxdly; lo++) {
+		unsigned	hi = lo;
+
+		if (0 == (window & (1<<lo)))
+			continue;
+		while((hi < maxdly)&&(window & (1<<(hi+1))))
+			hi++;
+		if (hi+1-lo > bestlen) {
+			bestlen = hi+1-lo;
+			best = (lo+hi)/2;
+		} lo = hi;
+	}
+
+	if (window == 0) {
+		printf("CALIBRATION FAILED: No read delay works at CLKDIV=%d\n",
+			clkdiv);
+		m_fpga->writeio(R_FLASHSPEED, speed);
+	} else {
+		if (m_debug)
+			printf("CLKDIV=%d, window %04x, RDDELAY <= %d\n",
+				clkdiv, window, best);
+		m_fpga->writeio(R_FLASHSPEED, (speed & 0x0000ffff)
+				| SPEED_CLKDIV(clkdiv) | SPEED_RDDELAY(best));
+	}
+
+	delete[] rbuf;
+	delete[] ref;
+	return window;
+#endif
+}
+// }}}
+
 bool	FLASHDRVR::write(const unsigned addr, const unsigned len,
 		const char *data, const bool verify) {
 #ifdef	FLASH_ACCESS
@@ -450,9 +823,20 @@ bool	FLASHDRVR::write(const unsigned addr, const unsigned len,
 			char *sbuf = new char[SECTORSZB];
 			const char *dp;	// pointer to our "desired" buffer
 			unsigned	base,ln;
+#ifdef	R_FLASHCRC
+			unsigned	dirty;
+#endif
 
 			base = (addr>s)?addr:s;
 			ln=((addr+len>s+SECTORSZB)?(s+SECTORSZB):(addr+len))-base;
+#ifdef	R_FLASHCRC
+			// Anything may be written to a blank range, so there's
+			// no need to read it back and compare
+			if (blank_check(base, ln, dirty)) {
+				newv = base;
+				ln = 0;
+			} else
+#endif
 			m_fpga->readi(base, ln>>2, (uint32_t *)sbuf);
 			byteswapbuf(ln>>2, (uint32_t *)sbuf);
 
@@ -495,7 +879,13 @@ bool	FLASHDRVR::write(const unsigned addr, const unsigned len,
 			// our results to the page boundary
 			if (PAGEOF(start+len-1)!=PAGEOF(start))
 				len = PAGEOF(start+PGLENB)-start;
+#ifdef	R_FLASHCRC
+			// The whole image is verified by CRC once written,
+			// rather than reading back each page
+			if (!page_program(start, len, &data[p-addr], false)) {
+#else
 			if (!page_program(start, len, &data[p-addr], verify)) {
+#endif
 				printf("WRITE-PAGE FAILED!\n");
 				return false;
 			}
@@ -510,6 +900,13 @@ bool	FLASHDRVR::write(const unsigned addr, const unsigned len,
 
 	place_online();
 
+#ifdef	R_FLASHCRC
+	if ((verify)&&(!verify_crc(addr, len, data))) {
+		printf("CRC VERIFY FAILED!\n");
+		return false;
+	}
+#endif
+
 	return true;
 #else
 	return false;
@@ -62,6 +62,10 @@ private:
 	bool	verify_config(void);
 	void	set_config(void);
 	void	flwait(void);
+	bool	blank_check(const unsigned addr, const unsigned len,
+			unsigned &dirty);
+	bool	verify_readback(const unsigned addr, const unsigned len,
+			const char *data);
 public:
 	FLASHDRVR(DEVBUS *fpga);
 	bool	erase_sector(const unsigned sector, const bool verify_erase=true);
@@ -69,6 +73,10 @@ public:
 			const char *data, const bool verify_write=true);
 	bool	write(const unsigned addr, const unsigned len,
 			const char *data, const bool verify=false);
+	bool	verify_crc(const unsigned addr, const unsigned len,
+			const char *data);
+	unsigned	calibrate(const unsigned addr, const unsigned len,
+			const char *data, const unsigned clkdiv);
 
 	unsigned	flashid(void);
 
@@ -0,0 +1,436 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// Filename: 	flashscript.cpp
+// {{{
+// Project:	A Set of Wishbone Controlled SPI Flash Controllers
+//
+// Purpose:	Startup script assembler.  The quad and dual SPI flash
+//		controllers run a 32 word script out of reset, taking the
+//	flash out of whatever mode it was left in and placing it into the XIP
+//	mode they read from.  Given OPT_STARTUP_FILE, that script is read from
+//	a hex file.  This program writes such a file, either from a readable
+//	description or from one of a set of vendor presets.
+//
+//	Usage: flashscript [-dkl] [-f <MHz>] [-n <ndummy>] [-o <file.hex>]
+//			(-v <vendor> | <script>)
+//
+//	-d		Build for the dual SPI controller, rather than quad
+//	-f <MHz>	The SCK rate the script runs at: the system clock,
+//			divided by OPT_CLKDIV+1.  100MHz by default.  Used to
+//			turn delays into clock counts.
+//	-k		Keep the flash's non-volatile configuration.  Presets
+//			then leave out any non-volatile register writes, such
+//			as setting a QUAD bit that has already been set, along
+//			with the long wait following them.
+//	-l		List the preset script, rather than assembling it
+//	-n <ndummy>	The controller's NDUMMY parameter, 6 by default for
+//			the quad controller, 8 for dual
+//	-o <file>	The hex file to write, rather than stdout
+//	-v <vendor>	One of spansion, micron, or winbond
+//
+//	The script itself has one statement per line.  A '#' starts a
+//	comment.  Statements are ...
+//
+//	spi <byte> ...	Bytes sent one bit per clock, on MOSI
+//	out <byte> ...	Bytes sent across all four (two) data pins
+//	in <n>		N bytes clocked with the data pins as inputs
+//	dummy <n>	N clocks with the data pins as inputs
+//	wait <n>	Raise CS, and idle for at least N clocks
+//	delay <us>	Raise CS, and idle for at least this many microseconds
+//
+//	Bytes are in hex.  Consecutive spi, out, in, or dummy statements
+//	form a single transaction, with CS held low throughout.  A wait or
+//	delay is needed between any two transactions.  The last transaction
+//	should leave the flash in XIP mode.
+//
+//	The script is placed at the end of the 32 words, ahead of the two
+//	(required) maximum length idles, and the words before it are filled
+//	with the shortest idles the controller allows.
+//
+// Creator:	Dan Gisselquist, Ph.D.
+//		Gisselquist Technology, LLC
+//
+////////////////////////////////////////////////////////////////////////////////
+// }}}
+// Copyright (C) 2015-2021, Gisselquist Technology, LLC
+// {{{
+// This file is part of the set of Wishbone controlled SPI flash controllers
+// project
+//
+// The Wishbone SPI flash controller project is free software (firmware):
+// you can redistribute it and/or modify it under the terms of the GNU Lesser
+// General Public License as published by the Free Software Foundation, either
+// version 3 of the License, or (at your option) any later version.
+//
+// The Wishbone SPI flash controller project is distributed in the hope
+// that it will be useful, but WITHOUT ANY WARRANTY; without even the implied
+// warranty of MERCHANTIBILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  (It's in the $(ROOT)/doc directory.  Run make
+// with no target there if the PDF file isn't present.)  If not, see
+// <http://www.gnu.org/licenses/> for a copy.
+// }}}
+// License:	LGPL, v3, as defined and found on www.gnu.org,
+// {{{
+//		http://www.gnu.org/licenses/lgpl.html
+//
+//
+////////////////////////////////////////////////////////////////////////////////
+//
+// }}}
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+// Script word format, matching the controllers
+// {{{
+static const unsigned	NWORDS = 32,	// Words in the script
+		NUSER  = NWORDS-2,	// Less the two required final idles
+		WAITBIT  = 0x400,	// Marks an idle (counter) word
+		MAXWAIT  = 0x3ff,	// The longest idle a word can hold
+		MINWAIT  = 1,		// The shortest
+		// Modes, in bits [9:8]
+		NORMAL_SPI = 0x000,
+		WIDE_WRITE = 0x200,	// QUAD_WRITE, or DUAL_WRITE
+		WIDE_READ  = 0x300,	// QUAD_READ, or DUAL_READ
+		// The controller idles this long following a reset, before
+		// starting its script
+		RESET_IDLE = MAXWAIT+1;
+// }}}
+
+static	bool	gbl_dual = false, gbl_keep = false;
+static	double	gbl_mhz = 100.0;
+static	int	gbl_ndummy = -1;
+
+static	unsigned	gbl_word[NWORDS];
+static	const char	*gbl_note[NWORDS];
+static	unsigned	gbl_nwords = 0;
+static	int		gbl_line = 0;
+
+void	usage(void) {
+	printf("USAGE: flashscript [-dkl] [-f <MHz>] [-n <ndummy>] [-o <file.hex>]\n"
+"\t\t(-v <vendor> | <script>)\n"
+"\n"
+"\tAssembles a startup script for the quad (or, with -d, dual) SPI\n"
+"\tflash controller, to be loaded through OPT_STARTUP_FILE.  Vendors\n"
+"\tare spansion, micron, and winbond.\n");
+}
+
+// error
+// {{{
+static	void	error(const char *msg, const char *arg = "") {
+	if (gbl_line > 0)
+		fprintf(stderr, "ERR: Line %d: %s%s\n", gbl_line, msg, arg);
+	else
+		fprintf(stderr, "ERR: %s%s\n", msg, arg);
+	exit(EXIT_FAILURE);
+}
+// }}}
+
+// emit
+// {{{
+static	void	emit(unsigned w, const char *note) {
+	if (gbl_nwords >= NUSER) {
+		fprintf(stderr, "ERR: The script needs more than the %d words available\n", NUSER);
+		exit(EXIT_FAILURE);
+	}
+	gbl_note[gbl_nwords] = strdup(note);
+	gbl_word[gbl_nwords++] = w;
+}
+// }}}
+
+// emitwait
+// {{{
+// Idle for at least nclocks, using as few words as possible.  Every wait
+// raises CS, even one of zero clocks.
+static	void	emitwait(unsigned long nclocks, const char *note) {
+	do {
+		unsigned	w;
+
+		w = (nclocks > MAXWAIT) ? MAXWAIT : (unsigned)nclocks;
+		if (w < MINWAIT)
+			w = MINWAIT;
+		// The controller's formal properties require the bottom
+		// eight bits of any count to be nonzero
+		if ((w & 0x0ff) == 0)
+			w++;
+		emit(WAITBIT | w, note);
+		nclocks = (nclocks > w) ? nclocks - w : 0;
+	} while(nclocks > 0);
+}
+// }}}
+
+// nextnum
+// {{{
+static	bool	nextnum(char **ptr, unsigned long *v, int base) {
+	char	*end;
+
+	while(isspace(**ptr))
+		(*ptr)++;
+	if (**ptr == '\0')
+		return false;
+	*v = strtoul(*ptr, &end, base);
+	if ((end == *ptr)||((*end != '\0')&&(!isspace(*end))))
+		error("Bad number, ", *ptr);
+	*ptr = end;
+	return true;
+}
+// }}}
+
+// assemble
+// {{{
+// Assemble one line of a script
+static	void	assemble(char *line) {
+	char		*ptr, *cmd, *comment;
+	unsigned long	v;
+	char		note[96];
+
+	if (NULL != (comment = strchr(line, '#')))
+		*comment = '\0';
+	ptr = line;
+	while(isspace(*ptr))
+		ptr++;
+	if (*ptr == '\0')
+		return;
+	cmd = ptr;
+	while((*ptr)&&(!isspace(*ptr)))
+		ptr++;
+	if (*ptr)
+		*ptr++ = '\0';
+
+	if ((strcmp(cmd, "spi")==0)||(strcmp(cmd, "out")==0)) {
+		unsigned	mode = (cmd[0] == 's') ? NORMAL_SPI : WIDE_WRITE;
+		bool		any = false;
+
+		while(nextnum(&ptr, &v, 16)) {
+			if (v > 0x0ff)
+				error("Byte out of range in ", cmd);
+			snprintf(note, sizeof(note), "%.3s %02lx", cmd, v);
+			emit(mode | (unsigned)v, note);
+			any = true;
+		} if (!any)
+			error("No bytes given to ", cmd);
+	} else if (strcmp(cmd, "in")==0) {
+		if ((!nextnum(&ptr, &v, 0))||(v == 0))
+			error("Bad byte count given to ", cmd);
+		while(v-- > 0)
+			emit(WIDE_READ, "in");
+	} else if (strcmp(cmd, "dummy")==0) {
+		unsigned	perword = (gbl_dual) ? 4 : 2;
+
+		if (!nextnum(&ptr, &v, 0))
+			error("No clock count given to ", cmd);
+		// Any clocks beyond those asked for only read more data
+		for(unsigned k=0; k<v; k+= perword)
+			emit(WIDE_READ, "dummy");
+	} else if (strcmp(cmd, "wait")==0) {
+		if (!nextnum(&ptr, &v, 0))
+			error("No clock count given to ", cmd);
+		snprintf(note, sizeof(note), "wait %lu", v);
+		emitwait(v, note);
+	} else if (strcmp(cmd, "delay")==0) {
+		double	us;
+		char	*end;
+
+		us = strtod(ptr, &end);
+		if ((end == ptr)||(us < 0))
+			error("Bad time given to ", cmd);
+		snprintf(note, sizeof(note), "delay %gus", us);
+		emitwait((unsigned long)ceil(us * gbl_mhz), note);
+	} else
+		error("Unknown statement, ", cmd);
+}
+// }}}
+
+// preset
+// {{{
+// Write out a vendor's startup script, in the same language the
+// assembler reads
+static	void	preset(FILE *fp, const char *vendor) {
+	// The CS high time, tSHSL, needed between commands: 50ns is
+	// enough for all of these devices
+	const	double	TSHSL = 0.05;
+	// The clocks of the mode byte following the address
+	const	int	modeclocks = (gbl_dual) ? 4 : 2;
+
+	fprintf(fp, "# Startup script for %s flash, %s SPI, NDUMMY=%d\n#\n",
+		vendor, (gbl_dual) ? "dual" : "quad", gbl_ndummy);
+	fprintf(fp,
+"# Leave any XIP mode the flash might be in.  With all pins high, this is an\n"
+"# address followed by an invalid mode byte, or else an ignored command.\n"
+"spi ff ff ff\n"
+"delay %g\n", TSHSL);
+
+	if (strcmp(vendor, "spansion")==0) {
+		// {{{
+		// The QUAD bit in configuration register one is non-volatile,
+		// so writing it costs a full write cycle.  50us is the write
+		// time of the simulated flash, not that of any actual part.
+		if (!gbl_keep)
+			fprintf(fp,
+"# Set the QUAD bit: write enable, then WRR status 00, configuration 02\n"
+"spi 06\n"
+"delay %g\n"
+"spi 01 00 02\n"
+"# tW, the time for the register write to complete\n"
+"delay 50\n", TSHSL);
+		// }}}
+	} else if (strcmp(vendor, "micron")==0) {
+		// {{{
+		// Micron parts take a quad I/O read without any QUAD bit,
+		// but their dummy cycle count is set in the volatile
+		// configuration register.  Since the register is volatile,
+		// it can be written on every startup without any write
+		// cycle delay.
+		if ((gbl_ndummy < 1)||(gbl_ndummy > 14))
+			error("Micron devices support between 1 and 14 dummy cycles");
+		fprintf(fp,
+"# Write enable, then write the volatile configuration register: %d dummy\n"
+"# cycles, XIP enabled, and no wrapping\n"
+"spi 06\n"
+"delay %g\n"
+"spi 81 %02x\n"
+"delay %g\n", gbl_ndummy, TSHSL, (gbl_ndummy << 4) | 0x03, TSHSL);
+		// }}}
+	} else if (strcmp(vendor, "winbond")==0) {
+		// {{{
+		// Winbond's dummy cycles are fixed, but the QE bit may be set
+		// in volatile status register two, without any delay.
+		if (gbl_ndummy != modeclocks + ((gbl_dual) ? 0 : 4))
+			fprintf(stderr, "WARNING: Winbond devices use an NDUMMY of %d\n",
+				modeclocks + ((gbl_dual) ? 0 : 4));
+		if (!gbl_keep)
+			fprintf(fp,
+"# Set the QE bit in the volatile copy of status register two\n"
+"spi 50\n"
+"delay %g\n"
+"spi 31 02\n"
+"delay %g\n", TSHSL, TSHSL);
+		// }}}
+	} else
+		error("Unknown vendor, ", vendor);
+
+	fprintf(fp,
+"# Enter XIP mode, with a %s I/O read of address zero\n"
+"spi %s\n"
+"out 00 00 00 a0\n",
+		(gbl_dual) ? "dual" : "quad", (gbl_dual) ? "bb" : "eb");
+	if (gbl_ndummy > modeclocks)
+		fprintf(fp, "dummy %d\n", gbl_ndummy - modeclocks);
+	fprintf(fp, "# Read a byte, and we are done\nin 1\n");
+}
+// }}}
+
+int main(int argc, char **argv) {
+	const char	*vendor = NULL, *outfname = NULL, *source;
+	bool		list = false;
+	FILE		*fin, *fout;
+	char		line[256];
+	int		opt;
+	unsigned long	clocks;
+
+	while((opt = getopt(argc, argv, "hdklf:n:o:v:")) != -1) {
+		switch(opt) {
+		case 'd': gbl_dual = true; break;
+		case 'f': gbl_mhz  = strtod(optarg, NULL); break;
+		case 'k': gbl_keep = true; break;
+		case 'l': list = true; break;
+		case 'n': gbl_ndummy = atoi(optarg); break;
+		case 'o': outfname = optarg; break;
+		case 'v': vendor = optarg; break;
+		case 'h': usage(); exit(EXIT_SUCCESS);
+		default:
+			usage(); exit(EXIT_FAILURE);
+		}
+	}
+
+	if (gbl_ndummy < 0)
+		gbl_ndummy = (gbl_dual) ? 8 : 6;
+	if (gbl_mhz <= 0)
+		error("Bad clock rate");
+
+	// Get the script, either from a preset or a file
+	// {{{
+	if ((vendor)&&(optind == argc)) {
+		if (list) {
+			preset(stdout, vendor);
+			exit(EXIT_SUCCESS);
+		}
+
+		fin = tmpfile();
+		if (NULL == fin)
+			error("Could not create a temporary file");
+		preset(fin, vendor);
+		rewind(fin);
+		source = vendor;
+	} else if ((!vendor)&&(!list)&&(optind+1 == argc)) {
+		source = argv[optind];
+		fin = fopen(source, "r");
+		if (NULL == fin)
+			error("Could not open ", source);
+	} else {
+		usage();
+		exit(EXIT_FAILURE);
+	}
+	// }}}
+
+	while(fgets(line, sizeof(line), fin)) {
+		gbl_line++;
+		assemble(line);
+	} fclose(fin);
+	gbl_line = 0;
+
+	if (gbl_nwords == 0)
+		error("Empty script");
+
+	// Write the result
+	// {{{
+	fout = stdout;
+	if ((outfname)&&(NULL == (fout = fopen(outfname, "w"))))
+		error("Could not open ", outfname);
+
+	fprintf(fout, "// %s startup script, assembled by flashscript from %s\n",
+		(gbl_dual) ? "dualflexpress" : "qflexpress", source);
+	fprintf(fout, "// NDUMMY=%d, %gMHz SCK\n", gbl_ndummy, gbl_mhz);
+
+	clocks = RESET_IDLE;
+	for(unsigned k=0; k<NWORDS; k++) {
+		unsigned	w;
+		const char	*note;
+
+		if (k < NUSER - gbl_nwords) {
+			w = WAITBIT | MINWAIT;
+			note = "(idle)";
+		} else if (k < NUSER) {
+			w = gbl_word[k - (NUSER - gbl_nwords)];
+			note = gbl_note[k - (NUSER - gbl_nwords)];
+		} else {
+			// Required
+			w = WAITBIT | MAXWAIT;
+			note = "(final idle)";
+		}
+
+		if (w & WAITBIT)
+			clocks += (w & MAXWAIT) + 1;
+		else if ((w & WIDE_WRITE)==0)
+			clocks += 8;
+		else
+			clocks += (gbl_dual) ? 4 : 2;
+
+		fprintf(fout, "%03x\t// %02x: %s\n", w, k, note);
+	}
+
+	if (fout != stdout)
+		fclose(fout);
+	// }}}
+
+	fprintf(stderr, "%d script words, about %lu SCK clocks (%.1fus) to start up\n",
+		gbl_nwords, clocks, clocks / gbl_mhz);
+
+	return EXIT_SUCCESS;
+}